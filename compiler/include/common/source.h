@@ -0,0 +1,65 @@
+
+/**
+ * @file source.h
+ * @brief Loading of source files for the lexer.
+ *
+ * Large files are mapped read-only, small ones and non-regular files
+ * (pipes, terminals) are read. Either way the text is followed by at
+ * least SLN_COMMON_SOURCE_PADDING zero bytes, so the lexer can look a
+ * few bytes ahead and run aligned vector loads without bounds checks.
+ */
+
+#ifndef SELENA_COMMON_SOURCE_H_
+#define SELENA_COMMON_SOURCE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <utils/allocation.h>
+
+/// @brief Zero bytes guaranteed after the text.
+#define SLN_COMMON_SOURCE_PADDING 64u
+
+/// @brief Files below this size are read instead of mapped.
+#define SLN_COMMON_SOURCE_MAP_THRESHOLD (64u * 1024u)
+
+/**
+ * @struct sln_common_source_t
+ * @brief Loaded source file.
+ */
+typedef struct {
+    const char* text;       /**< Contents, NUL-terminated and padded */
+    size_t len;             /**< Contents length */
+    void* region;           /**< Start of the mapping or buffer to release, NULL if in an arena */
+    size_t region_len;      /**< Mapping length, 0 for a heap buffer */
+    int error;              /**< errno of the failed load, 0 if none */
+} sln_common_source_t;
+
+/**
+ * @brief Loads a source file.
+ *
+ * @param[out] source loaded file; `error` is set on failure.
+ * @param[in] path file path.
+ * @returns false if the file cannot be opened, read or mapped.
+ */
+bool sln_common_source_load(sln_common_source_t* source, const char* path);
+
+/**
+ * @brief Loads a source file, reading small files into an arena.
+ *
+ * The text of a read file lives until the arena is reset; mapped files
+ * still need sln_common_source_free().
+ *
+ * @param[out] source loaded file; `error` is set on failure.
+ * @param[in] path file path.
+ * @param[in] arena arena for read files, NULL for the heap.
+ * @returns false if the file cannot be opened, read or mapped.
+ */
+bool sln_common_source_load_in(sln_common_source_t* source, const char* path, sln_utils_arena_t* arena);
+
+/**
+ * @brief Releases the file contents.
+ */
+void sln_common_source_free(sln_common_source_t* source);
+
+#endif // SELENA_COMMON_SOURCE_H_
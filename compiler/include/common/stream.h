@@ -0,0 +1,70 @@
+
+/**
+ * @file stream.h
+ * @brief Chunked input from a file descriptor.
+ *
+ * Keeps a sliding window over the input instead of the whole text:
+ * the owner reads fixed-size chunks at the end and drops consumed
+ * bytes at the front. The window is always NUL-terminated and padded,
+ * so the lexer scan kernels can run over it directly.
+ */
+
+#ifndef SELENA_COMMON_STREAM_H_
+#define SELENA_COMMON_STREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/// @brief Default number of bytes requested per read.
+#define SLN_COMMON_STREAM_CHUNK_SIZE (64u * 1024u)
+
+/**
+ * @struct sln_common_stream_t
+ * @brief Input window.
+ */
+typedef struct {
+    int fd;                 /**< Input descriptor, not owned */
+    char* data;             /**< Window, data[len] is always '\0' */
+    size_t len;             /**< Bytes in the window */
+    size_t cap;             /**< Window capacity, excluding padding */
+    size_t chunk_size;      /**< Bytes requested per read */
+    uint64_t base;          /**< Input offset of data[0] */
+    bool eof;               /**< The descriptor has no more data */
+    int error;              /**< errno of the failed read, 0 if none */
+} sln_common_stream_t;
+
+/**
+ * @brief Sets up a window over an open descriptor (e.g. 0 for stdin).
+ *
+ * @param[out] stream stream to initialize.
+ * @param[in] fd input descriptor; the caller closes it.
+ * @param[in] chunk_size bytes per read, SLN_COMMON_STREAM_CHUNK_SIZE if 0.
+ * @returns false on allocation failure.
+ */
+bool sln_common_stream_open_fd(sln_common_stream_t* stream, int fd, size_t chunk_size);
+
+/**
+ * @brief Reads the next chunk to the end of the window.
+ *
+ * The window grows only when the unconsumed bytes leave no room for a
+ * chunk, so its size stays bounded by the longest unconsumed run.
+ *
+ * @returns number of bytes read; 0 at end of input or on error
+ *          (see `eof` and `error`).
+ */
+size_t sln_common_stream_fill(sln_common_stream_t* stream);
+
+/**
+ * @brief Drops the first @p count bytes of the window.
+ *
+ * Pointers into the window are invalidated.
+ */
+void sln_common_stream_consume(sln_common_stream_t* stream, size_t count);
+
+/**
+ * @brief Frees the window. Does not close the descriptor.
+ */
+void sln_common_stream_close(sln_common_stream_t* stream);
+
+#endif // SELENA_COMMON_STREAM_H_
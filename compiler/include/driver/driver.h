@@ -0,0 +1,125 @@
+
+/**
+ * @file driver.h
+ * @brief Compilation driver for many input files.
+ *
+ * Every FILE and CODE argument is a unit. Units are loaded and lexed on
+ * a work-stealing thread pool; each worker reuses its own token stream
+ * and scratch arena from one unit to the next. A unit of a megabyte or
+ * more is lexed in parts, with idle workers helping (see
+ * sln_lex_generate_parallel()). Output and diagnostics of a unit are
+ * buffered and written to stdout/stderr in argument order, whichever
+ * worker finishes first.
+ *
+ * With a cache directory set, a unit whose text was lexed before
+ * without diagnostics is mapped from the token cache instead of being
+ * lexed (see lexer/lexer_cache.h), and fresh clean results are stored.
+ *
+ * With parsing on, the significant tokens of a unit are expanded into
+ * the worker's arena and parsed there (see parser/parser.h), with idle
+ * workers helping on the items of large units. In
+ * pipeline mode a unit missing from the cache is instead lexed on a
+ * thread of its own while the worker parses it (see lexer/lexer_pipe.h);
+ * such units have no token stream and are not stored in the cache.
+ *
+ * A FILE argument of "-" reads standard input, which is never cached.
+ * Without parsing it is lexed as it arrives by the pull lexer (see
+ * lexer/lexer_stream.h): each token goes to the token hook and only a
+ * window of the input stays resident. Such a unit is lexed on the
+ * calling thread once every earlier unit is written, while the pool goes
+ * on with later ones, and its output goes straight to stdout and stderr
+ * rather than being buffered. With parsing it is read whole first and
+ * compiled like a file.
+ *
+ * All units share one interner. Symbol ids therefore depend on the
+ * order in which workers reach a name; compare symbols by text across
+ * runs, not by id.
+ */
+
+#ifndef SELENA_DRIVER_H_
+#define SELENA_DRIVER_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <lexer/lexer.h>
+#include <lexer/lexer_tokens.h>
+#include <parser/parser.h>
+#include <utils/exit_codes.h>
+#include <utils/input_args.h>
+#include <utils/intern.h>
+
+/**
+ * @struct sln_driver_unit_t
+ * @brief One lexed input, as seen by the emit callback.
+ */
+typedef struct {
+    size_t index;                   /**< Position among the units */
+    const char* name;               /**< File path, or "<code>" */
+    const char* text;               /**< Source text */
+    const sln_lex_tokens_t* tokens; /**< Tokens, valid during the callback only; NULL if pipelined */
+    sln_utils_intern_t* symbols;    /**< Shared interner */
+    const sln_ast_t* ast;           /**< Syntax tree when parsing, else NULL; valid during the callback only */
+    sln_lex_error_t status;         /**< Lexer result */
+    sln_parse_error_t parse_status; /**< Parser result */
+    size_t streamed;                /**< Tokens passed to the token hook so far, 0 if not streamed */
+} sln_driver_unit_t;
+
+/**
+ * @brief Per-unit output hook, run on a worker thread.
+ *
+ * For a streamed unit it runs after the last token, on the thread and
+ * stream of the token hook.
+ *
+ * @param[in] unit lexed unit.
+ * @param[in] out buffered stream, written to stdout in unit order.
+ * @param[in] user sln_driver_options_t::user.
+ */
+typedef void (*sln_driver_emit_t)(const sln_driver_unit_t* unit, FILE* out, void* user);
+
+/**
+ * @brief Per-token output hook of a streamed unit, run on the thread calling sln_driver_run().
+ *
+ * A streamed unit has no text or token stream; its tokens come here
+ * one by one, ending with SLN_LEX_TOKEN_EOF, and the emit hook runs
+ * after the last one.
+ *
+ * @param[in] unit streamed unit; `streamed` is the index of the token.
+ * @param[in] window text the token span points into, valid during the call only.
+ * @param[in] token lexed token.
+ * @param[in] out stdout, every earlier unit already written to it.
+ * @param[in] user sln_driver_options_t::user.
+ */
+typedef void (*sln_driver_token_t)(const sln_driver_unit_t* unit, const char* window,
+                                   const sln_lex_token_t* token, FILE* out, void* user);
+
+/**
+ * @struct sln_driver_options_t
+ * @brief Driver settings.
+ */
+typedef struct {
+    size_t jobs;            /**< Worker threads, 0 for one per online CPU */
+    sln_driver_emit_t emit; /**< Output hook, may be NULL */
+    sln_driver_token_t token; /**< Token hook of streamed units, may be NULL */
+    void* user;             /**< Passed to emit */
+    const char* cache_dir;  /**< Token cache directory, NULL to always lex */
+    bool parse;             /**< Parse every unit after lexing it */
+    bool pipeline;          /**< When parsing, lex on another thread while the parser runs */
+} sln_driver_options_t;
+
+/**
+ * @brief Loads and lexes, and optionally parses, every FILE and CODE argument.
+ *
+ * @param[in] args parsed arguments.
+ * @param[in] arg_count number of arguments.
+ * @param[in] symbols interner shared by all units.
+ * @param[in] options driver settings.
+ * @returns SLN_EXIT_FAILURE if any unit failed to load, lex or parse,
+ *          SLN_EXIT_FAILURE_INTERNAL if the pool could not start.
+ */
+sln_exit_code_t sln_driver_run(const sln_input_arg_t* args, size_t arg_count,
+                               sln_utils_intern_t* symbols,
+                               const sln_driver_options_t* options);
+
+#endif // SELENA_DRIVER_H_
@@ -14,6 +14,9 @@
 #include <stddef.h>
 
 #include "lexer_errors.h"
+#include "lexer_keywords.h"
+#include <utils/intern.h>
+#include <utils/thread_pool.h>
 
 /**
  * @enum sln_lex_token_type_t
@@ -26,7 +29,7 @@ typedef enum {
     SLN_LEX_TOKEN_EOF,        /**< End of file */
     SLN_LEX_TOKEN_EOL,        /**< End of line */
     SLN_LEX_TOKEN_COMMENT,    /**< Comments # and ## ## */
-    SLN_LEX_TOKEN_UNKNOWN,    /**< Unknown/invalid token */
+    SLN_LEX_TOKEN_UNKNOWN,    /**< Invalid bytes, or the unterminated string or char it starts */
 
     // --- Identifiers & literals ---
     SLN_LEX_TOKEN_IDENTIFIER, /**< User-defined names */
@@ -36,37 +39,9 @@ typedef enum {
     SLN_LEX_TOKEN_STRING_LITERAL,
 
     // --- Keywords ---
-    SLN_LEX_TOKEN_KW_NAMESPACE,
-    SLN_LEX_TOKEN_KW_TYPE,
-    SLN_LEX_TOKEN_KW_STRUCT,
-    SLN_LEX_TOKEN_KW_ENUM,
-    SLN_LEX_TOKEN_KW_USE,
-    SLN_LEX_TOKEN_KW_VAR,
-    SLN_LEX_TOKEN_KW_RETURN,
-    SLN_LEX_TOKEN_KW_FOR,
-    SLN_LEX_TOKEN_KW_WHILE,
-    SLN_LEX_TOKEN_KW_IF,
-    SLN_LEX_TOKEN_KW_ELSE,
-    SLN_LEX_TOKEN_KW_SWITCH,
-    SLN_LEX_TOKEN_KW_CASE,
-    SLN_LEX_TOKEN_KW_DEFAULT,
-    SLN_LEX_TOKEN_KW_BREAK,
-    SLN_LEX_TOKEN_KW_CONTINUE,
-
-    SLN_LEX_TOKEN_KW_NIL,
-    SLN_LEX_TOKEN_KW_I8,
-    SLN_LEX_TOKEN_KW_I16,
-    SLN_LEX_TOKEN_KW_I32,
-    SLN_LEX_TOKEN_KW_I64,
-    SLN_LEX_TOKEN_KW_U8,
-    SLN_LEX_TOKEN_KW_U16,
-    SLN_LEX_TOKEN_KW_U32,
-    SLN_LEX_TOKEN_KW_U64,
-    SLN_LEX_TOKEN_KW_BLN,
-    SLN_LEX_TOKEN_KW_USIZE,
-    SLN_LEX_TOKEN_KW_STR,
-    SLN_LEX_TOKEN_KW_MAIN,
-    SLN_LEX_TOKEN_KW_ARGS,
+#define _SLN_LEX_KEYWORD_TOKEN(name, spelling) SLN_LEX_TOKEN_KW_##name,
+    SLN_LEX_KEYWORDS(_SLN_LEX_KEYWORD_TOKEN)
+#undef _SLN_LEX_KEYWORD_TOKEN
 
     // --- Operators ---
     // Arithmetic
@@ -136,14 +111,31 @@ typedef enum {
     _SLN_LEX_TOKEN_COUNT       /**< Number of tokens */
 } sln_lex_token_type_t;
 
+/// @brief Diagnostics after which lexing of a text stops early.
+#define SLN_LEX_MAX_ERRORS 100
+
+/**
+ * @struct sln_lex_span_t
+ * @brief Byte range of a token in the source text.
+ */
+typedef struct {
+    uint32_t offset;        /**< Offset of the first byte */
+    uint32_t length;        /**< Length in bytes */
+} sln_lex_span_t;
+
 /**
  * @struct sln_lex_token_t
  * @brief Represents a single token with optional data.
+ *
+ * Identifiers and string literals carry the interned symbol of their
+ * name or decoded value, comments carry no payload: their text is
+ * the span in the source.
  */
 typedef struct {
     sln_lex_token_type_t type;
+    sln_lex_span_t span;    /**< Whole lexeme, including quotes and comment markers */
     union {
-        char* cstr;         /**< For identifiers, strings (dynamically allocated) */
+        sln_utils_sym_t sym; /**< For identifiers, strings (interned) */
         uint64_t u64;       /**< For unsigned literals */
         int64_t i64;        /**< For signed literals */
         long double lfloat; /**< For floating literals */
@@ -156,6 +148,10 @@ typedef struct {
 typedef struct {
     sln_lex_token_t* tokens; /**< Token array */
     size_t len;              /**< Number of tokens */
+    size_t unterminated;     /**< No token before this index is an unterminated
+                                  string: the first one's index, or len if there
+                                  is none. The lexer keeps it exact; 0 is always
+                                  safe for buffers built otherwise. */
 } sln_lex_token_buffer_t;
 
 /**
@@ -163,14 +159,182 @@ typedef struct {
  *
  * @param text Input source string
  * @param buffer Output token buffer
+ * @param symbols Interner for identifiers and string literals
  * @param error_stream Error reporting stream
- * @return Lexer error code
+ * @return Lexer error code. Source diagnostics (e.g. SLN_LEX_INTEGER_OVERFLOW)
+ *         are printed to error_stream with their line and column, and the
+ *         first one is returned, but the buffer still holds the full token
+ *         stream and must be freed. Lines are only indexed once a
+ *         diagnostic needs them. After SLN_LEX_MAX_ERRORS diagnostics
+ *         lexing stops, and EOF is placed where it stopped.
  */
 extern sln_lex_error_t sln_lex_generate(
     const char* text,
     sln_lex_token_buffer_t* buffer,
+    sln_utils_intern_t* symbols,
+    FILE* error_stream);
+
+/**
+ * @struct sln_lex_trivia_item_t
+ * @brief Line break or comment set aside by sln_lex_generate_trivia().
+ */
+typedef struct {
+    uint32_t token;             /**< Index of the significant token that follows it */
+    sln_lex_token_type_t type;  /**< SLN_LEX_TOKEN_EOL or SLN_LEX_TOKEN_COMMENT */
+    sln_lex_span_t span;
+} sln_lex_trivia_item_t;
+
+/**
+ * @struct sln_lex_trivia_t
+ * @brief Trivia of a text in source order.
+ */
+typedef struct {
+    sln_lex_trivia_item_t* items;
+    size_t len;
+} sln_lex_trivia_t;
+
+/**
+ * @brief Lexical analysis that keeps line breaks and comments apart.
+ *
+ * The buffer gets only significant tokens, ending with EOF, for the
+ * parser; line breaks and comments go to @p trivia, keyed by the index
+ * of the token they precede. Otherwise as sln_lex_generate().
+ *
+ * @param text Input source string
+ * @param buffer Output token buffer
+ * @param trivia Output trivia, freed with sln_lex_free_trivia()
+ * @param symbols Interner for identifiers and string literals
+ * @param error_stream Error reporting stream
+ * @return Lexer error code, as sln_lex_generate()
+ */
+extern sln_lex_error_t sln_lex_generate_trivia(
+    const char* text,
+    sln_lex_token_buffer_t* buffer,
+    sln_lex_trivia_t* trivia,
+    sln_utils_intern_t* symbols,
     FILE* error_stream);
 
+/**
+ * @brief Trivia in front of the token at @p index.
+ *
+ * @param trivia Trivia from sln_lex_generate_trivia()
+ * @param index Token index
+ * @param count Number of items returned
+ * @return First item, valid for @p count items
+ */
+extern const sln_lex_trivia_item_t* sln_lex_trivia_before(
+    const sln_lex_trivia_t* trivia,
+    size_t index,
+    size_t* count);
+
+extern void sln_lex_free_trivia(sln_lex_trivia_t* trivia);
+
+/**
+ * @brief Lexical analysis of input text on several threads.
+ *
+ * The text is split at line starts and the parts are lexed at once;
+ * parts starting inside a string or block comment are fixed up when
+ * the results are joined. Tokens, symbol ids, diagnostics and the
+ * return code are identical to sln_lex_generate(), which is used
+ * directly for small texts.
+ *
+ * With a pool the parts go to its workers and the caller, which may be
+ * one of them, takes parts too; without one a thread is started per part.
+ *
+ * @param text Input source string
+ * @param buffer Output token buffer
+ * @param symbols Interner for identifiers and string literals
+ * @param error_stream Error reporting stream
+ * @param threads Maximum number of parts lexed at once, including the caller's
+ * @param pool Pool to lex the parts on, or NULL
+ * @return Lexer error code, as sln_lex_generate()
+ */
+extern sln_lex_error_t sln_lex_generate_parallel(
+    const char* text,
+    sln_lex_token_buffer_t* buffer,
+    sln_utils_intern_t* symbols,
+    FILE* error_stream,
+    size_t threads,
+    sln_utils_pool_t* pool);
+
+/**
+ * @struct sln_lex_edit_t
+ * @brief Replacement of a byte range of the text by new bytes.
+ */
+typedef struct {
+    size_t offset;          /**< First replaced byte */
+    size_t removed;         /**< Bytes replaced in the old text */
+    size_t inserted;        /**< Bytes in their place in the new text */
+} sln_lex_edit_t;
+
+/**
+ * @struct sln_lex_relexed_t
+ * @brief Tokens sln_lex_relex() replaced; the ones after them only moved.
+ */
+typedef struct {
+    size_t first;           /**< Index of the first replaced token */
+    size_t removed;         /**< Number of old tokens replaced */
+    size_t inserted;        /**< Number of new tokens in their place */
+} sln_lex_relexed_t;
+
+/**
+ * @brief Updates the tokens of a text after an edit.
+ *
+ * Only the edited region is lexed again. Tokens before it are kept,
+ * and lexing stops at the first token after the edit that starts where
+ * an old token started: the lexer carries no state between tokens, so
+ * the old tokens from there on are reused with shifted offsets. Edits
+ * that open or close a string or block comment just lex further.
+ * Diagnostics are printed only for the tokens lexed again, with no
+ * error limit; a buffer that sln_lex_generate() cut short at
+ * SLN_LEX_MAX_ERRORS is lexed again in full.
+ *
+ * @param text New source string
+ * @param buffer Tokens of the old text from sln_lex_generate(), updated in place
+ * @param edit Edit turning the old text into @p text; if it does not
+ *        match the buffer, the whole text is lexed again
+ * @param symbols Interner the buffer was lexed with
+ * @param error_stream Error reporting stream
+ * @param relexed Replaced tokens, may be NULL
+ * @return Lexer error code, as sln_lex_generate(). On allocation
+ *         failure the buffer is freed.
+ */
+extern sln_lex_error_t sln_lex_relex(
+    const char* text,
+    sln_lex_token_buffer_t* buffer,
+    const sln_lex_edit_t* edit,
+    sln_utils_intern_t* symbols,
+    FILE* error_stream,
+    sln_lex_relexed_t* relexed);
+
 extern void sln_lex_free_tokens(sln_lex_token_buffer_t* buffer);
 
+/**
+ * @brief Text of an identifier, string literal or comment.
+ *
+ * For identifiers this is the lexeme itself, for string literals
+ * the raw content between the quotes (the decoded value is the
+ * interned `data.sym`), and for comments the content without the
+ * `#`/`##` markers and the trailing newline.
+ *
+ * @param[in] text Source string the token was produced from
+ * @param[in] token Token
+ * @param[out] out_len Length of the returned text
+ * @return Pointer to the text (not NUL-terminated), or NULL for
+ *         tokens without text
+ */
+extern const char* sln_lex_token_text(
+    const char* text,
+    const sln_lex_token_t* token,
+    size_t* out_len);
+
+/**
+ * @brief Keyword spelled by a lexeme, through the lexer's perfect hash.
+ *
+ * @param[in] str Lexeme, not necessarily NUL-terminated
+ * @param[in] len Length of the lexeme
+ * @return The SLN_LEX_TOKEN_KW_ type, or SLN_LEX_TOKEN_UNKNOWN
+ */
+extern sln_lex_token_type_t sln_lex_keyword_type(const char* str, size_t len);
+
 #endif // SELENA_LEXER_H_
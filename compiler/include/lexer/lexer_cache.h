@@ -0,0 +1,90 @@
+/**
+ * @file lexer_cache.h
+ * @brief On-disk cache of token streams, keyed by source content.
+ *
+ * A cached file is the sln_lex_tokens_t of one text, written as an
+ * image whose arrays are mapped back as they are: kinds, offsets,
+ * payload bitmap, payload entries, float values and trivia. Symbols cannot be
+ * stored as ids, which only mean something to one interner, so the
+ * image carries its own string pool; on load each pool string is
+ * interned once and the payload values of identifiers and strings are
+ * rewritten in a private copy of their pages. Everything else is read
+ * from the page cache without copying.
+ *
+ * Entries are named by a 64-bit hash of the text. The image header
+ * also records the compiler version, the format, the text length and
+ * the host layout, and a load checks every index in the image before
+ * the stream is handed out; any mismatch is a miss. Only texts that
+ * lexed without diagnostics are stored, so a hit has nothing to report.
+ *
+ * An entry is written to a temporary file in the cache directory and
+ * renamed into place, so processes sharing the directory see either
+ * no entry or a whole one.
+ */
+
+#ifndef SELENA_LEXER_CACHE_H_
+#define SELENA_LEXER_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <lexer/lexer_tokens.h>
+#include <utils/intern.h>
+
+/// @brief Image format; bump when the layout or the token encoding changes.
+#define SLN_LEX_CACHE_FORMAT 2u
+
+#ifndef SLN_VERSION
+#   define SLN_VERSION "dev"
+#endif
+
+/**
+ * @struct sln_lex_cache_entry_t
+ * @brief Token stream mapped from the cache.
+ */
+typedef struct {
+    sln_lex_tokens_t tokens;    /**< Read-only view; do not push, clear or free it */
+    void* region;               /**< Mapping, NULL if none */
+    size_t region_len;
+} sln_lex_cache_entry_t;
+
+/**
+ * @brief Content hash naming the cache entry of a text.
+ */
+uint64_t sln_lex_cache_key(const char* text, size_t len);
+
+/**
+ * @brief Maps the cached tokens of a text.
+ *
+ * @param[in] dir cache directory.
+ * @param[in] key sln_lex_cache_key() of the text.
+ * @param[in] text_len length of the text.
+ * @param[in] symbols interner the stream's symbols are added to.
+ * @param[out] entry mapped stream; release it with sln_lex_cache_release().
+ * @returns false on a miss, including unreadable or mismatched entries.
+ */
+bool sln_lex_cache_load(const char* dir, uint64_t key, size_t text_len,
+                        sln_utils_intern_t* symbols, sln_lex_cache_entry_t* entry);
+
+/**
+ * @brief Stores the tokens of a text that lexed without diagnostics.
+ *
+ * Creates the directory if missing. Failures leave no entry behind.
+ *
+ * @param[in] dir cache directory.
+ * @param[in] key sln_lex_cache_key() of the text.
+ * @param[in] text_len length of the text.
+ * @param[in] tokens stream to store.
+ * @param[in] symbols interner the stream's symbols come from.
+ * @returns false if the entry could not be written.
+ */
+bool sln_lex_cache_store(const char* dir, uint64_t key, size_t text_len,
+                         const sln_lex_tokens_t* tokens, const sln_utils_intern_t* symbols);
+
+/**
+ * @brief Unmaps a stream returned by sln_lex_cache_load().
+ */
+void sln_lex_cache_release(sln_lex_cache_entry_t* entry);
+
+#endif // SELENA_LEXER_CACHE_H_
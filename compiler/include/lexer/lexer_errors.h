@@ -9,11 +9,16 @@ typedef enum {
     SLN_LEX_NO_FILE,
     SLN_LEX_NO_ERROR_STREAM,
     SLN_LEX_NO_TOKEN_BUFFER,
+    SLN_LEX_NO_SYMBOL_TABLE,
     SLN_LEX_INVALID_TOKEN,
     SLN_LEX_UNTERMINATED_STRING,
     SLN_LEX_UNTERMINATED_CHAR,
     SLN_LEX_INVALID_ESCAPE_SEQUENCE,
     SLN_LEX_ALLOCATION_FAILED,
+    SLN_LEX_SOURCE_TOO_LARGE,
+    SLN_LEX_INTEGER_OVERFLOW,
+    SLN_LEX_READ_FAILED,
+    SLN_LEX_INVALID_UTF8,
 } sln_lex_error_t;
 
 #endif // SELENA_LEXER_ERRORS_H_
\ No newline at end of file
@@ -0,0 +1,67 @@
+
+/**
+ * @file lexer_keywords.h
+ * @brief The single list of Selena keywords.
+ *
+ * The list expands into the keyword part of sln_lex_token_type_t and
+ * is read by the lexer table generator (tools/lexgen.c), which builds
+ * a perfect hash over it at build time. Add new keywords here only.
+ */
+
+#ifndef SELENA_LEXER_KEYWORDS_H_
+#define SELENA_LEXER_KEYWORDS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief X(NAME, "spelling") for every keyword, in token order.
+ */
+#define SLN_LEX_KEYWORDS(X) \
+    X(NAMESPACE, "namespace") \
+    X(TYPE,      "type")      \
+    X(STRUCT,    "struct")    \
+    X(ENUM,      "enum")      \
+    X(USE,       "use")       \
+    X(VAR,       "var")       \
+    X(RETURN,    "return")    \
+    X(FOR,       "for")       \
+    X(WHILE,     "while")     \
+    X(IF,        "if")        \
+    X(ELSE,      "else")      \
+    X(SWITCH,    "switch")    \
+    X(CASE,      "case")      \
+    X(DEFAULT,   "default")   \
+    X(BREAK,     "break")     \
+    X(CONTINUE,  "continue")  \
+                              \
+    X(NIL,       "nil")       \
+    X(I8,        "i8")        \
+    X(I16,       "i16")       \
+    X(I32,       "i32")       \
+    X(I64,       "i64")       \
+    X(U8,        "u8")        \
+    X(U16,       "u16")       \
+    X(U32,       "u32")       \
+    X(U64,       "u64")       \
+    X(BLN,       "bln")       \
+    X(USIZE,     "usize")     \
+    X(STR,       "str")       \
+    X(MAIN,      "MAIN")      \
+    X(ARGS,      "ARGS")
+
+/**
+ * @brief Key of a candidate keyword for the perfect hash.
+ *
+ * Uses the length and the first, middle and last bytes, all of which
+ * the scanner has just read. The generator fails if two keywords
+ * share a key.
+ */
+static inline uint32_t sln_lex_keyword_key(const char* str, size_t len) {
+    return (uint32_t)(uint8_t)str[0]
+         | (uint32_t)(uint8_t)str[len / 2] << 8
+         | (uint32_t)(uint8_t)str[len - 1] << 16
+         | (uint32_t)len << 24;
+}
+
+#endif // SELENA_LEXER_KEYWORDS_H_
@@ -0,0 +1,58 @@
+/**
+ * @file lexer_lines.h
+ * @brief Line/column lookup for byte offsets of a source text.
+ *
+ * Tokens only carry byte offsets. The table of line starts is built
+ * on the first lookup, so texts without diagnostics never pay for it.
+ */
+
+#ifndef SELENA_LEXER_LINES_H_
+#define SELENA_LEXER_LINES_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @struct sln_lex_location_t
+ * @brief Position in a text, both counted from 1.
+ */
+typedef struct {
+    uint32_t line;
+    uint32_t column;        /**< In bytes */
+} sln_lex_location_t;
+
+/**
+ * @struct sln_lex_lines_t
+ * @brief Line starts of a text, found when first needed.
+ */
+typedef struct {
+    const char* text;
+    uint32_t* starts;       /**< Offset of every line start, NULL until built */
+    size_t count;
+} sln_lex_lines_t;
+
+/**
+ * @brief Prepares a table for a NUL-terminated text; nothing is scanned yet.
+ *
+ * @param[out] lines table to set up.
+ * @param[in] text text, at most UINT32_MAX bytes, must outlive the table.
+ */
+void sln_lex_lines_init(sln_lex_lines_t* lines, const char* text);
+
+/**
+ * @brief Line and column of a byte offset. Lines end at '\n'.
+ *
+ * @param[in] lines table, built by the first call.
+ * @param[in] offset byte offset, at most the text length.
+ * @param[out] location position of the offset.
+ * @returns false if the table cannot be allocated.
+ */
+bool sln_lex_lines_locate(sln_lex_lines_t* lines, size_t offset, sln_lex_location_t* location);
+
+/**
+ * @brief Frees the table.
+ */
+void sln_lex_lines_free(sln_lex_lines_t* lines);
+
+#endif // SELENA_LEXER_LINES_H_
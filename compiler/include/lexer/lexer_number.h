@@ -0,0 +1,28 @@
+
+/**
+ * @file lexer_number.h
+ * @brief Conversion of decimal floating literals.
+ *
+ * Built without fast-math so that the fast path stays exact: the
+ * result is always the correctly rounded long double.
+ */
+
+#ifndef SELENA_LEXER_NUMBER_H_
+#define SELENA_LEXER_NUMBER_H_
+
+#include <stddef.h>
+
+/**
+ * @brief Converts a scanned decimal float literal.
+ *
+ * Literals whose significand and power of ten are both exact in a
+ * long double take one multiplication or division, anything else
+ * falls back to strtold() on the source text.
+ *
+ * @param[in] lexeme literal of the form `digits[.digits][(e|E)[+|-]digits]`.
+ * @param[in] len literal length; the byte after it must not continue the literal.
+ * @return correctly rounded value.
+ */
+long double sln_lex_decimal_float(const char* lexeme, size_t len);
+
+#endif // SELENA_LEXER_NUMBER_H_
@@ -0,0 +1,67 @@
+
+/**
+ * @file lexer_operators.h
+ * @brief Spellings of Selena operators, brackets and separators.
+ *
+ * Read by the lexer table generator (tools/lexgen.c), which turns the
+ * list into the operator state-transition table. Every token between
+ * SLN_LEX_TOKEN_PLUS and SLN_LEX_TOKEN_SEMICOLON must appear here once.
+ */
+
+#ifndef SELENA_LEXER_OPERATORS_H_
+#define SELENA_LEXER_OPERATORS_H_
+
+/**
+ * @brief X(NAME, "spelling") for every operator, in token order.
+ */
+#define SLN_LEX_OPERATORS(X)          \
+    X(PLUS,           "+")            \
+    X(MINUS,          "-")            \
+    X(STAR,           "*")            \
+    X(SLASH,          "/")            \
+    X(PERCENT,        "%")            \
+    X(INCREMENT,      "++")           \
+    X(DECREMENT,      "--")           \
+    X(AMP,            "&")            \
+    X(PIPE,           "|")            \
+    X(CARET,          "^")            \
+    X(TILDE,          "~")            \
+    X(LSHIFT,         "<<")           \
+    X(RSHIFT,         ">>")           \
+    X(BANG,           "!")            \
+    X(AND_AND,        "&&")           \
+    X(OR_OR,          "||")           \
+    X(EQ,             "==")           \
+    X(NE,             "!=")           \
+    X(LT,             "<")            \
+    X(GT,             ">")            \
+    X(LE,             "<=")           \
+    X(GE,             ">=")           \
+    X(ASSIGN,         "=")            \
+    X(PLUS_ASSIGN,    "+=")           \
+    X(MINUS_ASSIGN,   "-=")           \
+    X(STAR_ASSIGN,    "*=")           \
+    X(SLASH_ASSIGN,   "/=")           \
+    X(PERCENT_ASSIGN, "%=")           \
+    X(AMP_ASSIGN,     "&=")           \
+    X(PIPE_ASSIGN,    "|=")           \
+    X(CARET_ASSIGN,   "^=")           \
+    X(LSHIFT_ASSIGN,  "<<=")          \
+    X(RSHIFT_ASSIGN,  ">>=")          \
+    X(COLON,          ":")            \
+    X(DOUBLE_COLON,   "::")           \
+    X(AT,             "@")            \
+    X(ARROW,          "->")           \
+    X(COMMA,          ",")            \
+    X(DOT,            ".")            \
+    X(ELLIPSIS,       "...")          \
+    X(QUESTION,       "?")            \
+    X(LPAREN,         "(")            \
+    X(RPAREN,         ")")            \
+    X(LBRACE,         "{")            \
+    X(RBRACE,         "}")            \
+    X(LBRACKET,       "[")            \
+    X(RBRACKET,       "]")            \
+    X(SEMICOLON,      ";")
+
+#endif // SELENA_LEXER_OPERATORS_H_
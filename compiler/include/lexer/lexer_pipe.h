@@ -0,0 +1,78 @@
+/**
+ * @file lexer_pipe.h
+ * @brief Lexer running ahead of its consumer on another thread.
+ *
+ * The lexer thread fills fixed-size batches of tokens in a bounded
+ * single-producer/single-consumer ring (utils/spsc_ring.h), so a later
+ * stage can work on the first tokens while the rest of the text is
+ * still being lexed. When the consumer falls behind the lexer waits,
+ * so at most SLN_LEX_PIPE_DEPTH batches are in memory at once.
+ *
+ * Tokens and diagnostics are those of sln_lex_generate_trivia(): line
+ * breaks and comments are dropped, as the parser does not read them.
+ * The lexer's diagnostics are held back and printed by
+ * sln_lex_pipe_close(), so they never interleave with the consumer's.
+ */
+
+#ifndef SELENA_LEXER_PIPE_H_
+#define SELENA_LEXER_PIPE_H_
+
+#include <stdio.h>
+
+#include "lexer.h"
+
+/// @brief Tokens per batch (32 KiB).
+#define SLN_LEX_PIPE_BATCH 1024
+
+/// @brief Batches in flight; a power of two.
+#define SLN_LEX_PIPE_DEPTH 8
+
+/**
+ * @struct sln_lex_batch_t
+ * @brief Consecutive tokens; the last batch ends with SLN_LEX_TOKEN_EOF.
+ */
+typedef struct {
+    size_t len;
+    sln_lex_token_t tokens[SLN_LEX_PIPE_BATCH];
+} sln_lex_batch_t;
+
+typedef struct sln_lex_pipe sln_lex_pipe_t;
+
+/**
+ * @brief Starts lexing @p text on a new thread.
+ *
+ * @param text Input source string; must stay valid until the pipe is closed
+ * @param symbols Interner for identifiers and string literals
+ * @param error_stream Error reporting stream
+ * @param pipe Output pipe, to be closed with sln_lex_pipe_close()
+ * @return SLN_LEX_OK, an argument error, SLN_LEX_SOURCE_TOO_LARGE or
+ *         SLN_LEX_ALLOCATION_FAILED (also when no thread can be started)
+ */
+extern sln_lex_error_t sln_lex_pipe_open(
+    const char* text,
+    sln_utils_intern_t* symbols,
+    FILE* error_stream,
+    sln_lex_pipe_t** pipe);
+
+/**
+ * @brief Next batch, waiting for the lexer if needed.
+ *
+ * The previous batch goes back to the lexer and must not be used any more.
+ *
+ * @param pipe Pipe
+ * @return Batch, or NULL after the last one
+ */
+extern const sln_lex_batch_t* sln_lex_pipe_next(sln_lex_pipe_t* pipe);
+
+/**
+ * @brief Stops the lexer if still running, prints its diagnostics and frees the pipe.
+ *
+ * May be called before every batch was read; only the diagnostics of
+ * the text lexed so far are printed then.
+ *
+ * @param pipe Pipe from sln_lex_pipe_open()
+ * @return Lexer error code, as sln_lex_generate()
+ */
+extern sln_lex_error_t sln_lex_pipe_close(sln_lex_pipe_t* pipe);
+
+#endif // SELENA_LEXER_PIPE_H_
@@ -0,0 +1,56 @@
+
+/**
+ * @file lexer_scan.h
+ * @brief Vectorized byte-search kernels used by the lexer.
+ *
+ * Every kernel takes a pointer into a NUL-terminated text and returns
+ * a pointer to the first byte that stops the scan; the terminating
+ * NUL always stops it; find_invalid_utf8 scans a bounded range of
+ * such a text instead. SSE2 and AVX2 versions are picked at run time
+ * by sln_lex_scan_init(), with a scalar fallback elsewhere.
+ *
+ * Vector kernels only issue loads aligned to the vector width, so they
+ * never cross into a page that does not contain part of the text.
+ */
+
+#ifndef SELENA_LEXER_SCAN_H_
+#define SELENA_LEXER_SCAN_H_
+
+#include <stddef.h>
+
+/**
+ * @struct sln_lex_scan_kernels_t
+ * @brief Scanning kernels of one instruction set.
+ */
+typedef struct {
+    const char* (*skip_blanks)(const char* p); /**< First byte other than ' ' and '\t' */
+    const char* (*find_eol)(const char* p);    /**< First '\n' */
+    const char* (*find_hash)(const char* p);   /**< First '#' */
+    const char* (*find_quote)(const char* p);  /**< First '"' or '\\' */
+    /** First byte of an ill-formed UTF-8 sequence in [p, end), or `end`; `p` starts a sequence */
+    const char* (*find_invalid_utf8)(const char* p, const char* end);
+    const char* name;                          /**< Instruction set name */
+} sln_lex_scan_kernels_t;
+
+/// @brief Kernels in use. Valid (scalar) before sln_lex_scan_init() as well.
+extern sln_lex_scan_kernels_t sln_lex_scan;
+
+/**
+ * @brief Selects the best kernels for the running CPU.
+ *
+ * Thread-safe and idempotent; sln_lex_generate() calls it on entry.
+ */
+void sln_lex_scan_init(void);
+
+/**
+ * @brief Every kernel set the running CPU supports, scalar first.
+ *
+ * Lets tests and benchmarks call each set directly rather than the
+ * one sln_lex_scan_init() picked. Calls sln_lex_scan_init().
+ *
+ * @param[out] count number of sets.
+ * @return the sets, valid for the life of the process.
+ */
+const sln_lex_scan_kernels_t* sln_lex_scan_sets(size_t* count);
+
+#endif // SELENA_LEXER_SCAN_H_
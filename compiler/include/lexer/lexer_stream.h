@@ -0,0 +1,77 @@
+
+/**
+ * @file lexer_stream.h
+ * @brief Pull lexer over chunked input.
+ *
+ * Produces the same tokens as sln_lex_generate() one at a time, while
+ * only a window of the input is resident. A token that reaches the end
+ * of the window (an open string or block comment, a possibly longer
+ * operator or identifier) is held back until the next chunk arrives,
+ * so chunk boundaries never change the result.
+ */
+
+#ifndef SELENA_LEXER_STREAM_H_
+#define SELENA_LEXER_STREAM_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+#include <common/stream.h>
+
+/**
+ * @struct sln_lex_stream_t
+ * @brief State of a pull lexer.
+ */
+typedef struct {
+    sln_common_stream_t* input;
+    sln_utils_intern_t* symbols;
+    FILE* error_stream;
+    size_t pos;                 /**< Next unlexed byte of the window */
+    sln_lex_error_t status;     /**< First source diagnostic reported */
+    size_t errors_left;         /**< Diagnostics until the lexer stops */
+    bool done;                  /**< SLN_LEX_TOKEN_EOF has been returned */
+} sln_lex_stream_t;
+
+/**
+ * @brief Sets up a pull lexer.
+ *
+ * @param lexer Lexer to initialize
+ * @param input Opened input window
+ * @param symbols Interner for identifiers and string literals
+ * @param error_stream Error reporting stream
+ * @return Lexer error code
+ */
+extern sln_lex_error_t sln_lex_stream_init(
+    sln_lex_stream_t* lexer,
+    sln_common_stream_t* input,
+    sln_utils_intern_t* symbols,
+    FILE* error_stream);
+
+/**
+ * @brief Lexes the next token.
+ *
+ * The token span is relative to sln_lex_stream_window() and stays
+ * valid until the next call. After SLN_LEX_TOKEN_EOF every call
+ * returns SLN_LEX_TOKEN_EOF again.
+ *
+ * @param lexer Lexer
+ * @param token Output token
+ * @param out_offset Input offset of the token (may be NULL)
+ * @return SLN_LEX_OK, SLN_LEX_READ_FAILED or SLN_LEX_ALLOCATION_FAILED.
+ *         Source diagnostics are printed and kept in `status`.
+ */
+extern sln_lex_error_t sln_lex_stream_next(
+    sln_lex_stream_t* lexer,
+    sln_lex_token_t* token,
+    uint64_t* out_offset);
+
+/**
+ * @brief Current window; the text token spans point into.
+ */
+static inline const char* sln_lex_stream_window(const sln_lex_stream_t* lexer) {
+    return lexer->input->data;
+}
+
+#endif // SELENA_LEXER_STREAM_H_
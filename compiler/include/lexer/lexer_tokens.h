@@ -0,0 +1,157 @@
+
+/**
+ * @file lexer_tokens.h
+ * @brief Struct-of-arrays token stream.
+ *
+ * A compact alternative to sln_lex_token_buffer_t. Every token costs a
+ * one-byte kind and a four-byte source offset. Only tokens whose length
+ * does not follow from their kind (identifiers, literals, runs of
+ * invalid bytes) get a payload entry with the length and value.
+ * A bitmap with per-block ranks maps a token index to its payload
+ * entry in constant time.
+ *
+ * Line breaks and comments are kept apart as trivia, keyed by the token
+ * they precede (see sln_lex_trivia_before()), so the stream itself holds
+ * only the significant tokens the parser reads.
+ *
+ * Read tokens through the accessors below, not the arrays: the layout
+ * may change.
+ */
+
+#ifndef SELENA_LEXER_TOKENS_H_
+#define SELENA_LEXER_TOKENS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+
+/// @brief Tokens per payload bitmap word.
+#define SLN_LEX_TOKENS_BLOCK 64u
+
+/**
+ * @struct sln_lex_tokens_t
+ * @brief Token stream, one array per field.
+ */
+typedef struct {
+    uint8_t* kinds;             /**< sln_lex_token_type_t of every token */
+    uint32_t* offsets;          /**< Source offset of every token */
+    uint64_t* payload_bits;     /**< Bit i: token i has a payload entry */
+    uint32_t* payload_rank;     /**< Payload entries before each bitmap word */
+    uint32_t* payload_lengths;  /**< Span length per payload entry */
+    uint64_t* payload_values;   /**< Symbol, integer, or index into floats */
+    long double* floats;        /**< Values of float literals */
+    sln_lex_trivia_t trivia;    /**< Line breaks and comments */
+    size_t len;                 /**< Number of tokens */
+    size_t payload_len;         /**< Number of payload entries */
+    size_t floats_len;          /**< Number of float literals */
+    size_t cap;
+    size_t payload_cap;
+    size_t floats_cap;
+    size_t trivia_cap;
+} sln_lex_tokens_t;
+
+/// @brief Lengths of the kinds that do not need a payload entry.
+extern const uint8_t sln_lex_token_fixed_length[_SLN_LEX_TOKEN_COUNT];
+
+/**
+ * @brief Lexical analysis of input text into a struct-of-arrays stream.
+ *
+ * Same tokens, trivia, diagnostics and return codes as
+ * sln_lex_generate_trivia().
+ *
+ * @param text Input source string
+ * @param tokens Output stream, must be zero-initialized, cleared or freed
+ * @param symbols Interner for identifiers and string literals
+ * @param error_stream Error reporting stream
+ * @return Lexer error code
+ */
+extern sln_lex_error_t sln_lex_generate_tokens(
+    const char* text,
+    sln_lex_tokens_t* tokens,
+    sln_utils_intern_t* symbols,
+    FILE* error_stream);
+
+/**
+ * @brief Appends one token; a line break or comment goes to the trivia.
+ * @returns false on allocation failure.
+ */
+extern bool sln_lex_tokens_push(sln_lex_tokens_t* tokens, const sln_lex_token_t* token);
+
+extern void sln_lex_tokens_free(sln_lex_tokens_t* tokens);
+
+/**
+ * @brief Empties the stream but keeps its arrays for reuse.
+ */
+extern void sln_lex_tokens_clear(sln_lex_tokens_t* tokens);
+
+/**
+ * @brief Bytes held by the stream's used entries and trivia (not their spare capacity).
+ */
+extern size_t sln_lex_tokens_memory(const sln_lex_tokens_t* tokens);
+
+/**
+ * @brief Kind of the token at @p index.
+ */
+static inline sln_lex_token_type_t sln_lex_tokens_kind(const sln_lex_tokens_t* tokens, size_t index) {
+    return (sln_lex_token_type_t)tokens->kinds[index];
+}
+
+/**
+ * @brief Payload entry of the token at @p index, or SIZE_MAX if it has none.
+ */
+static inline size_t sln_lex_tokens_payload(const sln_lex_tokens_t* tokens, size_t index) {
+    size_t word = index / SLN_LEX_TOKENS_BLOCK;
+    uint64_t bit = (uint64_t)1 << (index % SLN_LEX_TOKENS_BLOCK);
+    uint64_t bits = tokens->payload_bits[word];
+    if (!(bits & bit)) return SIZE_MAX;
+    return tokens->payload_rank[word] + (size_t)__builtin_popcountll(bits & (bit - 1));
+}
+
+/**
+ * @brief Source span of the token at @p index.
+ */
+static inline sln_lex_span_t sln_lex_tokens_span(const sln_lex_tokens_t* tokens, size_t index) {
+    size_t payload = sln_lex_tokens_payload(tokens, index);
+    sln_lex_span_t span = { tokens->offsets[index], 0 };
+    span.length = payload == SIZE_MAX
+        ? sln_lex_token_fixed_length[tokens->kinds[index]]
+        : tokens->payload_lengths[payload];
+    return span;
+}
+
+/**
+ * @brief Interned symbol of an identifier or string literal.
+ */
+static inline sln_utils_sym_t sln_lex_tokens_sym(const sln_lex_tokens_t* tokens, size_t index) {
+    return (sln_utils_sym_t)tokens->payload_values[sln_lex_tokens_payload(tokens, index)];
+}
+
+/**
+ * @brief Value of an integer literal.
+ */
+static inline uint64_t sln_lex_tokens_u64(const sln_lex_tokens_t* tokens, size_t index) {
+    return tokens->payload_values[sln_lex_tokens_payload(tokens, index)];
+}
+
+/**
+ * @brief Value of a char literal.
+ */
+static inline int64_t sln_lex_tokens_i64(const sln_lex_tokens_t* tokens, size_t index) {
+    return (int64_t)tokens->payload_values[sln_lex_tokens_payload(tokens, index)];
+}
+
+/**
+ * @brief Value of a float literal.
+ */
+static inline long double sln_lex_tokens_float(const sln_lex_tokens_t* tokens, size_t index) {
+    return tokens->floats[tokens->payload_values[sln_lex_tokens_payload(tokens, index)]];
+}
+
+/**
+ * @brief Rebuilds the full token at @p index.
+ */
+extern sln_lex_token_t sln_lex_tokens_get(const sln_lex_tokens_t* tokens, size_t index);
+
+#endif // SELENA_LEXER_TOKENS_H_
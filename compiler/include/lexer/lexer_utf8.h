@@ -0,0 +1,91 @@
+/**
+ * @file lexer_utf8.h
+ * @brief UTF-8 decoding and the Unicode identifier rule.
+ *
+ * Identifiers are ASCII letters, digits and '_' plus any code point
+ * from U+00A1 on, except spaces, line separators and the format
+ * characters that can hide or reorder text (zero-width characters,
+ * bidi controls, BOM). A digit cannot start an identifier.
+ */
+
+#ifndef SELENA_LEXER_UTF8_H_
+#define SELENA_LEXER_UTF8_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Allowed range of the byte after a lead byte (Unicode table 3-7)
+static inline void _sln_lex_utf8_second(uint8_t lead, uint8_t* lo, uint8_t* hi) {
+    *lo = 0x80;
+    *hi = 0xBF;
+    if (lead == 0xE0) *lo = 0xA0;
+    else if (lead == 0xED) *hi = 0x9F;
+    else if (lead == 0xF0) *lo = 0x90;
+    else if (lead == 0xF4) *hi = 0x8F;
+}
+
+/**
+ * @brief Decodes the well-formed UTF-8 sequence at @p p.
+ *
+ * @param[in] p sequence in a NUL-terminated text.
+ * @param[out] code_point decoded code point.
+ * @return sequence length, 0 if the bytes are not well-formed.
+ */
+static inline size_t sln_lex_utf8_decode(const char* p, uint32_t* code_point) {
+    const uint8_t* s = (const uint8_t*)p;
+    uint8_t lead = s[0];
+    if (lead < 0x80) {
+        *code_point = lead;
+        return 1;
+    }
+    if (lead < 0xC2 || lead > 0xF4) return 0;
+    
+    uint8_t lo, hi;
+    _sln_lex_utf8_second(lead, &lo, &hi);
+    if (s[1] < lo || s[1] > hi) return 0;
+    if (lead < 0xE0) {
+        *code_point = (uint32_t)(lead & 0x1F) << 6 | (uint32_t)(s[1] & 0x3F);
+        return 2;
+    }
+    if ((s[2] & 0xC0) != 0x80) return 0;
+    if (lead < 0xF0) {
+        *code_point = (uint32_t)(lead & 0x0F) << 12 | (uint32_t)(s[1] & 0x3F) << 6 | (uint32_t)(s[2] & 0x3F);
+        return 3;
+    }
+    if ((s[3] & 0xC0) != 0x80) return 0;
+    *code_point = (uint32_t)(lead & 0x07) << 18 | (uint32_t)(s[1] & 0x3F) << 12
+                | (uint32_t)(s[2] & 0x3F) << 6 | (uint32_t)(s[3] & 0x3F);
+    return 4;
+}
+
+/**
+ * @brief Length of the ill-formed sequence at @p p, its maximal subpart (1 to 3 bytes).
+ */
+static inline size_t sln_lex_utf8_invalid_length(const char* p) {
+    const uint8_t* s = (const uint8_t*)p;
+    if (s[0] < 0xC2 || s[0] > 0xF4) return 1;
+    
+    uint8_t lo, hi;
+    _sln_lex_utf8_second(s[0], &lo, &hi);
+    if (s[1] < lo || s[1] > hi || s[0] < 0xE0) return 1;
+    if ((s[2] & 0xC0) != 0x80 || s[0] < 0xF0) return 2;
+    return 3;
+}
+
+/**
+ * @brief Whether a code point of U+0080 or above may appear in identifiers.
+ */
+static inline bool sln_lex_utf8_is_ident(uint32_t code_point) {
+    if (code_point <= 0xA0) return false;                               // C1 controls, no-break space
+    if (code_point == 0xAD || code_point == 0x061C) return false;       // soft hyphen, Arabic letter mark
+    if (code_point == 0x1680 || code_point == 0x180E) return false;     // Ogham space, Mongolian separator
+    if (code_point >= 0x2000 && code_point <= 0x200F) return false;     // spaces, zero-width, LRM/RLM
+    if (code_point >= 0x2028 && code_point <= 0x202F) return false;     // separators, bidi embeddings
+    if (code_point >= 0x205F && code_point <= 0x206F) return false;     // invisible operators, bidi isolates
+    if (code_point == 0x3000 || code_point == 0xFEFF) return false;     // ideographic space, BOM
+    if (code_point >= 0xFFF0 && code_point <= 0xFFFF) return false;     // specials, noncharacters
+    return true;
+}
+
+#endif // SELENA_LEXER_UTF8_H_
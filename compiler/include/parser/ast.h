@@ -0,0 +1,165 @@
+/**
+ * @file ast.h
+ * @brief Flat syntax tree built by the parser.
+ *
+ * Nodes sit in one array and refer to each other by 32-bit index, not
+ * by pointer. Every node has a main token and two operands whose use
+ * depends on its kind (see SLN_AST_KINDS). Children that do not fit in
+ * two operands, such as the items of a namespace or the arguments of a
+ * call, are runs of ids in a second array, `extra`; the operands then
+ * hold the run's [start, end) in `extra`. Both arrays live in the arena
+ * the tree was parsed into.
+ *
+ * Node 0 is the root. No node has the root as a child, so 0 also means
+ * "no node" in operands. Every other node comes after its children, so
+ * a pass in id order sees children before their parent.
+ */
+
+#ifndef SELENA_PARSER_AST_H_
+#define SELENA_PARSER_AST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <lexer/lexer.h>
+
+/// @brief Id of a node: its index in sln_ast_t::nodes.
+typedef uint32_t sln_ast_id_t;
+
+/// @brief Operand value for a missing child.
+#define SLN_AST_NONE ((sln_ast_id_t)0)
+
+/**
+ * @brief X(NAME) for every node kind, with the meaning of its fields.
+ *
+ * "extra[lhs..rhs)" means the children are extra[lhs] to extra[rhs - 1];
+ * "extra[rhs]: a, b" means rhs indexes a group of operands in `extra`.
+ */
+#define SLN_AST_KINDS(X)                                                                    \
+    /* Items */                                                                             \
+    X(ROOT)             /* extra[lhs..rhs): items */                                        \
+    X(NAMESPACE)        /* token: name; extra[lhs..rhs): items */                           \
+    X(USE)              /* lhs: NAME or PATH; rhs: alias token or 0; flags: GLOB */         \
+    X(TYPE_DEF)         /* token: name; lhs: type */                                        \
+    X(STRUCT)           /* extra[lhs..rhs): FIELD */                                        \
+    X(FIELD)            /* token: name; lhs: type */                                        \
+    X(ENUM)             /* extra[lhs..rhs): ENUMERATOR or EXT_POINT */                      \
+    X(ENUMERATOR)       /* token: name; lhs: value or 0 */                                  \
+    X(EXT_POINT)        /* token: name after '@' */                                         \
+    X(EXTEND)           /* token: extension point name; lhs: extended type; rhs: INIT_LIST */ \
+    X(FUNC)             /* lhs: name; extra[rhs]: params start, params end, return type, body */ \
+    X(PARAM)            /* token: name; lhs: type */                                        \
+    /* Statements */                                                                        \
+    X(BLOCK)            /* token: '{'; extra[lhs..rhs): statements */                       \
+    X(VAR)              /* token: name; lhs: type or 0; rhs: initial value or 0 */          \
+    X(RETURN)           /* lhs: value or 0 */                                               \
+    X(IF)               /* lhs: condition; extra[rhs]: then, else or 0 */                   \
+    X(WHILE)            /* lhs: condition; rhs: body */                                     \
+    X(FOR)              /* extra[lhs]: init, condition, step, each may be 0; rhs: body */   \
+    X(SWITCH)           /* lhs: value; extra[rhs]: cases start, cases end */                \
+    X(CASE)             /* lhs: value, 0 for default; rhs: body */                          \
+    X(BREAK)                                                                                \
+    X(CONTINUE)                                                                             \
+    X(EXPR_STMT)        /* lhs: expression */                                               \
+    /* Expressions */                                                                       \
+    X(NAME)             /* token: identifier, MAIN or ARGS */                               \
+    X(PATH)             /* extra[lhs..rhs): token of every segment */                       \
+    X(INT)              /* token: literal */                                                \
+    X(FLOAT)            /* token: literal */                                                \
+    X(CHAR)             /* token: literal */                                                \
+    X(STRING)           /* token: literal */                                                \
+    X(NIL)                                                                                  \
+    X(UNARY)            /* token: operator; lhs: operand */                                 \
+    X(POSTFIX)          /* token: operator; lhs: operand */                                 \
+    X(BINARY)           /* token: operator, assignments included; lhs, rhs: operands */     \
+    X(TERNARY)          /* lhs: condition; extra[rhs]: then, else */                        \
+    X(CALL)             /* token: '('; lhs: callee; extra[rhs]: arguments start, end */     \
+    X(INDEX)            /* token: '['; lhs: operand; rhs: index */                          \
+    X(MEMBER)           /* token: member name; lhs: operand */                              \
+    X(CAST)             /* token: '->'; lhs: operand; rhs: type */                          \
+    X(TUPLE)            /* token: '('; extra[lhs..rhs): elements */                         \
+    X(INIT_LIST)        /* token: '{'; extra[lhs..rhs): elements */                         \
+    /* Types; named types are NAME or PATH */                                               \
+    X(TYPE_BUILTIN)     /* token: type keyword */                                           \
+    X(TYPE_TUPLE)       /* token: '('; extra[lhs..rhs): types; '(T)' is just T */           \
+    X(TYPE_ARRAY)       /* token: '['; lhs: element type; rhs: length or 0 */               \
+    /* Recovery */                                                                          \
+    X(ERROR)            /* token: where parsing failed */
+
+/**
+ * @enum sln_ast_kind_t
+ * @brief Node kinds.
+ */
+typedef enum {
+#define _SLN_AST_KIND(name) SLN_AST_##name,
+    SLN_AST_KINDS(_SLN_AST_KIND)
+#undef _SLN_AST_KIND
+    _SLN_AST_KIND_COUNT
+} sln_ast_kind_t;
+
+/// @brief USE flag: the path ends in '*' and imports every name under it.
+#define SLN_AST_FLAG_GLOB 0x01u
+
+/**
+ * @struct sln_ast_node_t
+ * @brief One node, 16 bytes.
+ */
+typedef struct {
+    uint8_t kind;           /**< sln_ast_kind_t */
+    uint8_t flags;          /**< SLN_AST_FLAG_* */
+    uint16_t reserved;
+    uint32_t token;         /**< Main token, an index into sln_ast_t::tokens */
+    uint32_t lhs;
+    uint32_t rhs;
+} sln_ast_node_t;
+
+/**
+ * @struct sln_ast_t
+ * @brief Syntax tree of one text.
+ */
+typedef struct {
+    sln_ast_node_t* nodes;          /**< nodes[0] is the root */
+    uint32_t* extra;                /**< Child runs and operand groups */
+    size_t len;                     /**< Number of nodes */
+    size_t extra_len;
+    const sln_lex_token_t* tokens;  /**< Tokens the tree was parsed from */
+    size_t token_count;
+} sln_ast_t;
+
+/**
+ * @brief Node with id @p id.
+ */
+static inline const sln_ast_node_t* sln_ast_node(const sln_ast_t* ast, sln_ast_id_t id) {
+    return &ast->nodes[id];
+}
+
+/**
+ * @brief Ids in extra[start..end), such as the items of a ROOT node.
+ *
+ * @param[in] ast tree.
+ * @param[in] start first index in `extra`.
+ * @param[in] end index past the last one.
+ * @param[out] count number of ids.
+ * @returns first id, valid for @p count ids.
+ */
+static inline const uint32_t* sln_ast_range(const sln_ast_t* ast, uint32_t start, uint32_t end, size_t* count) {
+    *count = end - start;
+    return ast->extra + start;
+}
+
+/**
+ * @brief Name of a node kind, such as "TYPE_DEF".
+ */
+const char* sln_ast_kind_name(sln_ast_kind_t kind);
+
+/**
+ * @brief Prints the tree, one node per line, indented by depth.
+ *
+ * @param[in] ast tree.
+ * @param[in] text source text the tokens were lexed from.
+ * @param[in] stream output stream.
+ */
+void sln_ast_dump(const sln_ast_t* ast, const char* text, FILE* stream);
+
+#endif // SELENA_PARSER_AST_H_
@@ -0,0 +1,125 @@
+/**
+ * @file parser.h
+ * @brief Parser: tokens to a flat syntax tree.
+ *
+ * Recursive descent for items and statements, precedence climbing
+ * (Pratt) for expressions. Nodes and child lists go into growing arrays
+ * in the caller's arena; nothing is allocated per node.
+ *
+ * Grammar notes:
+ *  - Paths join names with `::`. In expressions `a:b` is a path too
+ *    (`cli:io.println(...)`), except in the middle of `c ? x : y`.
+ *  - A statement starting with `name:` declares a variable when a type
+ *    follows: a type keyword, `(`, or a name followed by `=`, `;` or
+ *    `[`. So `a:b = v;` declares `a`; write `a::b = v;` to assign a path.
+ *  - `MAIN` and `ARGS` are names.
+ */
+
+#ifndef SELENA_PARSER_H_
+#define SELENA_PARSER_H_
+
+#include <stdio.h>
+
+#include "ast.h"
+#include "parser_errors.h"
+#include <lexer/lexer.h>
+#include <lexer/lexer_pipe.h>
+#include <utils/allocation.h>
+#include <utils/thread_pool.h>
+
+/// @brief Diagnostics after which parsing stops.
+#define SLN_PARSE_MAX_ERRORS 100
+
+/// @brief Deepest nesting of expressions, statements and types.
+#define SLN_PARSE_MAX_DEPTH 256
+
+/// @brief Default token count of a chunk in sln_parse_parallel().
+#define SLN_PARSE_CHUNK_TOKENS 16384UL
+
+/**
+ * @brief Builds the syntax tree of a token buffer.
+ *
+ * The buffer holds significant tokens only, as sln_lex_generate_trivia()
+ * and sln_lex_generate_tokens() produce them: line breaks and comments
+ * are trivia, kept apart from the stream. Syntax errors are printed to
+ * @p error_stream with their line and column; after one, tokens are
+ * skipped to the next statement or item and the broken part becomes an
+ * ERROR node, so the tree is always complete.
+ * No diagnostic is printed at UNKNOWN tokens, the lexer reported them.
+ *
+ * @param[in] text source string the buffer was lexed from.
+ * @param[in] buffer tokens, ending with EOF; must outlive the tree.
+ * @param[in] arena arena the tree is allocated in.
+ * @param[in] error_stream error reporting stream.
+ * @param[out] ast tree, valid until the arena is reset or freed.
+ * @returns the first error, SLN_PARSE_OK if none.
+ */
+sln_parse_error_t sln_parse(
+    const char* text,
+    const sln_lex_token_buffer_t* buffer,
+    sln_utils_arena_t* arena,
+    FILE* error_stream,
+    sln_ast_t* ast);
+
+/**
+ * @brief Builds the syntax tree while the text is still being lexed.
+ *
+ * As sln_parse(), but tokens are pulled from @p pipe as the parser
+ * reaches them, so parsing overlaps lexing. They are collected in
+ * @p buffer, which the tree points into; the tree and diagnostics are
+ * the same as parsing the whole buffer at once. The pipe may still
+ * hold batches afterwards if parsing stopped early; sln_lex_pipe_close()
+ * discards them.
+ *
+ * @param[in] text source string the pipe lexes.
+ * @param[in] pipe running lexer.
+ * @param[out] buffer tokens read; free with sln_lex_free_tokens() after the tree.
+ * @param[in] arena arena the tree is allocated in.
+ * @param[in] error_stream error reporting stream.
+ * @param[out] ast tree, valid until the arena is reset or freed.
+ * @returns the first error, SLN_PARSE_OK if none.
+ */
+sln_parse_error_t sln_parse_pipe(
+    const char* text,
+    sln_lex_pipe_t* pipe,
+    sln_lex_token_buffer_t* buffer,
+    sln_utils_arena_t* arena,
+    FILE* error_stream,
+    sln_ast_t* ast);
+
+/**
+ * @brief Builds the syntax tree of a token buffer, top-level items in parallel.
+ *
+ * A pass over the token kinds matches brackets to find where top-level
+ * items end, and cuts the buffer there into chunks of at least
+ * @p chunk_tokens tokens. The chunks are parsed by the caller and by tasks on @p pool,
+ * then joined in source order. The tree is the one sln_parse() builds,
+ * bit for bit, whatever the number of workers.
+ *
+ * Buffers too small for two chunks, and those whose brackets do not
+ * balance, are parsed by sln_parse() directly. So is the whole buffer
+ * again when a chunk has a syntax error, so the diagnostics are those
+ * of sln_parse() too.
+ *
+ * May be called from a task of @p pool: the caller does not wait for
+ * helper tasks that have not started.
+ *
+ * @param[in] text source string the buffer was lexed from.
+ * @param[in] buffer tokens, ending with EOF; must outlive the tree.
+ * @param[in] arena arena the tree is allocated in.
+ * @param[in] error_stream error reporting stream.
+ * @param[out] ast tree, valid until the arena is reset or freed.
+ * @param[in] pool pool for the helper tasks; NULL to parse serially.
+ * @param[in] chunk_tokens tokens per chunk, SLN_PARSE_CHUNK_TOKENS if 0.
+ * @returns the first error, SLN_PARSE_OK if none.
+ */
+sln_parse_error_t sln_parse_parallel(
+    const char* text,
+    const sln_lex_token_buffer_t* buffer,
+    sln_utils_arena_t* arena,
+    FILE* error_stream,
+    sln_ast_t* ast,
+    sln_utils_pool_t* pool,
+    size_t chunk_tokens);
+
+#endif // SELENA_PARSER_H_
@@ -0,0 +1,15 @@
+#ifndef SELENA_PARSER_ERRORS_H_
+#define SELENA_PARSER_ERRORS_H_
+
+typedef enum {
+    SLN_PARSE_OK,
+    SLN_PARSE_NO_TOKEN_BUFFER,
+    SLN_PARSE_NO_ERROR_STREAM,
+    SLN_PARSE_NO_ARENA,
+    SLN_PARSE_UNEXPECTED_TOKEN,
+    SLN_PARSE_TOO_DEEP,
+    SLN_PARSE_ALLOCATION_FAILED,
+    SLN_PARSE_SOURCE_TOO_LARGE,
+} sln_parse_error_t;
+
+#endif // SELENA_PARSER_ERRORS_H_
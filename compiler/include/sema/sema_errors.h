@@ -0,0 +1,16 @@
+#ifndef SELENA_SEMA_ERRORS_H_
+#define SELENA_SEMA_ERRORS_H_
+
+typedef enum {
+    SLN_SEMA_OK,
+    SLN_SEMA_NO_TABLE,
+    SLN_SEMA_NO_TREE,
+    SLN_SEMA_NO_ERROR_STREAM,
+    SLN_SEMA_DUPLICATE,
+    SLN_SEMA_UNRESOLVED,
+    SLN_SEMA_INVALID_EXTENSION,
+    SLN_SEMA_VALUE_CONFLICT,
+    SLN_SEMA_ALLOCATION_FAILED,
+} sln_sema_error_t;
+
+#endif // SELENA_SEMA_ERRORS_H_
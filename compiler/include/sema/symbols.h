@@ -0,0 +1,266 @@
+/**
+ * @file symbols.h
+ * @brief Symbol table of qualified names, shared by every unit.
+ *
+ * Namespaces and enum types open scopes; every declaration is an entry
+ * keyed by the scope it is declared in and its interned name. All keys
+ * live in one open-addressing table. A scope's hash is its parent's
+ * extended by its name, and a key's hash is its scope's extended the
+ * same way, so resolving `a::b::c` is one probe per segment whatever
+ * the number of names or modules. Namespaces of the same name, in one
+ * unit or many, are one scope.
+ *
+ * Imports copy nothing. `use p;` and `use p as n;` add one ALIAS entry
+ * naming the target; `use p*;` adds the scope of `p` to the views of
+ * the importing scope, which unqualified lookups search after the
+ * scope's own names. Top-level imports go to the file scope of their
+ * unit, which only lookups from that unit see, between its namespaces
+ * and the root; imports in a namespace go to the namespace, for every
+ * unit that adds to it.
+ *
+ * Units are collected one by one with sln_sema_collect(), then imports,
+ * functions declared by qualified name (`ns::f() {...}`) and extensions
+ * are bound at once by sln_sema_bind(), so they may refer to any unit.
+ * The table is not thread-safe.
+ *
+ * Extensions, `type@point = { A, B };`, declare their names in the scope
+ * of the enum, as if written at `@point`. Binding also builds the
+ * registry of every point's enumerators, from all units in one pass:
+ * they are ordered by unit, then by source order, and an enum's values
+ * count up through its own enumerators and its points' in turn. Lookups
+ * go through the point's entry, never through the trees.
+ */
+
+#ifndef SELENA_SEMA_SYMBOLS_H_
+#define SELENA_SEMA_SYMBOLS_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sema_errors.h"
+#include <parser/ast.h>
+#include <utils/intern.h>
+
+/// @brief Scope id; the root scope, that of the top-level items, is 0.
+typedef uint32_t sln_sema_scope_t;
+
+/// @brief Root scope.
+#define SLN_SEMA_ROOT ((sln_sema_scope_t)0)
+
+/// @brief Entry id. Ids are dense and start from 1.
+typedef uint32_t sln_sema_id_t;
+
+/// @brief Id that never refers to an entry.
+#define SLN_SEMA_NONE ((sln_sema_id_t)0)
+
+/// @brief ENUMERATOR: `value` is known.
+#define SLN_SEMA_FLAG_VALUED 0x01u
+
+/// @brief ENUMERATOR: value given in the source.
+#define SLN_SEMA_FLAG_EXPLICIT 0x02u
+
+/// @brief ENUMERATOR: declared by an extension.
+#define SLN_SEMA_FLAG_EXTENSION 0x04u
+
+/**
+ * @brief X(NAME) for every entry kind.
+ */
+#define SLN_SEMA_KINDS(X)                                                       \
+    X(NAMESPACE)        /* opens a scope */                                     \
+    X(TYPE)             /* opens a scope if the type is an enum */              \
+    X(ENUMERATOR)                                                               \
+    X(EXT_POINT)        /* `@name` in an enum */                                \
+    X(FUNC)                                                                     \
+    X(VAR)                                                                      \
+    X(ALIAS)            /* imported name; target: entry it names */
+
+/**
+ * @enum sln_sema_kind_t
+ * @brief Entry kinds.
+ */
+typedef enum {
+#define _SLN_SEMA_KIND(name) SLN_SEMA_##name,
+    SLN_SEMA_KINDS(_SLN_SEMA_KIND)
+#undef _SLN_SEMA_KIND
+    _SLN_SEMA_KIND_COUNT
+} sln_sema_kind_t;
+
+/**
+ * @struct sln_sema_entry_t
+ * @brief One declared or imported name.
+ */
+typedef struct {
+    sln_utils_sym_t name;
+    uint8_t kind;               /**< sln_sema_kind_t */
+    uint8_t flags;              /**< SLN_SEMA_FLAG_* */
+    sln_sema_scope_t parent;    /**< Scope it is declared in */
+    sln_sema_scope_t scope;     /**< Scope it opens, SLN_SEMA_ROOT if none */
+    sln_sema_id_t target;       /**< ALIAS: entry named, never an alias itself;
+                                     extension ENUMERATOR: its EXT_POINT;
+                                     EXT_POINT: index among the points */
+    uint32_t unit;              /**< Unit of the declaration */
+    sln_ast_id_t node;          /**< Declaring node in that unit's tree */
+    int64_t value;              /**< ENUMERATOR: value, if SLN_SEMA_FLAG_VALUED */
+} sln_sema_entry_t;
+
+typedef struct sln_sema_symbols sln_sema_symbols_t;
+
+/**
+ * @brief Creates an empty table.
+ * @param[in] symbols interner the trees' names were interned in.
+ * @returns NULL on allocation failure.
+ */
+sln_sema_symbols_t* sln_sema_symbols_create(sln_utils_intern_t* symbols);
+
+/**
+ * @brief Destroys the table.
+ */
+void sln_sema_symbols_destroy(sln_sema_symbols_t* table);
+
+/**
+ * @brief Declares a name in a scope.
+ *
+ * A NAMESPACE, or a TYPE or other entry with @p opens set, gets a
+ * fresh scope. Declaring a namespace again returns the first one.
+ *
+ * @param[in] table table.
+ * @param[in] scope scope to declare in.
+ * @param[in] kind entry kind, not ALIAS.
+ * @param[in] name interned name.
+ * @param[in] opens whether the entry opens a scope; implied for namespaces.
+ * @param[in] unit unit of the declaration.
+ * @param[in] node declaring node.
+ * @param[out] id new entry, or the one already holding the name.
+ * @returns SLN_SEMA_OK, SLN_SEMA_DUPLICATE or SLN_SEMA_ALLOCATION_FAILED.
+ */
+sln_sema_error_t sln_sema_declare(sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_sema_kind_t kind,
+                                  sln_utils_sym_t name, bool opens, uint32_t unit, sln_ast_id_t node,
+                                  sln_sema_id_t* id);
+
+/**
+ * @brief Makes @p name in @p scope refer to @p target.
+ *
+ * Aliasing a name to the entry it already refers to is no error.
+ *
+ * @returns SLN_SEMA_OK, SLN_SEMA_DUPLICATE or SLN_SEMA_ALLOCATION_FAILED.
+ */
+sln_sema_error_t sln_sema_alias(sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_utils_sym_t name,
+                                sln_sema_id_t target, uint32_t unit, sln_ast_id_t node);
+
+/**
+ * @brief Adds @p target to the scopes unqualified lookups in @p scope search.
+ *
+ * Views are not transitive: names @p target itself imports with a glob
+ * are not seen through it.
+ *
+ * @returns false on allocation failure.
+ */
+bool sln_sema_import(sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_sema_scope_t target);
+
+/**
+ * @brief Name declared or aliased in @p scope itself.
+ * @returns the entry, the alias's target for aliases, or SLN_SEMA_NONE.
+ */
+sln_sema_id_t sln_sema_member(const sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_utils_sym_t name);
+
+/**
+ * @brief File scope of a unit, for its top-level imports.
+ * @returns the scope, or SLN_SEMA_ROOT if the unit was not collected.
+ */
+sln_sema_scope_t sln_sema_unit_scope(const sln_sema_symbols_t* table, uint32_t unit);
+
+/**
+ * @brief Name as seen from @p scope in the unit with file scope @p file.
+ *
+ * Searches each scope from @p scope outwards, its own names then its
+ * views, with @p file just before the root.
+ *
+ * @returns the entry, the alias's target for aliases, or SLN_SEMA_NONE.
+ */
+sln_sema_id_t sln_sema_lookup(const sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_sema_scope_t file,
+                              sln_utils_sym_t name);
+
+/**
+ * @brief Resolves a path as seen from @p scope in the unit with file scope @p file.
+ *
+ * The first segment is looked up as sln_sema_lookup(), every other one
+ * as a member of the scope the previous one opens.
+ *
+ * @returns the entry, or SLN_SEMA_NONE if a segment is missing or opens no scope.
+ */
+sln_sema_id_t sln_sema_resolve(const sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_sema_scope_t file,
+                               const sln_utils_sym_t* path, size_t len);
+
+/**
+ * @brief Extension point @p name of the enum type @p type.
+ * @returns the EXT_POINT entry, or SLN_SEMA_NONE.
+ */
+sln_sema_id_t sln_sema_ext_point(const sln_sema_symbols_t* table, sln_sema_id_t type, sln_utils_sym_t name);
+
+/**
+ * @brief Enumerators added to an extension point by every unit, in value order.
+ * @param[in] table table, bound.
+ * @param[in] point EXT_POINT entry.
+ * @param[out] count number of enumerators.
+ * @returns their ids, valid until the next sln_sema_bind().
+ */
+const sln_sema_id_t* sln_sema_extensions(const sln_sema_symbols_t* table, sln_sema_id_t point, size_t* count);
+
+/**
+ * @brief Entry with id @p id, which must come from this table.
+ */
+const sln_sema_entry_t* sln_sema_entry(const sln_sema_symbols_t* table, sln_sema_id_t id);
+
+/**
+ * @brief Number of entries, aliases included.
+ */
+size_t sln_sema_count(const sln_sema_symbols_t* table);
+
+/**
+ * @brief Declares the items of a tree.
+ *
+ * Namespaces, types with the enumerators and extension points of enum
+ * types, functions and variables are declared; `use` items, functions
+ * named by a path and extensions are kept for sln_sema_bind(). Duplicate
+ * names are printed to @p error_stream with their line and column.
+ * Every unit is collected once.
+ *
+ * @param[in] table table.
+ * @param[in] unit index of the unit, stored in its entries.
+ * @param[in] ast tree of the unit, only read during the call.
+ * @param[in] text source string the tree was parsed from.
+ * @param[in] error_stream error reporting stream.
+ * @returns the first error, SLN_SEMA_OK if none.
+ */
+sln_sema_error_t sln_sema_collect(sln_sema_symbols_t* table, uint32_t unit, const sln_ast_t* ast,
+                                  const char* text, FILE* error_stream);
+
+/**
+ * @brief Binds the imports, qualified functions and extensions of every collected unit.
+ *
+ * Imports may depend on each other (`use a as b; use b::c;`), in any
+ * order. Items are tried in source order; one whose path does not
+ * resolve waits on the name it misses, in the scope it misses it from
+ * (or every scope a lookup of its first segment searches), and is tried
+ * again only once that name is declared there or a glob import brings it
+ * into view. Each item is thus retried only when it may bind, however
+ * long the chains of imports. Paths still unresolved once no item is
+ * left to try are printed to @p error_stream. Then the
+ * extension registry is built and enumerator values are assigned, in
+ * time linear in the enumerators; an extension's enumerator whose value
+ * an explicit one already holds is printed as a conflict.
+ *
+ * @param[in] table table.
+ * @param[in] error_stream error reporting stream.
+ * @returns the first error, SLN_SEMA_OK if none.
+ */
+sln_sema_error_t sln_sema_bind(sln_sema_symbols_t* table, FILE* error_stream);
+
+/**
+ * @brief Name of an entry kind, such as "NAMESPACE".
+ */
+const char* sln_sema_kind_name(sln_sema_kind_t kind);
+
+#endif // SELENA_SEMA_SYMBOLS_H_
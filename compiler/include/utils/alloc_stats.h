@@ -0,0 +1,94 @@
+
+/**
+ * @file alloc_stats.h
+ * @brief Allocation profile keyed by call site.
+ *
+ * When enabled, every SLN_ALLOC and arena allocation is counted under
+ * its site: the allocating function and, for arena objects, the arena
+ * name. A site keeps a count, total bytes, a size histogram and, for
+ * heap memory, the peak of its live bytes. Heap memory is live until
+ * sln_utils_free(); arena blocks are reported as their own site, since
+ * arena objects only die together.
+ *
+ * When disabled an allocation pays one relaxed atomic load.
+ */
+
+#ifndef SELENA_UTILS_ALLOC_STATS_H_
+#define SELENA_UTILS_ALLOC_STATS_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/// @brief Number of size histogram buckets.
+#define SLN_UTILS_ALLOC_STATS_BUCKETS 10
+
+/// @brief Distinct sites kept; later sites are folded into one entry.
+#define SLN_UTILS_ALLOC_STATS_MAX_SITES 1024
+
+/// @brief Site name of arena blocks.
+#define SLN_UTILS_ALLOC_STATS_ARENA_BLOCKS "<blocks>"
+
+typedef enum {
+    SLN_UTILS_ALLOC_STATS_TABLE = 0,
+    SLN_UTILS_ALLOC_STATS_JSON,
+} sln_utils_alloc_stats_format_t;
+
+/// @brief Set while profiling; read through sln_utils_alloc_stats_on().
+extern atomic_bool sln_utils_alloc_stats_active;
+
+/**
+ * @brief Whether allocations are being profiled.
+ */
+static inline bool sln_utils_alloc_stats_on(void) {
+    return __builtin_expect(atomic_load_explicit(&sln_utils_alloc_stats_active, memory_order_relaxed), 0);
+}
+
+/**
+ * @brief Starts profiling. Call before other threads allocate.
+ * @returns false if the bookkeeping cannot be set up.
+ */
+bool sln_utils_alloc_stats_enable(void);
+
+/**
+ * @brief Stops profiling and drops the profile. Call after other threads stopped allocating.
+ */
+void sln_utils_alloc_stats_disable(void);
+
+/**
+ * @brief Records an allocation.
+ *
+ * @param[in] ptr heap block whose lifetime is tracked, NULL for arena objects.
+ * @param[in] bytes allocation size.
+ * @param[in] function_info allocating function.
+ * @param[in] arena arena name, NULL for the heap.
+ */
+void sln_utils_alloc_stats_record(const void* ptr, size_t bytes,
+                                  const char* function_info, const char* arena);
+
+/**
+ * @brief Records the release of a block passed to sln_utils_alloc_stats_record().
+ *
+ * Unknown pointers, such as blocks allocated before profiling started, are ignored.
+ */
+void sln_utils_alloc_stats_release(const void* ptr);
+
+/**
+ * @brief Totals over heap sites and arena blocks.
+ *
+ * Arena objects are left out: their bytes are already part of the
+ * blocks they were carved from.
+ *
+ * @param[out] count number of heap allocations and arena blocks, may be NULL.
+ * @param[out] bytes bytes allocated, may be NULL.
+ * @param[out] peak_live peak of live heap and block bytes, may be NULL.
+ */
+void sln_utils_alloc_stats_totals(size_t* count, size_t* bytes, size_t* peak_live);
+
+/**
+ * @brief Prints the profile, sites with the highest peak first.
+ */
+void sln_utils_alloc_stats_print(FILE* stream, sln_utils_alloc_stats_format_t format);
+
+#endif // SELENA_UTILS_ALLOC_STATS_H_
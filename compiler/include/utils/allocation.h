@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 /**
  * @brief Sets the stream that will be used for allocation error messages.
@@ -27,5 +28,82 @@ void* sln_utils_alloc(size_t num, size_t size_of_element, const char* function_i
 #define SLN_ALLOC(num, type) \
     (type*)sln_utils_alloc((num), sizeof(type), __func__)
 
+/**
+ * @brief Frees memory from SLN_ALLOC(); `free()` works too but is invisible to the allocation profile.
+ */
+void sln_utils_free(void* ptr);
+
+/// @brief Alignment of every arena block.
+#define SLN_UTILS_ARENA_ALIGNMENT 64u
+
+/// @brief Default arena block size.
+#define SLN_UTILS_ARENA_BLOCK_SIZE (64u * 1024u)
+
+typedef struct sln_utils_arena_block sln_utils_arena_block_t;
+
+/**
+ * @struct sln_utils_arena_t
+ * @brief Bump-pointer region for objects that die together.
+ *
+ * Objects are never freed one by one: sln_utils_arena_reset() drops all
+ * of them at once and keeps the blocks for reuse, sln_utils_arena_free()
+ * returns the blocks. Memory is not zeroed unless asked for.
+ */
+typedef struct {
+    const char* name;                   /**< Shown in allocation failure messages */
+    sln_utils_arena_block_t* first;     /**< Block list, kept across resets */
+    sln_utils_arena_block_t* current;   /**< Block being filled */
+    size_t block_size;                  /**< Size of regular blocks */
+} sln_utils_arena_t;
+
+/**
+ * @brief Prepares an empty arena; no memory is taken until the first allocation.
+ *
+ * @param[out] arena arena to set up.
+ * @param[in] name arena name, must outlive the arena.
+ * @param[in] block_size size of regular blocks, 0 for SLN_UTILS_ARENA_BLOCK_SIZE.
+ */
+void sln_utils_arena_init(sln_utils_arena_t* arena, const char* name, size_t block_size);
+
+/**
+ * @brief Allocates elements in an arena.
+ *
+ * @param[in] arena arena.
+ * @param[in] num number of elements.
+ * @param[in] size_of_element size of each element.
+ * @param[in] alignment power of two, at most SLN_UTILS_ARENA_ALIGNMENT.
+ * @param[in] zero whether to zero the memory.
+ * @param[in] function_info name of the function and etc. For debug.
+ * @returns NULL on overflow or allocation failure.
+ */
+void* sln_utils_arena_alloc(sln_utils_arena_t* arena, size_t num, size_t size_of_element,
+                            size_t alignment, bool zero, const char* function_info);
+
+/**
+ * @brief Drops every object of the arena in O(1), keeping its blocks.
+ */
+void sln_utils_arena_reset(sln_utils_arena_t* arena);
+
+/**
+ * @brief Drops every object and releases the blocks.
+ */
+void sln_utils_arena_free(sln_utils_arena_t* arena);
+
+/**
+ * @brief Bytes held by the arena's blocks.
+ */
+size_t sln_utils_arena_reserved(const sln_utils_arena_t* arena);
+
+/**
+ * @brief Arena counterpart of SLN_ALLOC(); the memory is not zeroed.
+ */
+#define SLN_ARENA_ALLOC(arena, num, type) \
+    (type*)sln_utils_arena_alloc((arena), (num), sizeof(type), _Alignof(type), false, __func__)
+
+/**
+ * @brief Arena counterpart of SLN_ALLOC() with zeroed memory.
+ */
+#define SLN_ARENA_ALLOC_ZERO(arena, num, type) \
+    (type*)sln_utils_arena_alloc((arena), (num), sizeof(type), _Alignof(type), true, __func__)
 
 #endif // SELENA_UTILS_ALLOCATION_H_
\ No newline at end of file
@@ -20,6 +20,13 @@
  
      SLN_IN_ARG_TYPE_WARN,      // --warn {all|extra}
      SLN_IN_ARG_TYPE_FUNC,      // --func {custom}
+     SLN_IN_ARG_TYPE_JOBS,      // -j/--jobs <count>
+     SLN_IN_ARG_TYPE_STATS,     // --stats {alloc|alloc-json}
+     SLN_IN_ARG_TYPE_TIME,      // --time-report
+     SLN_IN_ARG_TYPE_TRACE,     // --trace <path>
+     SLN_IN_ARG_TYPE_CACHE,     // --cache-dir <path>
+     SLN_IN_ARG_TYPE_PARSE,     // --parse
+     SLN_IN_ARG_TYPE_PIPELINE,  // --pipeline
  
      _SLN_IN_ARG_TYPE_COUNT,
  } sln_input_arg_type_t;
@@ -33,6 +40,11 @@
      SLN_IN_ARG_FUNC_CUSTOM = 0,
  } sln_input_arg_func_t;
  
+ typedef enum {
+     SLN_IN_ARG_STATS_ALLOC = 0,
+     SLN_IN_ARG_STATS_ALLOC_JSON,
+ } sln_input_arg_stats_t;
+ 
  typedef struct {
      sln_input_arg_type_t type;
      const char* cstr;
@@ -40,6 +52,8 @@
      union {
          sln_input_arg_warn_t warn;
          sln_input_arg_func_t func;
+         size_t jobs;
+         sln_input_arg_stats_t stats;
          int _unused;
      } subtype;
  } sln_input_arg_t;
@@ -0,0 +1,95 @@
+
+/**
+ * @file intern.h
+ * @brief Thread-safe string interner (symbol table of names and literals).
+ *
+ * Every distinct byte string is mapped to a dense 32-bit symbol id,
+ * so later stages compare names by integer equality. Inserts may run
+ * concurrently from several threads.
+ */
+
+#ifndef SELENA_UTILS_INTERN_H_
+#define SELENA_UTILS_INTERN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Symbol id. Ids are dense and start from 1.
+typedef uint32_t sln_utils_sym_t;
+
+/// @brief Id that never refers to a symbol.
+#define SLN_UTILS_SYM_NONE ((sln_utils_sym_t)0)
+
+/// @brief Initial value of the incremental hash (32-bit FNV-1a).
+#define SLN_UTILS_INTERN_HASH_INIT 2166136261u
+
+typedef struct sln_utils_intern sln_utils_intern_t;
+
+/**
+ * @brief Feeds one byte into the incremental hash.
+ *
+ * Lets scanners compute the hash while they walk the bytes, so the
+ * string is not read twice.
+ *
+ * @param[in] hash current hash value.
+ * @param[in] c next byte.
+ * @returns updated hash value.
+ */
+static inline uint32_t sln_utils_intern_hash_step(uint32_t hash, char c) {
+    return (hash ^ (uint8_t)c) * 16777619u;
+}
+
+/**
+ * @brief Hashes a whole string the same way as sln_utils_intern_hash_step().
+ */
+uint32_t sln_utils_intern_hash(const char* str, size_t len);
+
+/**
+ * @brief Creates an empty interner.
+ * @returns NULL on allocation failure.
+ */
+sln_utils_intern_t* sln_utils_intern_create(void);
+
+/**
+ * @brief Destroys the interner and every string it holds.
+ */
+void sln_utils_intern_destroy(sln_utils_intern_t* table);
+
+/**
+ * @brief Interns a string with a precomputed hash.
+ *
+ * @param[in] table interner.
+ * @param[in] str string bytes (need not be NUL-terminated).
+ * @param[in] len length of the string.
+ * @param[in] hash value of sln_utils_intern_hash(str, len).
+ * @returns symbol id, or SLN_UTILS_SYM_NONE on allocation failure.
+ */
+sln_utils_sym_t sln_utils_intern_put(sln_utils_intern_t* table,
+                                     const char* str, size_t len, uint32_t hash);
+
+/**
+ * @brief Interns a string, computing its hash.
+ */
+sln_utils_sym_t sln_utils_intern(sln_utils_intern_t* table, const char* str, size_t len);
+
+/**
+ * @brief Text of a symbol.
+ *
+ * @param[in] table interner.
+ * @param[in] sym symbol id returned by this table.
+ * @param[out] out_len length of the string, may be NULL.
+ * @returns NUL-terminated string, or NULL for an unknown id.
+ */
+const char* sln_utils_intern_get(const sln_utils_intern_t* table, sln_utils_sym_t sym, size_t* out_len);
+
+/**
+ * @brief Number of distinct symbols.
+ */
+size_t sln_utils_intern_count(const sln_utils_intern_t* table);
+
+/**
+ * @brief Bytes currently allocated by the interner.
+ */
+size_t sln_utils_intern_memory(const sln_utils_intern_t* table);
+
+#endif // SELENA_UTILS_INTERN_H_
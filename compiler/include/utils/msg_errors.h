@@ -5,6 +5,7 @@
 #define SELENA_MSG_ERRORS_H_
 
 #include <stdio.h>
+#include <stddef.h>
 
 #include <utils/exit_codes.h>
 #include <resources/msg_resource.h>
@@ -26,4 +27,56 @@ typedef enum {
  */
 void sln_utils_msg_print(sln_res_msg_t msg_code, sln_utils_msg_type_t type, FILE* stream);
 
+/**
+ * @brief Displays the message text with the source position it refers to.
+ * 
+ * @param[in] msg_code code of the output text.
+ * @param[in] type message type.
+ * @param[in] offset byte offset in the source text.
+ * @param[in] stream output stream (stdout/stderr).
+ */
+void sln_utils_msg_print_at(sln_res_msg_t msg_code, sln_utils_msg_type_t type,
+                            size_t offset, FILE* stream);
+
+/**
+ * @brief Displays the message text with the source line and column it refers to.
+ * 
+ * @param[in] msg_code code of the output text.
+ * @param[in] type message type.
+ * @param[in] line line number, from 1.
+ * @param[in] column column number, from 1.
+ * @param[in] stream output stream (stdout/stderr).
+ */
+void sln_utils_msg_print_at_line(sln_res_msg_t msg_code, sln_utils_msg_type_t type,
+                                 size_t line, size_t column, FILE* stream);
+
+/**
+ * @brief Displays the message text followed by what it is about.
+ * 
+ * Prints `<message> '<subject>': <reason>.`
+ * 
+ * @param[in] msg_code code of the output text.
+ * @param[in] type message type.
+ * @param[in] subject e.g. a file path.
+ * @param[in] reason further details, may be NULL.
+ * @param[in] stream output stream (stdout/stderr).
+ */
+void sln_utils_msg_print_detail(sln_res_msg_t msg_code, sln_utils_msg_type_t type,
+                                const char* subject, const char* reason, FILE* stream);
+
+/**
+ * @brief Displays the message text, what it is about and where.
+ * 
+ * Prints `<message> '<subject>' (at line <line>, column <column>).`
+ * 
+ * @param[in] msg_code code of the output text.
+ * @param[in] type message type.
+ * @param[in] subject e.g. an expected token.
+ * @param[in] line line number, from 1.
+ * @param[in] column column number, from 1.
+ * @param[in] stream output stream (stdout/stderr).
+ */
+void sln_utils_msg_print_detail_at_line(sln_res_msg_t msg_code, sln_utils_msg_type_t type, const char* subject,
+                                        size_t line, size_t column, FILE* stream);
+
 #endif // SELENA_MSG_ERRORS_H_
\ No newline at end of file
@@ -0,0 +1,105 @@
+/**
+ * @file spsc_ring.h
+ * @brief Bounded single-producer/single-consumer ring of fixed-size slots.
+ *
+ * Slots are allocated once and filled in place: the producer acquires
+ * the next free slot, writes it and publishes it; the consumer peeks
+ * the oldest published slot, reads it and releases it. Indices are
+ * atomics on separate cache lines, and each side keeps a cached copy
+ * of the other's index, so a slot changes hands with no lock and
+ * usually without touching the other side's line.
+ *
+ * A full ring makes the producer wait and an empty one the consumer,
+ * which keeps memory bounded. Waiting spins briefly, then sleeps on a
+ * condition variable that the other side only signals when it sees a
+ * sleeper. The producer closes the ring when done; the consumer can
+ * cancel it to make the producer give up.
+ */
+
+#ifndef SELENA_UTILS_SPSC_RING_H_
+#define SELENA_UTILS_SPSC_RING_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+/// @brief Gap keeping each side's index off the other's cache line, however the ring is aligned.
+#define SLN_UTILS_RING_PAD 64
+
+/**
+ * @struct sln_utils_ring_t
+ * @brief Ring state; the fields are private.
+ */
+typedef struct {
+    atomic_size_t head;                 /**< Next slot to consume, written by the consumer */
+    size_t tail_cache;                  /**< Consumer's copy of `tail` */
+    char head_pad[SLN_UTILS_RING_PAD];
+    atomic_size_t tail;                 /**< Next slot to produce, written by the producer */
+    size_t head_cache;                  /**< Producer's copy of `head` */
+    char tail_pad[SLN_UTILS_RING_PAD];
+    atomic_bool closed;
+    atomic_bool cancelled;
+    atomic_bool producer_sleeping;      /**< The producer waits on `wake` */
+    atomic_bool consumer_sleeping;      /**< The consumer waits on `wake` */
+    mtx_t lock;
+    cnd_t wake;
+    char* slots;
+    size_t slot_size;
+    size_t mask;                        /**< Slot count - 1 */
+} sln_utils_ring_t;
+
+/**
+ * @brief Allocates a ring.
+ *
+ * @param[out] ring ring to set up.
+ * @param[in] slot_count number of slots, a power of two.
+ * @param[in] slot_size bytes per slot.
+ * @returns false if @p slot_count is not a power of two or on allocation failure.
+ */
+bool sln_utils_ring_init(sln_utils_ring_t* ring, size_t slot_count, size_t slot_size);
+
+/**
+ * @brief Frees the ring. Neither side may use it any more.
+ */
+void sln_utils_ring_free(sln_utils_ring_t* ring);
+
+/**
+ * @brief Producer: the next free slot, waiting while the ring is full.
+ *
+ * Repeated calls return the same slot until it is published.
+ *
+ * @returns NULL if the consumer cancelled the ring.
+ */
+void* sln_utils_ring_acquire(sln_utils_ring_t* ring);
+
+/**
+ * @brief Producer: hands the acquired slot to the consumer.
+ */
+void sln_utils_ring_publish(sln_utils_ring_t* ring);
+
+/**
+ * @brief Producer: no more slots will be published.
+ */
+void sln_utils_ring_close(sln_utils_ring_t* ring);
+
+/**
+ * @brief Consumer: the oldest published slot, waiting while the ring is empty.
+ *
+ * Repeated calls return the same slot until it is released.
+ *
+ * @returns NULL once the ring is closed and every slot was consumed.
+ */
+void* sln_utils_ring_peek(sln_utils_ring_t* ring);
+
+/**
+ * @brief Consumer: gives the peeked slot back to the producer.
+ */
+void sln_utils_ring_release(sln_utils_ring_t* ring);
+
+/**
+ * @brief Consumer: makes the producer's acquires fail from now on.
+ */
+void sln_utils_ring_cancel(sln_utils_ring_t* ring);
+
+#endif // SELENA_UTILS_SPSC_RING_H_
@@ -0,0 +1,65 @@
+
+/**
+ * @file thread_pool.h
+ * @brief Work-stealing thread pool.
+ *
+ * Every worker owns a deque of tasks. A worker takes its own newest
+ * task first and, when its deque is empty, steals the oldest task of
+ * another worker. Tasks submitted from a worker go to that worker's
+ * deque, tasks submitted from outside are dealt round-robin.
+ */
+
+#ifndef SELENA_UTILS_THREAD_POOL_H_
+#define SELENA_UTILS_THREAD_POOL_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/// @brief Upper bound on the number of workers.
+#define SLN_UTILS_POOL_MAX_WORKERS 256u
+
+typedef struct sln_utils_pool sln_utils_pool_t;
+
+/**
+ * @brief Task body.
+ * @param[in] arg argument given to sln_utils_pool_submit().
+ * @param[in] worker index of the running worker, below sln_utils_pool_size().
+ */
+typedef void (*sln_utils_pool_task_t)(void* arg, size_t worker);
+
+/**
+ * @brief Starts a pool.
+ * @param[in] workers number of threads, clamped to [1, SLN_UTILS_POOL_MAX_WORKERS].
+ * @returns NULL if the pool or its threads cannot be created.
+ */
+sln_utils_pool_t* sln_utils_pool_create(size_t workers);
+
+/**
+ * @brief Stops the workers once every submitted task has run and frees the pool.
+ */
+void sln_utils_pool_destroy(sln_utils_pool_t* pool);
+
+/**
+ * @brief Queues a task.
+ * @returns false on allocation failure; the task is not queued.
+ */
+bool sln_utils_pool_submit(sln_utils_pool_t* pool, sln_utils_pool_task_t task, void* arg);
+
+/**
+ * @brief Blocks until every submitted task, including nested ones, has run.
+ *
+ * Must not be called from a task.
+ */
+void sln_utils_pool_wait(sln_utils_pool_t* pool);
+
+/**
+ * @brief Number of workers.
+ */
+size_t sln_utils_pool_size(const sln_utils_pool_t* pool);
+
+/**
+ * @brief Number of online CPUs, at least 1.
+ */
+size_t sln_utils_cpu_count(void);
+
+#endif // SELENA_UTILS_THREAD_POOL_H_
@@ -0,0 +1,128 @@
+
+/**
+ * @file trace.h
+ * @brief Scoped phase timers with a summary and Chrome trace export.
+ *
+ * Phases are marked with the SLN_TRACE_* macros. Each thread appends
+ * its spans to its own buffer, so recording takes no lock. The spans
+ * feed a per-phase summary (--time-report) and a Chrome/Perfetto
+ * trace-event file with one track per thread (--trace=out.json).
+ *
+ * Built with SLN_TRACE_ENABLED=0 the macros expand to nothing; built
+ * with tracing but not switched on, a scope costs one relaxed load.
+ */
+
+#ifndef SELENA_UTILS_TRACE_H_
+#define SELENA_UTILS_TRACE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifndef SLN_TRACE_ENABLED
+#   define SLN_TRACE_ENABLED 1
+#endif
+
+/// @brief Set while spans are recorded; read through sln_utils_trace_on().
+extern atomic_bool sln_utils_trace_active;
+
+/**
+ * @brief Whether spans are being recorded.
+ */
+static inline bool sln_utils_trace_on(void) {
+    return __builtin_expect(atomic_load_explicit(&sln_utils_trace_active, memory_order_relaxed), 0);
+}
+
+/**
+ * @brief Monotonic clock in nanoseconds.
+ */
+uint64_t sln_utils_trace_now(void);
+
+/**
+ * @brief Starts recording; the calling thread is named "main".
+ * @returns false if tracing was compiled out or cannot be set up.
+ */
+bool sln_utils_trace_enable(void);
+
+/**
+ * @brief Stops recording and drops every span. Call after other threads stopped.
+ */
+void sln_utils_trace_disable(void);
+
+/**
+ * @brief Records a finished span on the calling thread's track.
+ *
+ * @param[in] name phase name, must outlive the trace.
+ * @param[in] detail extra label such as a file path, NULL if none; must outlive the trace.
+ * @param[in] start sln_utils_trace_now() at the start.
+ * @param[in] end sln_utils_trace_now() at the end.
+ */
+void sln_utils_trace_record(const char* name, const char* detail, uint64_t start, uint64_t end);
+
+/**
+ * @brief Names the calling thread's track.
+ */
+void sln_utils_trace_thread_name(const char* name);
+
+/**
+ * @brief Prints count, total, mean and max time of every phase.
+ */
+void sln_utils_trace_report(FILE* stream);
+
+/**
+ * @brief Writes the spans as Chrome trace events.
+ * @returns false if the file cannot be written.
+ */
+bool sln_utils_trace_write(const char* path);
+
+#if SLN_TRACE_ENABLED
+
+typedef struct {
+    const char* name;
+    const char* detail;
+    uint64_t start;         /**< 0 when not recording */
+} sln_utils_trace_scope_t;
+
+static inline void sln_utils_trace_scope_end(sln_utils_trace_scope_t* scope) {
+    if (scope->start) sln_utils_trace_record(scope->name, scope->detail, scope->start, sln_utils_trace_now());
+}
+
+#define _SLN_TRACE_CONCAT2(a, b) a##b
+#define _SLN_TRACE_CONCAT(a, b) _SLN_TRACE_CONCAT2(a, b)
+
+/**
+ * @brief Times the rest of the enclosing block as phase @p name.
+ */
+#define SLN_TRACE_SCOPE(name, detail)                                              \
+    __attribute__((cleanup(sln_utils_trace_scope_end)))                           \
+    sln_utils_trace_scope_t _SLN_TRACE_CONCAT(_sln_trace_scope_, __LINE__) =      \
+        { (name), (detail), sln_utils_trace_on() ? sln_utils_trace_now() : 0 }
+
+/**
+ * @brief Notes a start time, for spans that begin before tracing is switched on.
+ */
+#define SLN_TRACE_MARK(var) uint64_t var = sln_utils_trace_now()
+
+/**
+ * @brief Records phase @p name from SLN_TRACE_MARK(var) until now.
+ */
+#define SLN_TRACE_SPAN(name, detail, var) \
+    (sln_utils_trace_on() ? sln_utils_trace_record((name), (detail), (var), sln_utils_trace_now()) : (void)0)
+
+/**
+ * @brief Names the calling thread's track.
+ */
+#define SLN_TRACE_THREAD(name) \
+    (sln_utils_trace_on() ? sln_utils_trace_thread_name(name) : (void)0)
+
+#else
+
+#define SLN_TRACE_SCOPE(name, detail) ((void)0)
+#define SLN_TRACE_MARK(var) ((void)0)
+#define SLN_TRACE_SPAN(name, detail, var) ((void)0)
+#define SLN_TRACE_THREAD(name) ((void)0)
+
+#endif // SLN_TRACE_ENABLED
+
+#endif // SELENA_UTILS_TRACE_H_
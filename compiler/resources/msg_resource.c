@@ -9,6 +9,26 @@ const char* _msg_resource[] = {
     [SLN_MSG_INIT_ERRR] = "Error",
 
     [SLN_MSG_NO_ARGS] = "no input files",
+    [SLN_MSG_CANNOT_READ_FILE] = "cannot read source file",
+    [SLN_MSG_CANNOT_WRITE_FILE] = "cannot write file",
+
+    [SLN_MSG_LEX_INT_OVERFLOW] = "integer literal does not fit in u64",
+    [SLN_MSG_LEX_INVALID_CHARACTERS] = "invalid characters",
+    [SLN_MSG_LEX_UNTERMINATED_STRING] = "unterminated string literal",
+    [SLN_MSG_LEX_UNTERMINATED_CHAR] = "unterminated character literal",
+    [SLN_MSG_LEX_INVALID_UTF8] = "invalid UTF-8 sequence",
+    [SLN_MSG_LEX_TOO_MANY_ERRORS] = "too many errors, lexing stopped",
+    [SLN_MSG_PARSE_EXPECTED] = "expected",
+    [SLN_MSG_PARSE_EXPECTED_EXPRESSION] = "expected an expression",
+    [SLN_MSG_PARSE_EXPECTED_TYPE] = "expected a type",
+    [SLN_MSG_PARSE_EXPECTED_NAME] = "expected a name",
+    [SLN_MSG_PARSE_EXPECTED_ITEM] = "expected a declaration",
+    [SLN_MSG_PARSE_TOO_DEEP] = "nesting is too deep, parsing stopped",
+    [SLN_MSG_PARSE_TOO_MANY_ERRORS] = "too many errors, parsing stopped",
+    [SLN_MSG_SEMA_DUPLICATE] = "duplicate declaration",
+    [SLN_MSG_SEMA_UNRESOLVED] = "unresolved name",
+    [SLN_MSG_SEMA_EXPECTED_ENUMERATOR] = "expected an enumerator name",
+    [SLN_MSG_SEMA_VALUE_CONFLICT] = "enumerator value already taken",
 
 };
 
@@ -16,6 +16,31 @@ typedef enum {
     SLN_MSG_INIT_ERRR,
     
     SLN_MSG_NO_ARGS,
+    SLN_MSG_CANNOT_READ_FILE,
+    SLN_MSG_CANNOT_WRITE_FILE,
+
+    // lexer
+    SLN_MSG_LEX_INT_OVERFLOW,
+    SLN_MSG_LEX_INVALID_CHARACTERS,
+    SLN_MSG_LEX_UNTERMINATED_STRING,
+    SLN_MSG_LEX_UNTERMINATED_CHAR,
+    SLN_MSG_LEX_INVALID_UTF8,
+    SLN_MSG_LEX_TOO_MANY_ERRORS,
+
+    // parser
+    SLN_MSG_PARSE_EXPECTED,
+    SLN_MSG_PARSE_EXPECTED_EXPRESSION,
+    SLN_MSG_PARSE_EXPECTED_TYPE,
+    SLN_MSG_PARSE_EXPECTED_NAME,
+    SLN_MSG_PARSE_EXPECTED_ITEM,
+    SLN_MSG_PARSE_TOO_DEEP,
+    SLN_MSG_PARSE_TOO_MANY_ERRORS,
+
+    // names
+    SLN_MSG_SEMA_DUPLICATE,
+    SLN_MSG_SEMA_UNRESOLVED,
+    SLN_MSG_SEMA_EXPECTED_ENUMERATOR,
+    SLN_MSG_SEMA_VALUE_CONFLICT,
 
     // others
     _SLN_MSG_COUNT,
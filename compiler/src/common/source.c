@@ -0,0 +1,152 @@
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#   include <io.h>
+#   define _sln_read(fd, buf, len) _read((fd), (buf), (unsigned)(len))
+#   define _sln_close(fd) _close(fd)
+#else
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   define SLN_COMMON_SOURCE_MMAP 1
+#   define _sln_read(fd, buf, len) read((fd), (buf), (len))
+#   define _sln_close(fd) close(fd)
+#endif
+
+#include <utils/allocation.h>
+#include <common/source.h>
+
+// Heap buffers come zeroed; arena buffers only get their padding zeroed
+static char* _buffer(sln_utils_arena_t* arena, size_t size) {
+    return arena ? SLN_ARENA_ALLOC(arena, size, char) : SLN_ALLOC(size, char);
+}
+
+static void _release(sln_utils_arena_t* arena, char* buffer) {
+    if (!arena) sln_utils_free(buffer);
+}
+
+static bool _read_all(sln_common_source_t* source, int fd, size_t size_hint, sln_utils_arena_t* arena) {
+    size_t cap = size_hint + 1;
+    size_t len = 0;
+    char* buffer = _buffer(arena, cap + SLN_COMMON_SOURCE_PADDING);
+    if (!buffer) {
+        source->error = ENOMEM;
+        return false;
+    }
+
+    // A regular file is read in one call; the loop covers pipes and
+    // files that grew since fstat().
+    for (;;) {
+        if (len == cap) {
+            char* grown = _buffer(arena, cap * 2 + SLN_COMMON_SOURCE_PADDING);
+            if (!grown) {
+                _release(arena, buffer);
+                source->error = ENOMEM;
+                return false;
+            }
+            memcpy(grown, buffer, len);
+            _release(arena, buffer);
+            buffer = grown;
+            cap *= 2;
+        }
+        long got = (long)_sln_read(fd, buffer + len, cap - len);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            _release(arena, buffer);
+            source->error = errno;
+            return false;
+        }
+        if (got == 0) break;
+        len += (size_t)got;
+    }
+
+    if (arena) memset(buffer + len, 0, SLN_COMMON_SOURCE_PADDING);
+    source->text = buffer;
+    source->len = len;
+    source->region = arena ? NULL : buffer;
+    return true;
+}
+
+#if defined(SLN_COMMON_SOURCE_MMAP)
+static bool _map(sln_common_source_t* source, int fd, size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t region_len = (size + SLN_COMMON_SOURCE_PADDING + page - 1) / page * page;
+
+    // Reserve zero pages for the file plus padding, then map the file
+    // over their start. The tail of the last file page reads as zeros,
+    // and the anonymous pages after it cover a file that ends on a
+    // page boundary.
+    char* region = mmap(NULL, region_len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        source->error = errno;
+        return false;
+    }
+    if (mmap(region, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        source->error = errno;
+        munmap(region, region_len);
+        return false;
+    }
+    // The lexer makes one front-to-back pass
+    madvise(region, size, MADV_SEQUENTIAL);
+    madvise(region, size, MADV_WILLNEED);
+
+    source->text = region;
+    source->len = size;
+    source->region = region;
+    source->region_len = region_len;
+    return true;
+}
+#endif
+
+bool sln_common_source_load(sln_common_source_t* source, const char* path) {
+    return sln_common_source_load_in(source, path, NULL);
+}
+
+bool sln_common_source_load_in(sln_common_source_t* source, const char* path, sln_utils_arena_t* arena) {
+    memset(source, 0, sizeof(*source));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        source->error = errno;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        source->error = errno;
+        _sln_close(fd);
+        return false;
+    }
+
+    bool regular = S_ISREG(info.st_mode);
+    size_t size = regular ? (size_t)info.st_size : 0;
+    bool loaded;
+#if defined(SLN_COMMON_SOURCE_MMAP)
+    if (regular && size >= SLN_COMMON_SOURCE_MAP_THRESHOLD) {
+        loaded = _map(source, fd, size);
+    } else
+#endif
+    {
+        loaded = _read_all(source, fd, size, arena);
+    }
+
+    _sln_close(fd);
+    return loaded;
+}
+
+void sln_common_source_free(sln_common_source_t* source) {
+    if (!source) return;
+#if defined(SLN_COMMON_SOURCE_MMAP)
+    if (source->region_len) {
+        munmap(source->region, source->region_len);
+    } else
+#endif
+    {
+        sln_utils_free(source->region);
+    }
+    memset(source, 0, sizeof(*source));
+}
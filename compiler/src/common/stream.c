@@ -0,0 +1,72 @@
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#   include <io.h>
+#   define _sln_read(fd, buf, len) _read((fd), (buf), (unsigned)(len))
+#else
+#   include <unistd.h>
+#   define _sln_read(fd, buf, len) read((fd), (buf), (len))
+#endif
+
+#include <utils/allocation.h>
+#include <common/stream.h>
+
+// Zero bytes kept after the window: the terminating NUL plus room for
+// the widest aligned load of the scan kernels.
+#define SLN_COMMON_STREAM_PADDING 64u
+
+static bool _reserve(sln_common_stream_t* stream, size_t cap) {
+    if (cap <= stream->cap) return true;
+
+    char* data = SLN_ALLOC(cap + SLN_COMMON_STREAM_PADDING, char);
+    if (!data) return false;
+    if (stream->data) memcpy(data, stream->data, stream->len);
+    sln_utils_free(stream->data);
+    stream->data = data;
+    stream->cap = cap;
+    return true;
+}
+
+bool sln_common_stream_open_fd(sln_common_stream_t* stream, int fd, size_t chunk_size) {
+    memset(stream, 0, sizeof(*stream));
+    stream->fd = fd;
+    stream->chunk_size = chunk_size ? chunk_size : SLN_COMMON_STREAM_CHUNK_SIZE;
+    return _reserve(stream, stream->chunk_size * 2);
+}
+
+size_t sln_common_stream_fill(sln_common_stream_t* stream) {
+    if (stream->eof || stream->error) return 0;
+    if (stream->cap - stream->len < stream->chunk_size &&
+        !_reserve(stream, stream->cap * 2)) {
+        stream->error = ENOMEM;
+        return 0;
+    }
+
+    for (;;) {
+        long got = (long)_sln_read(stream->fd, stream->data + stream->len, stream->chunk_size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            stream->error = errno;
+            return 0;
+        }
+        if (got == 0) stream->eof = true;
+        stream->len += (size_t)got;
+        stream->data[stream->len] = '\0';
+        return (size_t)got;
+    }
+}
+
+void sln_common_stream_consume(sln_common_stream_t* stream, size_t count) {
+    memmove(stream->data, stream->data + count, stream->len - count);
+    stream->len -= count;
+    stream->base += count;
+    stream->data[stream->len] = '\0';
+}
+
+void sln_common_stream_close(sln_common_stream_t* stream) {
+    sln_utils_free(stream->data);
+    memset(stream, 0, sizeof(*stream));
+}
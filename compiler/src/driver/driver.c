@@ -0,0 +1,376 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include <driver/driver.h>
+#include <common/source.h>
+#include <common/stream.h>
+#include <lexer/lexer_cache.h>
+#include <lexer/lexer_stream.h>
+#include <utils/allocation.h>
+#include <utils/msg_errors.h>
+#include <utils/thread_pool.h>
+#include <utils/trace.h>
+
+// Buffered result of one unit, handed from its worker to the printer
+typedef struct {
+    const char* name;
+    const char* code;       /**< Text of a CODE argument, NULL for files */
+    char* out;
+    size_t out_len;
+    char* err;
+    size_t err_len;
+    bool failed;
+    bool done;
+} _sln_driver_result_t;
+
+// Scratch memory owned by one worker, on its own cache lines
+typedef struct {
+    _Alignas(SLN_UTILS_ARENA_ALIGNMENT) sln_lex_tokens_t tokens;
+    sln_utils_arena_t arena;    /**< Reset after every unit */
+} _sln_driver_scratch_t;
+
+typedef struct {
+    _sln_driver_result_t* results;
+    _sln_driver_scratch_t* scratch;
+    sln_utils_intern_t* symbols;
+    const sln_driver_options_t* options;
+    sln_utils_pool_t* pool;     /**< Also parses the chunks of large units */
+    mtx_t lock;
+    cnd_t done;             /**< Signalled when a result is done */
+} _sln_driver_t;
+
+typedef struct {
+    _sln_driver_t* driver;
+    size_t index;
+} _sln_driver_task_t;
+
+// Unit name that reads standard input
+#define SLN_DRIVER_STDIN "-"
+
+// Smaller units are lexed serially: splitting them gains less than
+// copying the tokens into the stream costs
+#define SLN_DRIVER_PARALLEL_LEX_MIN (1024UL * 1024UL)
+
+// The stream as a buffer in @p arena for the parser; its trivia stays behind
+static bool _expand_tokens(const sln_lex_tokens_t* tokens, sln_utils_arena_t* arena, sln_lex_token_buffer_t* buffer) {
+    buffer->tokens = SLN_ARENA_ALLOC(arena, tokens->len ? tokens->len : 1, sln_lex_token_t);
+    buffer->len = tokens->len;
+    if (!buffer->tokens) return false;
+    for (size_t i = 0; i < tokens->len; i++) {
+        buffer->tokens[i] = sln_lex_tokens_get(tokens, i);
+    }
+    return true;
+}
+
+// Lexes a large unit in parts on the pool, a small one straight into the stream
+static sln_lex_error_t _lex_unit(_sln_driver_t* driver, const char* text, size_t text_len,
+                                 sln_lex_tokens_t* tokens, FILE* err) {
+    size_t workers = sln_utils_pool_size(driver->pool);
+    if (text_len < SLN_DRIVER_PARALLEL_LEX_MIN || workers < 2) {
+        return sln_lex_generate_tokens(text, tokens, driver->symbols, err);
+    }
+
+    sln_lex_token_buffer_t buffer = {0};
+    sln_lex_error_t status = sln_lex_generate_parallel(text, &buffer, driver->symbols, err, workers, driver->pool);
+    for (size_t i = 0; status != SLN_LEX_ALLOCATION_FAILED && i < buffer.len; i++) {
+        if (!sln_lex_tokens_push(tokens, &buffer.tokens[i])) {
+            sln_lex_tokens_free(tokens);
+            status = SLN_LEX_ALLOCATION_FAILED;
+        }
+    }
+    sln_lex_free_tokens(&buffer);
+    return status;
+}
+
+// Lexes on a thread of its own while the parser takes the tokens; the
+// parser's diagnostics are held back so the output matches a serial run
+static sln_lex_error_t _pipe_unit(_sln_driver_t* driver, sln_utils_arena_t* arena, const char* text, FILE* err,
+                                  sln_lex_token_buffer_t* buffer, sln_ast_t* ast, sln_parse_error_t* parse_status) {
+    char* parse_err = NULL;
+    size_t parse_err_len = 0;
+    FILE* parse_stream = open_memstream(&parse_err, &parse_err_len);
+    if (!parse_stream) {
+        *parse_status = SLN_PARSE_ALLOCATION_FAILED;
+        return SLN_LEX_ALLOCATION_FAILED;
+    }
+
+    sln_lex_pipe_t* pipe;
+    sln_lex_error_t status = sln_lex_pipe_open(text, driver->symbols, err, &pipe);
+    if (status == SLN_LEX_OK) {
+        *parse_status = sln_parse_pipe(text, pipe, buffer, arena, parse_stream, ast);
+        status = sln_lex_pipe_close(pipe);
+    } else {
+        *parse_status = SLN_PARSE_NO_TOKEN_BUFFER;
+    }
+    if (status != SLN_LEX_OK) fprintf(err, "Lexer error: %d\n", status);
+    fclose(parse_stream);
+    if (parse_err) fwrite(parse_err, 1, parse_err_len, err);
+    free(parse_err);
+    return status;
+}
+
+// Lexes standard input as it arrives, handing every token to the token
+// hook; runs on the printer once every earlier unit is written, so @p out
+// and @p err are stdout and stderr and nothing is held back
+static bool _stream_unit(_sln_driver_t* driver, size_t index, FILE* out, FILE* err) {
+    const sln_driver_options_t* options = driver->options;
+    sln_common_stream_t input;
+    if (!sln_common_stream_open_fd(&input, STDIN_FILENO, 0)) {
+        fprintf(err, "Lexer error: %d\n", SLN_LEX_ALLOCATION_FAILED);
+        return false;
+    }
+
+    sln_driver_unit_t unit = { index, driver->results[index].name, NULL, NULL, driver->symbols,
+                               NULL, SLN_LEX_OK, SLN_PARSE_OK, 0 };
+    sln_lex_stream_t lexer;
+    sln_lex_error_t error = sln_lex_stream_init(&lexer, &input, driver->symbols, err);
+    sln_lex_token_t token = { .type = SLN_LEX_TOKEN_UNKNOWN };
+    while (error == SLN_LEX_OK && token.type != SLN_LEX_TOKEN_EOF) {
+        error = sln_lex_stream_next(&lexer, &token, NULL);
+        if (error != SLN_LEX_OK) break;
+        if (options->token) options->token(&unit, sln_lex_stream_window(&lexer), &token, out, options->user);
+        unit.streamed++;
+    }
+    if (error == SLN_LEX_READ_FAILED) {
+        sln_utils_msg_print_detail(SLN_MSG_CANNOT_READ_FILE, SLN_UTILS_MSG_TYPE_ERRR,
+                                   unit.name, strerror(input.error), err);
+    }
+    unit.status = error != SLN_LEX_OK ? error : lexer.status;
+    if (unit.status != SLN_LEX_OK) fprintf(err, "Lexer error: %d\n", unit.status);
+
+    if (options->emit) {
+        SLN_TRACE_SCOPE("emit", unit.name);
+        options->emit(&unit, out, options->user);
+    }
+    sln_common_stream_close(&input);
+    return unit.status == SLN_LEX_OK;
+}
+
+// Reads standard input to its end; the window is then the whole text
+static bool _read_stdin(sln_common_stream_t* input) {
+    if (!sln_common_stream_open_fd(input, STDIN_FILENO, 0)) {
+        input->error = ENOMEM;
+        return false;
+    }
+    while (sln_common_stream_fill(input) > 0) continue;
+    return input->error == 0;
+}
+
+static bool _from_stdin(const _sln_driver_result_t* result) {
+    return !result->code && strcmp(result->name, SLN_DRIVER_STDIN) == 0;
+}
+
+// Whether unit @p index is lexed as it arrives instead of on the pool
+static bool _is_streamed(const _sln_driver_t* driver, size_t index) {
+    return _from_stdin(&driver->results[index]) && !driver->options->parse;
+}
+
+static bool _compile_unit(_sln_driver_t* driver, size_t index, size_t worker, FILE* out, FILE* err) {
+    _sln_driver_result_t* result = &driver->results[index];
+    _sln_driver_scratch_t* scratch = &driver->scratch[worker];
+    bool from_stdin = _from_stdin(result);
+
+    sln_common_source_t source = {0};
+    sln_common_stream_t input = {0};
+    const char* text = result->code;
+    size_t text_len = text ? strlen(text) : 0;
+    if (from_stdin) {
+        if (!_read_stdin(&input)) {
+            sln_utils_msg_print_detail(SLN_MSG_CANNOT_READ_FILE, SLN_UTILS_MSG_TYPE_ERRR,
+                                       result->name, strerror(input.error), err);
+            sln_common_stream_close(&input);
+            return false;
+        }
+        text = input.data;
+        text_len = strlen(text);
+    } else if (!text) {
+        SLN_TRACE_MARK(load_start);
+        bool loaded = sln_common_source_load_in(&source, result->name, &scratch->arena);
+        SLN_TRACE_SPAN("load", result->name, load_start);
+        if (!loaded) {
+            sln_utils_msg_print_detail(SLN_MSG_CANNOT_READ_FILE, SLN_UTILS_MSG_TYPE_ERRR,
+                                       result->name, strerror(source.error), err);
+            sln_utils_arena_reset(&scratch->arena);
+            return false;
+        }
+        text = source.text;
+        text_len = source.len;
+    }
+
+    const char* cache_dir = from_stdin ? NULL : driver->options->cache_dir;
+    uint64_t key = cache_dir ? sln_lex_cache_key(text, text_len) : 0;
+    sln_lex_cache_entry_t cached = {0};
+    const sln_lex_tokens_t* tokens = &scratch->tokens;
+    sln_lex_error_t status = SLN_LEX_OK;
+    sln_ast_t ast = {0};
+    sln_parse_error_t parse_status = SLN_PARSE_OK;
+    sln_lex_token_buffer_t piped = {0};
+    if (cache_dir && sln_lex_cache_load(cache_dir, key, text_len, driver->symbols, &cached)) {
+        tokens = &cached.tokens;
+    } else if (driver->options->parse && driver->options->pipeline) {
+        // The pipe drops trivia and the parser keeps its batches, so there is nothing to cache
+        tokens = NULL;
+        status = _pipe_unit(driver, &scratch->arena, text, err, &piped, &ast, &parse_status);
+        if (parse_status != SLN_PARSE_OK) fprintf(err, "Parser error: %d\n", parse_status);
+    } else {
+        sln_lex_tokens_clear(&scratch->tokens);
+        status = _lex_unit(driver, text, text_len, &scratch->tokens, err);
+        if (status != SLN_LEX_OK) {
+            fprintf(err, "Lexer error: %d\n", status);
+        } else if (cache_dir) {
+            // Best effort: a unit that cannot be cached is only lexed again next time
+            sln_lex_cache_store(cache_dir, key, text_len, tokens, driver->symbols);
+        }
+    }
+
+    if (driver->options->parse && tokens) {
+        sln_lex_token_buffer_t buffer = {0};
+        parse_status = _expand_tokens(tokens, &scratch->arena, &buffer)
+            ? sln_parse_parallel(text, &buffer, &scratch->arena, err, &ast, driver->pool, 0)
+            : SLN_PARSE_ALLOCATION_FAILED;
+        if (parse_status != SLN_PARSE_OK) fprintf(err, "Parser error: %d\n", parse_status);
+    }
+
+    if (driver->options->emit) {
+        SLN_TRACE_SCOPE("emit", result->name);
+        sln_driver_unit_t unit = { index, result->name, text, tokens, driver->symbols,
+                                   driver->options->parse ? &ast : NULL, status, parse_status, 0 };
+        driver->options->emit(&unit, out, driver->options->user);
+    }
+
+    sln_lex_free_tokens(&piped);
+    sln_lex_cache_release(&cached);
+    sln_common_source_free(&source);
+    sln_common_stream_close(&input);
+    sln_utils_arena_reset(&scratch->arena);
+    return status == SLN_LEX_OK && parse_status == SLN_PARSE_OK;
+}
+
+static void _run_unit(void* arg, size_t worker) {
+    _sln_driver_task_t* task = arg;
+    _sln_driver_t* driver = task->driver;
+    _sln_driver_result_t* result = &driver->results[task->index];
+    SLN_TRACE_SCOPE("file", result->name);
+
+    FILE* out = open_memstream(&result->out, &result->out_len);
+    FILE* err = open_memstream(&result->err, &result->err_len);
+    bool ok = out && err && _compile_unit(driver, task->index, worker, out, err);
+    if (out) fclose(out);
+    if (err) fclose(err);
+
+    mtx_lock(&driver->lock);
+    result->failed = !ok;
+    result->done = true;
+    cnd_broadcast(&driver->done);
+    mtx_unlock(&driver->lock);
+}
+
+// Prints results in unit order as they complete; streamed units are
+// lexed here in their turn while the pool goes on with later units
+static sln_exit_code_t _print_results(_sln_driver_t* driver, size_t count) {
+    sln_exit_code_t exit_code = SLN_EXIT_SUCCESS;
+    for (size_t i = 0; i < count; i++) {
+        _sln_driver_result_t* result = &driver->results[i];
+        if (_is_streamed(driver, i)) {
+            SLN_TRACE_SCOPE("file", result->name);
+            if (!_stream_unit(driver, i, stdout, stderr)) exit_code = SLN_EXIT_FAILURE;
+            fflush(stdout);
+            continue;
+        }
+        mtx_lock(&driver->lock);
+        while (!result->done) cnd_wait(&driver->done, &driver->lock);
+        mtx_unlock(&driver->lock);
+
+        if (result->out) fwrite(result->out, 1, result->out_len, stdout);
+        fflush(stdout);
+        if (result->err) fwrite(result->err, 1, result->err_len, stderr);
+        if (result->failed) exit_code = SLN_EXIT_FAILURE;
+        free(result->out);
+        free(result->err);
+        result->out = NULL;
+        result->err = NULL;
+    }
+    return exit_code;
+}
+
+sln_exit_code_t sln_driver_run(const sln_input_arg_t* args, size_t arg_count,
+                               sln_utils_intern_t* symbols,
+                               const sln_driver_options_t* options) {
+    size_t count = 0;
+    for (size_t i = 0; i < arg_count; i++) {
+        if (args[i].type == SLN_IN_ARG_TYPE_FILE || args[i].type == SLN_IN_ARG_TYPE_CODE) count++;
+    }
+    if (count == 0) return SLN_EXIT_SUCCESS;
+
+    size_t jobs = options->jobs ? options->jobs : sln_utils_cpu_count();
+    // Workers beyond the unit count help lex and parse large units
+    if (jobs > SLN_UTILS_POOL_MAX_WORKERS) jobs = SLN_UTILS_POOL_MAX_WORKERS;
+
+    // Bookkeeping of the run, released at once at the end
+    sln_utils_arena_t arena;
+    sln_utils_arena_init(&arena, "driver", 0);
+    _sln_driver_t driver = { .symbols = symbols, .options = options };
+    driver.results = SLN_ARENA_ALLOC_ZERO(&arena, count, _sln_driver_result_t);
+    driver.scratch = SLN_ARENA_ALLOC_ZERO(&arena, jobs, _sln_driver_scratch_t);
+    _sln_driver_task_t* tasks = SLN_ARENA_ALLOC(&arena, count, _sln_driver_task_t);
+    if (!driver.results || !driver.scratch || !tasks) {
+        sln_utils_arena_free(&arena);
+        return SLN_EXIT_FAILURE_INTERNAL;
+    }
+    if (mtx_init(&driver.lock, mtx_plain) != thrd_success) {
+        sln_utils_arena_free(&arena);
+        return SLN_EXIT_FAILURE_INTERNAL;
+    }
+    if (cnd_init(&driver.done) != thrd_success) {
+        mtx_destroy(&driver.lock);
+        sln_utils_arena_free(&arena);
+        return SLN_EXIT_FAILURE_INTERNAL;
+    }
+    for (size_t i = 0; i < jobs; i++) {
+        sln_utils_arena_init(&driver.scratch[i].arena, "scratch", 0);
+    }
+
+    size_t unit = 0;
+    for (size_t i = 0; i < arg_count; i++) {
+        if (args[i].type == SLN_IN_ARG_TYPE_FILE) {
+            driver.results[unit++].name = args[i].cstr;
+        } else if (args[i].type == SLN_IN_ARG_TYPE_CODE) {
+            driver.results[unit].name = "<code>";
+            driver.results[unit++].code = args[i].cstr;
+        }
+    }
+
+    sln_exit_code_t exit_code = SLN_EXIT_FAILURE_INTERNAL;
+    sln_utils_pool_t* pool = sln_utils_pool_create(jobs);
+    driver.pool = pool;
+    if (pool) {
+        size_t submitted = 0;
+        for (; submitted < count; submitted++) {
+            tasks[submitted] = (_sln_driver_task_t){ &driver, submitted };
+            if (_is_streamed(&driver, submitted)) continue;
+            if (!sln_utils_pool_submit(pool, _run_unit, &tasks[submitted])) break;
+        }
+        if (submitted == count) {
+            exit_code = _print_results(&driver, count);
+        }
+        sln_utils_pool_destroy(pool);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        free(driver.results[i].out);
+        free(driver.results[i].err);
+    }
+    for (size_t i = 0; i < jobs; i++) {
+        sln_lex_tokens_free(&driver.scratch[i].tokens);
+        sln_utils_arena_free(&driver.scratch[i].arena);
+    }
+    cnd_destroy(&driver.done);
+    mtx_destroy(&driver.lock);
+    sln_utils_arena_free(&arena);
+    return exit_code;
+}
@@ -2,83 +2,130 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
-#include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <threads.h>
+#include <stdatomic.h>
 
 #include <utils/allocation.h>
 #include <lexer/lexer.h>
 #include <lexer/lexer_errors.h>
+#include <lexer/lexer_tables.h>
+#include <lexer/lexer_scan.h>
+#include <lexer/lexer_number.h>
+#include <lexer/lexer_tokens.h>
+#include <lexer/lexer_stream.h>
+#include <lexer/lexer_pipe.h>
+#include <lexer/lexer_lines.h>
+#include <lexer/lexer_utf8.h>
+#include <utils/msg_errors.h>
+#include <utils/spsc_ring.h>
+#include <utils/trace.h>
 
 #define SLN_LEXER_INITIAL_SIZE 1024UL
 #define SLN_LEXER_GROW_FACTOR 2
 #define SLN_LEXER_SMALL_STRING_SIZE 64
+// Bytes past a token end that deciding the token may have looked at
+#define SLN_LEXER_LOOKAHEAD 8
+// Parallel lexing does not split texts into chunks smaller than this
+#define SLN_LEXER_PARALLEL_MIN_CHUNK (256UL * 1024UL)
+#define SLN_LEXER_PARALLEL_MAX_THREADS 64
 
-static struct {
-    const char* keyword;
-    sln_lex_token_type_t type;
-    uint8_t length;
-} _keyword_table[] = {
-    {"ARGS",      SLN_LEX_TOKEN_KW_ARGS, 4},
-    {"MAIN",      SLN_LEX_TOKEN_KW_MAIN, 4},
-    {"bln",       SLN_LEX_TOKEN_KW_BLN, 3},
-    {"break",     SLN_LEX_TOKEN_KW_BREAK, 5},
-    {"case",      SLN_LEX_TOKEN_KW_CASE, 4},
-    {"continue",  SLN_LEX_TOKEN_KW_CONTINUE, 8},
-    {"default",   SLN_LEX_TOKEN_KW_DEFAULT, 7},
-    {"else",      SLN_LEX_TOKEN_KW_ELSE, 4},
-    {"enum",      SLN_LEX_TOKEN_KW_ENUM, 4},
-    {"for",       SLN_LEX_TOKEN_KW_FOR, 3},
-    {"i16",       SLN_LEX_TOKEN_KW_I16, 3},
-    {"i32",       SLN_LEX_TOKEN_KW_I32, 3},
-    {"i64",       SLN_LEX_TOKEN_KW_I64, 3},
-    {"i8",        SLN_LEX_TOKEN_KW_I8, 2},
-    {"if",        SLN_LEX_TOKEN_KW_IF, 2},
-    {"namespace", SLN_LEX_TOKEN_KW_NAMESPACE, 9},
-    {"nil",       SLN_LEX_TOKEN_KW_NIL, 3},
-    {"return",    SLN_LEX_TOKEN_KW_RETURN, 6},
-    {"str",       SLN_LEX_TOKEN_KW_STR, 3},
-    {"struct",    SLN_LEX_TOKEN_KW_STRUCT, 6},
-    {"switch",    SLN_LEX_TOKEN_KW_SWITCH, 6},
-    {"type",      SLN_LEX_TOKEN_KW_TYPE, 4},
-    {"u16",       SLN_LEX_TOKEN_KW_U16, 3},
-    {"u32",       SLN_LEX_TOKEN_KW_U32, 3},
-    {"u64",       SLN_LEX_TOKEN_KW_U64, 3},
-    {"u8",        SLN_LEX_TOKEN_KW_U8, 2},
-    {"use",       SLN_LEX_TOKEN_KW_USE, 3},
-    {"usize",     SLN_LEX_TOKEN_KW_USIZE, 5},
-    {"var",       SLN_LEX_TOKEN_KW_VAR, 3},
-    {"while",     SLN_LEX_TOKEN_KW_WHILE, 5}
-};
+/**
+ * @struct _sln_lex_diag_t
+ * @brief Diagnostic held back until its token is known to be kept.
+ */
+typedef struct {
+    size_t offset;              /**< At or after the start of the reporting token */
+    sln_lex_error_t error;
+    sln_res_msg_t msg;
+} _sln_lex_diag_t;
 
-static const size_t _keyword_table_size = sizeof(_keyword_table) / sizeof(_keyword_table[0]);
+typedef struct {
+    _sln_lex_diag_t* items;
+    size_t len;
+    size_t cap;
+    bool failed;                /**< A diagnostic was lost to an allocation failure */
+} _sln_lex_diags_t;
 
-static inline bool _is_newline(const char* text, size_t* pos) {
-    if (text[*pos] == '\n') {
-        (*pos)++;
-        return true;
+/**
+ * @struct _sln_lex_ctx_t
+ * @brief State shared by the token parsers of one sln_lex_generate() call.
+ */
+typedef struct {
+    const char* text;
+    sln_utils_intern_t* symbols;
+    FILE* error_stream;
+    sln_lex_error_t status;     /**< First diagnostic reported */
+    size_t limit;               /**< End of the text seen so far, SIZE_MAX if complete */
+    uint64_t base;              /**< Input offset of text[0] */
+    bool defer_symbols;         /**< Leave hashes (identifiers) and escape flags (strings) in `data` */
+    _sln_lex_diags_t* diags;    /**< Collects diagnostics instead of printing them if set */
+    sln_lex_lines_t* lines;     /**< Whole text, to report lines and columns; NULL for byte offsets */
+    size_t errors_left;         /**< Diagnostics until lexing stops, SIZE_MAX for no limit */
+} _sln_lex_ctx_t;
+
+// A token ending this close to the limit may change once more text
+// arrives, so it has no side effects (interning, diagnostics) yet.
+static inline bool _is_provisional(const _sln_lex_ctx_t* ctx, size_t end) {
+    return end + SLN_LEXER_LOOKAHEAD > ctx->limit;
+}
+
+static bool _diags_push(_sln_lex_diags_t* diags, _sln_lex_diag_t diag) {
+    if (diags->len == diags->cap) {
+        size_t cap = diags->cap ? diags->cap * SLN_LEXER_GROW_FACTOR : 16;
+        _sln_lex_diag_t* items = SLN_ALLOC(cap, _sln_lex_diag_t);
+        if (!items) {
+            diags->failed = true;
+            return false;
+        }
+        if (diags->items) memcpy(items, diags->items, diags->len * sizeof(*items));
+        sln_utils_free(diags->items);
+        diags->items = items;
+        diags->cap = cap;
     }
-    if (text[*pos] == '\r' && text[*pos + 1] == '\n') {
-        *pos += 2;
-        return true;
+    diags->items[diags->len++] = diag;
+    return true;
+}
+
+static void _report(_sln_lex_ctx_t* ctx, sln_lex_error_t error, sln_res_msg_t msg, size_t offset) {
+    if (ctx->errors_left == 0) return;
+    ctx->errors_left--;
+    if (ctx->diags) {
+        _diags_push(ctx->diags, (_sln_lex_diag_t){ offset, error, msg });
+        return;
     }
-    return false;
+    if (ctx->status == SLN_LEX_OK) ctx->status = error;
+    sln_lex_location_t location;
+    if (ctx->lines && sln_lex_lines_locate(ctx->lines, offset, &location)) {
+        sln_utils_msg_print_at_line(msg, SLN_UTILS_MSG_TYPE_ERRR, location.line, location.column, ctx->error_stream);
+    } else {
+        sln_utils_msg_print_at(msg, SLN_UTILS_MSG_TYPE_ERRR, (size_t)ctx->base + offset, ctx->error_stream);
+    }
+    if (ctx->errors_left == 0) sln_utils_msg_print(SLN_MSG_LEX_TOO_MANY_ERRORS, SLN_UTILS_MSG_TYPE_ERRR, ctx->error_stream);
+}
+
+static inline uint8_t _digit_value(char c) {
+    // Valid for any byte carrying SLN_LEX_CF_XDIGIT
+    return (uint8_t)(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
 }
 
-static inline bool _is_whitespace(const char* text, size_t* pos) {
+static inline void _skip_blanks(const char* text, size_t* pos) {
+    (*pos)++;
+    // Single blanks between tokens are not worth a kernel call
     if (text[*pos] == ' ' || text[*pos] == '\t') {
-        (*pos)++;
-        return true;
+        *pos = (size_t)(sln_lex_scan.skip_blanks(text + *pos) - text);
     }
-    return false;
 }
 
-static sln_lex_token_type_t _get_keyword_type(const char* str, size_t len) {
-    for (size_t i = 0; i < _keyword_table_size; i++) {
-        if (_keyword_table[i].length == len && 
-            memcmp(_keyword_table[i].keyword, str, len) == 0) {
-            return _keyword_table[i].type;
-        }
+static inline sln_lex_token_type_t _get_keyword_type(const char* str, size_t len) {
+    if (len < SLN_LEX_KEYWORD_MIN_LEN || len > SLN_LEX_KEYWORD_MAX_LEN) return SLN_LEX_TOKEN_UNKNOWN;
+    
+    uint32_t slot = _sln_lex_keyword_slot(str, len);
+    if (_sln_lex_keyword_hash[slot].length == len &&
+        memcmp(_sln_lex_keyword_hash[slot].text, str, len) == 0) {
+        return (sln_lex_token_type_t)_sln_lex_keyword_hash[slot].type;
     }
     return SLN_LEX_TOKEN_UNKNOWN;
 }
@@ -99,63 +146,39 @@ static char _process_escape_sequence(const char* text, size_t* pos) {
         case '0': (*pos)++; return '\0';
         case 'x': {
             (*pos)++;
-            if (!isxdigit(text[*pos])) return 0;
-            char hex[3] = {0};
-            hex[0] = text[(*pos)++];
-            if (isxdigit(text[*pos])) hex[1] = text[(*pos)++];
-            return (char)strtoul(hex, NULL, 16);
+            if (!(_sln_lex_char_flags[(uint8_t)text[*pos]] & SLN_LEX_CF_XDIGIT)) return 0;
+            uint8_t value = _digit_value(text[(*pos)++]);
+            if (_sln_lex_char_flags[(uint8_t)text[*pos]] & SLN_LEX_CF_XDIGIT) {
+                value = (uint8_t)(value << 4 | _digit_value(text[(*pos)++]));
+            }
+            return (char)value;
         }
+        case '\0': return 0;   // Text ends after the backslash
         default: return text[(*pos)++];
     }
 }
 
 static bool _parse_comment(const char* text, size_t* pos, sln_lex_token_t* token) {
     if (text[*pos] == '#' && text[*pos + 1] != '#') {
-        (*pos)++;
-        size_t content_start = *pos;
-        while (text[*pos] != '\0' && !_is_newline(text, pos)) (*pos)++;
-        
-        size_t length = *pos - content_start;
-        if (length > 0) {
-            char* comment_str = SLN_ALLOC(length + 1, char);
-            if (!comment_str) return false;
-            memcpy(comment_str, text + content_start, length);
-            comment_str[length] = '\0';
-            token->data.cstr = comment_str;
-        }
+        // The comment takes its line break with it
+        const char* end = sln_lex_scan.find_eol(text + *pos + 1);
+        *pos = (size_t)(end - text) + (*end == '\n');
         token->type = SLN_LEX_TOKEN_COMMENT;
         return true;
     }
     
     if (text[*pos] == '#' && text[*pos + 1] == '#') {
-        *pos += 2;
-        size_t content_start = *pos;
-        
-        while (text[*pos] != '\0') {
-            if (text[*pos] == '#' && text[*pos + 1] == '#') {
-                size_t content_length = *pos - content_start;
-                if (content_length > 0) {
-                    char* comment_str = SLN_ALLOC(content_length + 1, char);
-                    if (!comment_str) return false;
-                    memcpy(comment_str, text + content_start, content_length);
-                    comment_str[content_length] = '\0';
-                    token->data.cstr = comment_str;
-                }
-                token->type = SLN_LEX_TOKEN_COMMENT;
-                *pos += 2;
-                return true;
+        const char* end = text + *pos + 2;
+        for (;;) {
+            end = sln_lex_scan.find_hash(end);
+            if (*end == '\0') break;
+            if (end[1] == '#') {
+                end += 2;
+                break;
             }
-            (*pos)++;
-        }
-        
-        size_t content_length = *pos - content_start;
-        if (content_length > 0) {
-            char* comment_str = SLN_ALLOC(content_length + 1, char);
-            if (!comment_str) return false;
-            memcpy(comment_str, text + content_start, content_length);
-            comment_str[content_length] = '\0';
-            token->data.cstr = comment_str;
+            end++;
         }
+        *pos = (size_t)(end - text);
         token->type = SLN_LEX_TOKEN_COMMENT;
         return true;
     }
@@ -163,11 +186,28 @@ static bool _parse_comment(const char* text, size_t* pos, sln_lex_token_t* token
     return false;
 }
 
-static bool _parse_identifier(const char* text, size_t* pos, sln_lex_token_t* token) {
+static bool _parse_identifier(_sln_lex_ctx_t* ctx, size_t* pos, sln_lex_token_t* token) {
+    const char* text = ctx->text;
     size_t start = *pos;
-    while (isalnum(text[*pos]) || text[*pos] == '_') (*pos)++;
+    uint32_t hash = SLN_UTILS_INTERN_HASH_INIT;
+    for (;;) {
+        while (_sln_lex_char_flags[(uint8_t)text[*pos]] & SLN_LEX_CF_IDENT) {
+            hash = sln_utils_intern_hash_step(hash, text[*pos]);
+            (*pos)++;
+        }
+        if ((uint8_t)text[*pos] < 0x80) break;
+        
+        // Only non-ASCII identifiers get here past their ASCII run
+        uint32_t code_point;
+        size_t len = sln_lex_utf8_decode(text + *pos, &code_point);
+        if (!len || !sln_lex_utf8_is_ident(code_point)) break;
+        for (size_t end = *pos + len; *pos < end; (*pos)++) {
+            hash = sln_utils_intern_hash_step(hash, text[*pos]);
+        }
+    }
     
     size_t length = *pos - start;
+    if (length == 0) return false;
     sln_lex_token_type_t keyword_type = _get_keyword_type(text + start, length);
     
     if (keyword_type != SLN_LEX_TOKEN_UNKNOWN) {
@@ -176,194 +216,173 @@ static bool _parse_identifier(const char* text, size_t* pos, sln_lex_token_t* to
     }
     
     token->type = SLN_LEX_TOKEN_IDENTIFIER;
-    char* identifier = SLN_ALLOC(length + 1, char);
-    if (!identifier) return false;
-    memcpy(identifier, text + start, length);
-    identifier[length] = '\0';
-    token->data.cstr = identifier;
-    return true;
+    if (ctx->defer_symbols) {
+        token->data.u64 = hash;
+        return true;
+    }
+    if (_is_provisional(ctx, *pos)) return true;
+    token->data.sym = sln_utils_intern_put(ctx->symbols, text + start, length, hash);
+    return token->data.sym != SLN_UTILS_SYM_NONE;
 }
 
-static bool _parse_string(const char* text, size_t* pos, sln_lex_token_t* token, FILE* error_stream) {
-    (*pos)++;
-    (void)error_stream;
-    char stack_buffer[SLN_LEXER_SMALL_STRING_SIZE];
-    char* buffer = stack_buffer;
-    size_t buf_size = SLN_LEXER_SMALL_STRING_SIZE;
-    size_t buf_len = 0;
-    
-    while (text[*pos] != '\0' && text[*pos] != '"') {
-        if (buf_len >= buf_size - 1) {
-            buf_size *= 2;
-            char* new_buf = SLN_ALLOC(buf_size, char);
-            if (!new_buf) {
-                if (buffer != stack_buffer) free(buffer);
-                return false;
-            }
-            memcpy(new_buf, buffer, buf_len);
-            if (buffer != stack_buffer) free(buffer);
-            buffer = new_buf;
-        }
-        
-        if (text[*pos] == '\\') {
-            buffer[buf_len++] = _process_escape_sequence(text, pos);
-        } else {
-            buffer[buf_len++] = text[(*pos)++];
-        }
+// Interns the value of the string literal whose content is [start, end)
+static sln_utils_sym_t _string_symbol(_sln_lex_ctx_t* ctx, size_t start, size_t end, bool has_escape) {
+    const char* text = ctx->text;
+    if (!has_escape) return sln_utils_intern(ctx->symbols, text + start, end - start);
+    
+    char stack_buffer[SLN_LEXER_SMALL_STRING_SIZE] = {0};
+    char* decoded = stack_buffer;
+    if (end - start > sizeof(stack_buffer)) {
+        decoded = SLN_ALLOC(end - start, char);
+        if (!decoded) return SLN_UTILS_SYM_NONE;
     }
     
-    if (text[*pos] == '"') {
-        (*pos)++;
-        buffer[buf_len] = '\0';
-        
-        if (buffer == stack_buffer) {
-            char* final_str = SLN_ALLOC(buf_len + 1, char);
-            if (final_str) {
-                memcpy(final_str, buffer, buf_len + 1);
-                token->data.cstr = final_str;
-            } else {
-                return false;
-            }
+    size_t len = 0;
+    for (size_t pos = start; pos < end;) {
+        if (text[pos] == '\\') {
+            decoded[len++] = _process_escape_sequence(text, &pos);
         } else {
-            if (buf_len + 1 < buf_size / 2) {
-                char* final_str = SLN_ALLOC(buf_len + 1, char);
-                if (final_str) {
-                    memcpy(final_str, buffer, buf_len + 1);
-                    free(buffer);
-                    token->data.cstr = final_str;
-                } else {
-                    token->data.cstr = buffer;
-                }
-            } else {
-                token->data.cstr = buffer;
-            }
+            decoded[len++] = text[pos++];
         }
-        
-        token->type = SLN_LEX_TOKEN_STRING_LITERAL;
-        return true;
     }
-    
-    if (buffer != stack_buffer) free(buffer);
-    return false;
+    sln_utils_sym_t sym = sln_utils_intern(ctx->symbols, decoded, len);
+    if (decoded != stack_buffer) sln_utils_free(decoded);
+    return sym;
 }
 
-static bool _parse_hex_number(const char* text, size_t* pos, sln_lex_token_t* token) {
-    *pos += 2;
+static bool _parse_string(_sln_lex_ctx_t* ctx, size_t* pos, sln_lex_token_t* token) {
+    const char* text = ctx->text;
+    (*pos)++;
     size_t start = *pos;
+    bool has_escape = false;
     
-    while (isxdigit(text[*pos])) (*pos)++;
-    
-    size_t length = *pos - start;
-    if (length == 0) return false;
+    // The first pass only finds the closing quote, so escape-free
+    // strings are interned straight from the source.
+    const char* cursor = text + start;
+    for (;;) {
+        cursor = sln_lex_scan.find_quote(cursor);
+        if (*cursor != '\\') break;
+        has_escape = true;
+        if (cursor[1] == '\0') {
+            cursor++;
+            break;
+        }
+        cursor += 2;
+    }
+    size_t end = (size_t)(cursor - text);
+    if (text[end] != '"') {
+        *pos = end;
+        return false;
+    }
     
-    char* num_str = SLN_ALLOC(length + 1, char);
-    if (!num_str) return false;
+    *pos = end + 1;
+    token->type = SLN_LEX_TOKEN_STRING_LITERAL;
     
-    memcpy(num_str, text + start, length);
-    num_str[length] = '\0';
-    token->type = SLN_LEX_TOKEN_INT_LITERAL;
-    token->data.u64 = strtoull(num_str, NULL, 16);
-    free(num_str);
-    return true;
+    if (ctx->defer_symbols) {
+        token->data.u64 = has_escape;
+        return true;
+    }
+    if (_is_provisional(ctx, end + 1)) {
+        token->data.sym = SLN_UTILS_SYM_NONE;
+        return true;
+    }
+    token->data.sym = _string_symbol(ctx, start, end, has_escape);
+    return token->data.sym != SLN_UTILS_SYM_NONE;
 }
 
-static bool _parse_binary_number(const char* text, size_t* pos, sln_lex_token_t* token) {
-    *pos += 2;
+// Accumulates the digits at *pos that carry `flag`; on overflow the
+// value saturates to UINT64_MAX and a diagnostic is reported.
+static size_t _parse_integer_digits(_sln_lex_ctx_t* ctx, size_t* pos, sln_lex_token_t* token,
+                                    uint8_t flag, unsigned shift, size_t literal_start) {
+    const char* text = ctx->text;
     size_t start = *pos;
+    uint64_t value = 0;
+    bool overflow = false;
     
-    while (text[*pos] == '0' || text[*pos] == '1') (*pos)++;
-    
-    size_t length = *pos - start;
-    if (length == 0) return false;
-    
-    char* num_str = SLN_ALLOC(length + 1, char);
-    if (!num_str) return false;
+    for (char c; _sln_lex_char_flags[(uint8_t)(c = text[*pos])] & flag; (*pos)++) {
+        uint64_t digit = _digit_value(c);
+        if (shift) {
+            // Power-of-two bases: the bits shifted out must be zero
+            overflow |= (value >> (64 - shift)) != 0;
+            value = value << shift | digit;
+        } else {
+            overflow |= __builtin_mul_overflow(value, 10u, &value);
+            overflow |= __builtin_add_overflow(value, digit, &value);
+        }
+    }
     
-    memcpy(num_str, text + start, length);
-    num_str[length] = '\0';
     token->type = SLN_LEX_TOKEN_INT_LITERAL;
-    token->data.u64 = strtoull(num_str, NULL, 2);
-    free(num_str);
-    return true;
+    token->data.u64 = overflow ? UINT64_MAX : value;
+    if (overflow && !_is_provisional(ctx, *pos)) _report(ctx, SLN_LEX_INTEGER_OVERFLOW, SLN_MSG_LEX_INT_OVERFLOW, literal_start);
+    return *pos - start;
 }
 
-static bool _parse_octal_number(const char* text, size_t* pos, sln_lex_token_t* token) {
+static bool _parse_decimal_number(_sln_lex_ctx_t* ctx, size_t* pos, sln_lex_token_t* token) {
+    const char* text = ctx->text;
     size_t start = *pos;
-    while (text[*pos] >= '0' && text[*pos] <= '7') (*pos)++;
     
-    size_t length = *pos - start;
-    if (length == 0) return false;
-    
-    char* num_str = SLN_ALLOC(length + 1, char);
-    if (!num_str) return false;
+    while (_sln_lex_char_flags[(uint8_t)text[*pos]] & SLN_LEX_CF_DIGIT) (*pos)++;
     
-    memcpy(num_str, text + start, length);
-    num_str[length] = '\0';
-    token->type = SLN_LEX_TOKEN_INT_LITERAL;
-    token->data.u64 = strtoull(num_str, NULL, 8);
-    free(num_str);
-    return true;
-}
-
-static bool _parse_decimal_number(const char* text, size_t* pos, sln_lex_token_t* token) {
-    size_t start = *pos;
-    bool has_decimal = false;
+    bool has_decimal = text[*pos] == '.';
     bool has_exponent = false;
-    
-    while (isdigit(text[*pos])) (*pos)++;
-    
-    if (text[*pos] == '.') {
-        has_decimal = true;
+    if (has_decimal) {
         (*pos)++;
-        while (isdigit(text[*pos])) (*pos)++;
+        while (_sln_lex_char_flags[(uint8_t)text[*pos]] & SLN_LEX_CF_DIGIT) (*pos)++;
     }
     
     if (text[*pos] == 'e' || text[*pos] == 'E') {
         has_exponent = true;
         (*pos)++;
         if (text[*pos] == '+' || text[*pos] == '-') (*pos)++;
-        while (isdigit(text[*pos])) (*pos)++;
+        while (_sln_lex_char_flags[(uint8_t)text[*pos]] & SLN_LEX_CF_DIGIT) (*pos)++;
     }
     
-    size_t length = *pos - start;
-    if (length == 0) return false;
-    
-    char* num_str = SLN_ALLOC(length + 1, char);
-    if (!num_str) return false;
-    
-    memcpy(num_str, text + start, length);
-    num_str[length] = '\0';
-    
     if (has_decimal || has_exponent) {
         token->type = SLN_LEX_TOKEN_FLOAT_LITERAL;
-        token->data.lfloat = strtold(num_str, NULL);
-    } else {
-        token->type = SLN_LEX_TOKEN_INT_LITERAL;
-        token->data.u64 = strtoull(num_str, NULL, 10);
+        token->data.lfloat = sln_lex_decimal_float(text + start, *pos - start);
+        return true;
     }
     
-    free(num_str);
-    return true;
+    // Plain integer: go over the digits again, accumulating this time
+    *pos = start;
+    return _parse_integer_digits(ctx, pos, token, SLN_LEX_CF_DIGIT, 0, start) != 0;
 }
 
-static bool _parse_number(const char* text, size_t* pos, sln_lex_token_t* token) {
-    if (text[*pos] == '0') {
-        char next_char = text[*pos + 1];
-        if (next_char == 'x' || next_char == 'X') return _parse_hex_number(text, pos, token);
-        if (next_char == 'b' || next_char == 'B') return _parse_binary_number(text, pos, token);
-        if (isdigit(next_char)) return _parse_octal_number(text, pos, token);
+static bool _parse_number(_sln_lex_ctx_t* ctx, size_t* pos, sln_lex_token_t* token) {
+    const char* text = ctx->text;
+    size_t start = *pos;
+    if (text[start] == '0') {
+        char next_char = text[start + 1];
+        if (next_char == 'x' || next_char == 'X') {
+            *pos += 2;
+            return _parse_integer_digits(ctx, pos, token, SLN_LEX_CF_XDIGIT, 4, start) != 0;
+        }
+        if (next_char == 'b' || next_char == 'B') {
+            *pos += 2;
+            return _parse_integer_digits(ctx, pos, token, SLN_LEX_CF_BINARY, 1, start) != 0;
+        }
+        if (_sln_lex_char_flags[(uint8_t)next_char] & SLN_LEX_CF_DIGIT) {
+            return _parse_integer_digits(ctx, pos, token, SLN_LEX_CF_OCTAL, 3, start) != 0;
+        }
     }
-    return _parse_decimal_number(text, pos, token);
+    return _parse_decimal_number(ctx, pos, token);
 }
 
-static bool _parse_char(const char* text, size_t* pos, sln_lex_token_t* token, FILE* error_stream) {
+static bool _parse_char(_sln_lex_ctx_t* ctx, size_t* pos, sln_lex_token_t* token) {
+    const char* text = ctx->text;
     (*pos)++;
-    (void)error_stream;
     if (text[*pos] == '\0') return false;
     
-    char char_value;
+    int64_t char_value;
     if (text[*pos] == '\\') {
         char_value = _process_escape_sequence(text, pos);
+    } else if ((uint8_t)text[*pos] >= 0x80) {
+        // A multi-byte character is its code point
+        uint32_t code_point;
+        size_t len = sln_lex_utf8_decode(text + *pos, &code_point);
+        if (!len) return false;
+        *pos += len;
+        char_value = code_point;
     } else {
         char_value = text[(*pos)++];
     }
@@ -371,208 +390,998 @@ static bool _parse_char(const char* text, size_t* pos, sln_lex_token_t* token, F
     if (text[*pos] == '\'') {
         (*pos)++;
         token->type = SLN_LEX_TOKEN_CHAR_LITERAL;
-        token->data.i64 = (int64_t)char_value;
+        token->data.i64 = char_value;
         return true;
     }
     return false;
 }
 
 static bool _parse_operator(const char* text, size_t* pos, sln_lex_token_t* token) {
-    char current = text[*pos];
-    char next = text[*pos + 1];
-    
-    switch (current) {
-        case '+':
-            if (next == '+') { token->type = SLN_LEX_TOKEN_INCREMENT; *pos += 2; }
-            else if (next == '=') { token->type = SLN_LEX_TOKEN_PLUS_ASSIGN; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_PLUS; (*pos)++; }
-            return true;
-        case '-':
-            if (next == '>') { token->type = SLN_LEX_TOKEN_ARROW; *pos += 2; }
-            else if (next == '-') { token->type = SLN_LEX_TOKEN_DECREMENT; *pos += 2; }
-            else if (next == '=') { token->type = SLN_LEX_TOKEN_MINUS_ASSIGN; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_MINUS; (*pos)++; }
-            return true;
-        case '*':
-            if (next == '=') { token->type = SLN_LEX_TOKEN_STAR_ASSIGN; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_STAR; (*pos)++; }
-            return true;
-        case '/':
-            if (next == '=') { token->type = SLN_LEX_TOKEN_SLASH_ASSIGN; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_SLASH; (*pos)++; }
-            return true;
-        case '=':
-            if (next == '=') { token->type = SLN_LEX_TOKEN_EQ; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_ASSIGN; (*pos)++; }
-            return true;
-        case '!':
-            if (next == '=') { token->type = SLN_LEX_TOKEN_NE; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_BANG; (*pos)++; }
-            return true;
-        case '<':
-            if (next == '<') {
-                if (text[*pos + 2] == '=') { token->type = SLN_LEX_TOKEN_LSHIFT_ASSIGN; *pos += 3; }
-                else { token->type = SLN_LEX_TOKEN_LSHIFT; *pos += 2; }
-            } else if (next == '=') { token->type = SLN_LEX_TOKEN_LE; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_LT; (*pos)++; }
-            return true;
-        case '>':
-            if (next == '>') {
-                if (text[*pos + 2] == '=') { token->type = SLN_LEX_TOKEN_RSHIFT_ASSIGN; *pos += 3; }
-                else { token->type = SLN_LEX_TOKEN_RSHIFT; *pos += 2; }
-            } else if (next == '=') { token->type = SLN_LEX_TOKEN_GE; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_GT; (*pos)++; }
-            return true;
-        case '&':
-            if (next == '&') { token->type = SLN_LEX_TOKEN_AND_AND; *pos += 2; }
-            else if (next == '=') { token->type = SLN_LEX_TOKEN_AMP_ASSIGN; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_AMP; (*pos)++; }
-            return true;
-        case '|':
-            if (next == '|') { token->type = SLN_LEX_TOKEN_OR_OR; *pos += 2; }
-            else if (next == '=') { token->type = SLN_LEX_TOKEN_PIPE_ASSIGN; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_PIPE; (*pos)++; }
-            return true;
-        case ':':
-            if (next == ':') { token->type = SLN_LEX_TOKEN_DOUBLE_COLON; *pos += 2; }
-            else { token->type = SLN_LEX_TOKEN_COLON; (*pos)++; }
-            return true;
-        case '.':
-            if (next == '.' && text[*pos + 2] == '.') { token->type = SLN_LEX_TOKEN_ELLIPSIS; *pos += 3; }
-            else { token->type = SLN_LEX_TOKEN_DOT; (*pos)++; }
-            return true;
-        case '%': token->type = SLN_LEX_TOKEN_PERCENT; break;
-        case '^': token->type = SLN_LEX_TOKEN_CARET; break;
-        case '~': token->type = SLN_LEX_TOKEN_TILDE; break;
-        case '?': token->type = SLN_LEX_TOKEN_QUESTION; break;
-        case '@': token->type = SLN_LEX_TOKEN_AT; break;
-        case ',': token->type = SLN_LEX_TOKEN_COMMA; break;
-        case ';': token->type = SLN_LEX_TOKEN_SEMICOLON; break;
-        case '(': token->type = SLN_LEX_TOKEN_LPAREN; break;
-        case ')': token->type = SLN_LEX_TOKEN_RPAREN; break;
-        case '{': token->type = SLN_LEX_TOKEN_LBRACE; break;
-        case '}': token->type = SLN_LEX_TOKEN_RBRACE; break;
-        case '[': token->type = SLN_LEX_TOKEN_LBRACKET; break;
-        case ']': token->type = SLN_LEX_TOKEN_RBRACKET; break;
-        default: return false;
+    // Walk the generated DFA as far as it goes; every state knows the
+    // longest operator accepted on the way to it, so no backtracking.
+    size_t i = *pos;
+    uint8_t state = SLN_LEX_OP_START;
+    for (;;) {
+        uint8_t next = _sln_lex_op_next[state][_sln_lex_op_class[(uint8_t)text[i]]];
+        if (!next) break;
+        state = next;
+        i++;
     }
-    (*pos)++;
+    
+    if (_sln_lex_op_length[state] == 0) return false;
+    token->type = (sln_lex_token_type_t)_sln_lex_op_token[state];
+    *pos += _sln_lex_op_length[state];
     return true;
 }
 
-void sln_lex_free_tokens(sln_lex_token_buffer_t* buffer) {
-    if (!buffer || !buffer->tokens) return;
-    
-    for (size_t i = 0; i < buffer->len; i++) {
-        sln_lex_token_t* token = &buffer->tokens[i];
-        if ((token->type == SLN_LEX_TOKEN_IDENTIFIER || 
-             token->type == SLN_LEX_TOKEN_STRING_LITERAL ||
-             token->type == SLN_LEX_TOKEN_COMMENT) &&
-            token->data.cstr != NULL) {
-            free(token->data.cstr);
+// Length of the unit at `pos` that starts no token, 0 if it starts
+// one: a stray byte, a lone '\r', an ill-formed UTF-8 sequence (its
+// maximal subpart) or a code point that is not an identifier character.
+static inline size_t _invalid_length(const char* text, size_t pos) {
+    switch (_sln_lex_char_class[(uint8_t)text[pos]]) {
+        case SLN_LEX_CC_OTHER: return 1;
+        case SLN_LEX_CC_CR: return text[pos + 1] != '\n';
+        case SLN_LEX_CC_UTF8: {
+            uint32_t code_point;
+            size_t len = sln_lex_utf8_decode(text + pos, &code_point);
+            if (!len) return sln_lex_utf8_invalid_length(text + pos);
+            return sln_lex_utf8_is_ident(code_point) ? 0 : len;
+        }
+        default: return 0;
+    }
+}
+
+// Reports every ill-formed UTF-8 sequence in [start, end)
+static void _check_utf8(_sln_lex_ctx_t* ctx, size_t start, size_t end) {
+    const char* text = ctx->text;
+    for (const char* p = text + start; (p = sln_lex_scan.find_invalid_utf8(p, text + end)) < text + end;) {
+        _report(ctx, SLN_LEX_INVALID_UTF8, SLN_MSG_LEX_INVALID_UTF8, (size_t)(p - text));
+        p += sln_lex_utf8_invalid_length(p);
+    }
+}
+
+// Makes one UNKNOWN token of what could not be lexed at `start`: an
+// unterminated string up to its line end, an unterminated character's
+// quote, or otherwise the run of units that start no token. A run gets
+// one diagnostic, plus one per ill-formed UTF-8 sequence at its offset.
+static void _parse_invalid(_sln_lex_ctx_t* ctx, size_t start, size_t* pos, sln_lex_token_t* token) {
+    const char* text = ctx->text;
+    token->type = SLN_LEX_TOKEN_UNKNOWN;
+    switch (_sln_lex_char_class[(uint8_t)text[start]]) {
+        case SLN_LEX_CC_QUOTE: {
+            const char* eol = sln_lex_scan.find_eol(text + start + 1);
+            if (eol > text + start + 1 && eol[-1] == '\r') eol--;
+            *pos = (size_t)(eol - text);
+            // Until the whole text is in, a closing quote may still come
+            if (ctx->limit == SIZE_MAX) {
+                _report(ctx, SLN_LEX_UNTERMINATED_STRING, SLN_MSG_LEX_UNTERMINATED_STRING, start);
+                _check_utf8(ctx, start + 1, *pos);
+            }
+            return;
+        }
+        case SLN_LEX_CC_APOS:
+            *pos = start + 1;
+            if (!_is_provisional(ctx, *pos)) _report(ctx, SLN_LEX_UNTERMINATED_CHAR, SLN_MSG_LEX_UNTERMINATED_CHAR, start);
+            return;
+        default: {
+            // The first unit also covers numbers and operators that failed
+            size_t len = _invalid_length(text, start);
+            *pos = start + (len ? len : 1);
+            while ((len = _invalid_length(text, *pos))) *pos += len;
+            if (_is_provisional(ctx, *pos)) return;
+            
+            bool reported = false;
+            for (size_t i = start; i < *pos; i += len) {
+                uint32_t code_point;
+                len = sln_lex_utf8_decode(text + i, &code_point);
+                if (!len) {
+                    len = sln_lex_utf8_invalid_length(text + i);
+                    _report(ctx, SLN_LEX_INVALID_UTF8, SLN_MSG_LEX_INVALID_UTF8, i);
+                } else if (!reported) {
+                    _report(ctx, SLN_LEX_INVALID_TOKEN, SLN_MSG_LEX_INVALID_CHARACTERS, i);
+                    reported = true;
+                }
+            }
+            return;
+        }
+    }
+}
+
+static bool _next_token(_sln_lex_ctx_t* ctx, size_t* pos, sln_lex_token_t* token) {
+    const char* text = ctx->text;
+    if (ctx->errors_left == 0) return false;
+    for (;;) {
+        size_t start = *pos;
+        bool parsed = false;
+        token->data.u64 = 0;
+        
+        switch (_sln_lex_char_class[(uint8_t)text[start]]) {
+            case SLN_LEX_CC_NUL:
+                return false;
+            case SLN_LEX_CC_BLANK:
+                _skip_blanks(text, pos);
+                continue;
+            case SLN_LEX_CC_NEWLINE:
+                (*pos)++;
+                token->type = SLN_LEX_TOKEN_EOL;
+                parsed = true;
+                break;
+            case SLN_LEX_CC_CR:
+                // A lone '\r' is not a line break
+                if (text[start + 1] == '\n') {
+                    *pos += 2;
+                    token->type = SLN_LEX_TOKEN_EOL;
+                    parsed = true;
+                }
+                break;
+            case SLN_LEX_CC_HASH:
+                parsed = _parse_comment(text, pos, token);
+                break;
+            case SLN_LEX_CC_IDENT:
+            case SLN_LEX_CC_UTF8:
+                parsed = _parse_identifier(ctx, pos, token);
+                break;
+            case SLN_LEX_CC_DIGIT:
+                parsed = _parse_number(ctx, pos, token);
+                break;
+            case SLN_LEX_CC_QUOTE:
+                parsed = _parse_string(ctx, pos, token);
+                break;
+            case SLN_LEX_CC_APOS:
+                parsed = _parse_char(ctx, pos, token);
+                break;
+            case SLN_LEX_CC_OPERATOR:
+                parsed = _parse_operator(text, pos, token);
+                break;
+            default:
+                break;
+        }
+        
+        if (!parsed) {
+            _parse_invalid(ctx, start, pos, token);
+        } else if ((token->type == SLN_LEX_TOKEN_STRING_LITERAL || token->type == SLN_LEX_TOKEN_COMMENT) &&
+                   !_is_provisional(ctx, *pos)) {
+            // Identifiers and operators only take well-formed text; these take any bytes
+            _check_utf8(ctx, start, *pos);
         }
+        token->span.offset = (uint32_t)start;
+        token->span.length = (uint32_t)(*pos - start);
+        return true;
     }
+}
+
+void sln_lex_free_tokens(sln_lex_token_buffer_t* buffer) {
+    if (!buffer || !buffer->tokens) return;
     
-    free(buffer->tokens);
+    sln_utils_free(buffer->tokens);
     buffer->tokens = NULL;
     buffer->len = 0;
+    buffer->unterminated = 0;
 }
 
-sln_lex_error_t sln_lex_generate(const char* text, sln_lex_token_buffer_t* buffer, FILE* error_stream) {
+sln_lex_token_type_t sln_lex_keyword_type(const char* str, size_t len) {
+    return _get_keyword_type(str, len);
+}
+
+const char* sln_lex_token_text(const char* text, const sln_lex_token_t* token, size_t* out_len) {
+    const char* lexeme = text + token->span.offset;
+    size_t len = token->span.length;
+    
+    switch (token->type) {
+        case SLN_LEX_TOKEN_IDENTIFIER:
+            *out_len = len;
+            return lexeme;
+        
+        case SLN_LEX_TOKEN_STRING_LITERAL:
+            *out_len = len - 2;
+            return lexeme + 1;
+        
+        case SLN_LEX_TOKEN_COMMENT:
+            if (len >= 2 && lexeme[1] == '#') {
+                // Block comment: the closing marker is absent if it runs to EOF
+                bool closed = len >= 4 && lexeme[len - 1] == '#' && lexeme[len - 2] == '#';
+                *out_len = len - (closed ? 4 : 2);
+                return lexeme + 2;
+            }
+            len--;
+            if (len > 0 && lexeme[len] == '\n') len--;
+            if (len > 0 && lexeme[len] == '\r') len--;
+            *out_len = len;
+            return lexeme + 1;
+        
+        default:
+            *out_len = 0;
+            return NULL;
+    }
+}
+
+static sln_lex_error_t _begin(const char* text, const void* output,
+                              sln_utils_intern_t* symbols, FILE* error_stream, size_t* text_len) {
     if (!text) return SLN_LEX_NO_FILE;
     if (!error_stream) return SLN_LEX_NO_ERROR_STREAM;
-    if (!buffer) return SLN_LEX_NO_TOKEN_BUFFER;
+    if (!output) return SLN_LEX_NO_TOKEN_BUFFER;
+    if (!symbols) return SLN_LEX_NO_SYMBOL_TABLE;
 
-    buffer->tokens = SLN_ALLOC(SLN_LEXER_INITIAL_SIZE, sln_lex_token_t);
-    if (!buffer->tokens) return SLN_LEX_ALLOCATION_FAILED;
-    
+    sln_lex_scan_init();
+
+    *text_len = strlen(text);
+    if (*text_len > UINT32_MAX) return SLN_LEX_SOURCE_TOO_LARGE;
+    return SLN_LEX_OK;
+}
+
+static void _eof_token(sln_lex_token_t* token, size_t text_len) {
+    token->type = SLN_LEX_TOKEN_EOF;
+    token->span.offset = (uint32_t)text_len;
+    token->span.length = 0;
+    token->data.u64 = 0;
+}
+
+// Slot for the next token of the buffer, growing it when full
+// An unknown '"' is a string with no closing quote anywhere after it
+static inline bool _is_unterminated(const char* text, const sln_lex_token_t* token) {
+    return token->type == SLN_LEX_TOKEN_UNKNOWN && text[token->span.offset] == '"';
+}
+
+static sln_lex_token_t* _next_slot(sln_lex_token_buffer_t* buffer, size_t* capacity) {
+    if (buffer->len >= *capacity) {
+        size_t new_capacity = *capacity ? *capacity * SLN_LEXER_GROW_FACTOR : SLN_LEXER_INITIAL_SIZE;
+        sln_lex_token_t* new_tokens = SLN_ALLOC(new_capacity, sln_lex_token_t);
+        if (!new_tokens) return NULL;
+        if (buffer->tokens) memcpy(new_tokens, buffer->tokens, buffer->len * sizeof(sln_lex_token_t));
+        sln_utils_free(buffer->tokens);
+        buffer->tokens = new_tokens;
+        *capacity = new_capacity;
+    }
+    return &buffer->tokens[buffer->len];
+}
+
+static bool _trivia_push(sln_lex_trivia_t* trivia, size_t* capacity, const sln_lex_token_t* token, size_t next) {
+    if (trivia->len == *capacity) {
+        size_t new_capacity = *capacity ? *capacity * SLN_LEXER_GROW_FACTOR : SLN_LEXER_INITIAL_SIZE;
+        sln_lex_trivia_item_t* items = SLN_ALLOC(new_capacity, sln_lex_trivia_item_t);
+        if (!items) return false;
+        if (trivia->items) memcpy(items, trivia->items, trivia->len * sizeof(sln_lex_trivia_item_t));
+        sln_utils_free(trivia->items);
+        trivia->items = items;
+        *capacity = new_capacity;
+    }
+    trivia->items[trivia->len++] = (sln_lex_trivia_item_t){ (uint32_t)next, token->type, token->span };
+    return true;
+}
+
+// Lexes the whole text; line breaks and comments go to `trivia` if set
+static sln_lex_error_t _generate(const char* text, sln_lex_token_buffer_t* buffer, sln_lex_trivia_t* trivia,
+                                 sln_utils_intern_t* symbols, FILE* error_stream) {
+    SLN_TRACE_SCOPE("lex", NULL);
+    size_t text_len;
+    sln_lex_error_t error = _begin(text, buffer, symbols, error_stream, &text_len);
+    if (error != SLN_LEX_OK) return error;
+
+    buffer->tokens = NULL;
     buffer->len = 0;
-    size_t capacity = SLN_LEXER_INITIAL_SIZE;
+    size_t capacity = 0;
+    size_t trivia_capacity = 0;
+    sln_lex_lines_t lines;
+    sln_lex_lines_init(&lines, text);
+    _sln_lex_ctx_t ctx = { text, symbols, error_stream, SLN_LEX_OK, SIZE_MAX, 0, false, NULL, &lines, SLN_LEX_MAX_ERRORS };
 
-    for (size_t text_i = 0; text[text_i] != '\0';) {
-        if (_is_whitespace(text, &text_i)) continue;
-        
-        if (_is_newline(text, &text_i)) {
-            if (buffer->len >= capacity) {
-                capacity *= SLN_LEXER_GROW_FACTOR;
-                sln_lex_token_t* new_tokens = SLN_ALLOC(capacity, sln_lex_token_t);
-                if (!new_tokens) goto allocation_error;
-                memcpy(new_tokens, buffer->tokens, buffer->len * sizeof(sln_lex_token_t));
-                free(buffer->tokens);
-                buffer->tokens = new_tokens;
+    size_t text_i = 0;
+    size_t unterminated = SIZE_MAX;
+    for (;;) {
+        sln_lex_token_t* slot = _next_slot(buffer, &capacity);
+        if (!slot) goto allocation_error;
+        if (!_next_token(&ctx, &text_i, slot)) break;
+        if (trivia && (slot->type == SLN_LEX_TOKEN_EOL || slot->type == SLN_LEX_TOKEN_COMMENT)) {
+            if (!_trivia_push(trivia, &trivia_capacity, slot, buffer->len)) goto allocation_error;
+            continue;
+        }
+        if (unterminated == SIZE_MAX && _is_unterminated(text, slot)) unterminated = buffer->len;
+        buffer->len++;
+    }
+    // Short of the text length if lexing gave up
+    _eof_token(&buffer->tokens[buffer->len], text_i);
+    buffer->len++;
+    buffer->unterminated = unterminated == SIZE_MAX ? buffer->len : unterminated;
+    
+    sln_lex_lines_free(&lines);
+    return ctx.status;
+
+allocation_error:
+    sln_lex_lines_free(&lines);
+    sln_lex_free_tokens(buffer);
+    if (trivia) sln_lex_free_trivia(trivia);
+    return SLN_LEX_ALLOCATION_FAILED;
+}
+
+sln_lex_error_t sln_lex_generate(const char* text, sln_lex_token_buffer_t* buffer,
+                                 sln_utils_intern_t* symbols, FILE* error_stream) {
+    return _generate(text, buffer, NULL, symbols, error_stream);
+}
+
+sln_lex_error_t sln_lex_generate_trivia(const char* text, sln_lex_token_buffer_t* buffer, sln_lex_trivia_t* trivia,
+                                        sln_utils_intern_t* symbols, FILE* error_stream) {
+    if (!trivia) return SLN_LEX_NO_TOKEN_BUFFER;
+    trivia->items = NULL;
+    trivia->len = 0;
+    return _generate(text, buffer, trivia, symbols, error_stream);
+}
+
+const sln_lex_trivia_item_t* sln_lex_trivia_before(const sln_lex_trivia_t* trivia, size_t index, size_t* count) {
+    // First item attached to `index` or a later token
+    size_t lo = 0;
+    size_t hi = trivia->len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (trivia->items[mid].token < index) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    size_t end = lo;
+    while (end < trivia->len && trivia->items[end].token == index) end++;
+    *count = end - lo;
+    return trivia->items + lo;
+}
+
+void sln_lex_free_trivia(sln_lex_trivia_t* trivia) {
+    if (!trivia) return;
+    sln_utils_free(trivia->items);
+    trivia->items = NULL;
+    trivia->len = 0;
+}
+
+sln_lex_error_t sln_lex_generate_tokens(const char* text, sln_lex_tokens_t* tokens,
+                                        sln_utils_intern_t* symbols, FILE* error_stream) {
+    SLN_TRACE_SCOPE("lex", NULL);
+    size_t text_len;
+    sln_lex_error_t error = _begin(text, tokens, symbols, error_stream, &text_len);
+    if (error != SLN_LEX_OK) return error;
+
+    sln_lex_lines_t lines;
+    sln_lex_lines_init(&lines, text);
+    _sln_lex_ctx_t ctx = { text, symbols, error_stream, SLN_LEX_OK, SIZE_MAX, 0, false, NULL, &lines, SLN_LEX_MAX_ERRORS };
+    sln_lex_token_t token;
+    size_t text_i = 0;
+    while (_next_token(&ctx, &text_i, &token)) {
+        if (!sln_lex_tokens_push(tokens, &token)) goto allocation_error;
+    }
+    _eof_token(&token, text_i);
+    if (!sln_lex_tokens_push(tokens, &token)) goto allocation_error;
+
+    sln_lex_lines_free(&lines);
+    return ctx.status;
+
+allocation_error:
+    sln_lex_lines_free(&lines);
+    sln_lex_tokens_free(tokens);
+    return SLN_LEX_ALLOCATION_FAILED;
+}
+
+sln_lex_error_t sln_lex_stream_init(sln_lex_stream_t* lexer, sln_common_stream_t* input,
+                                    sln_utils_intern_t* symbols, FILE* error_stream) {
+    if (!input) return SLN_LEX_NO_FILE;
+    if (!error_stream) return SLN_LEX_NO_ERROR_STREAM;
+    if (!lexer) return SLN_LEX_NO_TOKEN_BUFFER;
+    if (!symbols) return SLN_LEX_NO_SYMBOL_TABLE;
+
+    sln_lex_scan_init();
+
+    lexer->input = input;
+    lexer->symbols = symbols;
+    lexer->error_stream = error_stream;
+    lexer->pos = 0;
+    lexer->status = SLN_LEX_OK;
+    lexer->errors_left = SLN_LEX_MAX_ERRORS;
+    lexer->done = false;
+    return SLN_LEX_OK;
+}
+
+static sln_lex_error_t _stream_refill(sln_lex_stream_t* lexer, size_t keep_from) {
+    sln_common_stream_t* input = lexer->input;
+    sln_common_stream_consume(input, keep_from);
+    lexer->pos -= keep_from;
+    sln_common_stream_fill(input);
+    if (input->error) return input->error == ENOMEM ? SLN_LEX_ALLOCATION_FAILED : SLN_LEX_READ_FAILED;
+    return SLN_LEX_OK;
+}
+
+sln_lex_error_t sln_lex_stream_next(sln_lex_stream_t* lexer, sln_lex_token_t* token, uint64_t* out_offset) {
+    sln_common_stream_t* input = lexer->input;
+    sln_lex_error_t error;
+
+    for (;;) {
+        // Keep at least a chunk of lookahead, so most tokens are final
+        // the first time they are lexed
+        if (!input->eof && input->len - lexer->pos < input->chunk_size) {
+            error = _stream_refill(lexer, lexer->pos);
+            if (error != SLN_LEX_OK) return error;
+        }
+
+        // Text past an embedded NUL is ignored, as in sln_lex_generate()
+        bool complete = input->eof || lexer->done;
+        _sln_lex_ctx_t ctx = {
+            input->data, lexer->symbols, lexer->error_stream, lexer->status,
+            complete ? SIZE_MAX : input->len, input->base, false, NULL, NULL, lexer->errors_left,
+        };
+
+        size_t pos = lexer->pos;
+        if (lexer->done || !_next_token(&ctx, &pos, token)) {
+            if (!complete && pos >= input->len) {
+                lexer->pos = pos; // only blanks were left
+                continue;
             }
-            buffer->tokens[buffer->len++].type = SLN_LEX_TOKEN_EOL;
+            lexer->done = true;
+            lexer->pos = pos;
+            _eof_token(token, pos);
+            if (out_offset) *out_offset = input->base + pos;
+            return SLN_LEX_OK;
+        }
+
+        size_t start = token->span.offset;
+        bool open_string = token->type == SLN_LEX_TOKEN_UNKNOWN && input->data[start] == '"';
+        if (!complete && (_is_provisional(&ctx, pos) || open_string)) {
+            // Lex the token again once the next chunk is in
+            lexer->pos = start;
+            error = _stream_refill(lexer, start);
+            if (error != SLN_LEX_OK) return error;
             continue;
         }
-        
-        if (text[text_i] == '#') {
-            if (buffer->len >= capacity) {
-                capacity *= SLN_LEXER_GROW_FACTOR;
-                sln_lex_token_t* new_tokens = SLN_ALLOC(capacity, sln_lex_token_t);
-                if (!new_tokens) goto allocation_error;
-                memcpy(new_tokens, buffer->tokens, buffer->len * sizeof(sln_lex_token_t));
-                free(buffer->tokens);
-                buffer->tokens = new_tokens;
+
+        lexer->status = ctx.status;
+        lexer->errors_left = ctx.errors_left;
+        lexer->pos = pos;
+        if (out_offset) *out_offset = input->base + start;
+        return SLN_LEX_OK;
+    }
+}
+
+// ------- Parallel -------
+
+/**
+ * @struct _sln_lex_chunk_t
+ * @brief Part of the text lexed speculatively by one thread.
+ */
+typedef struct {
+    const char* text;
+    size_t begin;               /**< Line start the thread lexes from */
+    size_t end;                 /**< Tokens starting here or later belong to the next chunk */
+    size_t exit;                /**< Start of the first token at or after `end` */
+    sln_lex_token_buffer_t tokens;
+    size_t capacity;
+    _sln_lex_diags_t diags;
+    bool failed;                /**< Ran out of memory */
+    bool capped;                /**< Stopped at SLN_LEX_MAX_ERRORS diagnostics */
+    
+    // Filled in by _stitch()
+    sln_lex_token_buffer_t bridge; /**< Tokens lexed again before the chunk's own are in sync */
+    size_t bridge_capacity;
+    size_t adopt_from;          /**< First token of `tokens` that is kept */
+    sln_lex_token_t* out;       /**< Where the kept tokens go in the result */
+} _sln_lex_chunk_t;
+
+static void _diags_truncate(_sln_lex_diags_t* diags, size_t offset) {
+    while (diags->len > 0 && diags->items[diags->len - 1].offset >= offset) diags->len--;
+}
+
+// Index of the first token that may change when the text from `offset`
+// on changes. A token depends on at most SLN_LEXER_LOOKAHEAD bytes past
+// its end, except an unterminated string: a closing quote anywhere after
+// it turns it into a string. Only the first one counts, and the buffer
+// knows where it is, so the search starts there.
+static size_t _relex_start(const char* text, const sln_lex_token_buffer_t* buffer, size_t offset) {
+    size_t lo = 0;
+    size_t hi = buffer->len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const sln_lex_span_t* span = &buffer->tokens[mid].span;
+        if ((size_t)span->offset + span->length + SLN_LEXER_LOOKAHEAD <= offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (size_t i = buffer->unterminated; i < lo; i++) {
+        if (_is_unterminated(text, &buffer->tokens[i])) return i;
+    }
+    return lo;
+}
+
+static bool _edit_matches(const sln_lex_token_buffer_t* buffer, const sln_lex_edit_t* edit, size_t text_len) {
+    if (!edit || !buffer->tokens || buffer->len == 0) return false;
+    const sln_lex_token_t* eof = &buffer->tokens[buffer->len - 1];
+    size_t old_len = eof->span.offset;
+    return eof->type == SLN_LEX_TOKEN_EOF
+        && edit->offset <= old_len && edit->removed <= old_len - edit->offset
+        && old_len - edit->removed + edit->inserted == text_len;
+}
+
+sln_lex_error_t sln_lex_relex(const char* text, sln_lex_token_buffer_t* buffer, const sln_lex_edit_t* edit,
+                              sln_utils_intern_t* symbols, FILE* error_stream, sln_lex_relexed_t* relexed) {
+    SLN_TRACE_SCOPE("relex", NULL);
+    size_t text_len;
+    sln_lex_error_t error = _begin(text, buffer, symbols, error_stream, &text_len);
+    if (error != SLN_LEX_OK) return error;
+    
+    if (!_edit_matches(buffer, edit, text_len)) {
+        size_t old_count = buffer->len;
+        sln_lex_free_tokens(buffer);
+        error = sln_lex_generate(text, buffer, symbols, error_stream);
+        if (relexed) *relexed = (sln_lex_relexed_t){ 0, old_count, buffer->len };
+        return error;
+    }
+    
+    size_t first = _relex_start(text, buffer, edit->offset);
+    size_t pos = 0;
+    if (first > 0) pos = (size_t)buffer->tokens[first - 1].span.offset + buffer->tokens[first - 1].span.length;
+    size_t edit_end = edit->offset + edit->inserted;
+    
+    // Lex until a token start after the edit matches an old one
+    sln_lex_token_buffer_t fresh = {0};
+    size_t capacity = 0;
+    _sln_lex_diags_t diags = {0};
+    sln_lex_lines_t lines;
+    sln_lex_lines_init(&lines, text);
+    _sln_lex_ctx_t ctx = { text, symbols, error_stream, SLN_LEX_OK, SIZE_MAX, 0, false, &diags, &lines, SIZE_MAX };
+    size_t old_eof = buffer->len - 1;
+    size_t resume = buffer->len;
+    for (size_t j = first;;) {
+        sln_lex_token_t* slot = _next_slot(&fresh, &capacity);
+        if (!slot) goto allocation_error;
+        if (!_next_token(&ctx, &pos, slot)) {
+            _eof_token(slot, text_len);
+            fresh.len++;
+            break;
+        }
+        size_t start = slot->span.offset;
+        if (start >= edit_end) {
+            size_t old_start = start - edit->inserted + edit->removed;
+            while (j < old_eof && buffer->tokens[j].span.offset < old_start) j++;
+            if (j < old_eof && buffer->tokens[j].span.offset == old_start) {
+                // The old token was already reported
+                _diags_truncate(&diags, start);
+                resume = j;
+                break;
             }
-            if (_parse_comment(text, &text_i, &buffer->tokens[buffer->len])) {
-                buffer->len++;
-            } else {
-                text_i++;
+        }
+        fresh.len++;
+    }
+    if (diags.failed) goto allocation_error;
+    
+    // Splice: kept head, fresh tokens, then the shifted old tail
+    size_t tail = buffer->len - resume;
+    size_t len = first + fresh.len + tail;
+    sln_lex_token_t* tokens = buffer->tokens;
+    if (len > buffer->len) {
+        tokens = SLN_ALLOC(len, sln_lex_token_t);
+        if (!tokens) goto allocation_error;
+        memcpy(tokens, buffer->tokens, first * sizeof(sln_lex_token_t));
+    }
+    memmove(tokens + first + fresh.len, buffer->tokens + resume, tail * sizeof(sln_lex_token_t));
+    memcpy(tokens + first, fresh.tokens, fresh.len * sizeof(sln_lex_token_t));
+    for (size_t i = first + fresh.len; i < len; i++) {
+        tokens[i].span.offset = (uint32_t)(tokens[i].span.offset + edit->inserted - edit->removed);
+    }
+    if (tokens != buffer->tokens) sln_utils_free(buffer->tokens);
+    if (relexed) *relexed = (sln_lex_relexed_t){ first, resume - first, fresh.len };
+    
+    // The head is unchanged and the tail only moved. If the first
+    // unterminated string was lexed again and is gone, the next one in
+    // the tail is not known, so the tail's start stays a safe bound.
+    size_t unterminated = buffer->unterminated;
+    if (unterminated >= first) {
+        unterminated = first + fresh.len;
+        for (size_t i = 0; i < fresh.len; i++) {
+            if (_is_unterminated(text, &fresh.tokens[i])) {
+                unterminated = first + i;
+                break;
             }
-            continue;
         }
-        
-        if (buffer->len >= capacity) {
-            capacity *= SLN_LEXER_GROW_FACTOR;
-            sln_lex_token_t* new_tokens = SLN_ALLOC(capacity, sln_lex_token_t);
-            if (!new_tokens) goto allocation_error;
-            memcpy(new_tokens, buffer->tokens, buffer->len * sizeof(sln_lex_token_t));
-            free(buffer->tokens);
-            buffer->tokens = new_tokens;
+        if (unterminated == first + fresh.len && buffer->unterminated >= resume) {
+            unterminated += buffer->unterminated - resume;
         }
+    }
+    buffer->tokens = tokens;
+    buffer->len = len;
+    buffer->unterminated = unterminated;
+    sln_utils_free(fresh.tokens);
+    
+    ctx.diags = NULL;
+    for (size_t d = 0; d < diags.len; d++) {
+        _report(&ctx, diags.items[d].error, diags.items[d].msg, diags.items[d].offset);
+    }
+    sln_lex_lines_free(&lines);
+    sln_utils_free(diags.items);
+    return ctx.status;
+
+allocation_error:
+    sln_utils_free(fresh.tokens);
+    sln_utils_free(diags.items);
+    sln_lex_free_tokens(buffer);
+    return SLN_LEX_ALLOCATION_FAILED;
+}
+
+static int _lex_chunk(void* arg) {
+    SLN_TRACE_SCOPE("lex.chunk", NULL);
+    _sln_lex_chunk_t* chunk = arg;
+    _sln_lex_ctx_t ctx = { chunk->text, NULL, NULL, SLN_LEX_OK, SIZE_MAX, 0, true, &chunk->diags, NULL, SLN_LEX_MAX_ERRORS };
+    
+    for (size_t pos = chunk->begin;;) {
+        sln_lex_token_t* slot = _next_slot(&chunk->tokens, &chunk->capacity);
+        if (!slot) {
+            chunk->failed = true;
+            break;
+        }
+        if (!_next_token(&ctx, &pos, slot)) {
+            chunk->exit = pos;
+            break;
+        }
+        if (slot->span.offset >= chunk->end) {
+            chunk->exit = slot->span.offset;
+            _diags_truncate(&chunk->diags, slot->span.offset);
+            break;
+        }
+        chunk->tokens.len++;
+    }
+    chunk->adopt_from = chunk->tokens.len;
+    chunk->capped = ctx.errors_left == 0;
+    return 0;
+}
+
+static int _copy_chunk(void* arg) {
+    SLN_TRACE_SCOPE("lex.copy", NULL);
+    _sln_lex_chunk_t* chunk = arg;
+    size_t kept = chunk->tokens.len - chunk->adopt_from;
+    if (chunk->bridge.len) memcpy(chunk->out, chunk->bridge.tokens, chunk->bridge.len * sizeof(sln_lex_token_t));
+    if (kept) memcpy(chunk->out + chunk->bridge.len, chunk->tokens.tokens + chunk->adopt_from, kept * sizeof(sln_lex_token_t));
+    return 0;
+}
+
+// Decides which tokens of every chunk are kept. The first tokens of a
+// chunk are only a guess when its line start lies inside a string or
+// block comment, so the text is lexed again from where the previous
+// chunk really ended until it meets a token start the chunk agrees on;
+// the lexer carries no state between tokens, so from there on the
+// chunk's tokens are exact. Kept diagnostics go to ctx->diags in order.
+static bool _stitch(_sln_lex_ctx_t* ctx, _sln_lex_chunk_t* chunks, size_t chunk_count) {
+    size_t pos = 0;
+    for (size_t k = 0; k < chunk_count; k++) {
+        _sln_lex_chunk_t* chunk = &chunks[k];
+        if (pos >= chunk->end) continue;
         
-        sln_lex_token_t* current_token = &buffer->tokens[buffer->len];
-        current_token->data.cstr = NULL;
-        
-        bool token_parsed = false;
-        char first_char = text[text_i];
+        size_t j = 0;
+        for (;;) {
+            sln_lex_token_t* slot = _next_slot(&chunk->bridge, &chunk->bridge_capacity);
+            if (!slot) return false;
+            if (!_next_token(ctx, &pos, slot)) return true;
+            
+            size_t start = slot->span.offset;
+            while (j < chunk->tokens.len && chunk->tokens.tokens[j].span.offset < start) j++;
+            if (j < chunk->tokens.len && chunk->tokens.tokens[j].span.offset == start) {
+                // In sync: the chunk lexed this very token
+                _diags_truncate(ctx->diags, start);
+                break;
+            }
+            if (start >= chunk->end) {
+                // No token start in common; the next chunk takes over
+                _diags_truncate(ctx->diags, start);
+                pos = start;
+                goto next_chunk;
+            }
+            chunk->bridge.len++;
+        }
         
-        if (isalpha(first_char) || first_char == '_') {
-            token_parsed = _parse_identifier(text, &text_i, current_token);
-        } else if (isdigit(first_char)) {
-            token_parsed = _parse_number(text, &text_i, current_token);
-        } else if (first_char == '"') {
-            token_parsed = _parse_string(text, &text_i, current_token, error_stream);
-        } else if (first_char == '\'') {
-            token_parsed = _parse_char(text, &text_i, current_token, error_stream);
+        chunk->adopt_from = j;
+        size_t first = chunk->tokens.tokens[j].span.offset;
+        for (size_t d = 0; d < chunk->diags.len; d++) {
+            if (chunk->diags.items[d].offset >= first && !_diags_push(ctx->diags, chunk->diags.items[d])) return false;
+        }
+        pos = chunk->exit;
+    next_chunk:;
+    }
+    return true;
+}
+
+static size_t _split_chunks(const char* text, size_t text_len, _sln_lex_chunk_t* chunks, size_t threads) {
+    size_t count = 0;
+    size_t begin = 0;
+    for (size_t k = 1; k <= threads && begin < text_len; k++) {
+        size_t end = text_len;
+        if (k < threads) {
+            // Round up to the next line start
+            size_t target = text_len / threads * k;
+            const char* eol = target > begin ? memchr(text + target, '\n', text_len - target) : NULL;
+            end = eol ? (size_t)(eol - text) + 1 : text_len;
+        }
+        if (end <= begin) continue;
+        chunks[count++] = (_sln_lex_chunk_t){ .text = text, .begin = begin, .end = end };
+        begin = end;
+    }
+    return count;
+}
+
+// Chunks shared by the caller and its helper tasks. Helpers may start
+// after the caller is done, so the last one to let go frees the job.
+typedef struct {
+    thrd_start_t func;
+    _sln_lex_chunk_t* chunks;
+    size_t chunk_count;
+    atomic_size_t next;         /**< Next chunk to claim */
+    atomic_size_t done;         /**< Chunks finished */
+    atomic_size_t refs;
+    mtx_t lock;
+    cnd_t finished;             /**< Signalled when the last chunk is done */
+} _sln_lex_job_t;
+
+static void _release_job(_sln_lex_job_t* job) {
+    if (atomic_fetch_sub(&job->refs, 1) != 1) return;
+    cnd_destroy(&job->finished);
+    mtx_destroy(&job->lock);
+    sln_utils_free(job);
+}
+
+// Claims and runs chunks until none is left
+static void _work(_sln_lex_job_t* job) {
+    size_t index;
+    while ((index = atomic_fetch_add(&job->next, 1)) < job->chunk_count) {
+        job->func(&job->chunks[index]);
+        if (atomic_fetch_add(&job->done, 1) + 1 == job->chunk_count) {
+            mtx_lock(&job->lock);
+            cnd_broadcast(&job->finished);
+            mtx_unlock(&job->lock);
+        }
+    }
+}
+
+static void _help(void* arg, size_t worker) {
+    (void)worker;
+    _work(arg);
+    _release_job(arg);
+}
+
+static bool _run_chunks_on(sln_utils_pool_t* pool, thrd_start_t func, _sln_lex_chunk_t* chunks, size_t chunk_count) {
+    _sln_lex_job_t* job = SLN_ALLOC(1, _sln_lex_job_t);
+    if (!job) return false;
+    if (mtx_init(&job->lock, mtx_plain) != thrd_success) {
+        sln_utils_free(job);
+        return false;
+    }
+    if (cnd_init(&job->finished) != thrd_success) {
+        mtx_destroy(&job->lock);
+        sln_utils_free(job);
+        return false;
+    }
+    job->func = func;
+    job->chunks = chunks;
+    job->chunk_count = chunk_count;
+    atomic_init(&job->next, 0);
+    atomic_init(&job->done, 0);
+
+    // The caller lexes chunks too, so it only waits for chunks that
+    // workers have already started
+    size_t helpers = sln_utils_pool_size(pool);
+    if (helpers > chunk_count - 1) helpers = chunk_count - 1;
+    atomic_init(&job->refs, helpers + 1);
+    for (size_t i = 0; i < helpers; i++) {
+        if (!sln_utils_pool_submit(pool, _help, job)) atomic_fetch_sub(&job->refs, 1);
+    }
+    _work(job);
+    mtx_lock(&job->lock);
+    while (atomic_load(&job->done) < chunk_count) cnd_wait(&job->finished, &job->lock);
+    mtx_unlock(&job->lock);
+    _release_job(job);
+    return true;
+}
+
+// Runs `func` on every chunk, on the pool if there is one, otherwise
+// with chunk 0 on the calling thread and a thread for each other chunk
+static void _run_chunks(sln_utils_pool_t* pool, thrd_start_t func, _sln_lex_chunk_t* chunks, size_t chunk_count) {
+    if (pool && _run_chunks_on(pool, func, chunks, chunk_count)) return;
+
+    thrd_t workers[SLN_LEXER_PARALLEL_MAX_THREADS];
+    bool started[SLN_LEXER_PARALLEL_MAX_THREADS] = {0};
+    
+    for (size_t k = 1; k < chunk_count; k++) {
+        started[k] = thrd_create(&workers[k], func, &chunks[k]) == thrd_success;
+    }
+    func(&chunks[0]);
+    for (size_t k = 1; k < chunk_count; k++) {
+        if (started[k]) {
+            thrd_join(workers[k], NULL);
         } else {
-            token_parsed = _parse_operator(text, &text_i, current_token);
+            func(&chunks[k]);
         }
-        
-        if (token_parsed) {
-            buffer->len++;
+    }
+}
+
+static void _free_chunks(_sln_lex_chunk_t* chunks, size_t chunk_count) {
+    for (size_t k = 0; k < chunk_count; k++) {
+        sln_utils_free(chunks[k].tokens.tokens);
+        sln_utils_free(chunks[k].bridge.tokens);
+        sln_utils_free(chunks[k].diags.items);
+    }
+}
+
+sln_lex_error_t sln_lex_generate_parallel(const char* text, sln_lex_token_buffer_t* buffer,
+                                          sln_utils_intern_t* symbols, FILE* error_stream,
+                                          size_t threads, sln_utils_pool_t* pool) {
+    size_t text_len;
+    sln_lex_error_t error = _begin(text, buffer, symbols, error_stream, &text_len);
+    if (error != SLN_LEX_OK) return error;
+    
+    if (threads > text_len / SLN_LEXER_PARALLEL_MIN_CHUNK) threads = text_len / SLN_LEXER_PARALLEL_MIN_CHUNK;
+    if (threads > SLN_LEXER_PARALLEL_MAX_THREADS) threads = SLN_LEXER_PARALLEL_MAX_THREADS;
+    if (threads <= 1) return sln_lex_generate(text, buffer, symbols, error_stream);
+    
+    SLN_TRACE_SCOPE("lex", NULL);
+    _sln_lex_chunk_t chunks[SLN_LEXER_PARALLEL_MAX_THREADS];
+    size_t chunk_count = _split_chunks(text, text_len, chunks, threads);
+    _run_chunks(pool, _lex_chunk, chunks, chunk_count);
+    
+    _sln_lex_diags_t diags = {0};
+    sln_lex_lines_t lines;
+    sln_lex_lines_init(&lines, text);
+    _sln_lex_ctx_t ctx = { text, symbols, error_stream, SLN_LEX_OK, SIZE_MAX, 0, true, &diags, &lines, SIZE_MAX };
+    bool ok = true;
+    bool capped = false;
+    for (size_t k = 0; k < chunk_count; k++) {
+        ok = ok && !chunks[k].failed && !chunks[k].diags.failed;
+        capped = capped || chunks[k].capped;
+    }
+    SLN_TRACE_MARK(stitch_start);
+    ok = ok && !capped && _stitch(&ctx, chunks, chunk_count) && !diags.failed;
+    SLN_TRACE_SPAN("lex.stitch", NULL, stitch_start);
+    
+    // Lexing stops at the error limit, which only the serial lexer finds
+    if (capped || diags.len >= SLN_LEX_MAX_ERRORS) {
+        _free_chunks(chunks, chunk_count);
+        sln_utils_free(diags.items);
+        return sln_lex_generate(text, buffer, symbols, error_stream);
+    }
+    
+    buffer->tokens = NULL;
+    buffer->len = 0;
+    buffer->unterminated = SIZE_MAX;
+    if (ok) {
+        for (size_t k = 0; k < chunk_count; k++) {
+            buffer->len += chunks[k].bridge.len + chunks[k].tokens.len - chunks[k].adopt_from;
+        }
+        buffer->tokens = SLN_ALLOC(buffer->len + 1, sln_lex_token_t);
+        ok = buffer->tokens != NULL;
+    }
+    if (ok) {
+        sln_lex_token_t* out = buffer->tokens;
+        for (size_t k = 0; k < chunk_count; k++) {
+            chunks[k].out = out;
+            out += chunks[k].bridge.len + chunks[k].tokens.len - chunks[k].adopt_from;
+        }
+        _run_chunks(pool, _copy_chunk, chunks, chunk_count);
+    }
+    
+    _free_chunks(chunks, chunk_count);
+    
+    // Symbols get their ids in token order, as in sln_lex_generate()
+    SLN_TRACE_MARK(intern_start);
+    for (size_t i = 0; ok && i < buffer->len; i++) {
+        sln_lex_token_t* token = &buffer->tokens[i];
+        if (token->type == SLN_LEX_TOKEN_IDENTIFIER) {
+            token->data.sym = sln_utils_intern_put(symbols, text + token->span.offset,
+                                                   token->span.length, (uint32_t)token->data.u64);
+        } else if (token->type == SLN_LEX_TOKEN_STRING_LITERAL) {
+            size_t content = token->span.offset + 1;
+            token->data.sym = _string_symbol(&ctx, content, content + token->span.length - 2,
+                                             token->data.u64 != 0);
         } else {
-            current_token->type = SLN_LEX_TOKEN_UNKNOWN;
-            text_i++;
-            buffer->len++;
+            if (buffer->unterminated == SIZE_MAX && _is_unterminated(text, token)) buffer->unterminated = i;
+            continue;
         }
+        ok = token->data.sym != SLN_UTILS_SYM_NONE;
     }
+    SLN_TRACE_SPAN("lex.intern", NULL, intern_start);
     
-    if (buffer->len >= capacity) {
-        capacity += 1;
-        sln_lex_token_t* new_tokens = SLN_ALLOC(capacity, sln_lex_token_t);
-        if (!new_tokens) goto allocation_error;
-        memcpy(new_tokens, buffer->tokens, buffer->len * sizeof(sln_lex_token_t));
-        free(buffer->tokens);
-        buffer->tokens = new_tokens;
+    if (!ok) {
+        sln_utils_free(diags.items);
+        sln_lex_free_tokens(buffer);
+        buffer->len = 0;
+        return SLN_LEX_ALLOCATION_FAILED;
     }
-    buffer->tokens[buffer->len].type = SLN_LEX_TOKEN_EOF;
-    buffer->tokens[buffer->len].data.cstr = NULL;
+    
+    _eof_token(&buffer->tokens[buffer->len], text_len);
     buffer->len++;
+    if (buffer->unterminated == SIZE_MAX) buffer->unterminated = buffer->len;
     
+    ctx.diags = NULL;
+    for (size_t d = 0; d < diags.len; d++) {
+        _report(&ctx, diags.items[d].error, diags.items[d].msg, diags.items[d].offset);
+    }
+    sln_lex_lines_free(&lines);
+    sln_utils_free(diags.items);
+    return ctx.status;
+}
+
+struct sln_lex_pipe {
+    sln_utils_ring_t ring;
+    thrd_t thread;
+    const char* text;
+    sln_utils_intern_t* symbols;
+    FILE* error_stream;
+    _sln_lex_diags_t diags;     /**< Collected by the lexer thread, printed on close */
+    bool holding;               /**< The consumer holds a batch */
+};
+
+static int _pipe_lex(void* arg) {
+    SLN_TRACE_THREAD("lexer");
+    SLN_TRACE_SCOPE("lex", NULL);
+    sln_lex_pipe_t* pipe = arg;
+    _sln_lex_ctx_t ctx = { pipe->text, pipe->symbols, NULL, SLN_LEX_OK, SIZE_MAX, 0, false, &pipe->diags, NULL, SLN_LEX_MAX_ERRORS };
+
+    size_t text_i = 0;
+    bool more = true;
+    sln_lex_batch_t* batch;
+    while ((batch = sln_utils_ring_acquire(&pipe->ring))) {
+        batch->len = 0;
+        while (more && batch->len < SLN_LEX_PIPE_BATCH) {
+            sln_lex_token_t* token = &batch->tokens[batch->len];
+            more = _next_token(&ctx, &text_i, token);
+            if (more && token->type != SLN_LEX_TOKEN_EOL && token->type != SLN_LEX_TOKEN_COMMENT) batch->len++;
+        }
+        bool last = !more && batch->len < SLN_LEX_PIPE_BATCH;
+        // Short of the text length if lexing gave up
+        if (last) _eof_token(&batch->tokens[batch->len++], text_i);
+        sln_utils_ring_publish(&pipe->ring);
+        if (last) break;
+    }
+    sln_utils_ring_close(&pipe->ring);
+    return 0;
+}
+
+sln_lex_error_t sln_lex_pipe_open(const char* text, sln_utils_intern_t* symbols, FILE* error_stream,
+                                  sln_lex_pipe_t** pipe) {
+    size_t text_len;
+    sln_lex_error_t error = _begin(text, pipe, symbols, error_stream, &text_len);
+    if (error != SLN_LEX_OK) return error;
+
+    sln_lex_pipe_t* p = SLN_ALLOC(1, sln_lex_pipe_t);
+    if (!p) return SLN_LEX_ALLOCATION_FAILED;
+    p->text = text;
+    p->symbols = symbols;
+    p->error_stream = error_stream;
+    if (!sln_utils_ring_init(&p->ring, SLN_LEX_PIPE_DEPTH, sizeof(sln_lex_batch_t))) {
+        sln_utils_free(p);
+        return SLN_LEX_ALLOCATION_FAILED;
+    }
+    if (thrd_create(&p->thread, _pipe_lex, p) != thrd_success) {
+        sln_utils_ring_free(&p->ring);
+        sln_utils_free(p);
+        return SLN_LEX_ALLOCATION_FAILED;
+    }
+    *pipe = p;
     return SLN_LEX_OK;
+}
 
-allocation_error:
-    sln_lex_free_tokens(buffer);
-    return SLN_LEX_ALLOCATION_FAILED;
-}
\ No newline at end of file
+const sln_lex_batch_t* sln_lex_pipe_next(sln_lex_pipe_t* pipe) {
+    if (pipe->holding) sln_utils_ring_release(&pipe->ring);
+    const sln_lex_batch_t* batch = sln_utils_ring_peek(&pipe->ring);
+    pipe->holding = batch != NULL;
+    return batch;
+}
+
+sln_lex_error_t sln_lex_pipe_close(sln_lex_pipe_t* pipe) {
+    if (pipe->holding) sln_utils_ring_release(&pipe->ring);
+    sln_utils_ring_cancel(&pipe->ring);
+    thrd_join(pipe->thread, NULL);
+
+    // The same diagnostics, in the same order, as a serial run
+    sln_lex_lines_t lines;
+    sln_lex_lines_init(&lines, pipe->text);
+    _sln_lex_ctx_t ctx = { pipe->text, pipe->symbols, pipe->error_stream, SLN_LEX_OK, SIZE_MAX, 0, false, NULL, &lines, SLN_LEX_MAX_ERRORS };
+    for (size_t d = 0; d < pipe->diags.len; d++) {
+        _report(&ctx, pipe->diags.items[d].error, pipe->diags.items[d].msg, pipe->diags.items[d].offset);
+    }
+    sln_lex_error_t status = pipe->diags.failed ? SLN_LEX_ALLOCATION_FAILED : ctx.status;
+    sln_lex_lines_free(&lines);
+    sln_utils_free(pipe->diags.items);
+    sln_utils_ring_free(&pipe->ring);
+    sln_utils_free(pipe);
+    return status;
+}
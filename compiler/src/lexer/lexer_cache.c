@@ -0,0 +1,501 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   define SLN_LEX_CACHE_MMAP 1
+#endif
+
+#include <utils/allocation.h>
+#include <utils/trace.h>
+#include <lexer/lexer_cache.h>
+
+#define SLN_LEX_CACHE_MAGIC "SLNTOKS"
+// Sections start on cache lines; the mapping itself is page aligned
+#define SLN_LEX_CACHE_ALIGN 64u
+#define SLN_LEX_CACHE_VERSION_SIZE 32u
+// Room for "/<16 hex digits>.tok" and the NUL
+#define SLN_LEX_CACHE_NAME_SIZE 24u
+
+// Word size and long double size; the byte order shows in `format`
+#define SLN_LEX_CACHE_LAYOUT ((uint32_t)(sizeof(void*) << 8 | sizeof(long double)))
+
+// XXH64 primes
+#define _P1 0x9E3779B185EBCA87ull
+#define _P2 0xC2B2AE3D27D4EB4Full
+#define _P3 0x165667B19E3779F9ull
+#define _P4 0x85EBCA77C2B2AE63ull
+#define _P5 0x27D4EB2F165667C5ull
+
+enum {
+    _SECTION_KINDS,
+    _SECTION_OFFSETS,
+    _SECTION_BITS,
+    _SECTION_RANK,
+    _SECTION_LENGTHS,
+    _SECTION_VALUES,
+    _SECTION_FLOATS,
+    _SECTION_TRIVIA,
+    _SECTION_SYMBOLS,
+    _SECTION_POOL,
+    _SECTION_COUNT,
+};
+
+/**
+ * @struct _sln_lex_cache_header_t
+ * @brief Start of an image; section offsets count from here.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t format;
+    uint32_t layout;
+    char version[SLN_LEX_CACHE_VERSION_SIZE];
+    uint64_t key;
+    uint64_t text_len;
+    uint64_t token_count;
+    uint64_t payload_count;
+    uint64_t float_count;
+    uint64_t trivia_count;
+    uint64_t symbol_count;
+    uint64_t pool_len;
+    uint64_t sections[_SECTION_COUNT];
+    uint64_t size;
+} _sln_lex_cache_header_t;
+
+// Pool string of one image symbol; payload values of symbols index these
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} _sln_lex_cache_symbol_t;
+
+// ------- Content hash -------
+
+static inline uint64_t _rotl(uint64_t x, unsigned r) {
+    return x << r | x >> (64 - r);
+}
+
+static inline uint64_t _read64(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t _read32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t _round(uint64_t acc, uint64_t input) {
+    return _rotl(acc + input * _P2, 31) * _P1;
+}
+
+static inline uint64_t _merge(uint64_t acc, uint64_t lane) {
+    return (acc ^ _round(0, lane)) * _P1 + _P4;
+}
+
+// XXH64; the seed ties keys to the compiler version and image format
+static uint64_t _hash(const char* p, size_t len, uint64_t seed) {
+    const char* end = p + len;
+    uint64_t h;
+    if (len >= 32) {
+        uint64_t v1 = seed + _P1 + _P2, v2 = seed + _P2, v3 = seed, v4 = seed - _P1;
+        for (; end - p >= 32; p += 32) {
+            v1 = _round(v1, _read64(p));
+            v2 = _round(v2, _read64(p + 8));
+            v3 = _round(v3, _read64(p + 16));
+            v4 = _round(v4, _read64(p + 24));
+        }
+        h = _rotl(v1, 1) + _rotl(v2, 7) + _rotl(v3, 12) + _rotl(v4, 18);
+        h = _merge(_merge(_merge(_merge(h, v1), v2), v3), v4);
+    } else {
+        h = seed + _P5;
+    }
+    h += len;
+    for (; end - p >= 8; p += 8) h = _rotl(h ^ _round(0, _read64(p)), 27) * _P1 + _P4;
+    if (end - p >= 4) {
+        h = _rotl(h ^ (uint64_t)_read32(p) * _P1, 23) * _P2 + _P3;
+        p += 4;
+    }
+    for (; p < end; p++) h = _rotl(h ^ (uint8_t)*p * _P5, 11) * _P1;
+
+    h ^= h >> 33;
+    h *= _P2;
+    h ^= h >> 29;
+    h *= _P3;
+    return h ^ h >> 32;
+}
+
+uint64_t sln_lex_cache_key(const char* text, size_t len) {
+    SLN_TRACE_SCOPE("cache.key", NULL);
+    static const char version[] = SLN_VERSION;
+    uint64_t seed = _hash(version, sizeof(version) - 1, SLN_LEX_CACHE_FORMAT);
+    return _hash(text, len, seed);
+}
+
+// ------- Image layout -------
+
+static inline uint64_t _align(uint64_t offset) {
+    return (offset + SLN_LEX_CACHE_ALIGN - 1) & ~(uint64_t)(SLN_LEX_CACHE_ALIGN - 1);
+}
+
+static inline size_t _words(size_t token_count) {
+    return (token_count + SLN_LEX_TOKENS_BLOCK - 1) / SLN_LEX_TOKENS_BLOCK;
+}
+
+// Section sizes of an image whose counts are set
+static void _section_sizes(const _sln_lex_cache_header_t* header, uint64_t sizes[_SECTION_COUNT]) {
+    uint64_t words = _words((size_t)header->token_count);
+    sizes[_SECTION_KINDS] = header->token_count * sizeof(uint8_t);
+    sizes[_SECTION_OFFSETS] = header->token_count * sizeof(uint32_t);
+    sizes[_SECTION_BITS] = words * sizeof(uint64_t);
+    sizes[_SECTION_RANK] = words * sizeof(uint32_t);
+    sizes[_SECTION_LENGTHS] = header->payload_count * sizeof(uint32_t);
+    sizes[_SECTION_VALUES] = header->payload_count * sizeof(uint64_t);
+    sizes[_SECTION_FLOATS] = header->float_count * sizeof(long double);
+    sizes[_SECTION_TRIVIA] = header->trivia_count * sizeof(sln_lex_trivia_item_t);
+    sizes[_SECTION_SYMBOLS] = header->symbol_count * sizeof(_sln_lex_cache_symbol_t);
+    sizes[_SECTION_POOL] = header->pool_len;
+}
+
+static void _header_init(_sln_lex_cache_header_t* header, uint64_t key, size_t text_len) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, SLN_LEX_CACHE_MAGIC, sizeof(SLN_LEX_CACHE_MAGIC));
+    header->format = SLN_LEX_CACHE_FORMAT;
+    header->layout = SLN_LEX_CACHE_LAYOUT;
+    strncpy(header->version, SLN_VERSION, SLN_LEX_CACHE_VERSION_SIZE - 1);
+    header->key = key;
+    header->text_len = text_len;
+}
+
+static bool _header_matches(const _sln_lex_cache_header_t* header, uint64_t key, size_t text_len) {
+    _sln_lex_cache_header_t expected;
+    _header_init(&expected, key, text_len);
+    return memcmp(header->magic, expected.magic, sizeof(expected.magic)) == 0
+        && header->format == expected.format
+        && header->layout == expected.layout
+        && memcmp(header->version, expected.version, sizeof(expected.version)) == 0
+        && header->key == key
+        && header->text_len == text_len;
+}
+
+#if SLN_LEX_CACHE_MMAP
+
+// "<dir>/<key>.tok"
+static char* _entry_path(const char* dir, uint64_t key) {
+    size_t size = strlen(dir) + SLN_LEX_CACHE_NAME_SIZE;
+    char* path = SLN_ALLOC(size, char);
+    if (path) snprintf(path, size, "%s/%016" PRIx64 ".tok", dir, key);
+    return path;
+}
+
+// ------- Load -------
+
+// Checks every index of a mapped image and points the stream at it.
+// Symbol payloads are rewritten from pool indices to interner ids.
+static bool _adopt(_sln_lex_cache_header_t* header, sln_utils_intern_t* symbols, sln_lex_tokens_t* tokens) {
+    char* base = (char*)header;
+    // Counts no larger than the file keep the section sizes from overflowing
+    if (header->token_count > header->size || header->payload_count > header->size ||
+        header->float_count > header->size || header->trivia_count > header->size ||
+        header->symbol_count > header->size ||
+        header->pool_len > header->size) {
+        return false;
+    }
+    uint64_t sizes[_SECTION_COUNT];
+    _section_sizes(header, sizes);
+    uint64_t end = _align(sizeof(*header));
+    for (int s = 0; s < _SECTION_COUNT; s++) {
+        if (header->sections[s] != end) return false;
+        end = _align(end + sizes[s]);
+    }
+    if (end != header->size) return false;
+
+    tokens->kinds = (uint8_t*)(base + header->sections[_SECTION_KINDS]);
+    tokens->offsets = (uint32_t*)(void*)(base + header->sections[_SECTION_OFFSETS]);
+    tokens->payload_bits = (uint64_t*)(void*)(base + header->sections[_SECTION_BITS]);
+    tokens->payload_rank = (uint32_t*)(void*)(base + header->sections[_SECTION_RANK]);
+    tokens->payload_lengths = (uint32_t*)(void*)(base + header->sections[_SECTION_LENGTHS]);
+    tokens->payload_values = (uint64_t*)(void*)(base + header->sections[_SECTION_VALUES]);
+    tokens->floats = (long double*)(void*)(base + header->sections[_SECTION_FLOATS]);
+    tokens->trivia.items = (sln_lex_trivia_item_t*)(void*)(base + header->sections[_SECTION_TRIVIA]);
+    tokens->len = tokens->cap = (size_t)header->token_count;
+    tokens->payload_len = tokens->payload_cap = (size_t)header->payload_count;
+    tokens->floats_len = tokens->floats_cap = (size_t)header->float_count;
+    tokens->trivia.len = tokens->trivia_cap = (size_t)header->trivia_count;
+
+    // Trivia come in source order, each before a token of the stream
+    for (size_t t = 0; t < tokens->trivia.len; t++) {
+        const sln_lex_trivia_item_t* item = &tokens->trivia.items[t];
+        if ((item->type != SLN_LEX_TOKEN_EOL && item->type != SLN_LEX_TOKEN_COMMENT) ||
+            item->token >= tokens->len || (t > 0 && item->token < item[-1].token) ||
+            (uint64_t)item->span.offset + item->span.length > header->text_len) {
+            return false;
+        }
+    }
+
+    // The ranks must be the running popcount, and no bit may lie past the last token
+    size_t words = _words(tokens->len);
+    uint64_t rank = 0;
+    for (size_t w = 0; w < words; w++) {
+        if (tokens->payload_rank[w] != rank) return false;
+        uint64_t bits = tokens->payload_bits[w];
+        if (w == words - 1 && tokens->len % SLN_LEX_TOKENS_BLOCK && bits >> (tokens->len % SLN_LEX_TOKENS_BLOCK)) return false;
+        rank += (uint64_t)__builtin_popcountll(bits);
+    }
+    if (rank != header->payload_count) return false;
+
+    const _sln_lex_cache_symbol_t* entries = (const _sln_lex_cache_symbol_t*)(const void*)(base + header->sections[_SECTION_SYMBOLS]);
+    const char* pool = base + header->sections[_SECTION_POOL];
+    sln_utils_sym_t* ids = SLN_ALLOC(header->symbol_count ? header->symbol_count : 1, sln_utils_sym_t);
+    if (!ids) return false;
+    bool ok = true;
+    for (size_t s = 0; ok && s < header->symbol_count; s++) {
+        ok = (uint64_t)entries[s].offset + entries[s].length <= header->pool_len
+          && (ids[s] = sln_utils_intern(symbols, pool + entries[s].offset, entries[s].length)) != SLN_UTILS_SYM_NONE;
+    }
+
+    for (size_t i = 0; ok && i < tokens->len; i++) {
+        uint8_t kind = tokens->kinds[i];
+        if (kind >= _SLN_LEX_TOKEN_COUNT) {
+            ok = false;
+            break;
+        }
+        size_t payload = sln_lex_tokens_payload(tokens, i);
+        uint64_t length = payload == SIZE_MAX ? sln_lex_token_fixed_length[kind] : tokens->payload_lengths[payload];
+        ok = (uint64_t)tokens->offsets[i] + length <= header->text_len;
+        switch (kind) {
+            case SLN_LEX_TOKEN_IDENTIFIER:
+            case SLN_LEX_TOKEN_STRING_LITERAL:
+                ok = ok && payload != SIZE_MAX && tokens->payload_values[payload] < header->symbol_count;
+                if (ok) tokens->payload_values[payload] = ids[tokens->payload_values[payload]];
+                break;
+            case SLN_LEX_TOKEN_FLOAT_LITERAL:
+                ok = ok && payload != SIZE_MAX && tokens->payload_values[payload] < header->float_count;
+                break;
+            case SLN_LEX_TOKEN_INT_LITERAL:
+            case SLN_LEX_TOKEN_CHAR_LITERAL:
+                ok = ok && payload != SIZE_MAX;
+                break;
+            default:
+                break;
+        }
+    }
+    sln_utils_free(ids);
+    return ok;
+}
+
+bool sln_lex_cache_load(const char* dir, uint64_t key, size_t text_len,
+                        sln_utils_intern_t* symbols, sln_lex_cache_entry_t* entry) {
+    SLN_TRACE_SCOPE("cache.load", NULL);
+    memset(entry, 0, sizeof(*entry));
+    char* path = _entry_path(dir, key);
+    if (!path) return false;
+    int fd = open(path, O_RDONLY);
+    sln_utils_free(path);
+    if (fd < 0) return false;
+
+    struct stat st;
+    void* region = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(_sln_lex_cache_header_t)) {
+        // Private and writable: only the pages of rewritten symbols get copied
+        region = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (region == MAP_FAILED) return false;
+
+    _sln_lex_cache_header_t* header = region;
+    if (!_header_matches(header, key, text_len) || header->size != (uint64_t)st.st_size ||
+        !_adopt(header, symbols, &entry->tokens)) {
+        munmap(region, (size_t)st.st_size);
+        memset(entry, 0, sizeof(*entry));
+        return false;
+    }
+    entry->region = region;
+    entry->region_len = (size_t)st.st_size;
+    return true;
+}
+
+void sln_lex_cache_release(sln_lex_cache_entry_t* entry) {
+    if (!entry || !entry->region) return;
+    munmap(entry->region, entry->region_len);
+    memset(entry, 0, sizeof(*entry));
+}
+
+// ------- Store -------
+
+// Image symbols in order of first use, found through an open-addressing
+// table from interner id to image index
+typedef struct {
+    sln_utils_sym_t* slots;     /**< Interner id, SLN_UTILS_SYM_NONE if empty */
+    uint32_t* indices;          /**< Image index of the id in the same slot */
+    size_t mask;
+    sln_utils_sym_t* order;     /**< Interner id of every image symbol */
+    size_t count;
+    uint64_t pool_len;
+} _sln_lex_cache_symbols_t;
+
+static bool _symbols_init(_sln_lex_cache_symbols_t* table, size_t max_count) {
+    size_t slots = 16;
+    while (slots < max_count * 2) slots *= 2;
+    table->slots = SLN_ALLOC(slots, sln_utils_sym_t);
+    table->indices = SLN_ALLOC(slots, uint32_t);
+    table->order = SLN_ALLOC(max_count ? max_count : 1, sln_utils_sym_t);
+    table->mask = slots - 1;
+    return table->slots && table->indices && table->order;
+}
+
+static void _symbols_free(_sln_lex_cache_symbols_t* table) {
+    sln_utils_free(table->slots);
+    sln_utils_free(table->indices);
+    sln_utils_free(table->order);
+}
+
+static uint32_t _symbols_index(_sln_lex_cache_symbols_t* table, const sln_utils_intern_t* symbols, sln_utils_sym_t sym) {
+    size_t slot = (sym * 0x9E3779B9u) & table->mask;
+    while (table->slots[slot] != SLN_UTILS_SYM_NONE) {
+        if (table->slots[slot] == sym) return table->indices[slot];
+        slot = (slot + 1) & table->mask;
+    }
+    size_t len = 0;
+    sln_utils_intern_get(symbols, sym, &len);
+    table->slots[slot] = sym;
+    table->indices[slot] = (uint32_t)table->count;
+    table->order[table->count] = sym;
+    table->pool_len += len;
+    return (uint32_t)table->count++;
+}
+
+// Writes a section at its offset, zero-filling the gap before it
+static bool _write_at(FILE* out, uint64_t* pos, uint64_t offset, const void* data, uint64_t size) {
+    static const char zeros[SLN_LEX_CACHE_ALIGN] = {0};
+    if (offset - *pos > sizeof(zeros) || fwrite(zeros, 1, (size_t)(offset - *pos), out) != offset - *pos) return false;
+    if (size && fwrite(data, 1, (size_t)size, out) != size) return false;
+    *pos = offset + size;
+    return true;
+}
+
+static bool _write_image(FILE* out, _sln_lex_cache_header_t* header, const sln_lex_tokens_t* tokens,
+                         const uint64_t* values, const _sln_lex_cache_symbols_t* table,
+                         const sln_utils_intern_t* symbols) {
+    uint64_t sizes[_SECTION_COUNT];
+    _section_sizes(header, sizes);
+    uint64_t end = _align(sizeof(*header));
+    for (int s = 0; s < _SECTION_COUNT; s++) {
+        header->sections[s] = end;
+        end = _align(end + sizes[s]);
+    }
+    header->size = end;
+
+    const void* data[_SECTION_COUNT] = {
+        tokens->kinds, tokens->offsets, tokens->payload_bits, tokens->payload_rank,
+        tokens->payload_lengths, values, tokens->floats, tokens->trivia.items, NULL, NULL,
+    };
+    uint64_t pos = 0;
+    if (!_write_at(out, &pos, 0, header, sizeof(*header))) return false;
+    for (int s = _SECTION_KINDS; s < _SECTION_SYMBOLS; s++) {
+        if (!_write_at(out, &pos, header->sections[s], data[s], sizes[s])) return false;
+    }
+
+    uint32_t offset = 0;
+    for (size_t s = 0; s < table->count; s++) {
+        size_t len = 0;
+        sln_utils_intern_get(symbols, table->order[s], &len);
+        _sln_lex_cache_symbol_t entry = { offset, (uint32_t)len };
+        uint64_t at = s ? pos : header->sections[_SECTION_SYMBOLS];
+        if (!_write_at(out, &pos, at, &entry, sizeof(entry))) return false;
+        offset += (uint32_t)len;
+    }
+    for (size_t s = 0; s < table->count; s++) {
+        size_t len = 0;
+        const char* str = sln_utils_intern_get(symbols, table->order[s], &len);
+        uint64_t at = s ? pos : header->sections[_SECTION_POOL];
+        if (!_write_at(out, &pos, at, str, len)) return false;
+    }
+    return _write_at(out, &pos, header->size, NULL, 0);
+}
+
+bool sln_lex_cache_store(const char* dir, uint64_t key, size_t text_len,
+                         const sln_lex_tokens_t* tokens, const sln_utils_intern_t* symbols) {
+    SLN_TRACE_SCOPE("cache.store", NULL);
+    // Symbol payloads become image indices, in a copy of the values
+    uint64_t* values = SLN_ALLOC(tokens->payload_len ? tokens->payload_len : 1, uint64_t);
+    _sln_lex_cache_symbols_t table = {0};
+    bool ok = values && _symbols_init(&table, tokens->payload_len);
+    if (ok) {
+        if (tokens->payload_len) memcpy(values, tokens->payload_values, tokens->payload_len * sizeof(*values));
+        for (size_t i = 0; i < tokens->len; i++) {
+            sln_lex_token_type_t kind = sln_lex_tokens_kind(tokens, i);
+            if (kind != SLN_LEX_TOKEN_IDENTIFIER && kind != SLN_LEX_TOKEN_STRING_LITERAL) continue;
+            size_t payload = sln_lex_tokens_payload(tokens, i);
+            values[payload] = _symbols_index(&table, symbols, (sln_utils_sym_t)values[payload]);
+        }
+        ok = table.pool_len <= UINT32_MAX;
+    }
+
+    char* path = ok ? _entry_path(dir, key) : NULL;
+    char* temp = path ? SLN_ALLOC(strlen(path) + 8, char) : NULL;
+    int fd = -1;
+    if (temp) {
+        snprintf(temp, strlen(path) + 8, "%s.XXXXXX", path);
+        if (mkdir(dir, 0777) != 0 && errno != EEXIST) ok = false;
+        if (ok) fd = mkstemp(temp);
+    }
+    if (fd >= 0) {
+        _sln_lex_cache_header_t header;
+        _header_init(&header, key, text_len);
+        header.token_count = tokens->len;
+        header.payload_count = tokens->payload_len;
+        header.float_count = tokens->floats_len;
+        header.trivia_count = tokens->trivia.len;
+        header.symbol_count = table.count;
+        header.pool_len = table.pool_len;
+
+        // mkstemp() makes the file private; other users may share the cache
+        fchmod(fd, 0644);
+        FILE* out = fdopen(fd, "wb");
+        if (!out) close(fd);
+        ok = out && _write_image(out, &header, tokens, values, &table, symbols);
+        if (out && fclose(out) != 0) ok = false;
+        // The rename publishes the entry whole; readers never see a partial one
+        if (!ok || rename(temp, path) != 0) {
+            unlink(temp);
+            ok = false;
+        }
+    } else {
+        ok = false;
+    }
+
+    sln_utils_free(temp);
+    sln_utils_free(path);
+    _symbols_free(&table);
+    sln_utils_free(values);
+    return ok;
+}
+
+#else
+
+bool sln_lex_cache_load(const char* dir, uint64_t key, size_t text_len,
+                        sln_utils_intern_t* symbols, sln_lex_cache_entry_t* entry) {
+    (void)dir; (void)key; (void)text_len; (void)symbols;
+    memset(entry, 0, sizeof(*entry));
+    return false;
+}
+
+bool sln_lex_cache_store(const char* dir, uint64_t key, size_t text_len,
+                         const sln_lex_tokens_t* tokens, const sln_utils_intern_t* symbols) {
+    (void)dir; (void)key; (void)text_len; (void)tokens; (void)symbols;
+    return false;
+}
+
+void sln_lex_cache_release(sln_lex_cache_entry_t* entry) {
+    (void)entry;
+}
+
+#endif // SLN_LEX_CACHE_MMAP
@@ -0,0 +1,70 @@
+#include <string.h>
+
+#include <utils/allocation.h>
+#include <lexer/lexer_lines.h>
+#include <lexer/lexer_scan.h>
+
+#define SLN_LEXER_LINES_INITIAL_SIZE 256UL
+#define SLN_LEXER_LINES_GROW_FACTOR 2
+
+void sln_lex_lines_init(sln_lex_lines_t* lines, const char* text) {
+    lines->text = text;
+    lines->starts = NULL;
+    lines->count = 0;
+}
+
+static bool _push(sln_lex_lines_t* lines, size_t* capacity, size_t start) {
+    if (lines->count == *capacity) {
+        size_t new_capacity = *capacity * SLN_LEXER_LINES_GROW_FACTOR;
+        uint32_t* starts = SLN_ALLOC(new_capacity, uint32_t);
+        if (!starts) return false;
+        memcpy(starts, lines->starts, lines->count * sizeof(uint32_t));
+        sln_utils_free(lines->starts);
+        lines->starts = starts;
+        *capacity = new_capacity;
+    }
+    lines->starts[lines->count++] = (uint32_t)start;
+    return true;
+}
+
+// Walks the line breaks with the vectorized find_eol kernel
+static bool _build(sln_lex_lines_t* lines) {
+    size_t capacity = SLN_LEXER_LINES_INITIAL_SIZE;
+    lines->starts = SLN_ALLOC(capacity, uint32_t);
+    if (!lines->starts) return false;
+    lines->starts[lines->count++] = 0;
+    
+    sln_lex_scan_init();
+    for (const char* p = sln_lex_scan.find_eol(lines->text); *p; p = sln_lex_scan.find_eol(p + 1)) {
+        if (!_push(lines, &capacity, (size_t)(p + 1 - lines->text))) {
+            sln_lex_lines_free(lines);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sln_lex_lines_locate(sln_lex_lines_t* lines, size_t offset, sln_lex_location_t* location) {
+    if (!lines->starts && !_build(lines)) return false;
+    
+    // Last line starting at or before the offset
+    size_t lo = 1;
+    size_t hi = lines->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (lines->starts[mid] <= offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    location->line = (uint32_t)lo;
+    location->column = (uint32_t)(offset - lines->starts[lo - 1] + 1);
+    return true;
+}
+
+void sln_lex_lines_free(sln_lex_lines_t* lines) {
+    sln_utils_free(lines->starts);
+    lines->starts = NULL;
+    lines->count = 0;
+}
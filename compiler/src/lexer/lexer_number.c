@@ -0,0 +1,76 @@
+
+#include <float.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <lexer/lexer_number.h>
+
+// Clinger's fast path: the significand and 10^|exponent| must both be
+// exact, then a single rounding operation yields the correct result.
+// 5^27 still fits a 64-bit significand, 5^22 a 53-bit one, 5^48 a 113-bit one.
+#if LDBL_MANT_DIG >= 113
+#   define SLN_LEX_FLOAT_MAX_POW10 48
+#   define SLN_LEX_FLOAT_MAX_DIGITS 19
+#elif LDBL_MANT_DIG >= 64
+#   define SLN_LEX_FLOAT_MAX_POW10 27
+#   define SLN_LEX_FLOAT_MAX_DIGITS 19
+#else
+#   define SLN_LEX_FLOAT_MAX_POW10 22
+#   define SLN_LEX_FLOAT_MAX_DIGITS 15
+#endif
+
+// Sized for the widest format; entries past SLN_LEX_FLOAT_MAX_POW10 are never read
+static const long double _pow10[] = {
+    1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L,
+    1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L,
+    1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L,
+    1e24L, 1e25L, 1e26L, 1e27L, 1e28L, 1e29L, 1e30L, 1e31L,
+    1e32L, 1e33L, 1e34L, 1e35L, 1e36L, 1e37L, 1e38L, 1e39L,
+    1e40L, 1e41L, 1e42L, 1e43L, 1e44L, 1e45L, 1e46L, 1e47L,
+    1e48L,
+};
+
+long double sln_lex_decimal_float(const char* lexeme, size_t len) {
+    const char* p = lexeme;
+    const char* end = lexeme + len;
+    uint64_t significand = 0;
+    int digits = 0;
+    long exponent = 0;
+
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (digits == 0 && *p == '0') continue;
+        if (++digits > SLN_LEX_FLOAT_MAX_DIGITS) goto exact;
+        significand = significand * 10 + (uint64_t)(*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            exponent--;
+            if (digits == 0 && *p == '0') continue;
+            if (++digits > SLN_LEX_FLOAT_MAX_DIGITS) goto exact;
+            significand = significand * 10 + (uint64_t)(*p - '0');
+        }
+    }
+    if (significand == 0) return 0.0L;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        bool negative = false;
+        long value = 0;
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) negative = *p++ == '-';
+        for (; p < end; p++) {
+            if (value > SLN_LEX_FLOAT_MAX_POW10 * 4) goto exact;
+            value = value * 10 + (*p - '0');
+        }
+        exponent += negative ? -value : value;
+    }
+
+    if (exponent < -SLN_LEX_FLOAT_MAX_POW10 || exponent > SLN_LEX_FLOAT_MAX_POW10) goto exact;
+
+    long double value = (long double)significand;
+    return exponent < 0 ? value / _pow10[-exponent] : value * _pow10[exponent];
+
+exact:
+    // The literal ends at a byte strtold() cannot take either
+    return strtold(lexeme, NULL);
+}
@@ -0,0 +1,289 @@
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <threads.h>
+
+#include <string.h>
+
+#include <lexer/lexer_scan.h>
+#include <lexer/lexer_utf8.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   define SLN_LEX_SCAN_X86 1
+#   include <immintrin.h>
+#endif
+
+// ------- Scalar -------
+
+static const char* _scalar_skip_blanks(const char* p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+static const char* _scalar_find_eol(const char* p) {
+    while (*p != '\0' && *p != '\n') p++;
+    return p;
+}
+
+static const char* _scalar_find_hash(const char* p) {
+    while (*p != '\0' && *p != '#') p++;
+    return p;
+}
+
+static const char* _scalar_find_quote(const char* p) {
+    while (*p != '\0' && *p != '"' && *p != '\\') p++;
+    return p;
+}
+
+static const char* _scalar_find_invalid_utf8(const char* p, const char* end) {
+    while (p < end) {
+        // Eight ASCII bytes at a time
+        uint64_t word;
+        if (end - p >= 8 && (memcpy(&word, p, 8), !(word & 0x8080808080808080ull))) {
+            p += 8;
+            continue;
+        }
+        uint32_t code_point;
+        size_t len = sln_lex_utf8_decode(p, &code_point);
+        if (!len || len > (size_t)(end - p)) return p;
+        p += len;
+    }
+    return end;
+}
+
+// Start of the sequence that `p` cuts in two, or `p`
+static const char* _utf8_boundary(const char* start, const char* p) {
+    for (ptrdiff_t k = 1; k <= 3 && k <= p - start; k++) {
+        uint8_t c = (uint8_t)p[-k];
+        if (c < 0x80) break;
+        if (c >= 0xC0) return p - k;
+    }
+    return p;
+}
+
+sln_lex_scan_kernels_t sln_lex_scan = {
+    _scalar_skip_blanks,
+    _scalar_find_eol,
+    _scalar_find_hash,
+    _scalar_find_quote,
+    _scalar_find_invalid_utf8,
+    "scalar",
+};
+
+// Sets the CPU supports, scalar first; filled once by _sln_lex_scan_select()
+static sln_lex_scan_kernels_t _sln_lex_scan_sets[3];
+static size_t _sln_lex_scan_set_count;
+
+#if defined(SLN_LEX_SCAN_X86)
+
+// Each kernel loads the aligned block holding `p`, drops the match bits
+// of bytes before `p`, then walks aligned blocks until a bit is set.
+// The aligned blocks may extend past the NUL, which is harmless but
+// looks like an overflow to AddressSanitizer.
+#define _SCAN_NO_ASAN __attribute__((no_sanitize_address))
+
+// ------- SSE2 -------
+
+#define _SSE2_SCAN(name, match_expr)                                        \
+    _SCAN_NO_ASAN                                                           \
+    static const char* name(const char* p) {                                \
+        const uintptr_t misalign = (uintptr_t)p & 15u;                      \
+        const char* block = p - misalign;                                   \
+        __m128i v = _mm_load_si128((const __m128i*)(const void*)block);     \
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(match_expr) >> misalign;\
+        if (mask) return p + __builtin_ctz(mask);                           \
+        for (;;) {                                                          \
+            block += 16;                                                    \
+            v = _mm_load_si128((const __m128i*)(const void*)block);         \
+            mask = (uint32_t)_mm_movemask_epi8(match_expr);                 \
+            if (mask) return block + __builtin_ctz(mask);                   \
+        }                                                                   \
+    }
+
+#define _SSE2_EQ(c) _mm_cmpeq_epi8(v, _mm_set1_epi8(c))
+
+_SSE2_SCAN(_sse2_skip_blanks,
+           _mm_xor_si128(_mm_or_si128(_SSE2_EQ(' '), _SSE2_EQ('\t')), _mm_set1_epi8(-1)))
+_SSE2_SCAN(_sse2_find_eol,
+           _mm_or_si128(_SSE2_EQ('\n'), _SSE2_EQ('\0')))
+_SSE2_SCAN(_sse2_find_hash,
+           _mm_or_si128(_SSE2_EQ('#'), _SSE2_EQ('\0')))
+_SSE2_SCAN(_sse2_find_quote,
+           _mm_or_si128(_mm_or_si128(_SSE2_EQ('"'), _SSE2_EQ('\\')), _SSE2_EQ('\0')))
+
+// Skips ASCII blocks; others are decoded
+static const char* _sse2_find_invalid_utf8(const char* p, const char* end) {
+    const char* start = p;
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)p);
+        if (_mm_movemask_epi8(v)) return _scalar_find_invalid_utf8(_utf8_boundary(start, p), end);
+        p += 16;
+    }
+    return _scalar_find_invalid_utf8(_utf8_boundary(start, p), end);
+}
+
+// ------- AVX2 -------
+
+#define _AVX2_SCAN(name, match_expr)                                        \
+    __attribute__((target("avx2"))) _SCAN_NO_ASAN                           \
+    static const char* name(const char* p) {                                \
+        const uintptr_t misalign = (uintptr_t)p & 31u;                      \
+        const char* block = p - misalign;                                   \
+        __m256i v = _mm256_load_si256((const __m256i*)(const void*)block);  \
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(match_expr) >> misalign; \
+        if (mask) return p + __builtin_ctz(mask);                           \
+        for (;;) {                                                          \
+            block += 32;                                                    \
+            v = _mm256_load_si256((const __m256i*)(const void*)block);      \
+            mask = (uint32_t)_mm256_movemask_epi8(match_expr);              \
+            if (mask) return block + __builtin_ctz(mask);                   \
+        }                                                                   \
+    }
+
+#define _AVX2_EQ(c) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))
+
+_AVX2_SCAN(_avx2_skip_blanks,
+           _mm256_xor_si256(_mm256_or_si256(_AVX2_EQ(' '), _AVX2_EQ('\t')), _mm256_set1_epi8(-1)))
+_AVX2_SCAN(_avx2_find_eol,
+           _mm256_or_si256(_AVX2_EQ('\n'), _AVX2_EQ('\0')))
+_AVX2_SCAN(_avx2_find_hash,
+           _mm256_or_si256(_AVX2_EQ('#'), _AVX2_EQ('\0')))
+_AVX2_SCAN(_avx2_find_quote,
+           _mm256_or_si256(_mm256_or_si256(_AVX2_EQ('"'), _AVX2_EQ('\\')), _AVX2_EQ('\0')))
+
+// UTF-8 validation by lookup tables (Keiser and Lemire, "Validating
+// UTF-8 in less than one instruction per byte"). Each byte is checked
+// against the three before it: the high nibbles of the previous byte
+// and of the byte itself and the low nibble of the previous byte each
+// select the error classes they allow, and a byte is ill-formed when
+// all three agree on one. Blocks only say whether they hold an error;
+// the scalar kernel then finds its exact offset.
+#define _UTF8_TOO_SHORT   (1 << 0)  /* lead followed by a lead or ASCII */
+#define _UTF8_TOO_LONG    (1 << 1)  /* ASCII followed by a continuation */
+#define _UTF8_OVERLONG_3  (1 << 2)
+#define _UTF8_TOO_LARGE   (1 << 3)
+#define _UTF8_SURROGATE   (1 << 4)
+#define _UTF8_OVERLONG_2  (1 << 5)
+#define _UTF8_TOO_LARGE_1000 (1 << 6)
+#define _UTF8_OVERLONG_4  (1 << 6)
+#define _UTF8_TWO_CONTS   (-0x80)   /* continuation after a continuation; bit 7, negative to fit a char */
+#define _UTF8_CARRY (_UTF8_TOO_SHORT | _UTF8_TOO_LONG | _UTF8_TWO_CONTS)
+
+#define _AVX2_TABLE(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+// Last `n` bytes of `prev` followed by the first 32 - n of `in`
+#define _AVX2_PREV(in, prev, n) \
+    _mm256_alignr_epi8((in), _mm256_permute2x128_si256((prev), (in), 0x21), 16 - (n))
+
+__attribute__((target("avx2")))
+static inline __m256i _avx2_utf8_errors(__m256i in, __m256i prev) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i prev1 = _AVX2_PREV(in, prev, 1);
+    
+    __m256i byte_1_high = _mm256_shuffle_epi8(_AVX2_TABLE(
+        _UTF8_TOO_LONG, _UTF8_TOO_LONG, _UTF8_TOO_LONG, _UTF8_TOO_LONG,
+        _UTF8_TOO_LONG, _UTF8_TOO_LONG, _UTF8_TOO_LONG, _UTF8_TOO_LONG,
+        _UTF8_TWO_CONTS, _UTF8_TWO_CONTS, _UTF8_TWO_CONTS, _UTF8_TWO_CONTS,
+        _UTF8_TOO_SHORT | _UTF8_OVERLONG_2,
+        _UTF8_TOO_SHORT,
+        _UTF8_TOO_SHORT | _UTF8_OVERLONG_3 | _UTF8_SURROGATE,
+        _UTF8_TOO_SHORT | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000 | _UTF8_OVERLONG_4
+    ), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    
+    __m256i byte_1_low = _mm256_shuffle_epi8(_AVX2_TABLE(
+        _UTF8_CARRY | _UTF8_OVERLONG_3 | _UTF8_OVERLONG_2 | _UTF8_OVERLONG_4,
+        _UTF8_CARRY | _UTF8_OVERLONG_2,
+        _UTF8_CARRY,
+        _UTF8_CARRY,
+        _UTF8_CARRY | _UTF8_TOO_LARGE,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000 | _UTF8_SURROGATE,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000,
+        _UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000
+    ), _mm256_and_si256(prev1, nibble));
+    
+    __m256i byte_2_high = _mm256_shuffle_epi8(_AVX2_TABLE(
+        _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT,
+        _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT,
+        _UTF8_TOO_LONG | _UTF8_OVERLONG_2 | _UTF8_TWO_CONTS | _UTF8_OVERLONG_3 | _UTF8_TOO_LARGE_1000 | _UTF8_OVERLONG_4,
+        _UTF8_TOO_LONG | _UTF8_OVERLONG_2 | _UTF8_TWO_CONTS | _UTF8_OVERLONG_3 | _UTF8_TOO_LARGE,
+        _UTF8_TOO_LONG | _UTF8_OVERLONG_2 | _UTF8_TWO_CONTS | _UTF8_SURROGATE | _UTF8_TOO_LARGE,
+        _UTF8_TOO_LONG | _UTF8_OVERLONG_2 | _UTF8_TWO_CONTS | _UTF8_SURROGATE | _UTF8_TOO_LARGE,
+        _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT
+    ), _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+    
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+    
+    // Continuations the third and fourth bytes of a sequence must be
+    __m256i third = _mm256_subs_epu8(_AVX2_PREV(in, prev, 2), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(_AVX2_PREV(in, prev, 3), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must_continue, special);
+}
+
+__attribute__((target("avx2")))
+static const char* _avx2_find_invalid_utf8(const char* p, const char* end) {
+    const char* start = p;
+    // Nonzero where the block ends inside a sequence
+    const __m256i last_lead = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    __m256i prev = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    
+    while (end - p >= 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i*)(const void*)p);
+        __m256i error = incomplete;
+        if (_mm256_movemask_epi8(in)) {
+            error = _avx2_utf8_errors(in, prev);
+            incomplete = _mm256_subs_epu8(in, last_lead);
+        }
+        if (!_mm256_testz_si256(error, error)) break;
+        prev = in;
+        p += 32;
+    }
+    return _scalar_find_invalid_utf8(_utf8_boundary(start, p), end);
+}
+
+#endif // SLN_LEX_SCAN_X86
+
+static once_flag _sln_lex_scan_once = ONCE_FLAG_INIT;
+
+static void _sln_lex_scan_select(void) {
+    _sln_lex_scan_sets[_sln_lex_scan_set_count++] = sln_lex_scan;
+#if defined(SLN_LEX_SCAN_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        _sln_lex_scan_sets[_sln_lex_scan_set_count++] = (sln_lex_scan_kernels_t){
+            _sse2_skip_blanks, _sse2_find_eol, _sse2_find_hash, _sse2_find_quote,
+            _sse2_find_invalid_utf8, "sse2",
+        };
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        _sln_lex_scan_sets[_sln_lex_scan_set_count++] = (sln_lex_scan_kernels_t){
+            _avx2_skip_blanks, _avx2_find_eol, _avx2_find_hash, _avx2_find_quote,
+            _avx2_find_invalid_utf8, "avx2",
+        };
+    }
+#endif
+    // The last set is the best one
+    sln_lex_scan = _sln_lex_scan_sets[_sln_lex_scan_set_count - 1];
+}
+
+void sln_lex_scan_init(void) {
+    call_once(&_sln_lex_scan_once, _sln_lex_scan_select);
+}
+
+const sln_lex_scan_kernels_t* sln_lex_scan_sets(size_t* count) {
+    sln_lex_scan_init();
+    *count = _sln_lex_scan_set_count;
+    return _sln_lex_scan_sets;
+}
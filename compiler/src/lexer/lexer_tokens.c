@@ -0,0 +1,186 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/allocation.h>
+#include <lexer/lexer_tokens.h>
+#include <lexer/lexer_operators.h>
+
+#define SLN_LEX_TOKENS_INITIAL_SIZE 1024UL
+#define SLN_LEX_TOKENS_GROW_FACTOR 2
+
+// Zero for kinds whose length varies: their tokens always get a payload entry
+const uint8_t sln_lex_token_fixed_length[_SLN_LEX_TOKEN_COUNT] = {
+    [SLN_LEX_TOKEN_UNKNOWN] = 1,
+#define _SLN_LEX_FIXED_LENGTH(name, spelling) [SLN_LEX_TOKEN_##name] = sizeof(spelling) - 1,
+    SLN_LEX_OPERATORS(_SLN_LEX_FIXED_LENGTH)
+#undef _SLN_LEX_FIXED_LENGTH
+#define _SLN_LEX_FIXED_LENGTH(name, spelling) [SLN_LEX_TOKEN_KW_##name] = sizeof(spelling) - 1,
+    SLN_LEX_KEYWORDS(_SLN_LEX_FIXED_LENGTH)
+#undef _SLN_LEX_FIXED_LENGTH
+};
+
+// Returns the moved array, or NULL with the old one left intact
+static void* _grow_array(void* array, size_t len, size_t new_cap, size_t size_of_element) {
+    char* fresh = SLN_ALLOC(new_cap * size_of_element, char);
+    if (!fresh) return NULL;
+    if (array) memcpy(fresh, array, len * size_of_element);
+    sln_utils_free(array);
+    return fresh;
+}
+
+// Needs a `void* fresh` in scope
+#define _GROW(array, len, new_cap)                                              \
+    ((fresh = _grow_array((array), (len), (new_cap), sizeof(*(array)))) != NULL \
+     && ((array) = fresh, true))
+
+static bool _reserve_tokens(sln_lex_tokens_t* tokens) {
+    if (tokens->len < tokens->cap) return true;
+    void* fresh;
+    size_t cap = tokens->cap ? tokens->cap * SLN_LEX_TOKENS_GROW_FACTOR : SLN_LEX_TOKENS_INITIAL_SIZE;
+    size_t words = tokens->cap / SLN_LEX_TOKENS_BLOCK;
+    size_t new_words = cap / SLN_LEX_TOKENS_BLOCK;
+    if (!_GROW(tokens->kinds, tokens->len, cap) ||
+        !_GROW(tokens->offsets, tokens->len, cap) ||
+        !_GROW(tokens->payload_bits, words, new_words) ||
+        !_GROW(tokens->payload_rank, words, new_words)) {
+        return false;
+    }
+    tokens->cap = cap;
+    return true;
+}
+
+static bool _push_payload(sln_lex_tokens_t* tokens, uint32_t length, uint64_t value) {
+    if (tokens->payload_len >= tokens->payload_cap) {
+        void* fresh;
+        size_t cap = tokens->payload_cap ? tokens->payload_cap * SLN_LEX_TOKENS_GROW_FACTOR
+                                         : SLN_LEX_TOKENS_INITIAL_SIZE;
+        if (!_GROW(tokens->payload_lengths, tokens->payload_len, cap) ||
+            !_GROW(tokens->payload_values, tokens->payload_len, cap)) {
+            return false;
+        }
+        tokens->payload_cap = cap;
+    }
+    tokens->payload_lengths[tokens->payload_len] = length;
+    tokens->payload_values[tokens->payload_len] = value;
+    tokens->payload_len++;
+    return true;
+}
+
+static bool _push_trivia(sln_lex_tokens_t* tokens, const sln_lex_token_t* token) {
+    sln_lex_trivia_t* trivia = &tokens->trivia;
+    if (trivia->len >= tokens->trivia_cap) {
+        void* fresh;
+        size_t cap = tokens->trivia_cap ? tokens->trivia_cap * SLN_LEX_TOKENS_GROW_FACTOR
+                                        : SLN_LEX_TOKENS_INITIAL_SIZE;
+        if (!_GROW(trivia->items, trivia->len, cap)) return false;
+        tokens->trivia_cap = cap;
+    }
+    trivia->items[trivia->len++] = (sln_lex_trivia_item_t){ (uint32_t)tokens->len, token->type, token->span };
+    return true;
+}
+
+bool sln_lex_tokens_push(sln_lex_tokens_t* tokens, const sln_lex_token_t* token) {
+    if (token->type == SLN_LEX_TOKEN_EOL || token->type == SLN_LEX_TOKEN_COMMENT) return _push_trivia(tokens, token);
+    if (!_reserve_tokens(tokens)) return false;
+
+    size_t index = tokens->len;
+    size_t word = index / SLN_LEX_TOKENS_BLOCK;
+    if (index % SLN_LEX_TOKENS_BLOCK == 0) {
+        tokens->payload_rank[word] = (uint32_t)tokens->payload_len;
+    }
+
+    uint64_t value = 0;
+    bool has_payload = true;
+    switch (token->type) {
+        case SLN_LEX_TOKEN_IDENTIFIER:
+        case SLN_LEX_TOKEN_STRING_LITERAL:
+            value = token->data.sym;
+            break;
+        case SLN_LEX_TOKEN_INT_LITERAL:
+        case SLN_LEX_TOKEN_CHAR_LITERAL:
+            value = token->data.u64;
+            break;
+        case SLN_LEX_TOKEN_FLOAT_LITERAL:
+            if (tokens->floats_len >= tokens->floats_cap) {
+                void* fresh;
+                size_t cap = tokens->floats_cap ? tokens->floats_cap * SLN_LEX_TOKENS_GROW_FACTOR
+                                                : SLN_LEX_TOKENS_INITIAL_SIZE;
+                if (!_GROW(tokens->floats, tokens->floats_len, cap)) return false;
+                tokens->floats_cap = cap;
+            }
+            tokens->floats[tokens->floats_len] = token->data.lfloat;
+            value = tokens->floats_len++;
+            break;
+        default:
+            has_payload = token->span.length != sln_lex_token_fixed_length[token->type];
+            break;
+    }
+
+    if (has_payload) {
+        if (!_push_payload(tokens, token->span.length, value)) return false;
+        tokens->payload_bits[word] |= (uint64_t)1 << (index % SLN_LEX_TOKENS_BLOCK);
+    }
+    tokens->kinds[index] = (uint8_t)token->type;
+    tokens->offsets[index] = token->span.offset;
+    tokens->len++;
+    return true;
+}
+
+void sln_lex_tokens_free(sln_lex_tokens_t* tokens) {
+    if (!tokens) return;
+
+    sln_utils_free(tokens->kinds);
+    sln_utils_free(tokens->offsets);
+    sln_utils_free(tokens->payload_bits);
+    sln_utils_free(tokens->payload_rank);
+    sln_utils_free(tokens->payload_lengths);
+    sln_utils_free(tokens->payload_values);
+    sln_utils_free(tokens->floats);
+    sln_utils_free(tokens->trivia.items);
+    memset(tokens, 0, sizeof(*tokens));
+}
+
+void sln_lex_tokens_clear(sln_lex_tokens_t* tokens) {
+    if (!tokens) return;
+
+    // Pushes only set payload bits, so the used words must start out clear
+    size_t words = (tokens->len + SLN_LEX_TOKENS_BLOCK - 1) / SLN_LEX_TOKENS_BLOCK;
+    if (words) memset(tokens->payload_bits, 0, words * sizeof(*tokens->payload_bits));
+    tokens->len = 0;
+    tokens->payload_len = 0;
+    tokens->floats_len = 0;
+    tokens->trivia.len = 0;
+}
+
+size_t sln_lex_tokens_memory(const sln_lex_tokens_t* tokens) {
+    size_t words = (tokens->len + SLN_LEX_TOKENS_BLOCK - 1) / SLN_LEX_TOKENS_BLOCK;
+    return tokens->len * (sizeof(*tokens->kinds) + sizeof(*tokens->offsets))
+         + words * (sizeof(*tokens->payload_bits) + sizeof(*tokens->payload_rank))
+         + tokens->payload_len * (sizeof(*tokens->payload_lengths) + sizeof(*tokens->payload_values))
+         + tokens->floats_len * sizeof(*tokens->floats)
+         + tokens->trivia.len * sizeof(*tokens->trivia.items);
+}
+
+sln_lex_token_t sln_lex_tokens_get(const sln_lex_tokens_t* tokens, size_t index) {
+    sln_lex_token_t token = {0};
+    token.type = sln_lex_tokens_kind(tokens, index);
+    token.span = sln_lex_tokens_span(tokens, index);
+
+    switch (token.type) {
+        case SLN_LEX_TOKEN_IDENTIFIER:
+        case SLN_LEX_TOKEN_STRING_LITERAL:
+            token.data.sym = sln_lex_tokens_sym(tokens, index);
+            break;
+        case SLN_LEX_TOKEN_INT_LITERAL:
+        case SLN_LEX_TOKEN_CHAR_LITERAL:
+            token.data.u64 = sln_lex_tokens_u64(tokens, index);
+            break;
+        case SLN_LEX_TOKEN_FLOAT_LITERAL:
+            token.data.lfloat = sln_lex_tokens_float(tokens, index);
+            break;
+        default:
+            break;
+    }
+    return token;
+}
@@ -1,9 +1,17 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <lexer/lexer.h>
+#include <lexer/lexer_tokens.h>
+#include <driver/driver.h>
+#include <utils/alloc_stats.h>
 #include <utils/cli_colors.h>
+#include <utils/exit_codes.h>
+#include <utils/input_args.h>
+#include <utils/msg_errors.h>
+#include <utils/trace.h>
 
 // Функция для красивого вывода токенов
 const char* token_type_to_string(sln_lex_token_type_t type) {
@@ -19,36 +27,9 @@ const char* token_type_to_string(sln_lex_token_type_t type) {
         case SLN_LEX_TOKEN_STRING_LITERAL: return "STRING_LITERAL";
         
         // Keywords
-        case SLN_LEX_TOKEN_KW_NAMESPACE: return "KW_NAMESPACE";
-        case SLN_LEX_TOKEN_KW_TYPE: return "KW_TYPE";
-        case SLN_LEX_TOKEN_KW_STRUCT: return "KW_STRUCT";
-        case SLN_LEX_TOKEN_KW_ENUM: return "KW_ENUM";
-        case SLN_LEX_TOKEN_KW_USE: return "KW_USE";
-        case SLN_LEX_TOKEN_KW_VAR: return "KW_VAR";
-        case SLN_LEX_TOKEN_KW_RETURN: return "KW_RETURN";
-        case SLN_LEX_TOKEN_KW_FOR: return "KW_FOR";
-        case SLN_LEX_TOKEN_KW_WHILE: return "KW_WHILE";
-        case SLN_LEX_TOKEN_KW_IF: return "KW_IF";
-        case SLN_LEX_TOKEN_KW_ELSE: return "KW_ELSE";
-        case SLN_LEX_TOKEN_KW_SWITCH: return "KW_SWITCH";
-        case SLN_LEX_TOKEN_KW_CASE: return "KW_CASE";
-        case SLN_LEX_TOKEN_KW_DEFAULT: return "KW_DEFAULT";
-        case SLN_LEX_TOKEN_KW_BREAK: return "KW_BREAK";
-        case SLN_LEX_TOKEN_KW_CONTINUE: return "KW_CONTINUE";
-        case SLN_LEX_TOKEN_KW_NIL: return "KW_NIL";
-        case SLN_LEX_TOKEN_KW_I8: return "KW_I8";
-        case SLN_LEX_TOKEN_KW_I16: return "KW_I16";
-        case SLN_LEX_TOKEN_KW_I32: return "KW_I32";
-        case SLN_LEX_TOKEN_KW_I64: return "KW_I64";
-        case SLN_LEX_TOKEN_KW_U8: return "KW_U8";
-        case SLN_LEX_TOKEN_KW_U16: return "KW_U16";
-        case SLN_LEX_TOKEN_KW_U32: return "KW_U32";
-        case SLN_LEX_TOKEN_KW_U64: return "KW_U64";
-        case SLN_LEX_TOKEN_KW_BLN: return "KW_BLN";
-        case SLN_LEX_TOKEN_KW_USIZE: return "KW_USIZE";
-        case SLN_LEX_TOKEN_KW_STR: return "KW_STR";
-        case SLN_LEX_TOKEN_KW_MAIN: return "KW_MAIN";
-        case SLN_LEX_TOKEN_KW_ARGS: return "KW_ARGS";
+#define _KEYWORD_CASE(name, spelling) case SLN_LEX_TOKEN_KW_##name: return "KW_" #name;
+        SLN_LEX_KEYWORDS(_KEYWORD_CASE)
+#undef _KEYWORD_CASE
         
         // Operators
         case SLN_LEX_TOKEN_PLUS: return "PLUS";
@@ -106,148 +87,216 @@ const char* token_type_to_string(sln_lex_token_type_t type) {
     }
 }
 
-void print_token_color(sln_lex_token_t token, int index) {
-    sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_LIGHTGRAY);
-    printf("[%3d] ", index);
+void print_token_color(FILE* out, const char* text, const sln_utils_intern_t* symbols,
+                       sln_lex_token_t token, int index) {
+    size_t text_len = 0;
+    const char* token_text = sln_lex_token_text(text, &token, &text_len);
+    if (token.type == SLN_LEX_TOKEN_IDENTIFIER || token.type == SLN_LEX_TOKEN_STRING_LITERAL) {
+        token_text = sln_utils_intern_get(symbols, token.data.sym, &text_len);
+    }
+
+    sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_LIGHTGRAY);
+    fprintf(out, "[%3d] ", index);
     
     switch (token.type) {
 
         case SLN_LEX_TOKEN_EOL:
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_DARKGRAY);
-            printf("%-20s", token_type_to_string(token.type));
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
-            printf(" '\\n'\n");
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_DARKGRAY);
+            fprintf(out, "%-20s", token_type_to_string(token.type));
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_WHITE);
+            fprintf(out, " '\\n'\n");
             break;
 
         case SLN_LEX_TOKEN_IDENTIFIER:
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_CYAN);
-            printf("%-20s", token_type_to_string(token.type));
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
-            printf(" '%.*s'\n", 30, token.data.cstr ? token.data.cstr : "(null)");
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_CYAN);
+            fprintf(out, "%-20s", token_type_to_string(token.type));
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_WHITE);
+            fprintf(out, " '%.*s'\n", (int)(text_len < 30 ? text_len : 30), token_text);
             break;
             
         case SLN_LEX_TOKEN_STRING_LITERAL:
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_GREEN);
-            printf("%-20s", token_type_to_string(token.type));
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
-            printf(" \"%.*s\"\n", 30, token.data.cstr ? token.data.cstr : "(null)");
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_GREEN);
+            fprintf(out, "%-20s", token_type_to_string(token.type));
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_WHITE);
+            fprintf(out, " \"%.*s\"\n", (int)(text_len < 30 ? text_len : 30), token_text);
             break;
             
         case SLN_LEX_TOKEN_INT_LITERAL:
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_YELLOW);
-            printf("%-20s", token_type_to_string(token.type));
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
-            printf(" %lu\n", token.data.u64);
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_YELLOW);
+            fprintf(out, "%-20s", token_type_to_string(token.type));
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_WHITE);
+            fprintf(out, " %lu\n", token.data.u64);
             break;
             
         case SLN_LEX_TOKEN_FLOAT_LITERAL:
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_YELLOW);
-            printf("%-20s", token_type_to_string(token.type));
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
-            printf(" %Lf\n", token.data.lfloat);
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_YELLOW);
+            fprintf(out, "%-20s", token_type_to_string(token.type));
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_WHITE);
+            fprintf(out, " %Lf\n", token.data.lfloat);
             break;
             
         case SLN_LEX_TOKEN_CHAR_LITERAL:
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_YELLOW);
-            printf("%-20s", token_type_to_string(token.type));
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
-            printf(" '%c'\n", (char)token.data.i64);
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_YELLOW);
+            fprintf(out, "%-20s", token_type_to_string(token.type));
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_WHITE);
+            fprintf(out, " '%c'\n", (char)token.data.i64);
             break;
             
         case SLN_LEX_TOKEN_COMMENT:
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_DARKGRAY);
-            printf("%-20s", token_type_to_string(token.type));
-            sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
-            if (token.data.cstr) {
-                printf(" '%s'\n", token.data.cstr);
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_DARKGRAY);
+            fprintf(out, "%-20s", token_type_to_string(token.type));
+            sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_WHITE);
+            if (text_len > 0) {
+                fprintf(out, " '%.*s'\n", (int)text_len, token_text);
             } else {
-                printf(" (empty)\n");
+                fprintf(out, " (empty)\n");
             }
             break;
 
         default:
             if (token.type >= SLN_LEX_TOKEN_KW_NAMESPACE && token.type <= SLN_LEX_TOKEN_KW_ARGS) {
-                sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_MAGENTA);
+                sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_MAGENTA);
             } else if (token.type >= SLN_LEX_TOKEN_PLUS && token.type <= SLN_LEX_TOKEN_QUESTION) {
-                sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_LIGHTRED);
+                sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_LIGHTRED);
             } else if (token.type >= SLN_LEX_TOKEN_LPAREN && token.type <= SLN_LEX_TOKEN_SEMICOLON) {
-                sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_LIGHTBLUE);
+                sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_LIGHTBLUE);
             } else {
-                sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
+                sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_WHITE);
             }
-            printf("%-20s\n", token_type_to_string(token.type));
+            fprintf(out, "%-20s\n", token_type_to_string(token.type));
             break;
     }
     
-    sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
+    sln_utils_cli_color_set(out, SLN_UTILS_CLI_COLOR_WHITE);
+}
+
+// Tokens of standard input are printed as they are lexed; the count comes last
+static void print_streamed_token(const sln_driver_unit_t* unit, const char* window,
+                                 const sln_lex_token_t* token, FILE* out, void* user) {
+    (void)user;
+    if (unit->streamed == 0) fprintf(out, "=== %s ===\n\n", unit->name);
+    print_token_color(out, window, unit->symbols, *token, (int)unit->streamed);
+}
+
+static void print_unit(const sln_driver_unit_t* unit, FILE* out, void* user) {
+    (void)user;
+    const sln_lex_tokens_t* tokens = unit->tokens;
+    if (unit->streamed > 0) {
+        fprintf(out, "\nTotal tokens: %zu\n\n", unit->streamed);
+        return;
+    }
+    fprintf(out, "=== %s ===\n", unit->name);
+    if (unit->ast) {
+        fprintf(out, "Total nodes: %zu\n\n", unit->ast->len);
+        sln_ast_dump(unit->ast, unit->text, out);
+        fputc('\n', out);
+        return;
+    }
+    size_t total = tokens->len + tokens->trivia.len;
+    fprintf(out, "Total tokens: %zu\n\n", total);
+    
+    // Line breaks and comments go back in front of the token they precede
+    size_t printed = 0;
+    for (size_t i = 0; i < tokens->len; i++) {
+        size_t count = 0;
+        const sln_lex_trivia_item_t* trivia = sln_lex_trivia_before(&tokens->trivia, i, &count);
+        for (size_t t = 0; t < count; t++) {
+            sln_lex_token_t token = { .type = trivia[t].type, .span = trivia[t].span };
+            print_token_color(out, unit->text, unit->symbols, token, (int)printed++);
+        }
+        print_token_color(out, unit->text, unit->symbols, sln_lex_tokens_get(tokens, i), (int)printed++);
+    }
+    
+    if (total > 0) {
+        fprintf(out, "\nTokens: %zu bytes (%.2f bytes/token, %zu as sln_lex_token_t)\n\n",
+                sln_lex_tokens_memory(tokens),
+                (double)sln_lex_tokens_memory(tokens) / (double)total,
+                sizeof(sln_lex_token_t));
+    }
 }
 
 int main(int argc, char* argv[]) {
     // Включим цвета в консоли
     sln_utils_cli_color_enable(stdout);
-
-    (void)argc;
-    (void)argv;
-
-    const char* test_code = 
-        "# Selena language example\n\n"
-        "use cli:io;\n\n"
-        "namespace main {\n"
-        "    type args = struct {\n"
-        "        num:usize,\n"
-        "        content:str[num]\n"
-        "    };\n\n"
-        "    type exit_status = enum {\n"
-        "        EXIT_SUCCESS,\n"
-        "        EXIT_FAILURE,\n"
-        "        @exit_status_ext\n"
-        "    };\n"
-        "}\n\n"
-        "## Это многострочный комментарий\n"
-        "   который может занимать несколько строк ##\n\n"
-        "main::exit_status@exit_status_ext = {\n"
-        "    EXIT_ERR1, EXIT_ERR2\n"
-        "};\n\n"
-        "MAIN(ARGS:(main::args)):i32 {\n\n"
-        "    var1:i64 = 10;\n\n"
-        "    cli:io.println(\"Selena app 1. You run it with:\");\n\n"
-        "    for (i = 0; i < ARGS.num; i++) {\n"
-        "        cli:io.println(\"arg[{i}]: \", ARGS.content[i]);\n"
-        "    }\n"
-        "    \n"
-        "    cli:flush();\n\n"
-        "    if (var1->usize == ARGS.num) {\n"
-        "        return main::exit_status::EXIT_ERR1;\n"
-        "    }\n\n"
-        "    return main::exit_status::EXIT_SUCCESS;\n"
-        "}";
-        
-    printf("=== Selena Lexer Test ===\n");
-    printf("Input code:\n");
-    sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_LIGHTGRAY);
-    printf("%s\n", test_code);
-    sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
-    printf("\n=== Token Stream ===\n");
     
-    sln_lex_token_buffer_t buffer = {0};
-    sln_lex_error_t error = sln_lex_generate(test_code, &buffer, stderr);
+    SLN_TRACE_MARK(args_start);
+    sln_input_arg_t* args = NULL;
+    size_t arg_count = 0;
+    if (!input_args_parse(argc, argv, &args, &arg_count)) {
+        return SLN_EXIT_FAILURE;
+    }
+    
+    bool time_report = false;
+    const char* trace_path = NULL;
+    for (size_t i = 0; i < arg_count; i++) {
+        if (args[i].type == SLN_IN_ARG_TYPE_TIME) time_report = true;
+        if (args[i].type == SLN_IN_ARG_TYPE_TRACE) trace_path = args[i].cstr;
+    }
+    if ((time_report || trace_path) && !sln_utils_trace_enable()) {
+        fprintf(stderr, "warning: built without tracing, --time-report and --trace are ignored\n");
+        time_report = false;
+        trace_path = NULL;
+    }
+    SLN_TRACE_SPAN("args", NULL, args_start);
     
-    if (error != SLN_LEX_OK) {
-        fprintf(stderr, "Lexer error: %d\n", error);
-        return 1;
+    size_t input_count = 0;
+    for (size_t i = 0; i < arg_count; i++) {
+        if (args[i].type == SLN_IN_ARG_TYPE_FILE || args[i].type == SLN_IN_ARG_TYPE_CODE) input_count++;
+    }
+    if (input_count == 0) {
+        sln_utils_msg_print(SLN_MSG_NO_ARGS, SLN_UTILS_MSG_TYPE_ERRR, stderr);
+        input_args_free(args, arg_count);
+        return SLN_EXIT_FAILURE;
     }
     
-    printf("Total tokens: %zu\n\n", buffer.len);
+    sln_utils_intern_t* symbols = sln_utils_intern_create();
+    if (!symbols) {
+        fprintf(stderr, "Lexer error: %d\n", SLN_LEX_ALLOCATION_FAILED);
+        input_args_free(args, arg_count);
+        return SLN_EXIT_FAILURE_INTERNAL;
+    }
     
-    for (size_t i = 0; i < buffer.len; i++) {
-        print_token_color(buffer.tokens[i], (int)i);
+    sln_driver_options_t options = { .jobs = 0, .emit = print_unit, .token = print_streamed_token, .user = NULL };
+    bool alloc_stats = false;
+    sln_utils_alloc_stats_format_t alloc_stats_format = SLN_UTILS_ALLOC_STATS_TABLE;
+    for (size_t i = 0; i < arg_count; i++) {
+        if (args[i].type == SLN_IN_ARG_TYPE_JOBS) options.jobs = args[i].subtype.jobs;
+        if (args[i].type == SLN_IN_ARG_TYPE_CACHE) options.cache_dir = args[i].cstr;
+        if (args[i].type == SLN_IN_ARG_TYPE_PARSE) options.parse = true;
+        if (args[i].type == SLN_IN_ARG_TYPE_PIPELINE) options.parse = options.pipeline = true;
+        if (args[i].type == SLN_IN_ARG_TYPE_STATS) {
+            alloc_stats = true;
+            alloc_stats_format = args[i].subtype.stats == SLN_IN_ARG_STATS_ALLOC_JSON
+                ? SLN_UTILS_ALLOC_STATS_JSON : SLN_UTILS_ALLOC_STATS_TABLE;
+        }
     }
+    if (alloc_stats && !sln_utils_alloc_stats_enable()) alloc_stats = false;
+    sln_exit_code_t exit_code = sln_driver_run(args, arg_count, symbols, &options);
     
-    // Освобождаем память
-    sln_lex_free_tokens(&buffer);
+    printf("Symbols: %zu (%zu bytes)\n",
+           sln_utils_intern_count(symbols), sln_utils_intern_memory(symbols));
     
+    sln_utils_intern_destroy(symbols);
+    
+    // Spans point into the arguments, so export them first
+    if (time_report || trace_path) {
+        fflush(stdout);
+        if (time_report) sln_utils_trace_report(stderr);
+        if (trace_path && !sln_utils_trace_write(trace_path)) {
+            sln_utils_msg_print_detail(SLN_MSG_CANNOT_WRITE_FILE, SLN_UTILS_MSG_TYPE_ERRR,
+                                       trace_path, strerror(errno), stderr);
+            exit_code = SLN_EXIT_FAILURE;
+        }
+        sln_utils_trace_disable();
+    }
+    input_args_free(args, arg_count);
     sln_utils_cli_color_set(stdout, SLN_UTILS_CLI_COLOR_WHITE);
-    printf("\n=== Test completed successfully ===\n");
     
-    return 0;
-}
\ No newline at end of file
+    if (alloc_stats) {
+        fflush(stdout);
+        sln_utils_alloc_stats_print(stderr, alloc_stats_format);
+        sln_utils_alloc_stats_disable();
+    }
+    
+    return exit_code;
+}
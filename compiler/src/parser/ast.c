@@ -0,0 +1,190 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include <parser/ast.h>
+#include <utils/allocation.h>
+
+static const char* const _kind_names[_SLN_AST_KIND_COUNT] = {
+#define _SLN_AST_KIND_NAME(name) #name,
+    SLN_AST_KINDS(_SLN_AST_KIND_NAME)
+#undef _SLN_AST_KIND_NAME
+};
+
+const char* sln_ast_kind_name(sln_ast_kind_t kind) {
+    return kind < _SLN_AST_KIND_COUNT ? _kind_names[kind] : "?";
+}
+
+static void _print_token(const sln_ast_t* ast, const char* text, uint32_t token, FILE* stream) {
+    if (token >= ast->token_count) return;
+    sln_lex_span_t span = ast->tokens[token].span;
+    fprintf(stream, "%.*s", (int)span.length, text + span.offset);
+}
+
+// Kinds whose main token is a bracket or keyword, not worth printing
+static bool _prints_token(sln_ast_kind_t kind) {
+    switch (kind) {
+        case SLN_AST_ROOT:
+        case SLN_AST_USE:
+        case SLN_AST_STRUCT:
+        case SLN_AST_ENUM:
+        case SLN_AST_BLOCK:
+        case SLN_AST_RETURN:
+        case SLN_AST_IF:
+        case SLN_AST_WHILE:
+        case SLN_AST_FOR:
+        case SLN_AST_SWITCH:
+        case SLN_AST_CASE:
+        case SLN_AST_BREAK:
+        case SLN_AST_CONTINUE:
+        case SLN_AST_EXPR_STMT:
+        case SLN_AST_PATH:
+        case SLN_AST_TERNARY:
+        case SLN_AST_CALL:
+        case SLN_AST_INDEX:
+        case SLN_AST_CAST:
+        case SLN_AST_TUPLE:
+        case SLN_AST_INIT_LIST:
+        case SLN_AST_TYPE_TUPLE:
+        case SLN_AST_TYPE_ARRAY:
+        case SLN_AST_FUNC:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Left-associative chains make trees as deep as they are long, so the
+// dump walks them with an explicit stack rather than recursion
+typedef struct {
+    sln_ast_id_t id;
+    unsigned depth;
+} _sln_ast_frame_t;
+
+typedef struct {
+    _sln_ast_frame_t* frames;
+    size_t len;
+    size_t cap;
+    bool failed;
+} _sln_ast_stack_t;
+
+static void _push(_sln_ast_stack_t* stack, sln_ast_id_t id, unsigned depth) {
+    if (id == SLN_AST_NONE || stack->failed) return;
+    if (stack->len == stack->cap) {
+        size_t cap = stack->cap ? stack->cap * 2 : 64;
+        _sln_ast_frame_t* frames = SLN_ALLOC(cap, _sln_ast_frame_t);
+        if (!frames) {
+            stack->failed = true;
+            return;
+        }
+        if (stack->len) memcpy(frames, stack->frames, stack->len * sizeof(*frames));
+        sln_utils_free(stack->frames);
+        stack->frames = frames;
+        stack->cap = cap;
+    }
+    stack->frames[stack->len++] = (_sln_ast_frame_t){ id, depth };
+}
+
+// Children are pushed last first, so they pop in source order
+static void _push_range(_sln_ast_stack_t* stack, const sln_ast_t* ast, uint32_t start, uint32_t end, unsigned depth) {
+    size_t count;
+    const uint32_t* ids = sln_ast_range(ast, start, end, &count);
+    while (count > 0) _push(stack, ids[--count], depth);
+}
+
+static void _print_node(const sln_ast_t* ast, const char* text, const sln_ast_node_t* node, unsigned depth, FILE* stream) {
+    sln_ast_kind_t kind = (sln_ast_kind_t)node->kind;
+    fprintf(stream, "%*s%s", (int)(depth * 2), "", sln_ast_kind_name(kind));
+    if (_prints_token(kind)) {
+        fputc(' ', stream);
+        _print_token(ast, text, node->token, stream);
+    }
+    if (kind == SLN_AST_PATH) {
+        for (uint32_t i = node->lhs; i < node->rhs; i++) {
+            fputs(i == node->lhs ? " " : "::", stream);
+            _print_token(ast, text, ast->extra[i], stream);
+        }
+    }
+    if (kind == SLN_AST_USE && (node->flags & SLN_AST_FLAG_GLOB)) fputs(" *", stream);
+    if (kind == SLN_AST_USE && node->rhs) {
+        fputs(" as ", stream);
+        _print_token(ast, text, node->rhs, stream);
+    }
+    fputc('\n', stream);
+}
+
+static void _push_children(_sln_ast_stack_t* stack, const sln_ast_t* ast, const sln_ast_node_t* node, unsigned depth) {
+    const uint32_t* extra = ast->extra;
+    switch ((sln_ast_kind_t)node->kind) {
+        case SLN_AST_ROOT:
+        case SLN_AST_NAMESPACE:
+        case SLN_AST_STRUCT:
+        case SLN_AST_ENUM:
+        case SLN_AST_BLOCK:
+        case SLN_AST_TUPLE:
+        case SLN_AST_INIT_LIST:
+        case SLN_AST_TYPE_TUPLE:
+            _push_range(stack, ast, node->lhs, node->rhs, depth);
+            break;
+        case SLN_AST_USE:
+        case SLN_AST_TYPE_DEF:
+        case SLN_AST_FIELD:
+        case SLN_AST_ENUMERATOR:
+        case SLN_AST_PARAM:
+        case SLN_AST_RETURN:
+        case SLN_AST_EXPR_STMT:
+        case SLN_AST_UNARY:
+        case SLN_AST_POSTFIX:
+        case SLN_AST_MEMBER:
+            _push(stack, node->lhs, depth);
+            break;
+        case SLN_AST_EXTEND:
+        case SLN_AST_VAR:
+        case SLN_AST_WHILE:
+        case SLN_AST_CASE:
+        case SLN_AST_BINARY:
+        case SLN_AST_INDEX:
+        case SLN_AST_CAST:
+        case SLN_AST_TYPE_ARRAY:
+            _push(stack, node->rhs, depth);
+            _push(stack, node->lhs, depth);
+            break;
+        case SLN_AST_FUNC:
+            _push(stack, extra[node->rhs + 3], depth);
+            _push(stack, extra[node->rhs + 2], depth);
+            _push_range(stack, ast, extra[node->rhs], extra[node->rhs + 1], depth);
+            _push(stack, node->lhs, depth);
+            break;
+        case SLN_AST_IF:
+        case SLN_AST_TERNARY:
+            _push(stack, extra[node->rhs + 1], depth);
+            _push(stack, extra[node->rhs], depth);
+            _push(stack, node->lhs, depth);
+            break;
+        case SLN_AST_FOR:
+            _push(stack, node->rhs, depth);
+            for (uint32_t i = 3; i > 0; i--) _push(stack, extra[node->lhs + i - 1], depth);
+            break;
+        case SLN_AST_SWITCH:
+        case SLN_AST_CALL:
+            _push_range(stack, ast, extra[node->rhs], extra[node->rhs + 1], depth);
+            _push(stack, node->lhs, depth);
+            break;
+        default:
+            break;
+    }
+}
+
+void sln_ast_dump(const sln_ast_t* ast, const char* text, FILE* stream) {
+    if (ast->len == 0) return;
+    _sln_ast_stack_t stack = {0};
+    sln_ast_id_t root = 0;
+    _print_node(ast, text, sln_ast_node(ast, root), 0, stream);
+    _push_children(&stack, ast, sln_ast_node(ast, root), 1);
+    while (stack.len > 0) {
+        _sln_ast_frame_t frame = stack.frames[--stack.len];
+        const sln_ast_node_t* node = sln_ast_node(ast, frame.id);
+        _print_node(ast, text, node, frame.depth, stream);
+        _push_children(&stack, ast, node, frame.depth + 1);
+    }
+    sln_utils_free(stack.frames);
+}
@@ -0,0 +1,1461 @@
+#include <string.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+#include <parser/parser.h>
+#include <lexer/lexer_lines.h>
+#include <lexer/lexer_operators.h>
+#include <lexer/lexer_pipe.h>
+#include <utils/allocation.h>
+#include <utils/msg_errors.h>
+#include <utils/trace.h>
+
+#define SLN_PARSER_INITIAL_SIZE 64UL
+#define SLN_PARSER_GROW_FACTOR 2
+
+// Binding powers of binary operators, lowest first; 0 ends an expression.
+// They are listed per token rather than derived from the operator groups
+// of sln_lex_token_type_t: those group tokens by kind, not by precedence.
+// C-like precedence splits the Bitwise group three ways (`<<`/`>>` bind
+// tighter than comparisons, `&` looser than them, then `^` and `|`) and
+// Arithmetic in two, so no group maps to one power.
+enum {
+    _SLN_PARSE_POWER_NONE,
+    _SLN_PARSE_POWER_ASSIGN,        // right-associative
+    _SLN_PARSE_POWER_TERNARY,       // right-associative
+    _SLN_PARSE_POWER_OR,
+    _SLN_PARSE_POWER_AND,
+    _SLN_PARSE_POWER_BIT_OR,
+    _SLN_PARSE_POWER_BIT_XOR,
+    _SLN_PARSE_POWER_BIT_AND,
+    _SLN_PARSE_POWER_EQUALITY,
+    _SLN_PARSE_POWER_RELATIONAL,
+    _SLN_PARSE_POWER_SHIFT,
+    _SLN_PARSE_POWER_ADDITIVE,
+    _SLN_PARSE_POWER_MULTIPLICATIVE,
+};
+
+static const uint8_t _binary_power[_SLN_LEX_TOKEN_COUNT] = {
+    [SLN_LEX_TOKEN_ASSIGN]         = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_PLUS_ASSIGN]    = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_MINUS_ASSIGN]   = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_STAR_ASSIGN]    = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_SLASH_ASSIGN]   = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_PERCENT_ASSIGN] = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_AMP_ASSIGN]     = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_PIPE_ASSIGN]    = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_CARET_ASSIGN]   = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_LSHIFT_ASSIGN]  = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_RSHIFT_ASSIGN]  = _SLN_PARSE_POWER_ASSIGN,
+    [SLN_LEX_TOKEN_QUESTION]       = _SLN_PARSE_POWER_TERNARY,
+    [SLN_LEX_TOKEN_OR_OR]          = _SLN_PARSE_POWER_OR,
+    [SLN_LEX_TOKEN_AND_AND]        = _SLN_PARSE_POWER_AND,
+    [SLN_LEX_TOKEN_PIPE]           = _SLN_PARSE_POWER_BIT_OR,
+    [SLN_LEX_TOKEN_CARET]          = _SLN_PARSE_POWER_BIT_XOR,
+    [SLN_LEX_TOKEN_AMP]            = _SLN_PARSE_POWER_BIT_AND,
+    [SLN_LEX_TOKEN_EQ]             = _SLN_PARSE_POWER_EQUALITY,
+    [SLN_LEX_TOKEN_NE]             = _SLN_PARSE_POWER_EQUALITY,
+    [SLN_LEX_TOKEN_LT]             = _SLN_PARSE_POWER_RELATIONAL,
+    [SLN_LEX_TOKEN_GT]             = _SLN_PARSE_POWER_RELATIONAL,
+    [SLN_LEX_TOKEN_LE]             = _SLN_PARSE_POWER_RELATIONAL,
+    [SLN_LEX_TOKEN_GE]             = _SLN_PARSE_POWER_RELATIONAL,
+    [SLN_LEX_TOKEN_LSHIFT]         = _SLN_PARSE_POWER_SHIFT,
+    [SLN_LEX_TOKEN_RSHIFT]         = _SLN_PARSE_POWER_SHIFT,
+    [SLN_LEX_TOKEN_PLUS]           = _SLN_PARSE_POWER_ADDITIVE,
+    [SLN_LEX_TOKEN_MINUS]          = _SLN_PARSE_POWER_ADDITIVE,
+    [SLN_LEX_TOKEN_STAR]           = _SLN_PARSE_POWER_MULTIPLICATIVE,
+    [SLN_LEX_TOKEN_SLASH]          = _SLN_PARSE_POWER_MULTIPLICATIVE,
+    [SLN_LEX_TOKEN_PERCENT]        = _SLN_PARSE_POWER_MULTIPLICATIVE,
+};
+
+// Spellings of the tokens "expected ..." diagnostics name
+static const char* const _spellings[_SLN_LEX_TOKEN_COUNT] = {
+#define _SLN_PARSE_KEYWORD(name, spelling) [SLN_LEX_TOKEN_KW_##name] = spelling,
+    SLN_LEX_KEYWORDS(_SLN_PARSE_KEYWORD)
+#undef _SLN_PARSE_KEYWORD
+#define _SLN_PARSE_OPERATOR(name, spelling) [SLN_LEX_TOKEN_##name] = spelling,
+    SLN_LEX_OPERATORS(_SLN_PARSE_OPERATOR)
+#undef _SLN_PARSE_OPERATOR
+};
+
+// Growing array of node ids or `extra` words
+typedef struct {
+    uint32_t* items;
+    size_t len;
+    size_t cap;
+} _sln_parse_words_t;
+
+typedef struct {
+    const char* text;
+    const sln_lex_token_t* tokens;
+    size_t count;
+    sln_lex_pipe_t* pipe;       /**< Source of more tokens; NULL for a whole buffer or once drained */
+    sln_lex_token_buffer_t* buffer; /**< Tokens pulled from `pipe` */
+    size_t buffer_cap;
+    size_t pos;                 /**< Current token, never a line break or comment */
+    size_t prev;                /**< Last consumed token */
+    FILE* error_stream;
+    sln_lex_lines_t lines;
+    sln_ast_node_t* nodes;
+    size_t len;
+    size_t cap;
+    _sln_parse_words_t extra;
+    _sln_parse_words_t scratch; /**< Children of the lists being parsed, as a stack */
+    sln_parse_error_t status;
+    size_t errors_left;
+    uint32_t depth;
+    bool panic;                 /**< An error was reported; quiet until resynchronized */
+    bool no_colon;              /**< ':' ends the expression, in the middle of `c ? x : y` */
+    bool stopped;               /**< Fatal error; every token reads as EOF from here on */
+    bool bail;                  /**< Stop quietly at the first error; the caller parses again to report it */
+} _sln_parse_ctx_t;
+
+typedef uint32_t (*_sln_parse_fn_t)(_sln_parse_ctx_t* ctx);
+
+static uint32_t _parse_expr(_sln_parse_ctx_t* ctx);
+static uint32_t _parse_type(_sln_parse_ctx_t* ctx);
+static uint32_t _parse_statement(_sln_parse_ctx_t* ctx);
+static uint32_t _parse_item(_sln_parse_ctx_t* ctx);
+static void _fail(_sln_parse_ctx_t* ctx);
+
+// --- Tokens ---
+
+// Appends batches from the pipe until the buffer reaches @p index or
+// the pipe runs dry
+static bool _pull(_sln_parse_ctx_t* ctx, size_t index) {
+    sln_lex_token_buffer_t* buffer = ctx->buffer;
+    while (ctx->pipe && index >= buffer->len) {
+        const sln_lex_batch_t* batch = sln_lex_pipe_next(ctx->pipe);
+        if (!batch) {
+            ctx->pipe = NULL;
+            break;
+        }
+        if (buffer->len + batch->len > ctx->buffer_cap) {
+            size_t cap = ctx->buffer_cap * SLN_PARSER_GROW_FACTOR;
+            if (cap < buffer->len + batch->len) cap = buffer->len + batch->len;
+            sln_lex_token_t* tokens = SLN_ALLOC(cap, sln_lex_token_t);
+            if (!tokens) {
+                ctx->pipe = NULL;
+                _fail(ctx);
+                break;
+            }
+            if (buffer->len) memcpy(tokens, buffer->tokens, buffer->len * sizeof(sln_lex_token_t));
+            sln_utils_free(buffer->tokens);
+            buffer->tokens = tokens;
+            ctx->buffer_cap = cap;
+        }
+        memcpy(buffer->tokens + buffer->len, batch->tokens, batch->len * sizeof(sln_lex_token_t));
+        buffer->len += batch->len;
+        if (buffer->len > UINT32_MAX / 4) {
+            ctx->pipe = NULL;
+            ctx->status = SLN_PARSE_SOURCE_TOO_LARGE;
+            ctx->stopped = true;
+        }
+        ctx->tokens = buffer->tokens;
+        ctx->count = buffer->len;
+    }
+    return index < ctx->count;
+}
+
+static inline sln_lex_token_type_t _type_at(_sln_parse_ctx_t* ctx, size_t index) {
+    if (index >= ctx->count && !_pull(ctx, index)) return SLN_LEX_TOKEN_EOF;
+    return ctx->tokens[index].type;
+}
+
+static inline sln_lex_token_type_t _peek(_sln_parse_ctx_t* ctx) {
+    return ctx->stopped ? SLN_LEX_TOKEN_EOF : _type_at(ctx, ctx->pos);
+}
+
+static inline sln_lex_token_type_t _peek_next(_sln_parse_ctx_t* ctx) {
+    return ctx->stopped ? SLN_LEX_TOKEN_EOF : _type_at(ctx, ctx->pos + 1);
+}
+
+// Consumes the current token and returns its index; EOF is never consumed
+static inline uint32_t _advance(_sln_parse_ctx_t* ctx) {
+    uint32_t token = (uint32_t)ctx->pos;
+    if (_peek(ctx) != SLN_LEX_TOKEN_EOF) {
+        ctx->prev = ctx->pos;
+        ctx->pos++;
+    }
+    return token;
+}
+
+static inline bool _accept(_sln_parse_ctx_t* ctx, sln_lex_token_type_t type) {
+    if (_peek(ctx) != type) return false;
+    _advance(ctx);
+    return true;
+}
+
+static inline bool _is_name(sln_lex_token_type_t type) {
+    return type == SLN_LEX_TOKEN_IDENTIFIER || type == SLN_LEX_TOKEN_KW_MAIN || type == SLN_LEX_TOKEN_KW_ARGS;
+}
+
+static inline bool _is_builtin_type(sln_lex_token_type_t type) {
+    return type >= SLN_LEX_TOKEN_KW_NIL && type <= SLN_LEX_TOKEN_KW_STR;
+}
+
+static inline bool _is_prefix(sln_lex_token_type_t type) {
+    switch (type) {
+        case SLN_LEX_TOKEN_PLUS:
+        case SLN_LEX_TOKEN_MINUS:
+        case SLN_LEX_TOKEN_BANG:
+        case SLN_LEX_TOKEN_TILDE:
+        case SLN_LEX_TOKEN_INCREMENT:
+        case SLN_LEX_TOKEN_DECREMENT:
+        case SLN_LEX_TOKEN_AMP:
+        case SLN_LEX_TOKEN_STAR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Whether the current token is the identifier @p word, for contextual keywords
+static bool _is_word(_sln_parse_ctx_t* ctx, const char* word) {
+    if (_peek(ctx) != SLN_LEX_TOKEN_IDENTIFIER) return false;
+    sln_lex_span_t span = ctx->tokens[ctx->pos].span;
+    return span.length == strlen(word) && memcmp(ctx->text + span.offset, word, span.length) == 0;
+}
+
+// --- Diagnostics ---
+
+static void _stop(_sln_parse_ctx_t* ctx) {
+    ctx->stopped = true;
+}
+
+static void _report(_sln_parse_ctx_t* ctx, sln_parse_error_t error, sln_res_msg_t msg, const char* subject) {
+    if (ctx->panic || ctx->stopped) return;
+    ctx->panic = true;
+    if (ctx->status == SLN_PARSE_OK) ctx->status = error;
+    if (ctx->bail) {
+        _stop(ctx);
+        return;
+    }
+
+    size_t token = ctx->stopped || ctx->pos >= ctx->count ? ctx->count - 1 : ctx->pos;
+    if (ctx->tokens[token].type == SLN_LEX_TOKEN_UNKNOWN) return;
+    ctx->errors_left--;
+
+    size_t offset = ctx->tokens[token].span.offset;
+    sln_lex_location_t location;
+    if (!sln_lex_lines_locate(&ctx->lines, offset, &location)) {
+        sln_utils_msg_print_at(msg, SLN_UTILS_MSG_TYPE_ERRR, offset, ctx->error_stream);
+    } else if (subject) {
+        sln_utils_msg_print_detail_at_line(msg, SLN_UTILS_MSG_TYPE_ERRR, subject,
+                                           location.line, location.column, ctx->error_stream);
+    } else {
+        sln_utils_msg_print_at_line(msg, SLN_UTILS_MSG_TYPE_ERRR, location.line, location.column, ctx->error_stream);
+    }
+    if (ctx->errors_left == 0) {
+        sln_utils_msg_print(SLN_MSG_PARSE_TOO_MANY_ERRORS, SLN_UTILS_MSG_TYPE_ERRR, ctx->error_stream);
+        _stop(ctx);
+    }
+}
+
+static bool _expect(_sln_parse_ctx_t* ctx, sln_lex_token_type_t type) {
+    if (_accept(ctx, type)) return true;
+    _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED, _spellings[type]);
+    return false;
+}
+
+static void _fail(_sln_parse_ctx_t* ctx) {
+    ctx->status = SLN_PARSE_ALLOCATION_FAILED;
+    _stop(ctx);
+}
+
+// --- Nodes and lists ---
+
+static bool _reserve(_sln_parse_ctx_t* ctx, _sln_parse_words_t* words, size_t n) {
+    if (words->len + n <= words->cap) return true;
+    size_t cap = words->cap ? words->cap : SLN_PARSER_INITIAL_SIZE;
+    while (cap < words->len + n) cap *= SLN_PARSER_GROW_FACTOR;
+    uint32_t* items = SLN_ALLOC(cap, uint32_t);
+    if (!items) {
+        _fail(ctx);
+        return false;
+    }
+    if (words->len) memcpy(items, words->items, words->len * sizeof(uint32_t));
+    sln_utils_free(words->items);
+    words->items = items;
+    words->cap = cap;
+    return true;
+}
+
+static inline void _push(_sln_parse_ctx_t* ctx, uint32_t id) {
+    if (ctx->scratch.len == ctx->scratch.cap && !_reserve(ctx, &ctx->scratch, 1)) return;
+    ctx->scratch.items[ctx->scratch.len++] = id;
+}
+
+// Moves scratch[top..] to `extra`; returns where they start there, they end at extra.len
+static uint32_t _commit(_sln_parse_ctx_t* ctx, size_t top) {
+    size_t n = ctx->scratch.len - top;
+    uint32_t start = (uint32_t)ctx->extra.len;
+    if (n == 0 || !_reserve(ctx, &ctx->extra, n)) return start;
+    memcpy(ctx->extra.items + ctx->extra.len, ctx->scratch.items + top, n * sizeof(uint32_t));
+    ctx->extra.len += n;
+    ctx->scratch.len = top;
+    return start;
+}
+
+// Stores an operand group in `extra`; returns its index
+static uint32_t _group(_sln_parse_ctx_t* ctx, const uint32_t* words, size_t n) {
+    uint32_t start = (uint32_t)ctx->extra.len;
+    if (!_reserve(ctx, &ctx->extra, n)) return start;
+    memcpy(ctx->extra.items + ctx->extra.len, words, n * sizeof(uint32_t));
+    ctx->extra.len += n;
+    return start;
+}
+
+static uint32_t _add(_sln_parse_ctx_t* ctx, sln_ast_kind_t kind, uint32_t token, uint32_t lhs, uint32_t rhs) {
+    if (ctx->len == ctx->cap) {
+        size_t cap = ctx->cap * SLN_PARSER_GROW_FACTOR;
+        sln_ast_node_t* nodes = SLN_ALLOC(cap, sln_ast_node_t);
+        if (!nodes) {
+            _fail(ctx);
+            return SLN_AST_NONE;
+        }
+        memcpy(nodes, ctx->nodes, ctx->len * sizeof(sln_ast_node_t));
+        sln_utils_free(ctx->nodes);
+        ctx->nodes = nodes;
+        ctx->cap = cap;
+    }
+    ctx->nodes[ctx->len] = (sln_ast_node_t){ (uint8_t)kind, 0, 0, token, lhs, rhs };
+    return (uint32_t)ctx->len++;
+}
+
+static inline uint32_t _add_range(_sln_parse_ctx_t* ctx, sln_ast_kind_t kind, uint32_t token, uint32_t start) {
+    return _add(ctx, kind, token, start, (uint32_t)ctx->extra.len);
+}
+
+static inline uint32_t _error_node(_sln_parse_ctx_t* ctx) {
+    return _add(ctx, SLN_AST_ERROR, (uint32_t)ctx->pos, 0, 0);
+}
+
+// --- Recovery ---
+
+static bool _enter(_sln_parse_ctx_t* ctx) {
+    if (++ctx->depth <= SLN_PARSE_MAX_DEPTH) return true;
+    ctx->depth--;
+    ctx->panic = false;
+    _report(ctx, SLN_PARSE_TOO_DEEP, SLN_MSG_PARSE_TOO_DEEP, NULL);
+    _stop(ctx);
+    return false;
+}
+
+static inline bool _is_statement_start(sln_lex_token_type_t type) {
+    switch (type) {
+        case SLN_LEX_TOKEN_KW_VAR:
+        case SLN_LEX_TOKEN_KW_RETURN:
+        case SLN_LEX_TOKEN_KW_FOR:
+        case SLN_LEX_TOKEN_KW_WHILE:
+        case SLN_LEX_TOKEN_KW_IF:
+        case SLN_LEX_TOKEN_KW_SWITCH:
+        case SLN_LEX_TOKEN_KW_BREAK:
+        case SLN_LEX_TOKEN_KW_CONTINUE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline bool _is_item_start(sln_lex_token_type_t type) {
+    return type == SLN_LEX_TOKEN_KW_USE || type == SLN_LEX_TOKEN_KW_NAMESPACE || type == SLN_LEX_TOKEN_KW_TYPE;
+}
+
+/*
+ * Skips the rest of a broken statement or item that began at @p start:
+ * up to and including a ';' or the '}' of a block opened on the way, or
+ * up to a '}' that closes the enclosing block or a token that starts the
+ * next statement (@p items false) or item (@p items true). Brackets are
+ * balanced. Nothing is skipped if the last token taken was a ';' or '}'.
+ */
+static void _sync(_sln_parse_ctx_t* ctx, size_t start, bool items) {
+    ctx->panic = false;
+    sln_lex_token_type_t last = _type_at(ctx, ctx->prev);
+    if (ctx->pos != start && (last == SLN_LEX_TOKEN_SEMICOLON || last == SLN_LEX_TOKEN_RBRACE)) return;
+
+    size_t depth = 0;
+    for (;;) {
+        sln_lex_token_type_t type = _peek(ctx);
+        if (type == SLN_LEX_TOKEN_EOF) break;
+        if (depth == 0) {
+            if (type == SLN_LEX_TOKEN_SEMICOLON) {
+                _advance(ctx);
+                break;
+            }
+            if (type == SLN_LEX_TOKEN_RBRACE) break;
+            if (ctx->pos != start && (items ? _is_item_start(type) : _is_statement_start(type))) break;
+        }
+        if (type == SLN_LEX_TOKEN_LPAREN || type == SLN_LEX_TOKEN_LBRACKET || type == SLN_LEX_TOKEN_LBRACE) {
+            depth++;
+        } else if (depth > 0 && (type == SLN_LEX_TOKEN_RPAREN || type == SLN_LEX_TOKEN_RBRACKET || type == SLN_LEX_TOKEN_RBRACE)) {
+            depth--;
+            if (depth == 0 && type == SLN_LEX_TOKEN_RBRACE) {
+                _advance(ctx);
+                break;
+            }
+        }
+        _advance(ctx);
+    }
+    // Always make progress
+    if (ctx->pos == start) _advance(ctx);
+}
+
+/*
+ * Skips to the @p close of a list after a missing separator. Stops
+ * early, without consuming it, at a ';' or, for lists not in braces,
+ * a '}' at the list's level; the caller's recovery takes over there.
+ */
+static bool _skip_to_close(_sln_parse_ctx_t* ctx, sln_lex_token_type_t close) {
+    size_t depth = 0;
+    for (;;) {
+        sln_lex_token_type_t type = _peek(ctx);
+        if (type == SLN_LEX_TOKEN_EOF) return false;
+        if (depth == 0) {
+            if (type == close) {
+                _advance(ctx);
+                return true;
+            }
+            if (type == SLN_LEX_TOKEN_SEMICOLON || type == SLN_LEX_TOKEN_RBRACE) return false;
+        }
+        if (type == SLN_LEX_TOKEN_LPAREN || type == SLN_LEX_TOKEN_LBRACKET || type == SLN_LEX_TOKEN_LBRACE) {
+            depth++;
+        } else if (depth > 0 && (type == SLN_LEX_TOKEN_RPAREN || type == SLN_LEX_TOKEN_RBRACKET || type == SLN_LEX_TOKEN_RBRACE)) {
+            depth--;
+        }
+        _advance(ctx);
+    }
+}
+
+/*
+ * Parses `elem (sep elem)* [sep] close` after the opening bracket, the
+ * elements going after any already on the scratch stack above @p top.
+ * Separators are ',' and, if @p semicolons, also ';'. Returns the start
+ * of the list in `extra`.
+ */
+static uint32_t _parse_list(_sln_parse_ctx_t* ctx, size_t top, sln_lex_token_type_t close,
+                            _sln_parse_fn_t elem, bool semicolons) {
+    // A ':' inside brackets cannot end a ternary's middle operand
+    bool no_colon = ctx->no_colon;
+    ctx->no_colon = false;
+    for (;;) {
+        sln_lex_token_type_t type = _peek(ctx);
+        if (type == close || type == SLN_LEX_TOKEN_EOF) break;
+        _push(ctx, elem(ctx));
+        if (!_accept(ctx, SLN_LEX_TOKEN_COMMA) && !(semicolons && _accept(ctx, SLN_LEX_TOKEN_SEMICOLON))) break;
+    }
+    // Once the list is closed, errors in it stay inside it
+    if (_accept(ctx, close)) {
+        ctx->panic = false;
+    } else {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED, _spellings[close]);
+        if (_skip_to_close(ctx, close)) ctx->panic = false;
+    }
+    ctx->no_colon = no_colon;
+    return _commit(ctx, top);
+}
+
+// --- Paths and types ---
+
+static inline bool _path_continues(_sln_parse_ctx_t* ctx, bool colon) {
+    sln_lex_token_type_t type = _peek(ctx);
+    if (type == SLN_LEX_TOKEN_DOUBLE_COLON) return _is_name(_peek_next(ctx));
+    if (type == SLN_LEX_TOKEN_COLON && colon && !ctx->no_colon) return _peek_next(ctx) == SLN_LEX_TOKEN_IDENTIFIER;
+    return false;
+}
+
+// name (('::' | ':') name)*, with ':' only if @p colon; the current token is a name
+static uint32_t _parse_path(_sln_parse_ctx_t* ctx, bool colon) {
+    uint32_t first = _advance(ctx);
+    if (!_path_continues(ctx, colon)) return _add(ctx, SLN_AST_NAME, first, 0, 0);
+
+    size_t top = ctx->scratch.len;
+    _push(ctx, first);
+    while (_path_continues(ctx, colon)) {
+        _advance(ctx);
+        _push(ctx, _advance(ctx));
+    }
+    return _add_range(ctx, SLN_AST_PATH, first, _commit(ctx, top));
+}
+
+static uint32_t _parse_name_node(_sln_parse_ctx_t* ctx, sln_ast_kind_t kind, bool typed) {
+    if (!_is_name(_peek(ctx))) {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_NAME, NULL);
+        return _error_node(ctx);
+    }
+    uint32_t name = _advance(ctx);
+    uint32_t type = SLN_AST_NONE;
+    if (typed && _expect(ctx, SLN_LEX_TOKEN_COLON)) type = _parse_type(ctx);
+    return _add(ctx, kind, name, type, SLN_AST_NONE);
+}
+
+static uint32_t _parse_field(_sln_parse_ctx_t* ctx) {
+    return _parse_name_node(ctx, SLN_AST_FIELD, true);
+}
+
+static uint32_t _parse_param(_sln_parse_ctx_t* ctx) {
+    return _parse_name_node(ctx, SLN_AST_PARAM, true);
+}
+
+static uint32_t _parse_enum_member(_sln_parse_ctx_t* ctx) {
+    if (_accept(ctx, SLN_LEX_TOKEN_AT)) return _parse_name_node(ctx, SLN_AST_EXT_POINT, false);
+    if (!_is_name(_peek(ctx))) {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_NAME, NULL);
+        return _error_node(ctx);
+    }
+    uint32_t name = _advance(ctx);
+    uint32_t value = _accept(ctx, SLN_LEX_TOKEN_ASSIGN) ? _parse_expr(ctx) : SLN_AST_NONE;
+    return _add(ctx, SLN_AST_ENUMERATOR, name, value, 0);
+}
+
+// `struct { ... }` or `enum { ... }`
+static uint32_t _parse_aggregate(_sln_parse_ctx_t* ctx, sln_ast_kind_t kind, _sln_parse_fn_t member) {
+    uint32_t token = _advance(ctx);
+    if (!_expect(ctx, SLN_LEX_TOKEN_LBRACE)) return _error_node(ctx);
+    return _add_range(ctx, kind, token, _parse_list(ctx, ctx->scratch.len, SLN_LEX_TOKEN_RBRACE, member, false));
+}
+
+static uint32_t _parse_type(_sln_parse_ctx_t* ctx) {
+    if (!_enter(ctx)) return _error_node(ctx);
+
+    uint32_t type;
+    sln_lex_token_type_t token = _peek(ctx);
+    if (_is_builtin_type(token)) {
+        type = _add(ctx, SLN_AST_TYPE_BUILTIN, _advance(ctx), 0, 0);
+    } else if (_is_name(token)) {
+        type = _parse_path(ctx, false);
+    } else if (token == SLN_LEX_TOKEN_KW_STRUCT) {
+        type = _parse_aggregate(ctx, SLN_AST_STRUCT, _parse_field);
+    } else if (token == SLN_LEX_TOKEN_KW_ENUM) {
+        type = _parse_aggregate(ctx, SLN_AST_ENUM, _parse_enum_member);
+    } else if (token == SLN_LEX_TOKEN_LPAREN) {
+        uint32_t paren = _advance(ctx);
+        uint32_t start = _parse_list(ctx, ctx->scratch.len, SLN_LEX_TOKEN_RPAREN, _parse_type, true);
+        if (ctx->extra.len - start == 1) {
+            // `(T)` only groups; its list is the last thing in `extra`, so drop it
+            type = ctx->extra.items[start];
+            ctx->extra.len = start;
+        } else {
+            type = _add_range(ctx, SLN_AST_TYPE_TUPLE, paren, start);
+        }
+    } else {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_TYPE, NULL);
+        type = _error_node(ctx);
+    }
+
+    while (_peek(ctx) == SLN_LEX_TOKEN_LBRACKET) {
+        uint32_t bracket = _advance(ctx);
+        uint32_t length = _peek(ctx) == SLN_LEX_TOKEN_RBRACKET ? SLN_AST_NONE : _parse_expr(ctx);
+        _expect(ctx, SLN_LEX_TOKEN_RBRACKET);
+        type = _add(ctx, SLN_AST_TYPE_ARRAY, bracket, type, length);
+    }
+    ctx->depth--;
+    return type;
+}
+
+// --- Expressions ---
+
+static uint32_t _parse_primary(_sln_parse_ctx_t* ctx) {
+    sln_lex_token_type_t type = _peek(ctx);
+    switch (type) {
+        case SLN_LEX_TOKEN_IDENTIFIER:
+        case SLN_LEX_TOKEN_KW_MAIN:
+        case SLN_LEX_TOKEN_KW_ARGS:
+            return _parse_path(ctx, true);
+        case SLN_LEX_TOKEN_INT_LITERAL:
+            return _add(ctx, SLN_AST_INT, _advance(ctx), 0, 0);
+        case SLN_LEX_TOKEN_FLOAT_LITERAL:
+            return _add(ctx, SLN_AST_FLOAT, _advance(ctx), 0, 0);
+        case SLN_LEX_TOKEN_CHAR_LITERAL:
+            return _add(ctx, SLN_AST_CHAR, _advance(ctx), 0, 0);
+        case SLN_LEX_TOKEN_STRING_LITERAL:
+            return _add(ctx, SLN_AST_STRING, _advance(ctx), 0, 0);
+        case SLN_LEX_TOKEN_KW_NIL:
+            return _add(ctx, SLN_AST_NIL, _advance(ctx), 0, 0);
+        case SLN_LEX_TOKEN_LPAREN: {
+            uint32_t paren = _advance(ctx);
+            if (_accept(ctx, SLN_LEX_TOKEN_RPAREN)) return _add_range(ctx, SLN_AST_TUPLE, paren, (uint32_t)ctx->extra.len);
+
+            bool no_colon = ctx->no_colon;
+            ctx->no_colon = false;
+            uint32_t first = _parse_expr(ctx);
+            if (!_accept(ctx, SLN_LEX_TOKEN_COMMA)) {
+                ctx->no_colon = no_colon;
+                _expect(ctx, SLN_LEX_TOKEN_RPAREN);
+                return first;
+            }
+            size_t top = ctx->scratch.len;
+            _push(ctx, first);
+            uint32_t start = _parse_list(ctx, top, SLN_LEX_TOKEN_RPAREN, _parse_expr, false);
+            ctx->no_colon = no_colon;
+            return _add_range(ctx, SLN_AST_TUPLE, paren, start);
+        }
+        case SLN_LEX_TOKEN_LBRACE: {
+            uint32_t brace = _advance(ctx);
+            return _add_range(ctx, SLN_AST_INIT_LIST, brace,
+                              _parse_list(ctx, ctx->scratch.len, SLN_LEX_TOKEN_RBRACE, _parse_expr, false));
+        }
+        default:
+            _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_EXPRESSION, NULL);
+            return _error_node(ctx);
+    }
+}
+
+static uint32_t _parse_postfix(_sln_parse_ctx_t* ctx) {
+    uint32_t node = _parse_primary(ctx);
+    for (;;) {
+        switch (_peek(ctx)) {
+            case SLN_LEX_TOKEN_LPAREN: {
+                uint32_t paren = _advance(ctx);
+                uint32_t args[2];
+                args[0] = _parse_list(ctx, ctx->scratch.len, SLN_LEX_TOKEN_RPAREN, _parse_expr, false);
+                args[1] = (uint32_t)ctx->extra.len;
+                node = _add(ctx, SLN_AST_CALL, paren, node, _group(ctx, args, 2));
+                break;
+            }
+            case SLN_LEX_TOKEN_LBRACKET: {
+                uint32_t bracket = _advance(ctx);
+                bool no_colon = ctx->no_colon;
+                ctx->no_colon = false;
+                uint32_t index = _parse_expr(ctx);
+                ctx->no_colon = no_colon;
+                _expect(ctx, SLN_LEX_TOKEN_RBRACKET);
+                node = _add(ctx, SLN_AST_INDEX, bracket, node, index);
+                break;
+            }
+            case SLN_LEX_TOKEN_DOT:
+                _advance(ctx);
+                if (!_is_name(_peek(ctx))) {
+                    _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_NAME, NULL);
+                    return node;
+                }
+                node = _add(ctx, SLN_AST_MEMBER, _advance(ctx), node, 0);
+                break;
+            case SLN_LEX_TOKEN_ARROW: {
+                uint32_t arrow = _advance(ctx);
+                node = _add(ctx, SLN_AST_CAST, arrow, node, _parse_type(ctx));
+                break;
+            }
+            case SLN_LEX_TOKEN_INCREMENT:
+            case SLN_LEX_TOKEN_DECREMENT:
+                node = _add(ctx, SLN_AST_POSTFIX, _advance(ctx), node, 0);
+                break;
+            default:
+                return node;
+        }
+    }
+}
+
+static uint32_t _parse_unary(_sln_parse_ctx_t* ctx) {
+    // Prefix operators are stacked instead of recursed into
+    size_t top = ctx->scratch.len;
+    while (_is_prefix(_peek(ctx))) _push(ctx, _advance(ctx));
+    uint32_t node = _parse_postfix(ctx);
+    while (ctx->scratch.len > top) {
+        uint32_t op = ctx->scratch.items[--ctx->scratch.len];
+        node = _add(ctx, SLN_AST_UNARY, op, node, 0);
+    }
+    return node;
+}
+
+// Operators binding at least as tightly as @p min
+static uint32_t _parse_binary(_sln_parse_ctx_t* ctx, uint8_t min) {
+    if (!_enter(ctx)) return _error_node(ctx);
+
+    uint32_t lhs = _parse_unary(ctx);
+    for (;;) {
+        sln_lex_token_type_t type = _peek(ctx);
+        uint8_t power = _binary_power[type];
+        if (power == _SLN_PARSE_POWER_NONE || power < min) break;
+        uint32_t op = _advance(ctx);
+
+        if (type == SLN_LEX_TOKEN_QUESTION) {
+            uint32_t branches[2];
+            bool no_colon = ctx->no_colon;
+            ctx->no_colon = true;
+            branches[0] = _parse_binary(ctx, _SLN_PARSE_POWER_ASSIGN);
+            ctx->no_colon = no_colon;
+            _expect(ctx, SLN_LEX_TOKEN_COLON);
+            branches[1] = _parse_binary(ctx, _SLN_PARSE_POWER_TERNARY);
+            lhs = _add(ctx, SLN_AST_TERNARY, op, lhs, _group(ctx, branches, 2));
+        } else {
+            uint8_t next = power == _SLN_PARSE_POWER_ASSIGN ? power : (uint8_t)(power + 1);
+            uint32_t rhs = _parse_binary(ctx, next);
+            lhs = _add(ctx, SLN_AST_BINARY, op, lhs, rhs);
+        }
+    }
+    ctx->depth--;
+    return lhs;
+}
+
+static uint32_t _parse_expr(_sln_parse_ctx_t* ctx) {
+    return _parse_binary(ctx, _SLN_PARSE_POWER_ASSIGN);
+}
+
+// --- Statements ---
+
+// `name:` followed by a type starts a declaration; see parser.h
+static bool _is_declaration(_sln_parse_ctx_t* ctx) {
+    if (ctx->stopped || !_is_name(_peek(ctx))) return false;
+    size_t i = ctx->pos + 1;
+    if (_type_at(ctx, i) != SLN_LEX_TOKEN_COLON) return false;
+    i++;
+    sln_lex_token_type_t type = _type_at(ctx, i);
+    if (_is_builtin_type(type) || type == SLN_LEX_TOKEN_LPAREN ||
+        type == SLN_LEX_TOKEN_KW_STRUCT || type == SLN_LEX_TOKEN_KW_ENUM) return true;
+    if (!_is_name(type)) return false;
+
+    i++;
+    while (_type_at(ctx, i) == SLN_LEX_TOKEN_DOUBLE_COLON && _is_name(_type_at(ctx, i + 1))) {
+        i += 2;
+    }
+    type = _type_at(ctx, i);
+    return type == SLN_LEX_TOKEN_ASSIGN || type == SLN_LEX_TOKEN_SEMICOLON || type == SLN_LEX_TOKEN_LBRACKET;
+}
+
+// name ':' type ['=' expr], or with `var` before it, name [':' type] ['=' expr]
+static uint32_t _parse_var(_sln_parse_ctx_t* ctx) {
+    bool keyword = _accept(ctx, SLN_LEX_TOKEN_KW_VAR);
+    if (!_is_name(_peek(ctx))) {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_NAME, NULL);
+        return _error_node(ctx);
+    }
+    uint32_t name = _advance(ctx);
+    uint32_t type = SLN_AST_NONE;
+    if (keyword ? _accept(ctx, SLN_LEX_TOKEN_COLON) : _expect(ctx, SLN_LEX_TOKEN_COLON)) type = _parse_type(ctx);
+    uint32_t value = _accept(ctx, SLN_LEX_TOKEN_ASSIGN) ? _parse_expr(ctx) : SLN_AST_NONE;
+    return _add(ctx, SLN_AST_VAR, name, type, value);
+}
+
+static uint32_t _parse_block(_sln_parse_ctx_t* ctx) {
+    if (_peek(ctx) != SLN_LEX_TOKEN_LBRACE) {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED, _spellings[SLN_LEX_TOKEN_LBRACE]);
+        return _error_node(ctx);
+    }
+    uint32_t brace = _advance(ctx);
+    size_t top = ctx->scratch.len;
+    for (;;) {
+        sln_lex_token_type_t type = _peek(ctx);
+        if (type == SLN_LEX_TOKEN_RBRACE || type == SLN_LEX_TOKEN_EOF) break;
+        uint32_t statement = _parse_statement(ctx);
+        if (statement) _push(ctx, statement);
+    }
+    _expect(ctx, SLN_LEX_TOKEN_RBRACE);
+    return _add_range(ctx, SLN_AST_BLOCK, brace, _commit(ctx, top));
+}
+
+// '(' expr ')'
+static uint32_t _parse_condition(_sln_parse_ctx_t* ctx) {
+    if (!_expect(ctx, SLN_LEX_TOKEN_LPAREN)) return _error_node(ctx);
+    uint32_t condition = _parse_expr(ctx);
+    _expect(ctx, SLN_LEX_TOKEN_RPAREN);
+    return condition;
+}
+
+static uint32_t _parse_if(_sln_parse_ctx_t* ctx) {
+    uint32_t token = _advance(ctx);
+    uint32_t condition = _parse_condition(ctx);
+    uint32_t branches[2] = { _parse_block(ctx), SLN_AST_NONE };
+    if (_accept(ctx, SLN_LEX_TOKEN_KW_ELSE)) {
+        branches[1] = _peek(ctx) == SLN_LEX_TOKEN_KW_IF ? _parse_statement(ctx) : _parse_block(ctx);
+    }
+    return _add(ctx, SLN_AST_IF, token, condition, _group(ctx, branches, 2));
+}
+
+static uint32_t _parse_for(_sln_parse_ctx_t* ctx) {
+    uint32_t token = _advance(ctx);
+    uint32_t parts[3] = { SLN_AST_NONE, SLN_AST_NONE, SLN_AST_NONE };
+    if (_expect(ctx, SLN_LEX_TOKEN_LPAREN)) {
+        if (_peek(ctx) != SLN_LEX_TOKEN_SEMICOLON) {
+            parts[0] = _peek(ctx) == SLN_LEX_TOKEN_KW_VAR || _is_declaration(ctx) ? _parse_var(ctx) : _parse_expr(ctx);
+        }
+        _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+        if (_peek(ctx) != SLN_LEX_TOKEN_SEMICOLON) parts[1] = _parse_expr(ctx);
+        _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+        if (_peek(ctx) != SLN_LEX_TOKEN_RPAREN) parts[2] = _parse_expr(ctx);
+        _expect(ctx, SLN_LEX_TOKEN_RPAREN);
+    }
+    uint32_t header = _group(ctx, parts, 3);
+    return _add(ctx, SLN_AST_FOR, token, header, _parse_block(ctx));
+}
+
+static uint32_t _parse_switch(_sln_parse_ctx_t* ctx) {
+    uint32_t token = _advance(ctx);
+    uint32_t value = _parse_condition(ctx);
+    uint32_t cases[2];
+    size_t top = ctx->scratch.len;
+    if (_expect(ctx, SLN_LEX_TOKEN_LBRACE)) {
+        for (;;) {
+            sln_lex_token_type_t type = _peek(ctx);
+            if (type == SLN_LEX_TOKEN_RBRACE || type == SLN_LEX_TOKEN_EOF) break;
+            size_t start = ctx->pos;
+            if (type == SLN_LEX_TOKEN_KW_CASE || type == SLN_LEX_TOKEN_KW_DEFAULT) {
+                uint32_t label = _advance(ctx);
+                uint32_t match = type == SLN_LEX_TOKEN_KW_CASE ? _parse_expr(ctx) : SLN_AST_NONE;
+                _push(ctx, _add(ctx, SLN_AST_CASE, label, match, _parse_block(ctx)));
+            } else {
+                _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED, _spellings[SLN_LEX_TOKEN_KW_CASE]);
+            }
+            if (ctx->panic) _sync(ctx, start, false);
+        }
+        _expect(ctx, SLN_LEX_TOKEN_RBRACE);
+    }
+    cases[0] = _commit(ctx, top);
+    cases[1] = (uint32_t)ctx->extra.len;
+    return _add(ctx, SLN_AST_SWITCH, token, value, _group(ctx, cases, 2));
+}
+
+// Returns SLN_AST_NONE for an empty statement
+static uint32_t _parse_statement(_sln_parse_ctx_t* ctx) {
+    if (!_enter(ctx)) return _error_node(ctx);
+
+    size_t start = ctx->pos;
+    uint32_t node;
+    switch (_peek(ctx)) {
+        case SLN_LEX_TOKEN_LBRACE:
+            node = _parse_block(ctx);
+            break;
+        case SLN_LEX_TOKEN_KW_IF:
+            node = _parse_if(ctx);
+            break;
+        case SLN_LEX_TOKEN_KW_WHILE: {
+            uint32_t token = _advance(ctx);
+            uint32_t condition = _parse_condition(ctx);
+            node = _add(ctx, SLN_AST_WHILE, token, condition, _parse_block(ctx));
+            break;
+        }
+        case SLN_LEX_TOKEN_KW_FOR:
+            node = _parse_for(ctx);
+            break;
+        case SLN_LEX_TOKEN_KW_SWITCH:
+            node = _parse_switch(ctx);
+            break;
+        case SLN_LEX_TOKEN_KW_RETURN: {
+            uint32_t token = _advance(ctx);
+            uint32_t value = _peek(ctx) == SLN_LEX_TOKEN_SEMICOLON ? SLN_AST_NONE : _parse_expr(ctx);
+            node = _add(ctx, SLN_AST_RETURN, token, value, 0);
+            _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+            break;
+        }
+        case SLN_LEX_TOKEN_KW_BREAK:
+            node = _add(ctx, SLN_AST_BREAK, _advance(ctx), 0, 0);
+            _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+            break;
+        case SLN_LEX_TOKEN_KW_CONTINUE:
+            node = _add(ctx, SLN_AST_CONTINUE, _advance(ctx), 0, 0);
+            _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+            break;
+        case SLN_LEX_TOKEN_SEMICOLON:
+            _advance(ctx);
+            node = SLN_AST_NONE;
+            break;
+        case SLN_LEX_TOKEN_KW_VAR:
+            node = _parse_var(ctx);
+            _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+            break;
+        default:
+            if (_is_declaration(ctx)) {
+                node = _parse_var(ctx);
+            } else {
+                uint32_t token = (uint32_t)ctx->pos;
+                node = _add(ctx, SLN_AST_EXPR_STMT, token, _parse_expr(ctx), 0);
+            }
+            _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+            break;
+    }
+    if (ctx->panic) _sync(ctx, start, false);
+    ctx->depth--;
+    return node;
+}
+
+// --- Items ---
+
+static uint32_t _parse_use(_sln_parse_ctx_t* ctx) {
+    uint32_t token = _advance(ctx);
+    if (!_is_name(_peek(ctx))) {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_NAME, NULL);
+        return _error_node(ctx);
+    }
+    uint32_t path = _parse_path(ctx, true);
+    bool glob = _accept(ctx, SLN_LEX_TOKEN_STAR) ||
+                (_peek(ctx) == SLN_LEX_TOKEN_DOUBLE_COLON && _peek_next(ctx) == SLN_LEX_TOKEN_STAR &&
+                 _accept(ctx, SLN_LEX_TOKEN_DOUBLE_COLON) && _accept(ctx, SLN_LEX_TOKEN_STAR));
+    uint32_t alias = 0;
+    if (!glob && _is_word(ctx, "as")) {
+        _advance(ctx);
+        if (_is_name(_peek(ctx))) {
+            alias = _advance(ctx);
+        } else {
+            _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_NAME, NULL);
+        }
+    }
+    _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+    uint32_t node = _add(ctx, SLN_AST_USE, token, path, alias);
+    if (glob && node) ctx->nodes[node].flags = SLN_AST_FLAG_GLOB;
+    return node;
+}
+
+// Items up to a '}' or EOF, pushed above @p top; returns their start in `extra`
+static uint32_t _parse_items(_sln_parse_ctx_t* ctx, size_t top) {
+    for (;;) {
+        sln_lex_token_type_t type = _peek(ctx);
+        if (type == SLN_LEX_TOKEN_EOF || (type == SLN_LEX_TOKEN_RBRACE && ctx->depth > 0)) break;
+        uint32_t item = _parse_item(ctx);
+        if (item) _push(ctx, item);
+    }
+    return _commit(ctx, top);
+}
+
+static uint32_t _parse_namespace(_sln_parse_ctx_t* ctx) {
+    _advance(ctx);
+    if (!_is_name(_peek(ctx))) {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_NAME, NULL);
+        return _error_node(ctx);
+    }
+    uint32_t name = _advance(ctx);
+    if (!_expect(ctx, SLN_LEX_TOKEN_LBRACE)) return _error_node(ctx);
+    uint32_t start = _parse_items(ctx, ctx->scratch.len);
+    uint32_t node = _add_range(ctx, SLN_AST_NAMESPACE, name, start);
+    if (_expect(ctx, SLN_LEX_TOKEN_RBRACE)) _accept(ctx, SLN_LEX_TOKEN_SEMICOLON);
+    return node;
+}
+
+static uint32_t _parse_type_def(_sln_parse_ctx_t* ctx) {
+    _advance(ctx);
+    if (!_is_name(_peek(ctx))) {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_NAME, NULL);
+        return _error_node(ctx);
+    }
+    uint32_t name = _advance(ctx);
+    uint32_t type = _expect(ctx, SLN_LEX_TOKEN_ASSIGN) ? _parse_type(ctx) : _error_node(ctx);
+    _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+    return _add(ctx, SLN_AST_TYPE_DEF, name, type, 0);
+}
+
+// path '(' params ')' [':' type] ['='] (block | ';')
+static uint32_t _parse_func(_sln_parse_ctx_t* ctx, uint32_t name) {
+    uint32_t token = ctx->nodes[name].token;
+    uint32_t parts[4];
+    _advance(ctx);
+    parts[0] = _parse_list(ctx, ctx->scratch.len, SLN_LEX_TOKEN_RPAREN, _parse_param, false);
+    parts[1] = (uint32_t)ctx->extra.len;
+    parts[2] = _accept(ctx, SLN_LEX_TOKEN_COLON) ? _parse_type(ctx) : SLN_AST_NONE;
+    _accept(ctx, SLN_LEX_TOKEN_ASSIGN);
+    parts[3] = _accept(ctx, SLN_LEX_TOKEN_SEMICOLON) ? SLN_AST_NONE : _parse_block(ctx);
+    return _add(ctx, SLN_AST_FUNC, token, name, _group(ctx, parts, 4));
+}
+
+// path '@' name '=' '{' ... '}' ';'
+static uint32_t _parse_extend(_sln_parse_ctx_t* ctx, uint32_t type) {
+    _advance(ctx);
+    if (!_is_name(_peek(ctx))) {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_NAME, NULL);
+        return _error_node(ctx);
+    }
+    uint32_t point = _advance(ctx);
+    uint32_t list = SLN_AST_NONE;
+    if (_expect(ctx, SLN_LEX_TOKEN_ASSIGN)) {
+        if (_peek(ctx) == SLN_LEX_TOKEN_LBRACE) {
+            uint32_t brace = _advance(ctx);
+            list = _add_range(ctx, SLN_AST_INIT_LIST, brace,
+                              _parse_list(ctx, ctx->scratch.len, SLN_LEX_TOKEN_RBRACE, _parse_expr, false));
+        } else {
+            _expect(ctx, SLN_LEX_TOKEN_LBRACE);
+        }
+    }
+    _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+    return _add(ctx, SLN_AST_EXTEND, point, type, list);
+}
+
+// Functions, extensions and global variables, all starting with a name
+static uint32_t _parse_named_item(_sln_parse_ctx_t* ctx) {
+    uint32_t name = _parse_path(ctx, false);
+    switch (_peek(ctx)) {
+        case SLN_LEX_TOKEN_LPAREN:
+            return _parse_func(ctx, name);
+        case SLN_LEX_TOKEN_AT:
+            return _parse_extend(ctx, name);
+        case SLN_LEX_TOKEN_COLON: {
+            _advance(ctx);
+            uint32_t type = _parse_type(ctx);
+            uint32_t value = _accept(ctx, SLN_LEX_TOKEN_ASSIGN) ? _parse_expr(ctx) : SLN_AST_NONE;
+            _expect(ctx, SLN_LEX_TOKEN_SEMICOLON);
+            return _add(ctx, SLN_AST_VAR, ctx->nodes[name].token, type, value);
+        }
+        default:
+            _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED, _spellings[SLN_LEX_TOKEN_LPAREN]);
+            return _error_node(ctx);
+    }
+}
+
+// Returns SLN_AST_NONE for a stray ';'
+static uint32_t _parse_item(_sln_parse_ctx_t* ctx) {
+    if (!_enter(ctx)) return _error_node(ctx);
+
+    size_t start = ctx->pos;
+    uint32_t node;
+    sln_lex_token_type_t type = _peek(ctx);
+    if (type == SLN_LEX_TOKEN_KW_USE) {
+        node = _parse_use(ctx);
+    } else if (type == SLN_LEX_TOKEN_KW_NAMESPACE) {
+        node = _parse_namespace(ctx);
+    } else if (type == SLN_LEX_TOKEN_KW_TYPE) {
+        node = _parse_type_def(ctx);
+    } else if (type == SLN_LEX_TOKEN_SEMICOLON) {
+        _advance(ctx);
+        node = SLN_AST_NONE;
+    } else if (_is_name(type)) {
+        node = _parse_named_item(ctx);
+    } else {
+        _report(ctx, SLN_PARSE_UNEXPECTED_TOKEN, SLN_MSG_PARSE_EXPECTED_ITEM, NULL);
+        node = _error_node(ctx);
+    }
+    if (ctx->panic) _sync(ctx, start, true);
+    ctx->depth--;
+    return node;
+}
+
+// Parses from ctx->pos to EOF and settles the tree in @p arena
+static sln_parse_error_t _run(_sln_parse_ctx_t* ctx, size_t nodes_hint, sln_utils_arena_t* arena, sln_ast_t* ast) {
+    // About one node per token
+    ctx->cap = nodes_hint + SLN_PARSER_INITIAL_SIZE;
+    ctx->nodes = SLN_ALLOC(ctx->cap, sln_ast_node_t);
+    if (!ctx->nodes) {
+        sln_lex_lines_free(&ctx->lines);
+        return SLN_PARSE_ALLOCATION_FAILED;
+    }
+
+    _add(ctx, SLN_AST_ROOT, 0, 0, 0);
+    uint32_t start = _parse_items(ctx, 0);
+    ctx->nodes[0].lhs = start;
+    ctx->nodes[0].rhs = (uint32_t)ctx->extra.len;
+
+    if (ctx->status != SLN_PARSE_ALLOCATION_FAILED) {
+        // Settle the tree in the arena at its final size
+        sln_ast_node_t* nodes = SLN_ARENA_ALLOC(arena, ctx->len, sln_ast_node_t);
+        uint32_t* extra = SLN_ARENA_ALLOC(arena, ctx->extra.len ? ctx->extra.len : 1, uint32_t);
+        if (nodes && extra) {
+            memcpy(nodes, ctx->nodes, ctx->len * sizeof(sln_ast_node_t));
+            if (ctx->extra.len) memcpy(extra, ctx->extra.items, ctx->extra.len * sizeof(uint32_t));
+            *ast = (sln_ast_t){ nodes, extra, ctx->len, ctx->extra.len, ctx->tokens, ctx->count };
+        } else {
+            ctx->status = SLN_PARSE_ALLOCATION_FAILED;
+        }
+    }
+    if (ctx->status == SLN_PARSE_ALLOCATION_FAILED) *ast = (sln_ast_t){ 0 };
+
+    sln_utils_free(ctx->nodes);
+    sln_utils_free(ctx->extra.items);
+    sln_utils_free(ctx->scratch.items);
+    sln_lex_lines_free(&ctx->lines);
+    return ctx->status;
+}
+
+sln_parse_error_t sln_parse(
+    const char* text,
+    const sln_lex_token_buffer_t* buffer,
+    sln_utils_arena_t* arena,
+    FILE* error_stream,
+    sln_ast_t* ast)
+{
+    if (!buffer || !buffer->tokens || buffer->len == 0) return SLN_PARSE_NO_TOKEN_BUFFER;
+    if (!error_stream) return SLN_PARSE_NO_ERROR_STREAM;
+    if (!arena) return SLN_PARSE_NO_ARENA;
+    // Nodes per token stay well below 4, so ids fit in 32 bits
+    if (buffer->len > UINT32_MAX / 4) return SLN_PARSE_SOURCE_TOO_LARGE;
+    SLN_TRACE_SCOPE("parse", NULL);
+
+    _sln_parse_ctx_t ctx = {
+        .text = text,
+        .tokens = buffer->tokens,
+        .count = buffer->len,
+        .error_stream = error_stream,
+        .status = SLN_PARSE_OK,
+        .errors_left = SLN_PARSE_MAX_ERRORS,
+    };
+    sln_lex_lines_init(&ctx.lines, text);
+    return _run(&ctx, buffer->len, arena, ast);
+}
+
+sln_parse_error_t sln_parse_pipe(
+    const char* text,
+    sln_lex_pipe_t* pipe,
+    sln_lex_token_buffer_t* buffer,
+    sln_utils_arena_t* arena,
+    FILE* error_stream,
+    sln_ast_t* ast)
+{
+    if (!pipe || !buffer) return SLN_PARSE_NO_TOKEN_BUFFER;
+    if (!error_stream) return SLN_PARSE_NO_ERROR_STREAM;
+    if (!arena) return SLN_PARSE_NO_ARENA;
+    SLN_TRACE_SCOPE("parse", NULL);
+
+    *buffer = (sln_lex_token_buffer_t){ 0 };
+    _sln_parse_ctx_t ctx = {
+        .text = text,
+        .pipe = pipe,
+        .buffer = buffer,
+        .buffer_cap = SLN_LEX_PIPE_BATCH,
+        .error_stream = error_stream,
+        .status = SLN_PARSE_OK,
+        .errors_left = SLN_PARSE_MAX_ERRORS,
+    };
+    buffer->tokens = SLN_ALLOC(ctx.buffer_cap, sln_lex_token_t);
+    if (!buffer->tokens) return SLN_PARSE_ALLOCATION_FAILED;
+    if (!_pull(&ctx, 0)) return ctx.status != SLN_PARSE_OK ? ctx.status : SLN_PARSE_NO_TOKEN_BUFFER;
+    sln_lex_lines_init(&ctx.lines, text);
+    // Roughly one significant token per 5 bytes of text
+    return _run(&ctx, strlen(text) / 5, arena, ast);
+}
+
+// --- Parallel parsing ---
+
+// Items of tokens [begin, end), parsed on their own
+typedef struct {
+    size_t begin;
+    size_t end;
+    sln_ast_node_t* nodes;      /**< nodes[0] is a placeholder, so 0 still means no node */
+    size_t len;
+    uint32_t* extra;
+    size_t extra_len;
+    uint32_t* items;            /**< Top-level items, not yet in `extra` */
+    size_t item_count;
+    bool failed;
+} _sln_parse_chunk_t;
+
+// Chunks shared by the caller and its helper tasks. Helpers may start
+// after the caller is done, so the last one to let go frees the job.
+typedef struct {
+    const char* text;
+    const sln_lex_token_t* tokens;
+    _sln_parse_chunk_t* chunks;
+    size_t chunk_count;
+    atomic_size_t next;         /**< Next chunk to claim */
+    atomic_size_t done;         /**< Chunks finished or skipped */
+    atomic_bool failed;         /**< A chunk failed; the others are skipped */
+    atomic_size_t refs;
+    mtx_t lock;
+    cnd_t finished;             /**< Signalled when the last chunk is done */
+} _sln_parse_job_t;
+
+/*
+ * Cuts the items of @p buffer into chunks, matching brackets by kind
+ * alone. An item ends at a ';' or a '}' back at depth 0, unless a ';'
+ * follows the '}' (`namespace n { };`). Where the parser would end an
+ * item elsewhere, a chunk ends in the middle of one and fails to parse.
+ * Returns the chunk count, 0 if the brackets do not balance.
+ */
+static size_t _split(const sln_lex_token_buffer_t* buffer, size_t chunk_tokens,
+                     _sln_parse_chunk_t* chunks, size_t cap) {
+    const sln_lex_token_t* tokens = buffer->tokens;
+    size_t depth = 0;
+    size_t begin = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < buffer->len; i++) {
+        switch (tokens[i].type) {
+            case SLN_LEX_TOKEN_LPAREN:
+            case SLN_LEX_TOKEN_LBRACKET:
+            case SLN_LEX_TOKEN_LBRACE:
+                depth++;
+                continue;
+            case SLN_LEX_TOKEN_RPAREN:
+            case SLN_LEX_TOKEN_RBRACKET:
+                if (depth == 0) return 0;
+                depth--;
+                continue;
+            case SLN_LEX_TOKEN_RBRACE:
+                if (depth == 0) return 0;
+                if (--depth > 0) continue;
+                if (i + 1 < buffer->len && tokens[i + 1].type == SLN_LEX_TOKEN_SEMICOLON) continue;
+                break;
+            case SLN_LEX_TOKEN_SEMICOLON:
+                if (depth > 0) continue;
+                break;
+            default:
+                continue;
+        }
+        if (i + 1 - begin >= chunk_tokens && count + 1 < cap) {
+            chunks[count++] = (_sln_parse_chunk_t){ .begin = begin, .end = i + 1 };
+            begin = i + 1;
+        }
+    }
+    if (depth > 0) return 0;
+    chunks[count++] = (_sln_parse_chunk_t){ .begin = begin, .end = buffer->len };
+    return count;
+}
+
+// Parses the items of a chunk as if the tokens after it were not there
+static void _parse_chunk(const char* text, const sln_lex_token_t* tokens, _sln_parse_chunk_t* chunk) {
+    SLN_TRACE_SCOPE("parse.chunk", NULL);
+    _sln_parse_ctx_t ctx = {
+        .text = text,
+        .tokens = tokens,
+        .count = chunk->end,
+        .status = SLN_PARSE_OK,
+        .errors_left = SLN_PARSE_MAX_ERRORS,
+        .bail = true,
+    };
+    ctx.pos = chunk->begin;
+    ctx.cap = chunk->end - chunk->begin + SLN_PARSER_INITIAL_SIZE;
+    ctx.nodes = SLN_ALLOC(ctx.cap, sln_ast_node_t);
+    if (!ctx.nodes) {
+        chunk->failed = true;
+        return;
+    }
+
+    _add(&ctx, SLN_AST_ERROR, 0, 0, 0);
+    while (_peek(&ctx) != SLN_LEX_TOKEN_EOF) {
+        uint32_t item = _parse_item(&ctx);
+        if (item) _push(&ctx, item);
+    }
+
+    chunk->nodes = ctx.nodes;
+    chunk->len = ctx.len;
+    chunk->extra = ctx.extra.items;
+    chunk->extra_len = ctx.extra.len;
+    chunk->items = ctx.scratch.items;
+    chunk->item_count = ctx.scratch.len;
+    chunk->failed = ctx.status != SLN_PARSE_OK;
+}
+
+static void _release_job(_sln_parse_job_t* job) {
+    if (atomic_fetch_sub(&job->refs, 1) != 1) return;
+    cnd_destroy(&job->finished);
+    mtx_destroy(&job->lock);
+    sln_utils_free(job);
+}
+
+// Claims and parses chunks until none is left
+static void _work(_sln_parse_job_t* job) {
+    size_t index;
+    while ((index = atomic_fetch_add(&job->next, 1)) < job->chunk_count) {
+        _sln_parse_chunk_t* chunk = &job->chunks[index];
+        if (!atomic_load(&job->failed)) {
+            _parse_chunk(job->text, job->tokens, chunk);
+            if (chunk->failed) atomic_store(&job->failed, true);
+        }
+        if (atomic_fetch_add(&job->done, 1) + 1 == job->chunk_count) {
+            mtx_lock(&job->lock);
+            cnd_broadcast(&job->finished);
+            mtx_unlock(&job->lock);
+        }
+    }
+}
+
+static void _help(void* arg, size_t worker) {
+    (void)worker;
+    _work(arg);
+    _release_job(arg);
+}
+
+// Shifts the node ids and `extra` indices a chunk node holds to their
+// place in the whole tree; 0 stays "no node". Every kind is listed and
+// there is no default, so -Wswitch stops the build when a kind is added
+// without saying what it points to. Returns false for a node that
+// cannot be in a chunk.
+static bool _relocate(sln_ast_node_t* node, uint32_t* extra, uint32_t node_shift, uint32_t extra_shift) {
+#define _ID(id) ((id) ? (id) + node_shift : SLN_AST_NONE)
+    switch ((sln_ast_kind_t)node->kind) {
+        case SLN_AST_NAMESPACE:
+        case SLN_AST_STRUCT:
+        case SLN_AST_ENUM:
+        case SLN_AST_BLOCK:
+        case SLN_AST_TUPLE:
+        case SLN_AST_INIT_LIST:
+        case SLN_AST_TYPE_TUPLE:
+            node->lhs += extra_shift;
+            node->rhs += extra_shift;
+            for (uint32_t i = node->lhs; i < node->rhs; i++) extra[i] = _ID(extra[i]);
+            break;
+        case SLN_AST_PATH:
+            node->lhs += extra_shift;
+            node->rhs += extra_shift;
+            break;
+        case SLN_AST_USE:
+        case SLN_AST_TYPE_DEF:
+        case SLN_AST_FIELD:
+        case SLN_AST_ENUMERATOR:
+        case SLN_AST_PARAM:
+        case SLN_AST_RETURN:
+        case SLN_AST_EXPR_STMT:
+        case SLN_AST_UNARY:
+        case SLN_AST_POSTFIX:
+        case SLN_AST_MEMBER:
+            node->lhs = _ID(node->lhs);
+            break;
+        case SLN_AST_EXTEND:
+        case SLN_AST_VAR:
+        case SLN_AST_WHILE:
+        case SLN_AST_CASE:
+        case SLN_AST_BINARY:
+        case SLN_AST_INDEX:
+        case SLN_AST_CAST:
+        case SLN_AST_TYPE_ARRAY:
+            node->lhs = _ID(node->lhs);
+            node->rhs = _ID(node->rhs);
+            break;
+        case SLN_AST_FUNC: {
+            node->lhs = _ID(node->lhs);
+            node->rhs += extra_shift;
+            uint32_t* parts = extra + node->rhs;
+            parts[0] += extra_shift;
+            parts[1] += extra_shift;
+            for (uint32_t i = parts[0]; i < parts[1]; i++) extra[i] = _ID(extra[i]);
+            parts[2] = _ID(parts[2]);
+            parts[3] = _ID(parts[3]);
+            break;
+        }
+        case SLN_AST_IF:
+        case SLN_AST_TERNARY:
+            node->lhs = _ID(node->lhs);
+            node->rhs += extra_shift;
+            extra[node->rhs] = _ID(extra[node->rhs]);
+            extra[node->rhs + 1] = _ID(extra[node->rhs + 1]);
+            break;
+        case SLN_AST_FOR:
+            node->lhs += extra_shift;
+            for (uint32_t i = node->lhs; i < node->lhs + 3; i++) extra[i] = _ID(extra[i]);
+            node->rhs = _ID(node->rhs);
+            break;
+        case SLN_AST_SWITCH:
+        case SLN_AST_CALL: {
+            node->lhs = _ID(node->lhs);
+            node->rhs += extra_shift;
+            uint32_t* range = extra + node->rhs;
+            range[0] += extra_shift;
+            range[1] += extra_shift;
+            for (uint32_t i = range[0]; i < range[1]; i++) extra[i] = _ID(extra[i]);
+            break;
+        }
+        case SLN_AST_EXT_POINT:
+        case SLN_AST_BREAK:
+        case SLN_AST_CONTINUE:
+        case SLN_AST_NAME:
+        case SLN_AST_INT:
+        case SLN_AST_FLOAT:
+        case SLN_AST_CHAR:
+        case SLN_AST_STRING:
+        case SLN_AST_NIL:
+        case SLN_AST_TYPE_BUILTIN:
+        case SLN_AST_ERROR:
+            break;
+        case SLN_AST_ROOT:
+        case _SLN_AST_KIND_COUNT:
+            return false;
+    }
+#undef _ID
+    return node->kind < _SLN_AST_KIND_COUNT;
+}
+
+/*
+ * Joins the chunk trees into the tree sln_parse() builds: the root,
+ * then each chunk's nodes and `extra` in source order, then the root's
+ * items. Chunk-local ids and indices only need shifting, as the serial
+ * parser would have put the same nodes at the same offsets. Returns
+ * false if memory runs out or a node cannot be relocated.
+ */
+static bool _merge(const _sln_parse_job_t* job, const sln_lex_token_buffer_t* buffer,
+                   sln_utils_arena_t* arena, sln_ast_t* ast) {
+    size_t len = 1;
+    size_t extra_len = 0;
+    size_t item_count = 0;
+    for (size_t k = 0; k < job->chunk_count; k++) {
+        len += job->chunks[k].len - 1;
+        extra_len += job->chunks[k].extra_len;
+        item_count += job->chunks[k].item_count;
+    }
+
+    sln_ast_node_t* nodes = SLN_ARENA_ALLOC(arena, len, sln_ast_node_t);
+    uint32_t* extra = SLN_ARENA_ALLOC(arena, (extra_len + item_count) ? extra_len + item_count : 1, uint32_t);
+    if (!nodes || !extra) return false;
+
+    nodes[0] = (sln_ast_node_t){ SLN_AST_ROOT, 0, 0, 0, (uint32_t)extra_len, (uint32_t)(extra_len + item_count) };
+    size_t node_base = 1;
+    size_t extra_base = 0;
+    uint32_t* items = extra + extra_len;
+    for (size_t k = 0; k < job->chunk_count; k++) {
+        const _sln_parse_chunk_t* chunk = &job->chunks[k];
+        uint32_t node_shift = (uint32_t)(node_base - 1);
+        uint32_t extra_shift = (uint32_t)extra_base;
+        memcpy(nodes + node_base, chunk->nodes + 1, (chunk->len - 1) * sizeof(sln_ast_node_t));
+        if (chunk->extra_len) memcpy(extra + extra_base, chunk->extra, chunk->extra_len * sizeof(uint32_t));
+        for (size_t i = 0; i < chunk->len - 1; i++) {
+            if (!_relocate(&nodes[node_base + i], extra, node_shift, extra_shift)) return false;
+        }
+        for (size_t i = 0; i < chunk->item_count; i++) *items++ = chunk->items[i] + node_shift;
+        node_base += chunk->len - 1;
+        extra_base += chunk->extra_len;
+    }
+    *ast = (sln_ast_t){ nodes, extra, len, extra_len + item_count, buffer->tokens, buffer->len };
+    return true;
+}
+
+sln_parse_error_t sln_parse_parallel(
+    const char* text,
+    const sln_lex_token_buffer_t* buffer,
+    sln_utils_arena_t* arena,
+    FILE* error_stream,
+    sln_ast_t* ast,
+    sln_utils_pool_t* pool,
+    size_t chunk_tokens)
+{
+    if (!buffer || !buffer->tokens || buffer->len == 0) return SLN_PARSE_NO_TOKEN_BUFFER;
+    if (chunk_tokens == 0) chunk_tokens = SLN_PARSE_CHUNK_TOKENS;
+    if (!pool || sln_utils_pool_size(pool) < 2 || buffer->len / 2 < chunk_tokens
+        || buffer->len > UINT32_MAX / 4) {
+        return sln_parse(text, buffer, arena, error_stream, ast);
+    }
+    if (!error_stream) return SLN_PARSE_NO_ERROR_STREAM;
+    if (!arena) return SLN_PARSE_NO_ARENA;
+
+    _sln_parse_job_t* job = SLN_ALLOC(1, _sln_parse_job_t);
+    size_t cap = buffer->len / chunk_tokens + 1;
+    _sln_parse_chunk_t* chunks = SLN_ALLOC(cap, _sln_parse_chunk_t);
+    size_t count = job && chunks ? _split(buffer, chunk_tokens, chunks, cap) : 0;
+    if (count < 2 || mtx_init(&job->lock, mtx_plain) != thrd_success) {
+        sln_utils_free(chunks);
+        sln_utils_free(job);
+        return sln_parse(text, buffer, arena, error_stream, ast);
+    }
+    if (cnd_init(&job->finished) != thrd_success) {
+        mtx_destroy(&job->lock);
+        sln_utils_free(chunks);
+        sln_utils_free(job);
+        return sln_parse(text, buffer, arena, error_stream, ast);
+    }
+    SLN_TRACE_SCOPE("parse", NULL);
+
+    job->text = text;
+    job->tokens = buffer->tokens;
+    job->chunks = chunks;
+    job->chunk_count = count;
+    atomic_init(&job->next, 0);
+    atomic_init(&job->done, 0);
+    atomic_init(&job->failed, false);
+
+    // The caller parses chunks too, so a pool busy with other work
+    // only slows this down
+    size_t helpers = sln_utils_pool_size(pool);
+    if (helpers > count - 1) helpers = count - 1;
+    atomic_init(&job->refs, helpers + 1);
+    for (size_t i = 0; i < helpers; i++) {
+        if (!sln_utils_pool_submit(pool, _help, job)) atomic_fetch_sub(&job->refs, 1);
+    }
+    _work(job);
+    mtx_lock(&job->lock);
+    while (atomic_load(&job->done) < count) cnd_wait(&job->finished, &job->lock);
+    mtx_unlock(&job->lock);
+
+    // A chunk with an error is parsed again as a whole, for the
+    // diagnostics and recovery of sln_parse(); so is a tree that cannot
+    // be joined, which sln_parse() builds with less memory
+    bool failed = atomic_load(&job->failed) || !_merge(job, buffer, arena, ast);
+    for (size_t k = 0; k < count; k++) {
+        sln_utils_free(chunks[k].nodes);
+        sln_utils_free(chunks[k].extra);
+        sln_utils_free(chunks[k].items);
+    }
+    sln_utils_free(chunks);
+    _release_job(job);
+    return failed ? sln_parse(text, buffer, arena, error_stream, ast) : SLN_PARSE_OK;
+}
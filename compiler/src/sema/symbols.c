@@ -0,0 +1,1111 @@
+#include <string.h>
+
+#include <sema/symbols.h>
+#include <lexer/lexer_lines.h>
+#include <utils/allocation.h>
+#include <utils/msg_errors.h>
+#include <utils/trace.h>
+
+#define SLN_SEMA_INITIAL_SIZE 64u
+#define SLN_SEMA_GROW_FACTOR 2
+
+// Longest path or source text printed in a diagnostic
+#define SLN_SEMA_PATH_TEXT 256
+
+typedef struct {
+    uint32_t hash;
+    sln_sema_id_t id;           /**< SLN_SEMA_NONE marks an empty slot */
+} _sln_sema_slot_t;
+
+typedef struct {
+    sln_sema_scope_t parent;
+    uint32_t hash;              /**< Hash of the scope's path */
+    uint32_t first_view;        /**< Index + 1 in `views`, 0 if none */
+    uint32_t last_view;
+} _sln_sema_scope_t;
+
+// Glob import, a link in its scope's list
+typedef struct {
+    sln_sema_scope_t target;
+    uint32_t next;              /**< Index + 1, 0 at the end */
+} _sln_sema_view_t;
+
+// `use` item or function named by a path, waiting for sln_sema_bind()
+typedef struct {
+    sln_sema_scope_t scope;     /**< Scope of the item */
+    sln_sema_scope_t file;      /**< File scope of its unit */
+    sln_utils_sym_t name;       /**< Name to declare, unused for globs */
+    uint32_t path;              /**< Segments: paths[path..path + path_len) */
+    uint32_t path_len;
+    uint32_t unit;
+    sln_ast_id_t node;
+    sln_lex_location_t location;
+    uint32_t members;           /**< Extension: members[members..members + member_len) */
+    uint32_t member_len;
+    bool func;                  /**< Function; the path is its scope's */
+    bool glob;
+    bool extend;                /**< Extension; name: its point */
+    bool done;
+    bool queued;                /**< In the ready queue of sln_sema_bind() */
+} _sln_sema_pending_t;
+
+// Name in an extension's list, `type@point = { name, ... };`
+typedef struct {
+    sln_utils_sym_t name;
+    uint32_t unit;
+    sln_ast_id_t node;
+    sln_lex_location_t location;
+    sln_sema_id_t id;           /**< Its enumerator, SLN_SEMA_NONE until bound */
+} _sln_sema_member_t;
+
+// Key (scope, name) pending items are blocked on, a link in its scope's list
+typedef struct {
+    sln_sema_scope_t scope;
+    sln_utils_sym_t name;
+    uint32_t hash;
+    uint32_t first;             /**< Index + 1 of its first wait, 0 if none is left */
+    uint32_t next;              /**< Index + 1 of the scope's next key, 0 at the end */
+} _sln_sema_wait_key_t;
+
+// Pending item parked on a key
+typedef struct {
+    uint32_t item;
+    uint32_t next;              /**< Index + 1, 0 at the end */
+} _sln_sema_wait_t;
+
+// Work of one sln_sema_bind(): the items to try next, and the others
+// parked on the keys whose declaration may let them bind
+typedef struct {
+    uint32_t* ready;            /**< Queue of pending item indexes */
+    size_t ready_head;
+    size_t ready_len;
+    size_t ready_cap;
+    _sln_sema_wait_key_t* keys;
+    size_t key_len;
+    size_t key_cap;
+    uint32_t* slots;            /**< Key index + 1, 0 marks an empty slot */
+    uint32_t mask;
+    _sln_sema_wait_t* waits;
+    size_t wait_len;
+    size_t wait_cap;
+    uint32_t* scope_keys;       /**< Scope -> index + 1 of its first key */
+    size_t scope_len;
+    bool failed;                /**< An allocation failed */
+} _sln_sema_worklist_t;
+
+// ENUMERATOR and EXT_POINT entries of an enum, in source order
+typedef struct {
+    uint32_t first;             /**< layout_items[first..first + len) */
+    uint32_t len;
+    bool explicit_values;       /**< Some enumerator has an explicit value */
+} _sln_sema_layout_t;
+
+struct sln_sema_symbols {
+    sln_utils_intern_t* symbols;
+    sln_sema_entry_t* entries;  /**< entries[0] is unused */
+    size_t len;
+    size_t cap;
+    _sln_sema_slot_t* slots;
+    uint32_t mask;
+    _sln_sema_scope_t* scopes;
+    size_t scope_len;
+    size_t scope_cap;
+    _sln_sema_view_t* views;
+    size_t view_len;
+    size_t view_cap;
+    _sln_sema_pending_t* pending;
+    size_t pending_len;
+    size_t pending_cap;
+    sln_utils_sym_t* paths;
+    size_t path_len;
+    size_t path_cap;
+    sln_sema_scope_t* unit_scopes; /**< File scope of every unit, 0 until collected */
+    size_t unit_cap;
+    _sln_sema_member_t* members;
+    size_t member_len;
+    size_t member_cap;
+    _sln_sema_layout_t* layouts;
+    size_t layout_len;
+    size_t layout_cap;
+    sln_sema_id_t* layout_items;
+    size_t layout_item_len;
+    size_t layout_item_cap;
+    _sln_sema_worklist_t* worklist; /**< Set during sln_sema_bind() only */
+    uint32_t point_len;
+    uint32_t* ext_offsets;      /**< Point index -> first of its enumerators in ext_ids; point_len + 1 */
+    sln_sema_id_t* ext_ids;     /**< Enumerators of every point, grouped by point */
+};
+
+static const char* const _kind_names[_SLN_SEMA_KIND_COUNT] = {
+#define _SLN_SEMA_KIND_NAME(name) #name,
+    SLN_SEMA_KINDS(_SLN_SEMA_KIND_NAME)
+#undef _SLN_SEMA_KIND_NAME
+};
+
+const char* sln_sema_kind_name(sln_sema_kind_t kind) {
+    return kind < _SLN_SEMA_KIND_COUNT ? _kind_names[kind] : "?";
+}
+
+// Hash of a path one segment longer: scope hashes and key hashes are
+// both built this way, from the root's
+static inline uint32_t _extend(uint32_t hash, sln_utils_sym_t name) {
+    hash = (hash ^ name) * 0x9E3779B1u;
+    return hash ^ (hash >> 16);
+}
+
+// Room for @p n more elements of @p size bytes; returns the array,
+// moved if it grew, or NULL with the old one left as it was
+static void* _reserve(void* items, size_t len, size_t* cap, size_t n, size_t size) {
+    if (len + n <= *cap) return items;
+    size_t new_cap = *cap ? *cap : SLN_SEMA_INITIAL_SIZE;
+    while (new_cap < len + n) new_cap *= SLN_SEMA_GROW_FACTOR;
+    void* grown = sln_utils_alloc(new_cap, size, __func__);
+    if (!grown) return NULL;
+    if (len) memcpy(grown, items, len * size);
+    sln_utils_free(items);
+    *cap = new_cap;
+    return grown;
+}
+
+// --- Worklist ---
+
+// Queues pending item @p item unless it is bound or queued already
+static void _ready(sln_sema_symbols_t* table, _sln_sema_worklist_t* list, uint32_t item) {
+    _sln_sema_pending_t* pending = &table->pending[item];
+    if (pending->done || pending->queued) return;
+    if (list->ready_head == list->ready_len) list->ready_head = list->ready_len = 0;
+    uint32_t* ready = _reserve(list->ready, list->ready_len, &list->ready_cap, 1, sizeof(*ready));
+    if (!ready) {
+        list->failed = true;
+        return;
+    }
+    list->ready = ready;
+    ready[list->ready_len++] = item;
+    pending->queued = true;
+}
+
+// Slot of the wait key (@p scope, @p name): its index + 1, or the empty one it would take
+static uint32_t _wait_probe(const _sln_sema_worklist_t* list, sln_sema_scope_t scope, sln_utils_sym_t name,
+                            uint32_t hash) {
+    uint32_t i = hash & list->mask;
+    for (; list->slots[i]; i = (i + 1) & list->mask) {
+        const _sln_sema_wait_key_t* key = &list->keys[list->slots[i] - 1];
+        if (key->hash == hash && key->scope == scope && key->name == name) break;
+    }
+    return i;
+}
+
+static bool _wait_grow(_sln_sema_worklist_t* list) {
+    uint32_t new_cap = (list->mask + 1) * SLN_SEMA_GROW_FACTOR;
+    uint32_t* slots = SLN_ALLOC(new_cap, uint32_t);
+    if (!slots) return false;
+    for (uint32_t i = 0; i <= list->mask; i++) {
+        if (!list->slots[i]) continue;
+        uint32_t j = list->keys[list->slots[i] - 1].hash & (new_cap - 1);
+        while (slots[j]) j = (j + 1) & (new_cap - 1);
+        slots[j] = list->slots[i];
+    }
+    sln_utils_free(list->slots);
+    list->slots = slots;
+    list->mask = new_cap - 1;
+    return true;
+}
+
+// Parks pending item @p item until (@p scope, @p name) is declared
+static void _park(sln_sema_symbols_t* table, _sln_sema_worklist_t* list, uint32_t item, sln_sema_scope_t scope,
+                  sln_utils_sym_t name) {
+    if (list->key_len * 2 >= list->mask + 1 && !_wait_grow(list)) {
+        list->failed = true;
+        return;
+    }
+    uint32_t hash = _extend(table->scopes[scope].hash, name);
+    uint32_t slot = _wait_probe(list, scope, name, hash);
+    if (!list->slots[slot]) {
+        _sln_sema_wait_key_t* keys = _reserve(list->keys, list->key_len, &list->key_cap, 1, sizeof(*keys));
+        if (!keys || list->key_len >= UINT32_MAX) {
+            list->failed = true;
+            return;
+        }
+        list->keys = keys;
+        uint32_t next = scope < list->scope_len ? list->scope_keys[scope] : 0;
+        keys[list->key_len++] = (_sln_sema_wait_key_t){ scope, name, hash, 0, next };
+        list->slots[slot] = (uint32_t)list->key_len;
+        if (scope < list->scope_len) list->scope_keys[scope] = (uint32_t)list->key_len;
+    }
+    _sln_sema_wait_t* waits = _reserve(list->waits, list->wait_len, &list->wait_cap, 1, sizeof(*waits));
+    if (!waits || list->wait_len >= UINT32_MAX) {
+        list->failed = true;
+        return;
+    }
+    list->waits = waits;
+    _sln_sema_wait_key_t* key = &list->keys[list->slots[slot] - 1];
+    waits[list->wait_len++] = (_sln_sema_wait_t){ item, key->first };
+    key->first = (uint32_t)list->wait_len;
+}
+
+// Queues every item parked on @p key
+static void _wake_key(sln_sema_symbols_t* table, _sln_sema_worklist_t* list, _sln_sema_wait_key_t* key) {
+    for (uint32_t w = key->first; w; w = list->waits[w - 1].next) _ready(table, list, list->waits[w - 1].item);
+    key->first = 0;
+}
+
+// Queues the items parked on (@p scope, @p name), just declared
+static void _wake(sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_utils_sym_t name, uint32_t hash) {
+    _sln_sema_worklist_t* list = table->worklist;
+    if (!list || !list->key_len) return;
+    uint32_t slot = _wait_probe(list, scope, name, hash);
+    if (list->slots[slot]) _wake_key(table, list, &list->keys[list->slots[slot] - 1]);
+}
+
+// --- Table ---
+
+// Slot of the key (@p scope, @p name): its entry's, or the empty one it would take
+static uint32_t _probe(const sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_utils_sym_t name, uint32_t hash) {
+    uint32_t i = hash & table->mask;
+    for (; table->slots[i].id != SLN_SEMA_NONE; i = (i + 1) & table->mask) {
+        if (table->slots[i].hash != hash) continue;
+        const sln_sema_entry_t* entry = &table->entries[table->slots[i].id];
+        if (entry->parent == scope && entry->name == name) break;
+    }
+    return i;
+}
+
+static bool _grow_slots(sln_sema_symbols_t* table) {
+    uint32_t new_cap = (table->mask + 1) * SLN_SEMA_GROW_FACTOR;
+    _sln_sema_slot_t* slots = SLN_ALLOC(new_cap, _sln_sema_slot_t);
+    if (!slots) return false;
+    for (uint32_t i = 0; i <= table->mask; i++) {
+        _sln_sema_slot_t slot = table->slots[i];
+        if (slot.id == SLN_SEMA_NONE) continue;
+        uint32_t j = slot.hash & (new_cap - 1);
+        while (slots[j].id != SLN_SEMA_NONE) j = (j + 1) & (new_cap - 1);
+        slots[j] = slot;
+    }
+    sln_utils_free(table->slots);
+    table->slots = slots;
+    table->mask = new_cap - 1;
+    return true;
+}
+
+// Adds @p entry under its key, opening a scope for it if @p opens
+static sln_sema_error_t _insert(sln_sema_symbols_t* table, sln_sema_entry_t entry, uint32_t hash, bool opens,
+                                sln_sema_id_t* id) {
+    if (table->len >= UINT32_MAX || table->scope_len >= UINT32_MAX) return SLN_SEMA_ALLOCATION_FAILED;
+    sln_sema_entry_t* entries = _reserve(table->entries, table->len, &table->cap, 1, sizeof(*entries));
+    if (!entries) return SLN_SEMA_ALLOCATION_FAILED;
+    table->entries = entries;
+    if (opens) {
+        _sln_sema_scope_t* scopes = _reserve(table->scopes, table->scope_len, &table->scope_cap, 1, sizeof(*scopes));
+        if (!scopes) return SLN_SEMA_ALLOCATION_FAILED;
+        table->scopes = scopes;
+    }
+    // Keep the load factor at or below 1/2; entries[0] holds no key
+    if (table->len * 2 > table->mask + 1 && !_grow_slots(table)) return SLN_SEMA_ALLOCATION_FAILED;
+
+    if (opens) {
+        entry.scope = (sln_sema_scope_t)table->scope_len;
+        table->scopes[table->scope_len++] = (_sln_sema_scope_t){ entry.parent, hash, 0, 0 };
+    }
+    *id = (sln_sema_id_t)table->len;
+    table->entries[table->len++] = entry;
+    uint32_t slot = _probe(table, entry.parent, entry.name, hash);
+    table->slots[slot] = (_sln_sema_slot_t){ hash, *id };
+    return SLN_SEMA_OK;
+}
+
+static inline sln_sema_id_t _own(const sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_utils_sym_t name) {
+    return table->slots[_probe(table, scope, name, _extend(table->scopes[scope].hash, name))].id;
+}
+
+static inline sln_sema_id_t _follow(const sln_sema_symbols_t* table, sln_sema_id_t id) {
+    return table->entries[id].kind == SLN_SEMA_ALIAS ? table->entries[id].target : id;
+}
+
+sln_sema_symbols_t* sln_sema_symbols_create(sln_utils_intern_t* symbols) {
+    sln_sema_symbols_t* table = SLN_ALLOC(1, sln_sema_symbols_t);
+    if (!table) return NULL;
+    table->symbols = symbols;
+    table->entries = SLN_ALLOC(SLN_SEMA_INITIAL_SIZE, sln_sema_entry_t);
+    table->slots = SLN_ALLOC(SLN_SEMA_INITIAL_SIZE, _sln_sema_slot_t);
+    table->scopes = SLN_ALLOC(SLN_SEMA_INITIAL_SIZE, _sln_sema_scope_t);
+    if (!table->entries || !table->slots || !table->scopes) {
+        sln_sema_symbols_destroy(table);
+        return NULL;
+    }
+    table->len = 1;
+    table->cap = SLN_SEMA_INITIAL_SIZE;
+    table->mask = SLN_SEMA_INITIAL_SIZE - 1;
+    table->scopes[0] = (_sln_sema_scope_t){ SLN_SEMA_ROOT, SLN_UTILS_INTERN_HASH_INIT, 0, 0 };
+    table->scope_len = 1;
+    table->scope_cap = SLN_SEMA_INITIAL_SIZE;
+    return table;
+}
+
+void sln_sema_symbols_destroy(sln_sema_symbols_t* table) {
+    if (!table) return;
+    sln_utils_free(table->entries);
+    sln_utils_free(table->slots);
+    sln_utils_free(table->scopes);
+    sln_utils_free(table->views);
+    sln_utils_free(table->pending);
+    sln_utils_free(table->paths);
+    sln_utils_free(table->unit_scopes);
+    sln_utils_free(table->members);
+    sln_utils_free(table->layouts);
+    sln_utils_free(table->layout_items);
+    sln_utils_free(table->ext_offsets);
+    sln_utils_free(table->ext_ids);
+    sln_utils_free(table);
+}
+
+sln_sema_error_t sln_sema_declare(sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_sema_kind_t kind,
+                                  sln_utils_sym_t name, bool opens, uint32_t unit, sln_ast_id_t node,
+                                  sln_sema_id_t* id) {
+    if (!table) return SLN_SEMA_NO_TABLE;
+    uint32_t hash = _extend(table->scopes[scope].hash, name);
+    sln_sema_id_t existing = table->slots[_probe(table, scope, name, hash)].id;
+    if (existing != SLN_SEMA_NONE) {
+        *id = existing;
+        bool merges = kind == SLN_SEMA_NAMESPACE && table->entries[existing].kind == SLN_SEMA_NAMESPACE;
+        return merges ? SLN_SEMA_OK : SLN_SEMA_DUPLICATE;
+    }
+    sln_sema_entry_t entry = { name, (uint8_t)kind, 0, scope, SLN_SEMA_ROOT, SLN_SEMA_NONE, unit, node, 0 };
+    sln_sema_error_t error = _insert(table, entry, hash, opens || kind == SLN_SEMA_NAMESPACE, id);
+    if (error == SLN_SEMA_OK) _wake(table, scope, name, hash);
+    return error;
+}
+
+sln_sema_error_t sln_sema_alias(sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_utils_sym_t name,
+                                sln_sema_id_t target, uint32_t unit, sln_ast_id_t node) {
+    if (!table) return SLN_SEMA_NO_TABLE;
+    target = _follow(table, target);
+    uint32_t hash = _extend(table->scopes[scope].hash, name);
+    sln_sema_id_t existing = table->slots[_probe(table, scope, name, hash)].id;
+    if (existing != SLN_SEMA_NONE) return _follow(table, existing) == target ? SLN_SEMA_OK : SLN_SEMA_DUPLICATE;
+    sln_sema_entry_t entry = { name, SLN_SEMA_ALIAS, 0, scope, SLN_SEMA_ROOT, target, unit, node, 0 };
+    sln_sema_id_t id;
+    sln_sema_error_t error = _insert(table, entry, hash, false, &id);
+    if (error == SLN_SEMA_OK) _wake(table, scope, name, hash);
+    return error;
+}
+
+// @p scope now sees the names of @p target too: items parked on a name
+// of @p scope that @p target holds may bind, the others now also wait
+// for @p target to get it
+static void _wake_view(sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_sema_scope_t target) {
+    _sln_sema_worklist_t* list = table->worklist;
+    if (!list || scope >= list->scope_len) return;
+    for (uint32_t k = list->scope_keys[scope]; k; k = list->keys[k - 1].next) {
+        if (!list->keys[k - 1].first) continue;
+        sln_utils_sym_t name = list->keys[k - 1].name;
+        if (_own(table, target, name) != SLN_SEMA_NONE) {
+            _wake_key(table, list, &list->keys[k - 1]);
+            continue;
+        }
+        // Parking may move the keys
+        for (uint32_t w = list->keys[k - 1].first; w; w = list->waits[w - 1].next) {
+            _park(table, list, list->waits[w - 1].item, target, name);
+        }
+    }
+}
+
+bool sln_sema_import(sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_sema_scope_t target) {
+    if (target == scope) return true;
+    _sln_sema_scope_t* info = &table->scopes[scope];
+    for (uint32_t v = info->first_view; v; v = table->views[v - 1].next) {
+        if (table->views[v - 1].target == target) return true;
+    }
+    _sln_sema_view_t* views = _reserve(table->views, table->view_len, &table->view_cap, 1, sizeof(*views));
+    if (!views || table->view_len >= UINT32_MAX) return false;
+    table->views = views;
+    views[table->view_len++] = (_sln_sema_view_t){ target, 0 };
+    uint32_t link = (uint32_t)table->view_len;
+    if (info->last_view) {
+        views[info->last_view - 1].next = link;
+    } else {
+        info->first_view = link;
+    }
+    info->last_view = link;
+    _wake_view(table, scope, target);
+    return true;
+}
+
+sln_sema_id_t sln_sema_member(const sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_utils_sym_t name) {
+    return _follow(table, _own(table, scope, name));
+}
+
+sln_sema_scope_t sln_sema_unit_scope(const sln_sema_symbols_t* table, uint32_t unit) {
+    return unit < table->unit_cap ? table->unit_scopes[unit] : SLN_SEMA_ROOT;
+}
+
+// Own names of @p scope, then those of its views
+static sln_sema_id_t _visible(const sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_utils_sym_t name) {
+    sln_sema_id_t id = _own(table, scope, name);
+    for (uint32_t v = table->scopes[scope].first_view; v && id == SLN_SEMA_NONE; v = table->views[v - 1].next) {
+        id = _own(table, table->views[v - 1].target, name);
+    }
+    return _follow(table, id);
+}
+
+sln_sema_id_t sln_sema_lookup(const sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_sema_scope_t file,
+                              sln_utils_sym_t name) {
+    for (;;) {
+        sln_sema_id_t id;
+        if (scope == file) file = SLN_SEMA_ROOT;
+        if (scope == SLN_SEMA_ROOT && file != SLN_SEMA_ROOT && (id = _visible(table, file, name))) return id;
+        if ((id = _visible(table, scope, name))) return id;
+        if (scope == SLN_SEMA_ROOT) return SLN_SEMA_NONE;
+        scope = table->scopes[scope].parent;
+    }
+}
+
+sln_sema_id_t sln_sema_resolve(const sln_sema_symbols_t* table, sln_sema_scope_t scope, sln_sema_scope_t file,
+                               const sln_utils_sym_t* path, size_t len) {
+    if (len == 0) return SLN_SEMA_NONE;
+    sln_sema_id_t id = sln_sema_lookup(table, scope, file, path[0]);
+    for (size_t i = 1; i < len && id != SLN_SEMA_NONE; i++) {
+        sln_sema_scope_t inner = table->entries[id].scope;
+        id = inner == SLN_SEMA_ROOT ? SLN_SEMA_NONE : sln_sema_member(table, inner, path[i]);
+    }
+    return id;
+}
+
+sln_sema_id_t sln_sema_ext_point(const sln_sema_symbols_t* table, sln_sema_id_t type, sln_utils_sym_t name) {
+    sln_sema_scope_t inner = table->entries[type].scope;
+    if (table->entries[type].kind != SLN_SEMA_TYPE || inner == SLN_SEMA_ROOT) return SLN_SEMA_NONE;
+    sln_sema_id_t id = _own(table, inner, name);
+    return table->entries[id].kind == SLN_SEMA_EXT_POINT ? id : SLN_SEMA_NONE;
+}
+
+const sln_sema_id_t* sln_sema_extensions(const sln_sema_symbols_t* table, sln_sema_id_t point, size_t* count) {
+    *count = 0;
+    if (table->entries[point].kind != SLN_SEMA_EXT_POINT || !table->ext_offsets) return NULL;
+    uint32_t index = table->entries[point].target;
+    *count = table->ext_offsets[index + 1] - table->ext_offsets[index];
+    return table->ext_ids + table->ext_offsets[index];
+}
+
+const sln_sema_entry_t* sln_sema_entry(const sln_sema_symbols_t* table, sln_sema_id_t id) {
+    return &table->entries[id];
+}
+
+size_t sln_sema_count(const sln_sema_symbols_t* table) {
+    return table->len - 1;
+}
+
+// --- Collection ---
+
+typedef struct {
+    sln_sema_symbols_t* table;
+    uint32_t unit;
+    sln_sema_scope_t file;
+    const sln_ast_t* ast;
+    const char* text;
+    FILE* error_stream;
+    sln_lex_lines_t lines;
+    sln_sema_error_t status;
+} _sln_sema_ctx_t;
+
+static void _fail(_sln_sema_ctx_t* ctx, sln_sema_error_t error) {
+    if (ctx->status == SLN_SEMA_OK) ctx->status = error;
+}
+
+// Interned name of a name token; MAIN and ARGS are keywords, so they carry none
+static sln_utils_sym_t _name(_sln_sema_ctx_t* ctx, uint32_t token) {
+    const sln_lex_token_t* tok = &ctx->ast->tokens[token];
+    if (tok->type == SLN_LEX_TOKEN_IDENTIFIER) return tok->data.sym;
+    sln_utils_sym_t sym = sln_utils_intern(ctx->table->symbols, ctx->text + tok->span.offset, tok->span.length);
+    if (sym == SLN_UTILS_SYM_NONE) _fail(ctx, SLN_SEMA_ALLOCATION_FAILED);
+    return sym;
+}
+
+static sln_lex_location_t _locate(_sln_sema_ctx_t* ctx, uint32_t token) {
+    sln_lex_location_t location = { 0, 0 };
+    if (!sln_lex_lines_locate(&ctx->lines, ctx->ast->tokens[token].span.offset, &location)) {
+        _fail(ctx, SLN_SEMA_ALLOCATION_FAILED);
+    }
+    return location;
+}
+
+static void _report_at(sln_res_msg_t msg, const char* subject, sln_lex_location_t location, FILE* stream) {
+    sln_utils_msg_print_detail_at_line(msg, SLN_UTILS_MSG_TYPE_ERRR, subject ? subject : "?",
+                                       location.line, location.column, stream);
+}
+
+// Declares @p name at the name token @p token, reporting a duplicate
+static sln_sema_id_t _declare(_sln_sema_ctx_t* ctx, sln_sema_scope_t scope, sln_sema_kind_t kind, uint32_t token,
+                              bool opens, sln_ast_id_t node) {
+    sln_utils_sym_t name = _name(ctx, token);
+    if (name == SLN_UTILS_SYM_NONE) return SLN_SEMA_NONE;
+    sln_sema_id_t id;
+    sln_sema_error_t status = sln_sema_declare(ctx->table, scope, kind, name, opens, ctx->unit, node, &id);
+    if (status == SLN_SEMA_OK) return id;
+    _fail(ctx, status);
+    if (status == SLN_SEMA_DUPLICATE) {
+        _report_at(SLN_MSG_SEMA_DUPLICATE, sln_utils_intern_get(ctx->table->symbols, name, NULL),
+                   _locate(ctx, token), ctx->error_stream);
+    }
+    return SLN_SEMA_NONE;
+}
+
+// Keeps a `use` item or a function named by @p path for sln_sema_bind()
+static void _defer(_sln_sema_ctx_t* ctx, sln_sema_scope_t scope, sln_ast_id_t path, sln_ast_id_t node,
+                   uint32_t alias, bool func, bool glob) {
+    sln_sema_symbols_t* table = ctx->table;
+    const sln_ast_node_t* name = sln_ast_node(ctx->ast, path);
+    size_t count = 1;
+    const uint32_t* tokens = &name->token;
+    if (name->kind == SLN_AST_PATH) tokens = sln_ast_range(ctx->ast, name->lhs, name->rhs, &count);
+    else if (name->kind != SLN_AST_NAME) return;
+
+    sln_utils_sym_t* paths = _reserve(table->paths, table->path_len, &table->path_cap, count, sizeof(*paths));
+    _sln_sema_pending_t* pending = _reserve(table->pending, table->pending_len, &table->pending_cap, 1, sizeof(*pending));
+    if (paths) table->paths = paths;
+    if (pending) table->pending = pending;
+    if (!paths || !pending || table->path_len + count > UINT32_MAX) {
+        _fail(ctx, SLN_SEMA_ALLOCATION_FAILED);
+        return;
+    }
+
+    _sln_sema_pending_t item = {
+        .scope = scope,
+        .file = ctx->file,
+        .path = (uint32_t)table->path_len,
+        .path_len = (uint32_t)count,
+        .unit = ctx->unit,
+        .node = node,
+        .location = _locate(ctx, tokens[0]),
+        .func = func,
+        .glob = glob,
+    };
+    for (size_t i = 0; i < count; i++) {
+        sln_utils_sym_t sym = _name(ctx, tokens[i]);
+        if (sym == SLN_UTILS_SYM_NONE) return;
+        paths[table->path_len + i] = sym;
+    }
+    item.name = alias ? _name(ctx, alias) : paths[table->path_len + count - 1];
+    // A function's own name is declared in the scope its path leads to
+    if (func) item.path_len--;
+    table->path_len += count;
+    table->pending[table->pending_len++] = item;
+}
+
+// Value of an integer literal, negated or not, that fits an int64_t
+static bool _literal(const sln_ast_t* ast, sln_ast_id_t id, int64_t* value) {
+    const sln_ast_node_t* node = sln_ast_node(ast, id);
+    bool negative = node->kind == SLN_AST_UNARY && ast->tokens[node->token].type == SLN_LEX_TOKEN_MINUS;
+    if (negative) node = sln_ast_node(ast, node->lhs);
+    if (node->kind != SLN_AST_INT) return false;
+    uint64_t magnitude = ast->tokens[node->token].data.u64;
+    if (magnitude > (uint64_t)INT64_MAX + negative) return false;
+    *value = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+    return true;
+}
+
+// Declares the enumerators and extension points of an enum in its own
+// scope and keeps their order, for sln_sema_bind() to number them
+static void _collect_enum(_sln_sema_ctx_t* ctx, sln_sema_scope_t scope, const sln_ast_node_t* type) {
+    sln_sema_symbols_t* table = ctx->table;
+    size_t count;
+    const uint32_t* members = sln_ast_range(ctx->ast, type->lhs, type->rhs, &count);
+    sln_sema_id_t* items = _reserve(table->layout_items, table->layout_item_len, &table->layout_item_cap, count,
+                                    sizeof(*items));
+    _sln_sema_layout_t* layouts = _reserve(table->layouts, table->layout_len, &table->layout_cap, 1, sizeof(*layouts));
+    if (items) table->layout_items = items;
+    if (layouts) table->layouts = layouts;
+    if (!items || !layouts || table->layout_item_len + count > UINT32_MAX) {
+        _fail(ctx, SLN_SEMA_ALLOCATION_FAILED);
+        return;
+    }
+
+    _sln_sema_layout_t layout = { (uint32_t)table->layout_item_len, 0, false };
+    for (size_t i = 0; i < count; i++) {
+        const sln_ast_node_t* member = sln_ast_node(ctx->ast, members[i]);
+        sln_sema_id_t id = SLN_SEMA_NONE;
+        if (member->kind == SLN_AST_ENUMERATOR) {
+            id = _declare(ctx, scope, SLN_SEMA_ENUMERATOR, member->token, false, members[i]);
+            if (id && member->lhs) {
+                sln_sema_entry_t* entry = &table->entries[id];
+                entry->flags = SLN_SEMA_FLAG_EXPLICIT;
+                if (_literal(ctx->ast, member->lhs, &entry->value)) entry->flags |= SLN_SEMA_FLAG_VALUED;
+                layout.explicit_values = true;
+            }
+        } else if (member->kind == SLN_AST_EXT_POINT) {
+            id = _declare(ctx, scope, SLN_SEMA_EXT_POINT, member->token, false, members[i]);
+            if (id) table->entries[id].target = table->point_len++;
+        }
+        if (id) table->layout_items[table->layout_item_len + layout.len++] = id;
+    }
+    table->layout_item_len += layout.len;
+    table->layouts[table->layout_len++] = layout;
+}
+
+// Keeps `type@point = { A, B };` for sln_sema_bind(), with its names
+static void _collect_extend(_sln_sema_ctx_t* ctx, sln_sema_scope_t scope, sln_ast_id_t id) {
+    sln_sema_symbols_t* table = ctx->table;
+    const sln_ast_node_t* node = sln_ast_node(ctx->ast, id);
+    size_t pending = table->pending_len;
+    _defer(ctx, scope, node->lhs, id, node->token, false, false);
+    if (table->pending_len == pending || !node->rhs) return;
+
+    const sln_ast_node_t* list = sln_ast_node(ctx->ast, node->rhs);
+    size_t count;
+    const uint32_t* names = sln_ast_range(ctx->ast, list->lhs, list->rhs, &count);
+    _sln_sema_member_t* members = _reserve(table->members, table->member_len, &table->member_cap, count,
+                                           sizeof(*members));
+    if (!members || table->member_len + count > UINT32_MAX) {
+        _fail(ctx, SLN_SEMA_ALLOCATION_FAILED);
+        return;
+    }
+    table->members = members;
+
+    _sln_sema_pending_t* item = &table->pending[pending];
+    item->extend = true;
+    item->members = (uint32_t)table->member_len;
+    for (size_t i = 0; i < count; i++) {
+        const sln_ast_node_t* name = sln_ast_node(ctx->ast, names[i]);
+        if (name->kind != SLN_AST_NAME) {
+            sln_lex_span_t span = ctx->ast->tokens[name->token].span;
+            char text[SLN_SEMA_PATH_TEXT];
+            snprintf(text, sizeof(text), "%.*s", (int)span.length, ctx->text + span.offset);
+            _fail(ctx, SLN_SEMA_INVALID_EXTENSION);
+            _report_at(SLN_MSG_SEMA_EXPECTED_ENUMERATOR, text, _locate(ctx, name->token), ctx->error_stream);
+            continue;
+        }
+        sln_utils_sym_t sym = _name(ctx, name->token);
+        if (sym == SLN_UTILS_SYM_NONE) return;
+        members[table->member_len + item->member_len++] =
+            (_sln_sema_member_t){ sym, ctx->unit, names[i], _locate(ctx, name->token), SLN_SEMA_NONE };
+    }
+    table->member_len += item->member_len;
+}
+
+// Namespaces nest no deeper than the parser's SLN_PARSE_MAX_DEPTH
+static void _collect_items(_sln_sema_ctx_t* ctx, sln_sema_scope_t scope, uint32_t start, uint32_t end) {
+    size_t count;
+    const uint32_t* items = sln_ast_range(ctx->ast, start, end, &count);
+    for (size_t i = 0; i < count && ctx->status != SLN_SEMA_ALLOCATION_FAILED; i++) {
+        const sln_ast_node_t* node = sln_ast_node(ctx->ast, items[i]);
+        switch ((sln_ast_kind_t)node->kind) {
+            case SLN_AST_NAMESPACE: {
+                sln_sema_id_t id = _declare(ctx, scope, SLN_SEMA_NAMESPACE, node->token, true, items[i]);
+                if (id) _collect_items(ctx, ctx->table->entries[id].scope, node->lhs, node->rhs);
+                break;
+            }
+            case SLN_AST_TYPE_DEF: {
+                const sln_ast_node_t* type = sln_ast_node(ctx->ast, node->lhs);
+                bool is_enum = node->lhs && type->kind == SLN_AST_ENUM;
+                sln_sema_id_t id = _declare(ctx, scope, SLN_SEMA_TYPE, node->token, is_enum, items[i]);
+                if (id && is_enum) _collect_enum(ctx, ctx->table->entries[id].scope, type);
+                break;
+            }
+            case SLN_AST_FUNC:
+                if (sln_ast_node(ctx->ast, node->lhs)->kind == SLN_AST_PATH) {
+                    _defer(ctx, scope, node->lhs, items[i], 0, true, false);
+                } else {
+                    _declare(ctx, scope, SLN_SEMA_FUNC, node->token, false, items[i]);
+                }
+                break;
+            case SLN_AST_VAR:
+                _declare(ctx, scope, SLN_SEMA_VAR, node->token, false, items[i]);
+                break;
+            case SLN_AST_EXTEND:
+                _collect_extend(ctx, scope, items[i]);
+                break;
+            case SLN_AST_USE:
+                // Top-level imports are the unit's own
+                _defer(ctx, scope == SLN_SEMA_ROOT ? ctx->file : scope, node->lhs, items[i], node->rhs, false, (node->flags & SLN_AST_FLAG_GLOB) != 0);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// File scope of @p unit, opened on its first collection
+static sln_sema_scope_t _file_scope(sln_sema_symbols_t* table, uint32_t unit) {
+    if (unit >= table->unit_cap) {
+        size_t cap = table->unit_cap;
+        sln_sema_scope_t* scopes = _reserve(table->unit_scopes, table->unit_cap, &cap, (size_t)unit + 1 - table->unit_cap,
+                                            sizeof(*scopes));
+        if (!scopes) return SLN_SEMA_ROOT;
+        memset(scopes + table->unit_cap, 0, (cap - table->unit_cap) * sizeof(*scopes));
+        table->unit_scopes = scopes;
+        table->unit_cap = cap;
+    }
+    if (table->unit_scopes[unit] != SLN_SEMA_ROOT) return table->unit_scopes[unit];
+
+    _sln_sema_scope_t* scopes = _reserve(table->scopes, table->scope_len, &table->scope_cap, 1, sizeof(*scopes));
+    if (!scopes || table->scope_len >= UINT32_MAX) return SLN_SEMA_ROOT;
+    table->scopes = scopes;
+    // No path leads here; the hash only spreads the file's aliases
+    scopes[table->scope_len] = (_sln_sema_scope_t){ SLN_SEMA_ROOT, _extend(~SLN_UTILS_INTERN_HASH_INIT, unit), 0, 0 };
+    table->unit_scopes[unit] = (sln_sema_scope_t)table->scope_len;
+    return (sln_sema_scope_t)table->scope_len++;
+}
+
+sln_sema_error_t sln_sema_collect(sln_sema_symbols_t* table, uint32_t unit, const sln_ast_t* ast,
+                                  const char* text, FILE* error_stream) {
+    if (!table) return SLN_SEMA_NO_TABLE;
+    if (!ast || ast->len == 0) return SLN_SEMA_NO_TREE;
+    if (!error_stream) return SLN_SEMA_NO_ERROR_STREAM;
+    SLN_TRACE_SCOPE("sema.collect", NULL);
+
+    _sln_sema_ctx_t ctx = { table, unit, SLN_SEMA_ROOT, ast, text, error_stream, { 0 }, SLN_SEMA_OK };
+    ctx.file = _file_scope(table, unit);
+    if (ctx.file == SLN_SEMA_ROOT) return SLN_SEMA_ALLOCATION_FAILED;
+    sln_lex_lines_init(&ctx.lines, text);
+    const sln_ast_node_t* root = sln_ast_node(ast, 0);
+    _collect_items(&ctx, SLN_SEMA_ROOT, root->lhs, root->rhs);
+    sln_lex_lines_free(&ctx.lines);
+    return ctx.status;
+}
+
+// --- Binding ---
+
+// Declares the names of an extension in the scope of its enum
+static void _bind_extend(sln_sema_symbols_t* table, const _sln_sema_pending_t* item, sln_sema_id_t point,
+                         sln_sema_error_t* status, FILE* error_stream) {
+    sln_sema_scope_t scope = table->entries[point].parent;
+    for (uint32_t i = item->members; i < item->members + item->member_len; i++) {
+        _sln_sema_member_t* member = &table->members[i];
+        sln_sema_id_t id;
+        sln_sema_error_t error = sln_sema_declare(table, scope, SLN_SEMA_ENUMERATOR, member->name, false,
+                                                  member->unit, member->node, &id);
+        if (error == SLN_SEMA_OK) {
+            table->entries[id].flags = SLN_SEMA_FLAG_EXTENSION;
+            table->entries[id].target = point;
+            member->id = id;
+            continue;
+        }
+        if (*status == SLN_SEMA_OK) *status = error;
+        if (error == SLN_SEMA_DUPLICATE) {
+            _report_at(SLN_MSG_SEMA_DUPLICATE, sln_utils_intern_get(table->symbols, member->name, NULL),
+                       member->location, error_stream);
+        }
+    }
+}
+
+// Name a pending item's path is missing, @p name in @p scope; an item
+// blocked on SLN_UTILS_SYM_NONE can never bind
+typedef struct {
+    sln_sema_scope_t scope;
+    sln_utils_sym_t name;
+    bool lookup;                /**< First segment, looked up from @p scope outwards */
+} _sln_sema_block_t;
+
+// sln_sema_resolve() of an item's path, telling where it stopped
+static sln_sema_id_t _resolve_item(const sln_sema_symbols_t* table, const _sln_sema_pending_t* item,
+                                   _sln_sema_block_t* block) {
+    const sln_utils_sym_t* path = table->paths + item->path;
+    sln_sema_id_t id = sln_sema_lookup(table, item->scope, item->file, path[0]);
+    *block = (_sln_sema_block_t){ item->scope, path[0], true };
+    for (uint32_t i = 1; i < item->path_len && id != SLN_SEMA_NONE; i++) {
+        sln_sema_scope_t inner = table->entries[id].scope;
+        *block = (_sln_sema_block_t){ inner, inner == SLN_SEMA_ROOT ? SLN_UTILS_SYM_NONE : path[i], false };
+        id = inner == SLN_SEMA_ROOT ? SLN_SEMA_NONE : sln_sema_member(table, inner, path[i]);
+    }
+    return id;
+}
+
+// Parks item @p index on @p name in @p scope and in its views
+static void _park_visible(sln_sema_symbols_t* table, uint32_t index, sln_sema_scope_t scope, sln_utils_sym_t name) {
+    _park(table, table->worklist, index, scope, name);
+    for (uint32_t v = table->scopes[scope].first_view; v; v = table->views[v - 1].next) {
+        _park(table, table->worklist, index, table->views[v - 1].target, name);
+    }
+}
+
+// Parks item @p index on every key whose declaration may unblock it;
+// a lookup waits in each scope sln_sema_lookup() searches
+static void _park_item(sln_sema_symbols_t* table, uint32_t index, const _sln_sema_block_t* block) {
+    if (!block->lookup) {
+        _park(table, table->worklist, index, block->scope, block->name);
+        return;
+    }
+    sln_sema_scope_t scope = block->scope;
+    sln_sema_scope_t file = table->pending[index].file;
+    for (;;) {
+        if (scope == file) file = SLN_SEMA_ROOT;
+        if (scope == SLN_SEMA_ROOT && file != SLN_SEMA_ROOT) _park_visible(table, index, file, block->name);
+        _park_visible(table, index, scope, block->name);
+        if (scope == SLN_SEMA_ROOT) return;
+        scope = table->scopes[scope].parent;
+    }
+}
+
+// Binds one pending item if its path resolves; returns whether it is
+// done, else where it is blocked
+static bool _bind(sln_sema_symbols_t* table, _sln_sema_pending_t* item, _sln_sema_block_t* block,
+                  sln_sema_error_t* status, FILE* error_stream) {
+    sln_sema_id_t target = _resolve_item(table, item, block);
+    if (target == SLN_SEMA_NONE) return false;
+    // Points are declared by sln_sema_collect() only, and scopes never change
+    block->name = SLN_UTILS_SYM_NONE;
+    if (item->extend) {
+        sln_sema_id_t point = sln_sema_ext_point(table, target, item->name);
+        if (point == SLN_SEMA_NONE) return false;
+        _bind_extend(table, item, point, status, error_stream);
+        return true;
+    }
+
+    sln_sema_scope_t inner = table->entries[target].scope;
+    sln_sema_error_t error = SLN_SEMA_OK;
+    if (item->glob || item->func) {
+        // Only namespaces and enums have names to import or functions to hold
+        if (inner == SLN_SEMA_ROOT) return false;
+        if (item->glob) {
+            if (!sln_sema_import(table, item->scope, inner)) error = SLN_SEMA_ALLOCATION_FAILED;
+        } else {
+            sln_sema_id_t id;
+            error = sln_sema_declare(table, inner, SLN_SEMA_FUNC, item->name, false, item->unit, item->node, &id);
+        }
+    } else {
+        error = sln_sema_alias(table, item->scope, item->name, target, item->unit, item->node);
+    }
+    if (error != SLN_SEMA_OK && *status == SLN_SEMA_OK) *status = error;
+    if (error == SLN_SEMA_DUPLICATE) {
+        _report_at(SLN_MSG_SEMA_DUPLICATE, sln_utils_intern_get(table->symbols, item->name, NULL),
+                   item->location, error_stream);
+    }
+    return true;
+}
+
+// Writes `a::b::c` to @p out, cut short if too long
+static void _path_text(const sln_sema_symbols_t* table, const _sln_sema_pending_t* item, char* out, size_t size) {
+    size_t len = 0;
+    out[0] = '\0';
+    uint32_t count = item->path_len + item->func;
+    for (uint32_t i = 0; i < count && len < size; i++) {
+        const char* segment = sln_utils_intern_get(table->symbols, table->paths[item->path + i], NULL);
+        int written = snprintf(out + len, size - len, "%s%s", i ? "::" : "", segment ? segment : "?");
+        if (written < 0) break;
+        len += (size_t)written;
+    }
+    if (item->extend && len < size) {
+        const char* point = sln_utils_intern_get(table->symbols, item->name, NULL);
+        snprintf(out + len, size - len, "@%s", point ? point : "?");
+    }
+}
+
+// Groups the bound extension names by point into ext_ids, ordered by
+// unit then source order within each point: two stable counting sorts,
+// by unit then by point. Returns the member index of every id, or NULL
+// on allocation failure
+static uint32_t* _index_extensions(sln_sema_symbols_t* table) {
+    sln_utils_free(table->ext_offsets);
+    sln_utils_free(table->ext_ids);
+    table->ext_ids = NULL;
+    table->ext_offsets = SLN_ALLOC((size_t)table->point_len + 1, uint32_t);
+    uint32_t* unit_offsets = SLN_ALLOC(table->unit_cap + 1, uint32_t);
+    uint32_t* by_unit = SLN_ALLOC(table->member_len + 1, uint32_t);
+    uint32_t* order = SLN_ALLOC(table->member_len + 1, uint32_t);
+    table->ext_ids = SLN_ALLOC(table->member_len + 1, sln_sema_id_t);
+    if (!table->ext_offsets || !unit_offsets || !by_unit || !order || !table->ext_ids) {
+        sln_utils_free(unit_offsets);
+        sln_utils_free(by_unit);
+        sln_utils_free(order);
+        return NULL;
+    }
+
+    uint32_t bound = 0;
+    for (uint32_t i = 0; i < table->member_len; i++) {
+        if (table->members[i].id) unit_offsets[table->members[i].unit + 1]++;
+    }
+    for (size_t u = 0; u < table->unit_cap; u++) unit_offsets[u + 1] += unit_offsets[u];
+    for (uint32_t i = 0; i < table->member_len; i++) {
+        if (!table->members[i].id) continue;
+        by_unit[unit_offsets[table->members[i].unit]++] = i;
+        bound++;
+    }
+
+    uint32_t* offsets = table->ext_offsets;
+    for (uint32_t i = 0; i < bound; i++) {
+        const sln_sema_entry_t* point = &table->entries[table->entries[table->members[by_unit[i]].id].target];
+        offsets[point->target + 1]++;
+    }
+    for (uint32_t p = 0; p < table->point_len; p++) offsets[p + 1] += offsets[p];
+    for (uint32_t i = 0; i < bound; i++) {
+        const _sln_sema_member_t* member = &table->members[by_unit[i]];
+        uint32_t p = table->entries[table->entries[member->id].target].target;
+        order[offsets[p]] = by_unit[i];
+        table->ext_ids[offsets[p]++] = member->id;
+    }
+    // The scatter moved every offset to the start of the next point
+    memmove(offsets + 1, offsets, table->point_len * sizeof(*offsets));
+    offsets[0] = 0;
+
+    sln_utils_free(unit_offsets);
+    sln_utils_free(by_unit);
+    return order;
+}
+
+// Next value, counting up from the last known one
+static void _number(sln_sema_entry_t* entry, int64_t* next, bool* known) {
+    if (*known) {
+        entry->value = *next;
+        entry->flags |= SLN_SEMA_FLAG_VALUED;
+    }
+    if (*next == INT64_MAX) *known = false;
+    else (*next)++;
+}
+
+// Adds @p id to the set of values of one enum; returns false if the
+// value is already there
+static bool _claim(const sln_sema_symbols_t* table, sln_sema_id_t* set, uint32_t mask, sln_sema_id_t id) {
+    int64_t value = table->entries[id].value;
+    uint64_t hash = (uint64_t)value * 0x9E3779B97F4A7C15u;
+    uint32_t i = (uint32_t)(hash >> 32) & mask;
+    for (; set[i] != SLN_SEMA_NONE; i = (i + 1) & mask) {
+        if (table->entries[set[i]].value == value) return false;
+    }
+    set[i] = id;
+    return true;
+}
+
+// Reports the extension names of an enum whose value an explicit or
+// earlier one already holds
+static sln_sema_error_t _check_values(sln_sema_symbols_t* table, const _sln_sema_layout_t* layout,
+                                      const uint32_t* order, sln_sema_id_t** set, size_t* set_cap, FILE* error_stream) {
+    const sln_sema_id_t* items = table->layout_items + layout->first;
+    size_t count = layout->len;
+    for (uint32_t i = 0; i < layout->len; i++) {
+        const sln_sema_entry_t* item = &table->entries[items[i]];
+        if (item->kind == SLN_SEMA_EXT_POINT) count += table->ext_offsets[item->target + 1] - table->ext_offsets[item->target];
+    }
+    size_t cap = SLN_SEMA_INITIAL_SIZE;
+    while (cap < count * 2) cap *= SLN_SEMA_GROW_FACTOR;
+    if (cap > *set_cap) {
+        sln_utils_free(*set);
+        *set_cap = 0;
+        if (!(*set = SLN_ALLOC(cap, sln_sema_id_t))) return SLN_SEMA_ALLOCATION_FAILED;
+        *set_cap = cap;
+    } else {
+        memset(*set, 0, cap * sizeof(**set));
+    }
+    uint32_t mask = (uint32_t)cap - 1;
+
+    // The enum's own enumerators first, so the extension's are the ones reported
+    for (uint32_t i = 0; i < layout->len; i++) {
+        const sln_sema_entry_t* item = &table->entries[items[i]];
+        if (item->kind == SLN_SEMA_ENUMERATOR && (item->flags & SLN_SEMA_FLAG_VALUED)) _claim(table, *set, mask, items[i]);
+    }
+    sln_sema_error_t status = SLN_SEMA_OK;
+    for (uint32_t i = 0; i < layout->len; i++) {
+        const sln_sema_entry_t* item = &table->entries[items[i]];
+        if (item->kind != SLN_SEMA_EXT_POINT) continue;
+        for (uint32_t k = table->ext_offsets[item->target]; k < table->ext_offsets[item->target + 1]; k++) {
+            const _sln_sema_member_t* member = &table->members[order[k]];
+            if (!(table->entries[member->id].flags & SLN_SEMA_FLAG_VALUED) || _claim(table, *set, mask, member->id)) {
+                continue;
+            }
+            _report_at(SLN_MSG_SEMA_VALUE_CONFLICT, sln_utils_intern_get(table->symbols, member->name, NULL),
+                       member->location, error_stream);
+            status = SLN_SEMA_VALUE_CONFLICT;
+        }
+    }
+    return status;
+}
+
+// Numbers every enum: its enumerators in source order, each point's
+// extension names in its place
+static sln_sema_error_t _assign_values(sln_sema_symbols_t* table, const uint32_t* order, FILE* error_stream) {
+    sln_sema_error_t status = SLN_SEMA_OK;
+    sln_sema_id_t* set = NULL;
+    size_t set_cap = 0;
+    for (size_t l = 0; l < table->layout_len && status != SLN_SEMA_ALLOCATION_FAILED; l++) {
+        const _sln_sema_layout_t* layout = &table->layouts[l];
+        const sln_sema_id_t* items = table->layout_items + layout->first;
+        int64_t next = 0;
+        bool known = true;
+        bool extended = false;
+        for (uint32_t i = 0; i < layout->len; i++) {
+            sln_sema_entry_t* item = &table->entries[items[i]];
+            if (item->kind == SLN_SEMA_EXT_POINT) {
+                for (uint32_t k = table->ext_offsets[item->target]; k < table->ext_offsets[item->target + 1]; k++) {
+                    _number(&table->entries[table->ext_ids[k]], &next, &known);
+                    extended = true;
+                }
+            } else if (item->flags & SLN_SEMA_FLAG_EXPLICIT) {
+                known = (item->flags & SLN_SEMA_FLAG_VALUED) != 0;
+                next = item->value;
+                _number(item, &next, &known);
+            } else {
+                _number(item, &next, &known);
+            }
+        }
+        // Counting up never repeats a value; only explicit ones can
+        if (!extended || !layout->explicit_values) continue;
+        sln_sema_error_t error = _check_values(table, layout, order, &set, &set_cap, error_stream);
+        if (error != SLN_SEMA_OK && status == SLN_SEMA_OK) status = error;
+    }
+    sln_utils_free(set);
+    return status;
+}
+
+static void _worklist_free(_sln_sema_worklist_t* list) {
+    sln_utils_free(list->ready);
+    sln_utils_free(list->keys);
+    sln_utils_free(list->slots);
+    sln_utils_free(list->waits);
+    sln_utils_free(list->scope_keys);
+}
+
+// Binds the pending items from a worklist: each is tried in source order,
+// and one that does not resolve waits until the name it misses is
+// declared, so every item is retried only when it may bind
+static sln_sema_error_t _bind_pending(sln_sema_symbols_t* table, FILE* error_stream) {
+    _sln_sema_worklist_t list = { .mask = SLN_SEMA_INITIAL_SIZE - 1, .scope_len = table->scope_len };
+    list.slots = SLN_ALLOC(SLN_SEMA_INITIAL_SIZE, uint32_t);
+    list.scope_keys = SLN_ALLOC(table->scope_len, uint32_t);
+    if (!list.slots || !list.scope_keys || table->pending_len > UINT32_MAX) {
+        _worklist_free(&list);
+        return SLN_SEMA_ALLOCATION_FAILED;
+    }
+    table->worklist = &list;
+    for (size_t i = 0; i < table->pending_len; i++) _ready(table, &list, (uint32_t)i);
+
+    sln_sema_error_t status = SLN_SEMA_OK;
+    while (list.ready_head < list.ready_len && !list.failed && status != SLN_SEMA_ALLOCATION_FAILED) {
+        uint32_t index = list.ready[list.ready_head++];
+        _sln_sema_pending_t* item = &table->pending[index];
+        item->queued = false;
+        // Queued again by what its own binding declared, or by a stale wait
+        if (item->done) continue;
+        _sln_sema_block_t block;
+        if (_bind(table, item, &block, &status, error_stream)) {
+            item->done = true;
+        } else if (block.name != SLN_UTILS_SYM_NONE) {
+            _park_item(table, index, &block);
+        }
+    }
+    table->worklist = NULL;
+    if (list.failed) status = SLN_SEMA_ALLOCATION_FAILED;
+    _worklist_free(&list);
+    return status;
+}
+
+sln_sema_error_t sln_sema_bind(sln_sema_symbols_t* table, FILE* error_stream) {
+    if (!table) return SLN_SEMA_NO_TABLE;
+    if (!error_stream) return SLN_SEMA_NO_ERROR_STREAM;
+    SLN_TRACE_SCOPE("sema.bind", NULL);
+
+    sln_sema_error_t status = _bind_pending(table, error_stream);
+
+    for (size_t i = 0; i < table->pending_len; i++) {
+        _sln_sema_pending_t* item = &table->pending[i];
+        if (item->done) continue;
+        char text[SLN_SEMA_PATH_TEXT];
+        _path_text(table, item, text, sizeof(text));
+        _report_at(SLN_MSG_SEMA_UNRESOLVED, text, item->location, error_stream);
+        if (status == SLN_SEMA_OK) status = SLN_SEMA_UNRESOLVED;
+        item->done = true;
+    }
+    if (status == SLN_SEMA_ALLOCATION_FAILED) return status;
+
+    uint32_t* order = _index_extensions(table);
+    if (!order) return SLN_SEMA_ALLOCATION_FAILED;
+    sln_sema_error_t error = _assign_values(table, order, error_stream);
+    sln_utils_free(order);
+    return status == SLN_SEMA_OK || error == SLN_SEMA_ALLOCATION_FAILED ? error : status;
+}
@@ -0,0 +1,336 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <utils/alloc_stats.h>
+
+// Live heap blocks are found again on release through a pointer map
+// split into locked shards. The profiler's own memory comes straight
+// from calloc so that it does not profile itself.
+#define SLN_ALLOC_STATS_SHARD_BITS 6
+#define SLN_ALLOC_STATS_SHARDS (1u << SLN_ALLOC_STATS_SHARD_BITS)
+#define SLN_ALLOC_STATS_INITIAL_SLOTS 256u
+#define SLN_ALLOC_STATS_OTHER (SLN_UTILS_ALLOC_STATS_MAX_SITES - 1)
+
+typedef struct {
+    _Atomic(const char*) function;  /**< NULL marks a free entry */
+    const char* arena;
+    atomic_size_t count;
+    atomic_size_t bytes;
+    atomic_size_t live;
+    atomic_size_t peak;
+    atomic_size_t histogram[SLN_UTILS_ALLOC_STATS_BUCKETS];
+} _sln_alloc_site_t;
+
+typedef struct {
+    uintptr_t ptr;                  /**< 0 marks an empty slot */
+    size_t bytes;
+    uint32_t site;
+} _sln_alloc_live_t;
+
+typedef struct {
+    mtx_t lock;
+    _sln_alloc_live_t* slots;
+    size_t cap;
+    size_t count;
+} _sln_alloc_shard_t;
+
+atomic_bool sln_utils_alloc_stats_active = false;
+
+static _sln_alloc_site_t _sites[SLN_UTILS_ALLOC_STATS_MAX_SITES];
+static mtx_t _sites_lock;
+static _sln_alloc_shard_t _shards[SLN_ALLOC_STATS_SHARDS];
+static atomic_size_t _total_live;
+static atomic_size_t _total_peak;
+
+static const char* const _bucket_names[SLN_UTILS_ALLOC_STATS_BUCKETS] = {
+    "<=16", "<=64", "<=256", "<=1K", "<=4K", "<=16K", "<=64K", "<=256K", "<=1M", ">1M"
+};
+
+// Bucket k holds sizes up to 16 * 4^k
+static unsigned _bucket(size_t bytes) {
+    if (bytes <= 16) return 0;
+    unsigned bits = 64u - (unsigned)__builtin_clzll((unsigned long long)(bytes - 1));
+    unsigned bucket = (bits - 3u) / 2u;
+    return bucket < SLN_UTILS_ALLOC_STATS_BUCKETS ? bucket : SLN_UTILS_ALLOC_STATS_BUCKETS - 1;
+}
+
+static void _raise(atomic_size_t* peak, size_t value) {
+    size_t seen = atomic_load_explicit(peak, memory_order_relaxed);
+    while (seen < value &&
+           !atomic_compare_exchange_weak_explicit(peak, &seen, value, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static inline uint64_t _mix(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    return key;
+}
+
+static bool _same_arena(const char* a, const char* b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+static uint32_t _site(const char* function, const char* arena) {
+    // Arena names are compared by text, so only the function picks the start
+    uint64_t hash = _mix((uint64_t)(uintptr_t)function);
+    uint32_t start = (uint32_t)(hash % SLN_ALLOC_STATS_OTHER);
+
+    for (bool locked = false;; locked = true) {
+        for (uint32_t i = 0; i < SLN_ALLOC_STATS_OTHER; i++) {
+            uint32_t index = (start + i) % SLN_ALLOC_STATS_OTHER;
+            _sln_alloc_site_t* site = &_sites[index];
+            const char* seen = atomic_load_explicit(&site->function, memory_order_acquire);
+            if (seen == function && _same_arena(site->arena, arena)) {
+                if (locked) mtx_unlock(&_sites_lock);
+                return index;
+            }
+            if (seen) continue;
+            if (!locked) break;
+
+            site->arena = arena;
+            atomic_store_explicit(&site->function, function, memory_order_release);
+            mtx_unlock(&_sites_lock);
+            return index;
+        }
+        if (locked) {
+            mtx_unlock(&_sites_lock);
+            return SLN_ALLOC_STATS_OTHER;
+        }
+        // Claim an entry under the lock, after looking again
+        mtx_lock(&_sites_lock);
+    }
+}
+
+static _sln_alloc_shard_t* _shard(uintptr_t ptr, uint64_t* out_hash) {
+    *out_hash = _mix((uint64_t)ptr);
+    return &_shards[*out_hash >> (64 - SLN_ALLOC_STATS_SHARD_BITS)];
+}
+
+static bool _shard_grow(_sln_alloc_shard_t* shard) {
+    size_t cap = shard->cap ? shard->cap * 2 : SLN_ALLOC_STATS_INITIAL_SLOTS;
+    _sln_alloc_live_t* slots = calloc(cap, sizeof(*slots));
+    if (!slots) return false;
+    for (size_t i = 0; i < shard->cap; i++) {
+        if (!shard->slots[i].ptr) continue;
+        size_t index = (size_t)_mix((uint64_t)shard->slots[i].ptr) & (cap - 1);
+        while (slots[index].ptr) index = (index + 1) & (cap - 1);
+        slots[index] = shard->slots[i];
+    }
+    free(shard->slots);
+    shard->slots = slots;
+    shard->cap = cap;
+    return true;
+}
+
+// Removes `ptr` from a locked shard; returns false if it is not there
+static bool _shard_take(_sln_alloc_shard_t* shard, uint64_t hash, uintptr_t ptr, _sln_alloc_live_t* out) {
+    if (!shard->cap) return false;
+    size_t mask = shard->cap - 1;
+    size_t index = (size_t)hash & mask;
+    while (shard->slots[index].ptr != ptr) {
+        if (!shard->slots[index].ptr) return false;
+        index = (index + 1) & mask;
+    }
+    *out = shard->slots[index];
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    for (size_t next = (index + 1) & mask; shard->slots[next].ptr; next = (next + 1) & mask) {
+        size_t home = (size_t)_mix((uint64_t)shard->slots[next].ptr) & mask;
+        if (((next - home) & mask) >= ((next - index) & mask)) {
+            shard->slots[index] = shard->slots[next];
+            index = next;
+        }
+    }
+    shard->slots[index].ptr = 0;
+    shard->count--;
+    return true;
+}
+
+static void _forget(const _sln_alloc_live_t* entry) {
+    atomic_fetch_sub_explicit(&_sites[entry->site].live, entry->bytes, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&_total_live, entry->bytes, memory_order_relaxed);
+}
+
+void sln_utils_alloc_stats_record(const void* ptr, size_t bytes,
+                                  const char* function_info, const char* arena) {
+    uint32_t index = _site(function_info ? function_info : "?", arena);
+    _sln_alloc_site_t* site = &_sites[index];
+    atomic_fetch_add_explicit(&site->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&site->bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&site->histogram[_bucket(bytes)], 1, memory_order_relaxed);
+    if (!ptr) return;
+
+    uint64_t hash;
+    uintptr_t key = (uintptr_t)ptr;
+    _sln_alloc_shard_t* shard = _shard(key, &hash);
+    _sln_alloc_live_t stale;
+    mtx_lock(&shard->lock);
+    // A block released with plain free() may come back at the same address
+    bool had_stale = _shard_take(shard, hash, key, &stale);
+    bool tracked = (shard->count + 1) * 2 <= shard->cap || _shard_grow(shard);
+    if (tracked) {
+        size_t slot = (size_t)hash & (shard->cap - 1);
+        while (shard->slots[slot].ptr) slot = (slot + 1) & (shard->cap - 1);
+        shard->slots[slot] = (_sln_alloc_live_t){ key, bytes, index };
+        shard->count++;
+    }
+    mtx_unlock(&shard->lock);
+    if (had_stale) _forget(&stale);
+    if (!tracked) return;
+
+    _raise(&site->peak, atomic_fetch_add_explicit(&site->live, bytes, memory_order_relaxed) + bytes);
+    _raise(&_total_peak, atomic_fetch_add_explicit(&_total_live, bytes, memory_order_relaxed) + bytes);
+}
+
+void sln_utils_alloc_stats_release(const void* ptr) {
+    if (!ptr) return;
+
+    uint64_t hash;
+    _sln_alloc_shard_t* shard = _shard((uintptr_t)ptr, &hash);
+    _sln_alloc_live_t entry;
+    mtx_lock(&shard->lock);
+    bool found = _shard_take(shard, hash, (uintptr_t)ptr, &entry);
+    mtx_unlock(&shard->lock);
+    if (found) _forget(&entry);
+}
+
+bool sln_utils_alloc_stats_enable(void) {
+    if (atomic_load(&sln_utils_alloc_stats_active)) return true;
+
+    if (mtx_init(&_sites_lock, mtx_plain) != thrd_success) return false;
+    for (size_t i = 0; i < SLN_ALLOC_STATS_SHARDS; i++) {
+        if (mtx_init(&_shards[i].lock, mtx_plain) != thrd_success) {
+            while (i-- > 0) mtx_destroy(&_shards[i].lock);
+            mtx_destroy(&_sites_lock);
+            return false;
+        }
+    }
+    atomic_store(&_sites[SLN_ALLOC_STATS_OTHER].function, "<other>");
+    atomic_store(&sln_utils_alloc_stats_active, true);
+    return true;
+}
+
+void sln_utils_alloc_stats_disable(void) {
+    if (!atomic_exchange(&sln_utils_alloc_stats_active, false)) return;
+
+    for (size_t i = 0; i < SLN_ALLOC_STATS_SHARDS; i++) {
+        free(_shards[i].slots);
+        mtx_destroy(&_shards[i].lock);
+    }
+    mtx_destroy(&_sites_lock);
+    memset(_shards, 0, sizeof(_shards));
+    memset(_sites, 0, sizeof(_sites));
+    atomic_store(&_total_live, 0);
+    atomic_store(&_total_peak, 0);
+}
+
+static int _compare_sites(const void* a, const void* b) {
+    const _sln_alloc_site_t* x = *(const _sln_alloc_site_t* const*)a;
+    const _sln_alloc_site_t* y = *(const _sln_alloc_site_t* const*)b;
+    size_t x_peak = atomic_load(&x->peak), y_peak = atomic_load(&y->peak);
+    if (x_peak != y_peak) return x_peak < y_peak ? 1 : -1;
+    size_t x_bytes = atomic_load(&x->bytes), y_bytes = atomic_load(&y->bytes);
+    if (x_bytes != y_bytes) return x_bytes < y_bytes ? 1 : -1;
+    return 0;
+}
+
+static void _print_table(FILE* stream, _sln_alloc_site_t** sites, size_t count,
+                         size_t total_count, size_t total_bytes) {
+    fprintf(stream, "%-28s %-10s %10s %14s %14s", "site", "arena", "count", "bytes", "peak live");
+    for (unsigned b = 0; b < SLN_UTILS_ALLOC_STATS_BUCKETS; b++) fprintf(stream, " %8s", _bucket_names[b]);
+    fputc('\n', stream);
+
+    for (size_t i = 0; i < count; i++) {
+        const _sln_alloc_site_t* site = sites[i];
+        fprintf(stream, "%-28s %-10s %10zu %14zu ",
+                atomic_load(&site->function), site->arena ? site->arena : "heap",
+                atomic_load(&site->count), atomic_load(&site->bytes));
+        if (site->arena && atomic_load(&site->peak) == 0) {
+            fprintf(stream, "%14s", "-");
+        } else {
+            fprintf(stream, "%14zu", atomic_load(&site->peak));
+        }
+        for (unsigned b = 0; b < SLN_UTILS_ALLOC_STATS_BUCKETS; b++) {
+            fprintf(stream, " %8zu", atomic_load(&site->histogram[b]));
+        }
+        fputc('\n', stream);
+    }
+    fprintf(stream, "%-28s %-10s %10zu %14zu %14zu\n", "total", "", total_count, total_bytes,
+            atomic_load(&_total_peak));
+}
+
+static void _print_json(FILE* stream, _sln_alloc_site_t** sites, size_t count,
+                        size_t total_count, size_t total_bytes) {
+    fputs("{\"sites\":[", stream);
+    for (size_t i = 0; i < count; i++) {
+        const _sln_alloc_site_t* site = sites[i];
+        fprintf(stream, "%s{\"site\":\"%s\",\"arena\":", i ? "," : "", atomic_load(&site->function));
+        if (site->arena) {
+            fprintf(stream, "\"%s\"", site->arena);
+        } else {
+            fputs("null", stream);
+        }
+        fprintf(stream, ",\"count\":%zu,\"bytes\":%zu,\"peak_live\":",
+                atomic_load(&site->count), atomic_load(&site->bytes));
+        if (site->arena && atomic_load(&site->peak) == 0) {
+            fputs("null", stream);
+        } else {
+            fprintf(stream, "%zu", atomic_load(&site->peak));
+        }
+        fputs(",\"histogram\":[", stream);
+        for (unsigned b = 0; b < SLN_UTILS_ALLOC_STATS_BUCKETS; b++) {
+            fprintf(stream, "%s%zu", b ? "," : "", atomic_load(&site->histogram[b]));
+        }
+        fputs("]}", stream);
+    }
+    fputs("],\"buckets\":[", stream);
+    for (unsigned b = 0; b < SLN_UTILS_ALLOC_STATS_BUCKETS; b++) {
+        fprintf(stream, "%s\"%s\"", b ? "," : "", _bucket_names[b]);
+    }
+    fprintf(stream, "],\"total\":{\"count\":%zu,\"bytes\":%zu,\"peak_live\":%zu}}\n",
+            total_count, total_bytes, atomic_load(&_total_peak));
+}
+
+// Arena objects are carved from blocks that are already counted, and
+// only blocks are live-tracked, so totals take blocks and skip objects
+static bool _is_arena_object_site(const _sln_alloc_site_t* site) {
+    return site->arena && strcmp(atomic_load(&site->function), SLN_UTILS_ALLOC_STATS_ARENA_BLOCKS) != 0;
+}
+
+void sln_utils_alloc_stats_totals(size_t* count, size_t* bytes, size_t* peak_live) {
+    size_t total_count = 0;
+    size_t total_bytes = 0;
+    for (size_t i = 0; i < SLN_UTILS_ALLOC_STATS_MAX_SITES; i++) {
+        const _sln_alloc_site_t* site = &_sites[i];
+        if (!atomic_load(&site->function) || _is_arena_object_site(site)) continue;
+        total_count += atomic_load(&site->count);
+        total_bytes += atomic_load(&site->bytes);
+    }
+    if (count) *count = total_count;
+    if (bytes) *bytes = total_bytes;
+    if (peak_live) *peak_live = atomic_load(&_total_peak);
+}
+
+void sln_utils_alloc_stats_print(FILE* stream, sln_utils_alloc_stats_format_t format) {
+    _sln_alloc_site_t* sites[SLN_UTILS_ALLOC_STATS_MAX_SITES];
+    size_t count = 0;
+    for (size_t i = 0; i < SLN_UTILS_ALLOC_STATS_MAX_SITES; i++) {
+        _sln_alloc_site_t* site = &_sites[i];
+        if (!atomic_load(&site->function) || atomic_load(&site->count) == 0) continue;
+        sites[count++] = site;
+    }
+    qsort(sites, count, sizeof(*sites), _compare_sites);
+
+    size_t total_count;
+    size_t total_bytes;
+    sln_utils_alloc_stats_totals(&total_count, &total_bytes, NULL);
+    if (format == SLN_UTILS_ALLOC_STATS_JSON) {
+        _print_json(stream, sites, count, total_count, total_bytes);
+    } else {
+        _print_table(stream, sites, count, total_count, total_bytes);
+    }
+}
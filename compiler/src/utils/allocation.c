@@ -1,9 +1,12 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 
 #include <utils/exit_codes.h>
 #include <utils/allocation.h>
+#include <utils/alloc_stats.h>
 #include <utils/cli_colors.h>
 
 static FILE *_sln_utils_error_stream = NULL;
@@ -15,27 +18,143 @@ int sln_utils_alloc_set_stream(FILE* error_stream) {
     return 0;
 }
 
+static void _report_failure(size_t total_bytes, const char* function_info, const char* arena_name) {
+    if (!_sln_utils_error_stream) return;
+
+    sln_utils_cli_color_set(_sln_utils_error_stream, SLN_UTILS_CLI_COLOR_WHITE);
+    fputs("[", _sln_utils_error_stream);
+
+    sln_utils_cli_color_set(_sln_utils_error_stream, SLN_UTILS_CLI_COLOR_LIGHTRED);
+    fputs("Internal error", _sln_utils_error_stream);
+
+    sln_utils_cli_color_set(_sln_utils_error_stream, SLN_UTILS_CLI_COLOR_WHITE);
+    fprintf(_sln_utils_error_stream, "]: Allocation failure (%zu bytes) in %s", total_bytes, function_info);
+    if (arena_name) fprintf(_sln_utils_error_stream, " (arena %s)", arena_name);
+    fputs(".\n", _sln_utils_error_stream);
+
+    fflush(_sln_utils_error_stream);
+}
+
 void* sln_utils_alloc(size_t num, size_t size_of_element, const char* function_info) {
     
     void* buff = calloc(num, size_of_element);
     if (buff != NULL) {
+        if (sln_utils_alloc_stats_on()) {
+            sln_utils_alloc_stats_record(buff, num * size_of_element, function_info, NULL);
+        }
         return buff;
     }
 
-    size_t total_bytes = num * size_of_element;
+    _report_failure(num * size_of_element, function_info, NULL);
+    return NULL;
+}
 
-    if (_sln_utils_error_stream) {
-        sln_utils_cli_color_set(_sln_utils_error_stream, SLN_UTILS_CLI_COLOR_WHITE);
-        fputs("[", _sln_utils_error_stream);
+void sln_utils_free(void* ptr) {
+    if (sln_utils_alloc_stats_on()) sln_utils_alloc_stats_release(ptr);
+    free(ptr);
+}
+
+// Block header padded to the block alignment, so `data` is aligned too
+struct sln_utils_arena_block {
+    struct sln_utils_arena_block* next;
+    size_t cap;
+    size_t used;
+    _Alignas(SLN_UTILS_ARENA_ALIGNMENT) unsigned char data[];
+};
 
-        sln_utils_cli_color_set(_sln_utils_error_stream, SLN_UTILS_CLI_COLOR_LIGHTRED);
-        fputs("Internal error", _sln_utils_error_stream);
+static inline size_t _align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
 
-        sln_utils_cli_color_set(_sln_utils_error_stream, SLN_UTILS_CLI_COLOR_WHITE);
-        fprintf(_sln_utils_error_stream, "]: Allocation failure (%zu bytes) in %s.\n", total_bytes, function_info);
+void sln_utils_arena_init(sln_utils_arena_t* arena, const char* name, size_t block_size) {
+    arena->name = name;
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size ? _align_up(block_size, SLN_UTILS_ARENA_ALIGNMENT)
+                                   : SLN_UTILS_ARENA_BLOCK_SIZE;
+}
 
-        fflush(_sln_utils_error_stream);
+// Moves to a block with `bytes` free: the kept block after the current
+// one if it is big enough, otherwise a new block linked in after it.
+// Regular blocks always fit a regular request, so only an oversized
+// kept block can be too small; it is replaced rather than piled up.
+static sln_utils_arena_block_t* _next_block(sln_utils_arena_t* arena, size_t bytes) {
+    sln_utils_arena_block_t* last = arena->current;
+    sln_utils_arena_block_t* kept = last ? last->next : NULL;
+    if (kept && kept->cap >= bytes) {
+        kept->used = 0;
+        return arena->current = kept;
     }
 
-    return NULL;
+    size_t cap = bytes > arena->block_size ? _align_up(bytes, SLN_UTILS_ARENA_ALIGNMENT) : arena->block_size;
+    if (cap < bytes) return NULL;
+    sln_utils_arena_block_t* block = aligned_alloc(SLN_UTILS_ARENA_ALIGNMENT, sizeof(*block) + cap);
+    if (!block) return NULL;
+    if (sln_utils_alloc_stats_on()) {
+        sln_utils_alloc_stats_record(block, sizeof(*block) + cap, SLN_UTILS_ALLOC_STATS_ARENA_BLOCKS, arena->name);
+    }
+    block->cap = cap;
+    block->used = 0;
+    if (kept && kept->cap > arena->block_size) {
+        block->next = kept->next;
+        sln_utils_free(kept);
+    } else {
+        block->next = kept;
+    }
+    if (last) {
+        last->next = block;
+    } else {
+        arena->first = block;
+    }
+    return arena->current = block;
+}
+
+void* sln_utils_arena_alloc(sln_utils_arena_t* arena, size_t num, size_t size_of_element,
+                            size_t alignment, bool zero, const char* function_info) {
+    size_t bytes;
+    if (__builtin_mul_overflow(num, size_of_element, &bytes)) {
+        _report_failure(SIZE_MAX, function_info, arena->name);
+        return NULL;
+    }
+
+    sln_utils_arena_block_t* block = arena->current;
+    size_t offset = block ? _align_up(block->used, alignment) : 0;
+    if (!block || offset > block->cap || bytes > block->cap - offset) {
+        block = _next_block(arena, bytes);
+        if (!block) {
+            _report_failure(bytes, function_info, arena->name);
+            return NULL;
+        }
+        offset = 0;
+    }
+
+    void* result = block->data + offset;
+    block->used = offset + bytes;
+    if (zero) memset(result, 0, bytes);
+    if (sln_utils_alloc_stats_on()) sln_utils_alloc_stats_record(NULL, bytes, function_info, arena->name);
+    return result;
+}
+
+void sln_utils_arena_reset(sln_utils_arena_t* arena) {
+    // Later blocks are emptied when the arena reaches them again
+    arena->current = arena->first;
+    if (arena->first) arena->first->used = 0;
+}
+
+void sln_utils_arena_free(sln_utils_arena_t* arena) {
+    for (sln_utils_arena_block_t* block = arena->first; block;) {
+        sln_utils_arena_block_t* next = block->next;
+        sln_utils_free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+size_t sln_utils_arena_reserved(const sln_utils_arena_t* arena) {
+    size_t total = 0;
+    for (const sln_utils_arena_block_t* block = arena->first; block; block = block->next) {
+        total += sizeof(*block) + block->cap;
+    }
+    return total;
 }
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -43,7 +44,8 @@ static bool vec_push(args_vec_t* v, sln_input_arg_t const* x) {
 
 static void free_one(sln_input_arg_t* a) {
     if (a && a->cstr) {
-        free((void*)a->cstr);
+        // cstr always comes from sln_strdup()
+        sln_utils_free((void*)(uintptr_t)a->cstr);
         a->cstr = NULL;
     }
 }
@@ -85,6 +87,35 @@ static bool parse_func_value(const char* v, sln_input_arg_func_t* out) {
     return false;
 }
 
+static bool parse_stats_value(const char* v, sln_input_arg_stats_t* out) {
+    if (!v) return false;
+    if (equals_ignore_case(v, "alloc"))      { *out = SLN_IN_ARG_STATS_ALLOC;      return true; }
+    if (equals_ignore_case(v, "alloc-json")) { *out = SLN_IN_ARG_STATS_ALLOC_JSON; return true; }
+    return false;
+}
+
+static bool parse_jobs_value(const char* v, size_t* out) {
+    if (!v || !isdigit((unsigned char)*v)) return false;
+    char* end = NULL;
+    unsigned long long n = strtoull(v, &end, 10);
+    if (*end != '\0' || n == 0 || n > SIZE_MAX) return false;
+    *out = (size_t)n;
+    return true;
+}
+
+static bool push_jobs(args_vec_t* v, const char* val) {
+    sln_input_arg_t a = { .type = SLN_IN_ARG_TYPE_JOBS, .cstr = NULL };
+    if (!parse_jobs_value(val, &a.subtype.jobs)) {
+        fprintf(stderr, "error: invalid job count '%s' (expected a positive number)\n", val);
+        return false;
+    }
+    if (!vec_push(v, &a)) {
+        fprintf(stderr, "error: out of memory while parsing arguments\n");
+        return false;
+    }
+    return true;
+}
+
 // ------- Parser -------
 
 bool input_args_parse(int argc, char* argv[],
@@ -177,6 +208,86 @@ bool input_args_parse(int argc, char* argv[],
                 continue;
             }
 
+            // --time-report
+            if (strcmp(arg, "--time-report") == 0) {
+                sln_input_arg_t a = { .type = SLN_IN_ARG_TYPE_TIME, .cstr = NULL };
+                if (!vec_push(&vec, &a)) goto oom;
+                continue;
+            }
+
+            // --trace[=path]
+            if (match_long_opt(arg, "trace", &val)) {
+                if (!val) {
+                    if (i + 1 >= argc) { fprintf(stderr, "error: --trace requires a value\n"); goto fail; }
+                    val = argv[++i];
+                }
+                sln_input_arg_t a = { .type = SLN_IN_ARG_TYPE_TRACE, .cstr = sln_strdup(val) };
+                if (!a.cstr || !vec_push(&vec, &a)) { free_one(&a); goto oom; }
+                continue;
+            }
+
+            // --parse
+            if (strcmp(arg, "--parse") == 0) {
+                sln_input_arg_t a = { .type = SLN_IN_ARG_TYPE_PARSE, .cstr = NULL };
+                if (!vec_push(&vec, &a)) goto oom;
+                continue;
+            }
+
+            // --pipeline
+            if (strcmp(arg, "--pipeline") == 0) {
+                sln_input_arg_t a = { .type = SLN_IN_ARG_TYPE_PIPELINE, .cstr = NULL };
+                if (!vec_push(&vec, &a)) goto oom;
+                continue;
+            }
+
+            // --cache-dir[=path]
+            if (match_long_opt(arg, "cache-dir", &val)) {
+                if (!val) {
+                    if (i + 1 >= argc) { fprintf(stderr, "error: --cache-dir requires a value\n"); goto fail; }
+                    val = argv[++i];
+                }
+                sln_input_arg_t a = { .type = SLN_IN_ARG_TYPE_CACHE, .cstr = sln_strdup(val) };
+                if (!a.cstr || !vec_push(&vec, &a)) { free_one(&a); goto oom; }
+                continue;
+            }
+
+            // --stats[=alloc|alloc-json]
+            if (match_long_opt(arg, "stats", &val)) {
+                if (!val) {
+                    if (i + 1 >= argc) { fprintf(stderr, "error: --stats requires a value (alloc|alloc-json)\n"); goto fail; }
+                    val = argv[++i];
+                }
+                sln_input_arg_stats_t st;
+                if (!parse_stats_value(val, &st)) {
+                    fprintf(stderr, "error: unknown --stats value '%s' (expected alloc|alloc-json)\n", val);
+                    goto fail;
+                }
+                sln_input_arg_t a = { .type = SLN_IN_ARG_TYPE_STATS, .cstr = NULL };
+                a.subtype.stats = st;
+                if (!vec_push(&vec, &a)) goto oom;
+                continue;
+            }
+
+            // --jobs[=N] / -j N / -jN
+            if (match_long_opt(arg, "jobs", &val)) {
+                if (!val) {
+                    if (i + 1 >= argc) { fprintf(stderr, "error: --jobs requires a value\n"); goto fail; }
+                    val = argv[++i];
+                }
+                if (!push_jobs(&vec, val)) goto fail;
+                continue;
+            }
+            if (arg[1] == 'j') {
+                if (arg[2] != '\0') {
+                    val = arg + 2;
+                } else {
+                    if (i + 1 >= argc) { fprintf(stderr, "error: -j requires a value\n"); goto fail; }
+                    val = argv[++i];
+                }
+                if (!push_jobs(&vec, val)) goto fail;
+                continue;
+            }
+
             // Короткие опции (простые, без кластеризации -xyz)
             if (arg[0] == '-' && arg[1] != '-' && arg[2] == '\0') {
                 char k = arg[1];
@@ -0,0 +1,241 @@
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+#include <utils/allocation.h>
+#include <utils/intern.h>
+
+// Shards are picked by the top hash bits, each has its own lock,
+// open-addressing table and string storage.
+#define SLN_INTERN_SHARD_BITS 6
+#define SLN_INTERN_SHARDS (1u << SLN_INTERN_SHARD_BITS)
+#define SLN_INTERN_INITIAL_SLOTS 64u
+#define SLN_INTERN_STRING_BLOCK 4096u
+
+// Symbol directory: chunk k holds SLN_INTERN_DIR_BASE << k entries,
+// so 32 chunk pointers cover the whole id space and never move.
+#define SLN_INTERN_DIR_BASE_BITS 10
+#define SLN_INTERN_DIR_BASE (1u << SLN_INTERN_DIR_BASE_BITS)
+#define SLN_INTERN_DIR_CHUNKS 32
+
+typedef struct {
+    const char* str;
+    uint32_t len;
+    uint32_t hash;
+} _sln_intern_entry_t;
+
+typedef struct {
+    uint32_t hash;
+    sln_utils_sym_t sym;    /**< SLN_UTILS_SYM_NONE marks an empty slot */
+} _sln_intern_slot_t;
+
+typedef struct _sln_intern_block {
+    struct _sln_intern_block* prev;
+    size_t used;
+    size_t cap;
+    char data[];
+} _sln_intern_block_t;
+
+typedef struct {
+    mtx_t lock;
+    _sln_intern_slot_t* slots;
+    uint32_t mask;
+    uint32_t count;
+    _sln_intern_block_t* block;
+} _sln_intern_shard_t;
+
+struct sln_utils_intern {
+    _sln_intern_shard_t shards[SLN_INTERN_SHARDS];
+    _Atomic(_sln_intern_entry_t*) dir[SLN_INTERN_DIR_CHUNKS];
+    atomic_uint_fast32_t next_sym;
+    atomic_size_t memory;
+};
+
+uint32_t sln_utils_intern_hash(const char* str, size_t len) {
+    uint32_t hash = SLN_UTILS_INTERN_HASH_INIT;
+    for (size_t i = 0; i < len; i++) hash = sln_utils_intern_hash_step(hash, str[i]);
+    return hash;
+}
+
+static inline unsigned _dir_chunk(uint32_t index, uint32_t* out_offset) {
+    uint32_t scaled = (index >> SLN_INTERN_DIR_BASE_BITS) + 1;
+    unsigned chunk = 31u - (unsigned)__builtin_clz(scaled);
+    *out_offset = index - ((SLN_INTERN_DIR_BASE << chunk) - SLN_INTERN_DIR_BASE);
+    return chunk;
+}
+
+static _sln_intern_entry_t* _dir_slot(sln_utils_intern_t* table, sln_utils_sym_t sym) {
+    uint32_t offset;
+    unsigned chunk = _dir_chunk(sym - 1, &offset);
+
+    _sln_intern_entry_t* entries = atomic_load_explicit(&table->dir[chunk], memory_order_acquire);
+    if (entries) return &entries[offset];
+
+    size_t chunk_len = (size_t)SLN_INTERN_DIR_BASE << chunk;
+    _sln_intern_entry_t* fresh = SLN_ALLOC(chunk_len, _sln_intern_entry_t);
+    if (!fresh) return NULL;
+
+    if (atomic_compare_exchange_strong_explicit(&table->dir[chunk], &entries, fresh,
+                                                memory_order_acq_rel, memory_order_acquire)) {
+        atomic_fetch_add_explicit(&table->memory, chunk_len * sizeof(*fresh), memory_order_relaxed);
+        entries = fresh;
+    } else {
+        sln_utils_free(fresh); // another thread installed the chunk first
+    }
+    return &entries[offset];
+}
+
+static const char* _store_string(sln_utils_intern_t* table, _sln_intern_shard_t* shard,
+                                 const char* str, size_t len) {
+    _sln_intern_block_t* block = shard->block;
+    if (!block || block->cap - block->used < len + 1) {
+        size_t cap = len + 1 > SLN_INTERN_STRING_BLOCK ? len + 1 : SLN_INTERN_STRING_BLOCK;
+        _sln_intern_block_t* fresh = (_sln_intern_block_t*)SLN_ALLOC(sizeof(*fresh) + cap, char);
+        if (!fresh) return NULL;
+        fresh->prev = block;
+        fresh->cap = cap;
+        shard->block = block = fresh;
+        atomic_fetch_add_explicit(&table->memory, sizeof(*fresh) + cap, memory_order_relaxed);
+    }
+    char* dst = block->data + block->used;
+    memcpy(dst, str, len);
+    dst[len] = '\0';
+    block->used += len + 1;
+    return dst;
+}
+
+static bool _grow_slots(sln_utils_intern_t* table, _sln_intern_shard_t* shard) {
+    uint32_t new_cap = (shard->mask + 1) * 2;
+    _sln_intern_slot_t* slots = SLN_ALLOC(new_cap, _sln_intern_slot_t);
+    if (!slots) return false;
+
+    for (uint32_t i = 0; i <= shard->mask; i++) {
+        _sln_intern_slot_t slot = shard->slots[i];
+        if (slot.sym == SLN_UTILS_SYM_NONE) continue;
+        uint32_t j = slot.hash & (new_cap - 1);
+        while (slots[j].sym != SLN_UTILS_SYM_NONE) j = (j + 1) & (new_cap - 1);
+        slots[j] = slot;
+    }
+    sln_utils_free(shard->slots);
+    shard->slots = slots;
+    shard->mask = new_cap - 1;
+    atomic_fetch_add_explicit(&table->memory, (new_cap / 2) * sizeof(*slots), memory_order_relaxed);
+    return true;
+}
+
+sln_utils_intern_t* sln_utils_intern_create(void) {
+    sln_utils_intern_t* table = SLN_ALLOC(1, sln_utils_intern_t);
+    if (!table) return NULL;
+
+    size_t memory = sizeof(*table);
+    for (size_t i = 0; i < SLN_INTERN_SHARDS; i++) {
+        _sln_intern_shard_t* shard = &table->shards[i];
+        shard->slots = SLN_ALLOC(SLN_INTERN_INITIAL_SLOTS, _sln_intern_slot_t);
+        if (!shard->slots || mtx_init(&shard->lock, mtx_plain) != thrd_success) {
+            sln_utils_free(shard->slots);
+            for (size_t j = 0; j < i; j++) {
+                mtx_destroy(&table->shards[j].lock);
+                sln_utils_free(table->shards[j].slots);
+            }
+            sln_utils_free(table);
+            return NULL;
+        }
+        shard->mask = SLN_INTERN_INITIAL_SLOTS - 1;
+        memory += SLN_INTERN_INITIAL_SLOTS * sizeof(_sln_intern_slot_t);
+    }
+    atomic_init(&table->next_sym, 1);
+    atomic_init(&table->memory, memory);
+    return table;
+}
+
+void sln_utils_intern_destroy(sln_utils_intern_t* table) {
+    if (!table) return;
+    for (size_t i = 0; i < SLN_INTERN_SHARDS; i++) {
+        _sln_intern_shard_t* shard = &table->shards[i];
+        mtx_destroy(&shard->lock);
+        sln_utils_free(shard->slots);
+        for (_sln_intern_block_t* block = shard->block; block;) {
+            _sln_intern_block_t* prev = block->prev;
+            sln_utils_free(block);
+            block = prev;
+        }
+    }
+    for (size_t i = 0; i < SLN_INTERN_DIR_CHUNKS; i++) {
+        sln_utils_free(atomic_load_explicit(&table->dir[i], memory_order_relaxed));
+    }
+    sln_utils_free(table);
+}
+
+sln_utils_sym_t sln_utils_intern_put(sln_utils_intern_t* table,
+                                     const char* str, size_t len, uint32_t hash) {
+    if (len > UINT32_MAX) return SLN_UTILS_SYM_NONE;
+
+    _sln_intern_shard_t* shard = &table->shards[hash >> (32 - SLN_INTERN_SHARD_BITS)];
+    sln_utils_sym_t sym = SLN_UTILS_SYM_NONE;
+
+    mtx_lock(&shard->lock);
+
+    uint32_t i = hash & shard->mask;
+    for (; shard->slots[i].sym != SLN_UTILS_SYM_NONE; i = (i + 1) & shard->mask) {
+        if (shard->slots[i].hash != hash) continue;
+        const _sln_intern_entry_t* entry = _dir_slot(table, shard->slots[i].sym);
+        if (entry->len == len && memcmp(entry->str, str, len) == 0) {
+            sym = shard->slots[i].sym;
+            goto unlock;
+        }
+    }
+
+    // Keep the load factor at or below 1/2
+    if ((shard->count + 1) * 2 > shard->mask + 1) {
+        if (!_grow_slots(table, shard)) goto unlock;
+        i = hash & shard->mask;
+        while (shard->slots[i].sym != SLN_UTILS_SYM_NONE) i = (i + 1) & shard->mask;
+    }
+
+    const char* stored = _store_string(table, shard, str, len);
+    if (!stored) goto unlock;
+
+    sln_utils_sym_t fresh = (sln_utils_sym_t)atomic_fetch_add_explicit(&table->next_sym, 1, memory_order_relaxed);
+    _sln_intern_entry_t* entry = _dir_slot(table, fresh);
+    if (!entry) goto unlock;
+    entry->str = stored;
+    entry->len = (uint32_t)len;
+    entry->hash = hash;
+
+    shard->slots[i].hash = hash;
+    shard->slots[i].sym = fresh;
+    shard->count++;
+    sym = fresh;
+
+unlock:
+    mtx_unlock(&shard->lock);
+    return sym;
+}
+
+sln_utils_sym_t sln_utils_intern(sln_utils_intern_t* table, const char* str, size_t len) {
+    return sln_utils_intern_put(table, str, len, sln_utils_intern_hash(str, len));
+}
+
+const char* sln_utils_intern_get(const sln_utils_intern_t* table, sln_utils_sym_t sym, size_t* out_len) {
+    if (sym == SLN_UTILS_SYM_NONE) return NULL;
+
+    uint32_t offset;
+    unsigned chunk = _dir_chunk(sym - 1, &offset);
+    const _sln_intern_entry_t* entries = atomic_load_explicit(&table->dir[chunk], memory_order_acquire);
+    if (!entries || !entries[offset].str) return NULL;
+
+    if (out_len) *out_len = entries[offset].len;
+    return entries[offset].str;
+}
+
+size_t sln_utils_intern_count(const sln_utils_intern_t* table) {
+    // Ids are dense, so the next id to hand out is also the count
+    return (size_t)atomic_load_explicit(&table->next_sym, memory_order_relaxed) - 1;
+}
+
+size_t sln_utils_intern_memory(const sln_utils_intern_t* table) {
+    return atomic_load_explicit(&table->memory, memory_order_relaxed);
+}
@@ -5,7 +5,7 @@
 #include <utils/msg_errors.h>
 #include <resources/msg_resource.h>
 
-void sln_utils_msg_print(sln_res_msg_t msg_code, sln_utils_msg_type_t type, FILE* stream) {
+static void _sln_utils_msg_print_prefix(sln_utils_msg_type_t type, FILE* stream) {
 
     sln_utils_cli_color_set(stream, SLN_UTILS_CLI_COLOR_LIGHTBLUE);
     fputs("selena: ", stream);
@@ -28,8 +28,46 @@ void sln_utils_msg_print(sln_res_msg_t msg_code, sln_utils_msg_type_t type, FILE
     }
     sln_utils_cli_color_set(stream, SLN_UTILS_CLI_COLOR_WHITE);
     fputs("]: ", stream);
+}
+
+void sln_utils_msg_print(sln_res_msg_t msg_code, sln_utils_msg_type_t type, FILE* stream) {
+    _sln_utils_msg_print_prefix(type, stream);
     fputs(sln_res_msg_get(msg_code), stream);
     fputs(".\n", stream);
     sln_utils_cli_color_set(stream, SLN_UTILS_CLI_COLOR_LIGHTGRAY);
     // it can be improved
 }
+
+void sln_utils_msg_print_at(sln_res_msg_t msg_code, sln_utils_msg_type_t type,
+                            size_t offset, FILE* stream) {
+    _sln_utils_msg_print_prefix(type, stream);
+    fputs(sln_res_msg_get(msg_code), stream);
+    fprintf(stream, " (at byte %zu).\n", offset);
+    sln_utils_cli_color_set(stream, SLN_UTILS_CLI_COLOR_LIGHTGRAY);
+}
+
+void sln_utils_msg_print_at_line(sln_res_msg_t msg_code, sln_utils_msg_type_t type,
+                                 size_t line, size_t column, FILE* stream) {
+    _sln_utils_msg_print_prefix(type, stream);
+    fputs(sln_res_msg_get(msg_code), stream);
+    fprintf(stream, " (at line %zu, column %zu).\n", line, column);
+    sln_utils_cli_color_set(stream, SLN_UTILS_CLI_COLOR_LIGHTGRAY);
+}
+
+void sln_utils_msg_print_detail(sln_res_msg_t msg_code, sln_utils_msg_type_t type,
+                                const char* subject, const char* reason, FILE* stream) {
+    _sln_utils_msg_print_prefix(type, stream);
+    fputs(sln_res_msg_get(msg_code), stream);
+    fprintf(stream, " '%s'", subject);
+    if (reason) fprintf(stream, ": %s", reason);
+    fputs(".\n", stream);
+    sln_utils_cli_color_set(stream, SLN_UTILS_CLI_COLOR_LIGHTGRAY);
+}
+
+void sln_utils_msg_print_detail_at_line(sln_res_msg_t msg_code, sln_utils_msg_type_t type, const char* subject,
+                                        size_t line, size_t column, FILE* stream) {
+    _sln_utils_msg_print_prefix(type, stream);
+    fputs(sln_res_msg_get(msg_code), stream);
+    fprintf(stream, " '%s' (at line %zu, column %zu).\n", subject, line, column);
+    sln_utils_cli_color_set(stream, SLN_UTILS_CLI_COLOR_LIGHTGRAY);
+}
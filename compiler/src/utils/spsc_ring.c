@@ -0,0 +1,120 @@
+#include <utils/allocation.h>
+#include <utils/spsc_ring.h>
+
+// Polls before going to sleep; a handoff normally takes less
+#define SLN_RING_SPINS 64
+
+bool sln_utils_ring_init(sln_utils_ring_t* ring, size_t slot_count, size_t slot_size) {
+    if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0 || slot_size == 0) return false;
+
+    ring->slots = SLN_ALLOC(slot_count * slot_size, char);
+    if (!ring->slots) return false;
+    if (mtx_init(&ring->lock, mtx_plain) != thrd_success) {
+        sln_utils_free(ring->slots);
+        return false;
+    }
+    if (cnd_init(&ring->wake) != thrd_success) {
+        mtx_destroy(&ring->lock);
+        sln_utils_free(ring->slots);
+        return false;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->closed, false);
+    atomic_init(&ring->cancelled, false);
+    atomic_init(&ring->producer_sleeping, false);
+    atomic_init(&ring->consumer_sleeping, false);
+    ring->tail_cache = 0;
+    ring->head_cache = 0;
+    ring->slot_size = slot_size;
+    ring->mask = slot_count - 1;
+    return true;
+}
+
+void sln_utils_ring_free(sln_utils_ring_t* ring) {
+    cnd_destroy(&ring->wake);
+    mtx_destroy(&ring->lock);
+    sln_utils_free(ring->slots);
+    ring->slots = NULL;
+}
+
+static bool _can_produce(sln_utils_ring_t* ring) {
+    return atomic_load(&ring->tail) - atomic_load(&ring->head) <= ring->mask
+        || atomic_load(&ring->cancelled);
+}
+
+static bool _can_consume(sln_utils_ring_t* ring) {
+    return atomic_load(&ring->head) != atomic_load(&ring->tail) || atomic_load(&ring->closed);
+}
+
+/*
+ * Sleeper and waker form a Dekker pair: the sleeper raises its flag then
+ * checks the indices, the waker moves an index then checks the flag, all
+ * sequentially consistent, so one of them always sees the other. The
+ * check under the lock closes the gap between the flag and cnd_wait().
+ */
+static void _wait(sln_utils_ring_t* ring, atomic_bool* sleeping, bool (*ready)(sln_utils_ring_t*)) {
+    for (int spin = 0; spin < SLN_RING_SPINS; spin++) {
+        if (ready(ring)) return;
+        thrd_yield();
+    }
+    mtx_lock(&ring->lock);
+    atomic_store(sleeping, true);
+    while (!ready(ring)) cnd_wait(&ring->wake, &ring->lock);
+    atomic_store(sleeping, false);
+    mtx_unlock(&ring->lock);
+}
+
+static void _wake(sln_utils_ring_t* ring, atomic_bool* sleeping) {
+    if (!atomic_load(sleeping)) return;
+    mtx_lock(&ring->lock);
+    cnd_broadcast(&ring->wake);
+    mtx_unlock(&ring->lock);
+}
+
+void* sln_utils_ring_acquire(sln_utils_ring_t* ring) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (tail - ring->head_cache > ring->mask) {
+        ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->head_cache > ring->mask) {
+            _wait(ring, &ring->producer_sleeping, _can_produce);
+            ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+        }
+    }
+    if (atomic_load_explicit(&ring->cancelled, memory_order_relaxed)) return NULL;
+    return ring->slots + (tail & ring->mask) * ring->slot_size;
+}
+
+void sln_utils_ring_publish(sln_utils_ring_t* ring) {
+    atomic_fetch_add(&ring->tail, 1);
+    _wake(ring, &ring->consumer_sleeping);
+}
+
+void sln_utils_ring_close(sln_utils_ring_t* ring) {
+    atomic_store(&ring->closed, true);
+    _wake(ring, &ring->consumer_sleeping);
+}
+
+void* sln_utils_ring_peek(sln_utils_ring_t* ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head == ring->tail_cache) {
+        ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == ring->tail_cache) {
+            _wait(ring, &ring->consumer_sleeping, _can_consume);
+            // `closed` is set after the last publish, so this sees every slot
+            ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+            if (head == ring->tail_cache) return NULL;
+        }
+    }
+    return ring->slots + (head & ring->mask) * ring->slot_size;
+}
+
+void sln_utils_ring_release(sln_utils_ring_t* ring) {
+    atomic_fetch_add(&ring->head, 1);
+    _wake(ring, &ring->producer_sleeping);
+}
+
+void sln_utils_ring_cancel(sln_utils_ring_t* ring) {
+    atomic_store(&ring->cancelled, true);
+    _wake(ring, &ring->producer_sleeping);
+}
@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include <utils/allocation.h>
+#include <utils/thread_pool.h>
+#include <utils/trace.h>
+
+#define SLN_POOL_DEQUE_INITIAL_SIZE 64UL
+#define SLN_POOL_DEQUE_GROW_FACTOR 2
+
+typedef struct {
+    sln_utils_pool_task_t task;
+    void* arg;
+} _sln_pool_job_t;
+
+// Ring buffer: the owner pushes and pops at the back, thieves take the front
+typedef struct {
+    mtx_t lock;
+    _sln_pool_job_t* jobs;
+    size_t head;
+    size_t len;
+    size_t cap;
+    thrd_t thread;
+    sln_utils_pool_t* pool;
+    size_t index;
+} _sln_pool_worker_t;
+
+struct sln_utils_pool {
+    _sln_pool_worker_t* workers;
+    size_t size;
+    mtx_t lock;
+    cnd_t work;             /**< Signalled when a job is queued or the pool stops */
+    cnd_t idle;             /**< Signalled when pending drops to zero */
+    atomic_size_t queued;   /**< Jobs sitting in deques */
+    atomic_size_t pending;  /**< Jobs submitted and not finished */
+    atomic_size_t next;     /**< Round-robin cursor for outside submissions */
+    bool stop;
+};
+
+static _Thread_local const sln_utils_pool_t* _current_pool = NULL;
+static _Thread_local size_t _current_worker = 0;
+
+static bool _deque_push(_sln_pool_worker_t* worker, _sln_pool_job_t job) {
+    mtx_lock(&worker->lock);
+    if (worker->len == worker->cap) {
+        size_t cap = worker->cap * SLN_POOL_DEQUE_GROW_FACTOR;
+        _sln_pool_job_t* jobs = SLN_ALLOC(cap, _sln_pool_job_t);
+        if (!jobs) {
+            mtx_unlock(&worker->lock);
+            return false;
+        }
+        for (size_t i = 0; i < worker->len; i++) {
+            jobs[i] = worker->jobs[(worker->head + i) % worker->cap];
+        }
+        sln_utils_free(worker->jobs);
+        worker->jobs = jobs;
+        worker->head = 0;
+        worker->cap = cap;
+    }
+    worker->jobs[(worker->head + worker->len) % worker->cap] = job;
+    worker->len++;
+    mtx_unlock(&worker->lock);
+    return true;
+}
+
+static bool _deque_pop(_sln_pool_worker_t* worker, _sln_pool_job_t* job) {
+    mtx_lock(&worker->lock);
+    bool found = worker->len > 0;
+    if (found) {
+        worker->len--;
+        *job = worker->jobs[(worker->head + worker->len) % worker->cap];
+    }
+    mtx_unlock(&worker->lock);
+    return found;
+}
+
+static bool _deque_steal(_sln_pool_worker_t* worker, _sln_pool_job_t* job) {
+    mtx_lock(&worker->lock);
+    bool found = worker->len > 0;
+    if (found) {
+        *job = worker->jobs[worker->head];
+        worker->head = (worker->head + 1) % worker->cap;
+        worker->len--;
+    }
+    mtx_unlock(&worker->lock);
+    return found;
+}
+
+static bool _take(sln_utils_pool_t* pool, size_t index, _sln_pool_job_t* job) {
+    if (atomic_load_explicit(&pool->queued, memory_order_acquire) == 0) return false;
+    bool found = _deque_pop(&pool->workers[index], job);
+    for (size_t k = 1; !found && k < pool->size; k++) {
+        found = _deque_steal(&pool->workers[(index + k) % pool->size], job);
+    }
+    if (found) atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_acq_rel);
+    return found;
+}
+
+static void _finish(sln_utils_pool_t* pool) {
+    if (atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_acq_rel) != 1) return;
+    mtx_lock(&pool->lock);
+    cnd_broadcast(&pool->idle);
+    mtx_unlock(&pool->lock);
+}
+
+static int _worker_main(void* arg) {
+    _sln_pool_worker_t* worker = arg;
+    sln_utils_pool_t* pool = worker->pool;
+    _current_pool = pool;
+    _current_worker = worker->index;
+    SLN_TRACE_THREAD("worker");
+
+    for (;;) {
+        _sln_pool_job_t job;
+        if (_take(pool, worker->index, &job)) {
+            job.task(job.arg, worker->index);
+            _finish(pool);
+            continue;
+        }
+
+        mtx_lock(&pool->lock);
+        while (atomic_load(&pool->queued) == 0 && !pool->stop) {
+            cnd_wait(&pool->work, &pool->lock);
+        }
+        bool stop = pool->stop && atomic_load(&pool->queued) == 0;
+        mtx_unlock(&pool->lock);
+        if (stop) return 0;
+    }
+}
+
+static void _stop_workers(sln_utils_pool_t* pool, size_t started) {
+    mtx_lock(&pool->lock);
+    pool->stop = true;
+    cnd_broadcast(&pool->work);
+    mtx_unlock(&pool->lock);
+    for (size_t i = 0; i < started; i++) {
+        thrd_join(pool->workers[i].thread, NULL);
+    }
+}
+
+static void _free_pool(sln_utils_pool_t* pool, size_t workers_ready) {
+    for (size_t i = 0; i < workers_ready; i++) {
+        mtx_destroy(&pool->workers[i].lock);
+        sln_utils_free(pool->workers[i].jobs);
+    }
+    sln_utils_free(pool->workers);
+    cnd_destroy(&pool->idle);
+    cnd_destroy(&pool->work);
+    mtx_destroy(&pool->lock);
+    sln_utils_free(pool);
+}
+
+sln_utils_pool_t* sln_utils_pool_create(size_t workers) {
+    if (workers == 0) workers = 1;
+    if (workers > SLN_UTILS_POOL_MAX_WORKERS) workers = SLN_UTILS_POOL_MAX_WORKERS;
+
+    sln_utils_pool_t* pool = SLN_ALLOC(1, sln_utils_pool_t);
+    if (!pool) return NULL;
+    if (mtx_init(&pool->lock, mtx_plain) != thrd_success) {
+        sln_utils_free(pool);
+        return NULL;
+    }
+    if (cnd_init(&pool->work) != thrd_success) {
+        mtx_destroy(&pool->lock);
+        sln_utils_free(pool);
+        return NULL;
+    }
+    if (cnd_init(&pool->idle) != thrd_success) {
+        cnd_destroy(&pool->work);
+        mtx_destroy(&pool->lock);
+        sln_utils_free(pool);
+        return NULL;
+    }
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->next, 0);
+    pool->size = workers;
+
+    pool->workers = SLN_ALLOC(workers, _sln_pool_worker_t);
+    if (!pool->workers) {
+        _free_pool(pool, 0);
+        return NULL;
+    }
+
+    size_t ready = 0;
+    for (; ready < workers; ready++) {
+        _sln_pool_worker_t* worker = &pool->workers[ready];
+        worker->jobs = SLN_ALLOC(SLN_POOL_DEQUE_INITIAL_SIZE, _sln_pool_job_t);
+        if (!worker->jobs) break;
+        if (mtx_init(&worker->lock, mtx_plain) != thrd_success) {
+            sln_utils_free(worker->jobs);
+            break;
+        }
+        worker->cap = SLN_POOL_DEQUE_INITIAL_SIZE;
+        worker->pool = pool;
+        worker->index = ready;
+    }
+    if (ready < workers) {
+        _free_pool(pool, ready);
+        return NULL;
+    }
+
+    for (size_t started = 0; started < workers; started++) {
+        if (thrd_create(&pool->workers[started].thread, _worker_main, &pool->workers[started]) != thrd_success) {
+            _stop_workers(pool, started);
+            _free_pool(pool, workers);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void sln_utils_pool_destroy(sln_utils_pool_t* pool) {
+    if (!pool) return;
+
+    sln_utils_pool_wait(pool);
+    _stop_workers(pool, pool->size);
+    _free_pool(pool, pool->size);
+}
+
+bool sln_utils_pool_submit(sln_utils_pool_t* pool, sln_utils_pool_task_t task, void* arg) {
+    size_t index = _current_pool == pool
+        ? _current_worker
+        : atomic_fetch_add_explicit(&pool->next, 1, memory_order_relaxed) % pool->size;
+
+    // Count the job before it becomes visible: a thief may take it and
+    // decrement queued as soon as the deque lock is released
+    atomic_fetch_add_explicit(&pool->pending, 1, memory_order_acq_rel);
+    atomic_fetch_add_explicit(&pool->queued, 1, memory_order_acq_rel);
+    if (!_deque_push(&pool->workers[index], (_sln_pool_job_t){ task, arg })) {
+        atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_acq_rel);
+        _finish(pool);
+        return false;
+    }
+
+    mtx_lock(&pool->lock);
+    cnd_signal(&pool->work);
+    mtx_unlock(&pool->lock);
+    return true;
+}
+
+void sln_utils_pool_wait(sln_utils_pool_t* pool) {
+    mtx_lock(&pool->lock);
+    while (atomic_load(&pool->pending) > 0) {
+        cnd_wait(&pool->idle, &pool->lock);
+    }
+    mtx_unlock(&pool->lock);
+}
+
+size_t sln_utils_pool_size(const sln_utils_pool_t* pool) {
+    return pool->size;
+}
+
+size_t sln_utils_cpu_count(void) {
+#if defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count > 0) return (size_t)count;
+#endif
+    return 1;
+}
@@ -0,0 +1,215 @@
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+
+#include <utils/allocation.h>
+#include <utils/trace.h>
+
+#define SLN_TRACE_INITIAL_EVENTS 256UL
+#define SLN_TRACE_GROW_FACTOR 2
+#define SLN_TRACE_MAX_PHASES 128
+
+typedef struct {
+    const char* name;
+    const char* detail;
+    uint64_t start;
+    uint64_t end;
+} _sln_trace_event_t;
+
+// Track of one thread; only its thread appends, the list is read after joins
+typedef struct _sln_trace_thread {
+    struct _sln_trace_thread* next;
+    const char* name;
+    uint32_t id;
+    _sln_trace_event_t* events;
+    size_t len;
+    size_t cap;
+} _sln_trace_thread_t;
+
+typedef struct {
+    const char* name;
+    size_t count;
+    uint64_t total;
+    uint64_t max;
+} _sln_trace_phase_t;
+
+atomic_bool sln_utils_trace_active = false;
+
+static mtx_t _lock;
+static _sln_trace_thread_t* _threads = NULL;
+static uint32_t _next_id = 0;
+static _Thread_local _sln_trace_thread_t* _self = NULL;
+
+uint64_t sln_utils_trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static _sln_trace_thread_t* _thread(void) {
+    if (_self) return _self;
+
+    _sln_trace_thread_t* thread = SLN_ALLOC(1, _sln_trace_thread_t);
+    if (!thread) return NULL;
+    mtx_lock(&_lock);
+    thread->id = _next_id++;
+    thread->next = _threads;
+    _threads = thread;
+    mtx_unlock(&_lock);
+    return _self = thread;
+}
+
+bool sln_utils_trace_enable(void) {
+#if SLN_TRACE_ENABLED
+    if (atomic_load(&sln_utils_trace_active)) return true;
+    if (mtx_init(&_lock, mtx_plain) != thrd_success) return false;
+    atomic_store(&sln_utils_trace_active, true);
+    sln_utils_trace_thread_name("main");
+    return true;
+#else
+    return false;
+#endif
+}
+
+void sln_utils_trace_disable(void) {
+    if (!atomic_exchange(&sln_utils_trace_active, false)) return;
+
+    for (_sln_trace_thread_t* thread = _threads; thread;) {
+        _sln_trace_thread_t* next = thread->next;
+        sln_utils_free(thread->events);
+        sln_utils_free(thread);
+        thread = next;
+    }
+    _threads = NULL;
+    _next_id = 0;
+    _self = NULL;
+    mtx_destroy(&_lock);
+}
+
+void sln_utils_trace_record(const char* name, const char* detail, uint64_t start, uint64_t end) {
+    if (!sln_utils_trace_on()) return;
+    _sln_trace_thread_t* thread = _thread();
+    if (!thread) return;
+
+    if (thread->len == thread->cap) {
+        size_t cap = thread->cap ? thread->cap * SLN_TRACE_GROW_FACTOR : SLN_TRACE_INITIAL_EVENTS;
+        _sln_trace_event_t* events = SLN_ALLOC(cap, _sln_trace_event_t);
+        if (!events) return;
+        if (thread->events) memcpy(events, thread->events, thread->len * sizeof(*events));
+        sln_utils_free(thread->events);
+        thread->events = events;
+        thread->cap = cap;
+    }
+    thread->events[thread->len++] = (_sln_trace_event_t){ name, detail, start, end };
+}
+
+void sln_utils_trace_thread_name(const char* name) {
+    if (!sln_utils_trace_on()) return;
+    _sln_trace_thread_t* thread = _thread();
+    if (thread) thread->name = name;
+}
+
+// Earliest start, so the exported times begin near zero
+static uint64_t _origin(void) {
+    uint64_t origin = UINT64_MAX;
+    for (const _sln_trace_thread_t* thread = _threads; thread; thread = thread->next) {
+        for (size_t i = 0; i < thread->len; i++) {
+            if (thread->events[i].start < origin) origin = thread->events[i].start;
+        }
+    }
+    return origin == UINT64_MAX ? 0 : origin;
+}
+
+void sln_utils_trace_report(FILE* stream) {
+    _sln_trace_phase_t phases[SLN_TRACE_MAX_PHASES];
+    size_t phase_count = 0;
+    uint64_t first = UINT64_MAX;
+    uint64_t last = 0;
+
+    for (const _sln_trace_thread_t* thread = _threads; thread; thread = thread->next) {
+        for (size_t i = 0; i < thread->len; i++) {
+            const _sln_trace_event_t* event = &thread->events[i];
+            uint64_t duration = event->end - event->start;
+            if (event->start < first) first = event->start;
+            if (event->end > last) last = event->end;
+
+            size_t p = 0;
+            while (p < phase_count && strcmp(phases[p].name, event->name) != 0) p++;
+            if (p == phase_count) {
+                if (phase_count == SLN_TRACE_MAX_PHASES) continue;
+                phases[phase_count++] = (_sln_trace_phase_t){ event->name, 0, 0, 0 };
+            }
+            phases[p].count++;
+            phases[p].total += duration;
+            if (duration > phases[p].max) phases[p].max = duration;
+        }
+    }
+
+    // Insertion sort by total time; there are few phases
+    for (size_t i = 1; i < phase_count; i++) {
+        _sln_trace_phase_t phase = phases[i];
+        size_t j = i;
+        for (; j > 0 && phases[j - 1].total < phase.total; j--) phases[j] = phases[j - 1];
+        phases[j] = phase;
+    }
+
+    fprintf(stream, "%-20s %8s %12s %12s %12s\n", "phase", "count", "total ms", "mean ms", "max ms");
+    for (size_t p = 0; p < phase_count; p++) {
+        fprintf(stream, "%-20s %8zu %12.3f %12.3f %12.3f\n", phases[p].name, phases[p].count,
+                (double)phases[p].total / 1e6,
+                (double)phases[p].total / 1e6 / (double)phases[p].count,
+                (double)phases[p].max / 1e6);
+    }
+    fprintf(stream, "%-20s %8s %12.3f\n", "wall", "",
+            last > first ? (double)(last - first) / 1e6 : 0.0);
+}
+
+static void _write_string(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const unsigned char* c = (const unsigned char*)text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+bool sln_utils_trace_write(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+
+    uint64_t origin = _origin();
+    bool first = true;
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", out);
+    for (const _sln_trace_thread_t* thread = _threads; thread; thread = thread->next) {
+        if (thread->name) {
+            fprintf(out, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                    first ? "" : ",", thread->id);
+            _write_string(out, thread->name);
+            fputs("}}", out);
+            first = false;
+        }
+        for (size_t i = 0; i < thread->len; i++) {
+            const _sln_trace_event_t* event = &thread->events[i];
+            // Trace-event times are microseconds; keep the nanoseconds as fractions
+            fprintf(out, "%s\n{\"ph\":\"X\",\"cat\":\"phase\",\"name\":", first ? "" : ",");
+            _write_string(out, event->name);
+            fprintf(out, ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", thread->id,
+                    (double)(event->start - origin) / 1e3, (double)(event->end - event->start) / 1e3);
+            if (event->detail) {
+                fputs(",\"args\":{\"file\":", out);
+                _write_string(out, event->detail);
+                fputc('}', out);
+            }
+            fputc('}', out);
+            first = false;
+        }
+    }
+    fputs("\n]}\n", out);
+    return fclose(out) == 0;
+}
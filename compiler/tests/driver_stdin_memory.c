@@ -0,0 +1,97 @@
+/**
+ * @file driver_stdin_memory.c
+ * @brief Peak memory of `selena -` on a large piped input.
+ *
+ * The compiler is run on a pipe fed with 16 MiB of examples/basic/syntax.sl
+ * repeated, once with standard input as the only unit and once after a
+ * file. Its tokens must reach stdout as they are lexed, so the peak
+ * resident set of the child must stay well below the input size.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <common/source.h>
+
+#include "test_util.h"
+
+#define TEST_INPUT_SIZE (16L * 1024L * 1024L)
+#define TEST_MAX_RSS_KB (32L * 1024L)
+
+// Runs selena on @p argv with @p size bytes of @p text repeated on its
+// stdin; returns the child's peak resident set in KiB, or -1
+static long _run(char* const* argv, const char* text, size_t len, long size) {
+    int input[2];
+    if (pipe(input) != 0) return -1;
+    pid_t child = fork();
+    if (child < 0) {
+        close(input[0]);
+        close(input[1]);
+        return -1;
+    }
+    if (child == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(input[0], STDIN_FILENO);
+        if (null >= 0) {
+            dup2(null, STDOUT_FILENO);
+            dup2(null, STDERR_FILENO);
+        }
+        close(input[0]);
+        close(input[1]);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    close(input[0]);
+    bool written = true;
+    for (long sent = 0; written && sent < size;) {
+        size_t chunk = len;
+        if ((long)chunk > size - sent) chunk = (size_t)(size - sent);
+        for (size_t done = 0; written && done < chunk;) {
+            ssize_t n = write(input[1], text + done, chunk - done);
+            if (n < 0 && errno == EINTR) continue;
+            written = n > 0;
+            if (written) done += (size_t)n;
+        }
+        sent += (long)chunk;
+    }
+    close(input[1]);
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) != child) return -1;
+    SLN_TEST_CHECK(written, "%s: the input pipe closed early", argv[1]);
+    SLN_TEST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "%s: selena failed with status %d", argv[1], status);
+    return usage.ru_maxrss;
+}
+
+static char _selena[] = SELENA_BINARY;
+static char _stdin[] = "-";
+static char _example[] = SLN_TEST_EXAMPLE("basic/syntax.sl");
+
+int main(void) {
+    // The child may stop reading on failure; its pipe must not kill the test
+    signal(SIGPIPE, SIG_IGN);
+
+    sln_common_source_t source = {0};
+    SLN_TEST_CHECK(sln_common_source_load(&source, _example), "cannot load %s", _example);
+    if (!source.text) return SLN_TEST_RESULT();
+
+    char* alone[] = { _selena, _stdin, NULL };
+    char* after_file[] = { _selena, _example, _stdin, NULL };
+    char* const* runs[] = { alone, after_file };
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        long rss = _run(runs[i], source.text, source.len, TEST_INPUT_SIZE);
+        SLN_TEST_CHECK(rss > 0, "run %zu: cannot run %s", i, _selena);
+        SLN_TEST_CHECK(rss <= TEST_MAX_RSS_KB, "run %zu: peak RSS %ld KiB on %ld MiB of stdin, expected at most %ld KiB",
+                       i, rss, TEST_INPUT_SIZE / (1024L * 1024L), TEST_MAX_RSS_KB);
+    }
+    sln_common_source_free(&source);
+    return SLN_TEST_RESULT();
+}
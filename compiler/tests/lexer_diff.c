@@ -0,0 +1,440 @@
+/**
+ * @file lexer_diff.c
+ * @brief Differential test of the table-driven lexer.
+ *
+ * The reference below is the lexer as it was before the generated
+ * tables: ctype classification, a nested switch over operators and
+ * strtoull()/strtold() for numbers, with the rules adopted since
+ * (saturating integers, %= and ^=, invalid runs). It covers ASCII
+ * text. Both lexers run on the examples, every operator and operator
+ * pair, numeric edge cases, strings, characters, comments and a
+ * generated corpus; kinds, spans, payloads and status must agree.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lexer/lexer.h>
+#include <lexer/lexer_errors.h>
+#include <lexer/lexer_keywords.h>
+#include <lexer/lexer_operators.h>
+#include <common/source.h>
+#include <utils/allocation.h>
+#include <utils/intern.h>
+
+#include "test_util.h"
+
+#define _TEST_SPELLING(name, spelling) spelling,
+static const char* const _keywords[] = { SLN_LEX_KEYWORDS(_TEST_SPELLING) };
+static const char* const _operators[] = { SLN_LEX_OPERATORS(_TEST_SPELLING) };
+#undef _TEST_SPELLING
+
+#define TEST_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+#define TEST_MAX_TEXT 8192
+
+typedef struct {
+    const char* text;
+    size_t pos;
+    sln_utils_intern_t* symbols;
+    sln_lex_error_t status;
+} _ref_t;
+
+static void _ref_report(_ref_t* ref, sln_lex_error_t error) {
+    if (ref->status == SLN_LEX_OK) ref->status = error;
+}
+
+static char _ref_escape(const char* text, size_t* pos) {
+    (*pos)++;
+    char c = text[*pos];
+    switch (c) {
+        case 'a': (*pos)++; return '\a';
+        case 'b': (*pos)++; return '\b';
+        case 'f': (*pos)++; return '\f';
+        case 'n': (*pos)++; return '\n';
+        case 'r': (*pos)++; return '\r';
+        case 't': (*pos)++; return '\t';
+        case 'v': (*pos)++; return '\v';
+        case '0': (*pos)++; return '\0';
+        case '\0': return 0;
+        case 'x': {
+            (*pos)++;
+            char digits[3] = {0};
+            for (size_t i = 0; i < 2 && isxdigit((unsigned char)text[*pos]); i++) digits[i] = text[(*pos)++];
+            return (char)strtoul(digits, NULL, 16);
+        }
+        default: (*pos)++; return c;
+    }
+}
+
+static bool _ref_number(_ref_t* ref, sln_lex_token_t* token) {
+    const char* text = ref->text;
+    size_t start = ref->pos;
+    size_t digits = start;
+    int base = 10;
+    bool is_float = false;
+
+    if (text[start] == '0' && (text[start + 1] == 'x' || text[start + 1] == 'X')) {
+        base = 16;
+        digits = start + 2;
+        ref->pos = digits;
+        while (isxdigit((unsigned char)text[ref->pos])) ref->pos++;
+    } else if (text[start] == '0' && (text[start + 1] == 'b' || text[start + 1] == 'B')) {
+        base = 2;
+        digits = start + 2;
+        ref->pos = digits;
+        while (text[ref->pos] == '0' || text[ref->pos] == '1') ref->pos++;
+    } else if (text[start] == '0' && isdigit((unsigned char)text[start + 1])) {
+        base = 8;
+        while (text[ref->pos] >= '0' && text[ref->pos] <= '7') ref->pos++;
+    } else {
+        while (isdigit((unsigned char)text[ref->pos])) ref->pos++;
+        if (text[ref->pos] == '.') {
+            is_float = true;
+            ref->pos++;
+            while (isdigit((unsigned char)text[ref->pos])) ref->pos++;
+        }
+        if (text[ref->pos] == 'e' || text[ref->pos] == 'E') {
+            is_float = true;
+            ref->pos++;
+            if (text[ref->pos] == '+' || text[ref->pos] == '-') ref->pos++;
+            while (isdigit((unsigned char)text[ref->pos])) ref->pos++;
+        }
+    }
+    if (ref->pos == digits) return false;
+
+    char lexeme[TEST_MAX_TEXT];
+    size_t len = ref->pos - digits;
+    memcpy(lexeme, text + digits, len);
+    lexeme[len] = '\0';
+    if (is_float) {
+        token->type = SLN_LEX_TOKEN_FLOAT_LITERAL;
+        token->data.lfloat = strtold(lexeme, NULL);
+        return true;
+    }
+    errno = 0;
+    token->type = SLN_LEX_TOKEN_INT_LITERAL;
+    token->data.u64 = strtoull(lexeme, NULL, base);
+    if (errno == ERANGE) _ref_report(ref, SLN_LEX_INTEGER_OVERFLOW);
+    return true;
+}
+
+static bool _ref_string(_ref_t* ref, sln_lex_token_t* token) {
+    const char* text = ref->text;
+    size_t start = ref->pos + 1;
+    size_t end = start;
+    while (text[end] != '"' && text[end] != '\0') {
+        if (text[end] == '\\' && text[end + 1] != '\0') end++;
+        end++;
+    }
+    if (text[end] != '"') return false;
+
+    char value[TEST_MAX_TEXT];
+    size_t len = 0;
+    for (size_t pos = start; pos < end;) {
+        value[len++] = text[pos] == '\\' ? _ref_escape(text, &pos) : text[pos++];
+    }
+    ref->pos = end + 1;
+    token->type = SLN_LEX_TOKEN_STRING_LITERAL;
+    token->data.sym = sln_utils_intern(ref->symbols, value, len);
+    return true;
+}
+
+static bool _ref_char(_ref_t* ref, sln_lex_token_t* token) {
+    const char* text = ref->text;
+    size_t pos = ref->pos + 1;
+    if (text[pos] == '\0') return false;
+    char value = text[pos] == '\\' ? _ref_escape(text, &pos) : text[pos++];
+    if (text[pos] != '\'') return false;
+    ref->pos = pos + 1;
+    token->type = SLN_LEX_TOKEN_CHAR_LITERAL;
+    token->data.i64 = value;
+    return true;
+}
+
+static bool _ref_operator(_ref_t* ref, sln_lex_token_t* token) {
+    const char* text = ref->text + ref->pos;
+    size_t len = 1;
+    switch (text[0]) {
+        case '+':
+            if (text[1] == '+') { token->type = SLN_LEX_TOKEN_INCREMENT; len = 2; }
+            else if (text[1] == '=') { token->type = SLN_LEX_TOKEN_PLUS_ASSIGN; len = 2; }
+            else token->type = SLN_LEX_TOKEN_PLUS;
+            break;
+        case '-':
+            if (text[1] == '>') { token->type = SLN_LEX_TOKEN_ARROW; len = 2; }
+            else if (text[1] == '-') { token->type = SLN_LEX_TOKEN_DECREMENT; len = 2; }
+            else if (text[1] == '=') { token->type = SLN_LEX_TOKEN_MINUS_ASSIGN; len = 2; }
+            else token->type = SLN_LEX_TOKEN_MINUS;
+            break;
+        case '*':
+            if (text[1] == '=') { token->type = SLN_LEX_TOKEN_STAR_ASSIGN; len = 2; }
+            else token->type = SLN_LEX_TOKEN_STAR;
+            break;
+        case '/':
+            if (text[1] == '=') { token->type = SLN_LEX_TOKEN_SLASH_ASSIGN; len = 2; }
+            else token->type = SLN_LEX_TOKEN_SLASH;
+            break;
+        case '%':
+            if (text[1] == '=') { token->type = SLN_LEX_TOKEN_PERCENT_ASSIGN; len = 2; }
+            else token->type = SLN_LEX_TOKEN_PERCENT;
+            break;
+        case '^':
+            if (text[1] == '=') { token->type = SLN_LEX_TOKEN_CARET_ASSIGN; len = 2; }
+            else token->type = SLN_LEX_TOKEN_CARET;
+            break;
+        case '=':
+            if (text[1] == '=') { token->type = SLN_LEX_TOKEN_EQ; len = 2; }
+            else token->type = SLN_LEX_TOKEN_ASSIGN;
+            break;
+        case '!':
+            if (text[1] == '=') { token->type = SLN_LEX_TOKEN_NE; len = 2; }
+            else token->type = SLN_LEX_TOKEN_BANG;
+            break;
+        case '<':
+            if (text[1] == '<' && text[2] == '=') { token->type = SLN_LEX_TOKEN_LSHIFT_ASSIGN; len = 3; }
+            else if (text[1] == '<') { token->type = SLN_LEX_TOKEN_LSHIFT; len = 2; }
+            else if (text[1] == '=') { token->type = SLN_LEX_TOKEN_LE; len = 2; }
+            else token->type = SLN_LEX_TOKEN_LT;
+            break;
+        case '>':
+            if (text[1] == '>' && text[2] == '=') { token->type = SLN_LEX_TOKEN_RSHIFT_ASSIGN; len = 3; }
+            else if (text[1] == '>') { token->type = SLN_LEX_TOKEN_RSHIFT; len = 2; }
+            else if (text[1] == '=') { token->type = SLN_LEX_TOKEN_GE; len = 2; }
+            else token->type = SLN_LEX_TOKEN_GT;
+            break;
+        case '&':
+            if (text[1] == '&') { token->type = SLN_LEX_TOKEN_AND_AND; len = 2; }
+            else if (text[1] == '=') { token->type = SLN_LEX_TOKEN_AMP_ASSIGN; len = 2; }
+            else token->type = SLN_LEX_TOKEN_AMP;
+            break;
+        case '|':
+            if (text[1] == '|') { token->type = SLN_LEX_TOKEN_OR_OR; len = 2; }
+            else if (text[1] == '=') { token->type = SLN_LEX_TOKEN_PIPE_ASSIGN; len = 2; }
+            else token->type = SLN_LEX_TOKEN_PIPE;
+            break;
+        case ':':
+            if (text[1] == ':') { token->type = SLN_LEX_TOKEN_DOUBLE_COLON; len = 2; }
+            else token->type = SLN_LEX_TOKEN_COLON;
+            break;
+        case '.':
+            if (text[1] == '.' && text[2] == '.') { token->type = SLN_LEX_TOKEN_ELLIPSIS; len = 3; }
+            else token->type = SLN_LEX_TOKEN_DOT;
+            break;
+        case '~': token->type = SLN_LEX_TOKEN_TILDE; break;
+        case '?': token->type = SLN_LEX_TOKEN_QUESTION; break;
+        case '@': token->type = SLN_LEX_TOKEN_AT; break;
+        case ',': token->type = SLN_LEX_TOKEN_COMMA; break;
+        case ';': token->type = SLN_LEX_TOKEN_SEMICOLON; break;
+        case '(': token->type = SLN_LEX_TOKEN_LPAREN; break;
+        case ')': token->type = SLN_LEX_TOKEN_RPAREN; break;
+        case '{': token->type = SLN_LEX_TOKEN_LBRACE; break;
+        case '}': token->type = SLN_LEX_TOKEN_RBRACE; break;
+        case '[': token->type = SLN_LEX_TOKEN_LBRACKET; break;
+        case ']': token->type = SLN_LEX_TOKEN_RBRACKET; break;
+        default: return false;
+    }
+    ref->pos += len;
+    return true;
+}
+
+// Bytes that start no token: what is left after every other rule
+static size_t _ref_invalid_length(const char* text, size_t pos) {
+    char c = text[pos];
+    if (c == '\r') return text[pos + 1] != '\n';
+    if (c == '\0' || c == ' ' || c == '\t' || c == '\n' || c == '#' || c == '"' || c == '\'') return 0;
+    if (isalnum((unsigned char)c) || c == '_' || strchr("+-*/%^=!<>&|:.~?@,;(){}[]", c)) return 0;
+    return 1;
+}
+
+static bool _ref_next(_ref_t* ref, sln_lex_token_t* token) {
+    const char* text = ref->text;
+    while (text[ref->pos] == ' ' || text[ref->pos] == '\t') ref->pos++;
+
+    size_t start = ref->pos;
+    char c = text[start];
+    bool parsed = true;
+    token->data.u64 = 0;
+    if (c == '\0') return false;
+
+    if (c == '\n' || (c == '\r' && text[start + 1] == '\n')) {
+        token->type = SLN_LEX_TOKEN_EOL;
+        ref->pos += c == '\n' ? 1 : 2;
+    } else if (c == '#' && text[start + 1] != '#') {
+        const char* eol = strchr(text + start, '\n');
+        ref->pos = eol ? (size_t)(eol - text) + 1 : strlen(text);
+        token->type = SLN_LEX_TOKEN_COMMENT;
+    } else if (c == '#') {
+        const char* close = strstr(text + start + 2, "##");
+        ref->pos = close ? (size_t)(close - text) + 2 : strlen(text);
+        token->type = SLN_LEX_TOKEN_COMMENT;
+    } else if (isalpha((unsigned char)c) || c == '_') {
+        while (isalnum((unsigned char)text[ref->pos]) || text[ref->pos] == '_') ref->pos++;
+        size_t len = ref->pos - start;
+        token->type = SLN_LEX_TOKEN_IDENTIFIER;
+        for (size_t k = 0; k < TEST_COUNT(_keywords); k++) {
+            if (strlen(_keywords[k]) == len && memcmp(_keywords[k], text + start, len) == 0) {
+                token->type = (sln_lex_token_type_t)(SLN_LEX_TOKEN_KW_NAMESPACE + k);
+            }
+        }
+        if (token->type == SLN_LEX_TOKEN_IDENTIFIER) token->data.sym = sln_utils_intern(ref->symbols, text + start, len);
+    } else if (isdigit((unsigned char)c)) {
+        parsed = _ref_number(ref, token);
+    } else if (c == '"') {
+        parsed = _ref_string(ref, token);
+    } else if (c == '\'') {
+        parsed = _ref_char(ref, token);
+    } else {
+        parsed = _ref_operator(ref, token);
+    }
+
+    if (!parsed) {
+        token->type = SLN_LEX_TOKEN_UNKNOWN;
+        token->data.u64 = 0;
+        if (c == '"') {
+            const char* eol = strchr(text + start + 1, '\n');
+            size_t end = eol ? (size_t)(eol - text) : strlen(text);
+            if (end > start + 1 && text[end - 1] == '\r') end--;
+            ref->pos = end;
+            _ref_report(ref, SLN_LEX_UNTERMINATED_STRING);
+        } else if (c == '\'') {
+            ref->pos = start + 1;
+            _ref_report(ref, SLN_LEX_UNTERMINATED_CHAR);
+        } else {
+            size_t len = _ref_invalid_length(text, start);
+            ref->pos = start + (len ? len : 1);
+            while ((len = _ref_invalid_length(text, ref->pos))) ref->pos += len;
+            _ref_report(ref, SLN_LEX_INVALID_TOKEN);
+        }
+    }
+    token->span.offset = (uint32_t)start;
+    token->span.length = (uint32_t)(ref->pos - start);
+    return true;
+}
+
+static void _check_text(const char* name, const char* text) {
+    char padded[TEST_MAX_TEXT + SLN_COMMON_SOURCE_PADDING] = {0};
+    size_t len = strlen(text);
+    SLN_TEST_CHECK(len < TEST_MAX_TEXT, "%s: text too long for the reference", name);
+    if (len >= TEST_MAX_TEXT) return;
+    memcpy(padded, text, len);
+
+    sln_utils_intern_t* symbols = sln_utils_intern_create();
+    FILE* sink = tmpfile();
+    sln_lex_token_buffer_t buffer = {0};
+    sln_lex_error_t status = sln_lex_generate(padded, &buffer, symbols, sink);
+
+    _ref_t ref = { padded, 0, symbols, SLN_LEX_OK };
+    sln_lex_token_t expected;
+    size_t i = 0;
+    bool same = true;
+    for (bool more = true; more && same; i++) {
+        more = _ref_next(&ref, &expected);
+        if (!more) {
+            expected = (sln_lex_token_t){ .type = SLN_LEX_TOKEN_EOF, .span = { (uint32_t)ref.pos, 0 } };
+        }
+        if (i >= buffer.len) {
+            SLN_TEST_CHECK(false, "%s: token %zu missing (type %d at %u)", name, i,
+                           (int)expected.type, expected.span.offset);
+            same = false;
+            break;
+        }
+        const sln_lex_token_t* actual = &buffer.tokens[i];
+        same = sln_test_same_token(actual, &expected);
+        SLN_TEST_CHECK(same, "%s: token %zu is type %d [%u,+%u), expected type %d [%u,+%u)", name, i,
+                       (int)actual->type, actual->span.offset, actual->span.length,
+                       (int)expected.type, expected.span.offset, expected.span.length);
+    }
+    SLN_TEST_CHECK(!same || i == buffer.len, "%s: %zu tokens, expected %zu", name, buffer.len, i);
+    SLN_TEST_CHECK(status == ref.status, "%s: status %d, expected %d", name, (int)status, (int)ref.status);
+
+    sln_lex_free_tokens(&buffer);
+    if (sink) fclose(sink);
+    sln_utils_intern_destroy(symbols);
+}
+
+static void _check_example(const char* path) {
+    sln_common_source_t source = {0};
+    SLN_TEST_CHECK(sln_common_source_load(&source, path), "cannot load %s", path);
+    if (!source.text) return;
+    _check_text(path, source.text);
+    sln_common_source_free(&source);
+}
+
+static void _check_operators(void) {
+    char text[TEST_MAX_TEXT];
+    size_t len = 0;
+    for (size_t i = 0; i < TEST_COUNT(_operators); i++) {
+        len += (size_t)snprintf(text + len, sizeof(text) - len, "%s ", _operators[i]);
+    }
+    _check_text("operators", text);
+
+    // Every pair without a blank, for the longest-match rule
+    for (size_t i = 0; i < TEST_COUNT(_operators); i++) {
+        len = 0;
+        for (size_t j = 0; j < TEST_COUNT(_operators); j++) {
+            len += (size_t)snprintf(text + len, sizeof(text) - len, "%s%s\n", _operators[i], _operators[j]);
+        }
+        _check_text("operator pairs", text);
+    }
+    _check_text("operator runs", "<<<= >>>= .... ..... ->> -->= :::: ::: +++= ---> &&& ||| === !== <<=< >=>");
+}
+
+static const char* const _cases[][2] = {
+    { "integers", "0 7 42 1234567890 18446744073709551615 00 017 0777 08 09 0x0 0xFF 0XdeadBEEF 0b0 0B101 1_000" },
+    { "integer overflow", "18446744073709551616 99999999999999999999999" },
+    { "hex overflow", "0xffffffffffffffff 0x10000000000000000" },
+    { "binary overflow", "0b1111111111111111111111111111111111111111111111111111111111111111 "
+                         "0b11111111111111111111111111111111111111111111111111111111111111111" },
+    { "octal overflow", "01777777777777777777777 02000000000000000000000" },
+    { "bad prefixes", "0x 0b 0b2 0xg 0X 0B" },
+    { "floats", "1.5 1. 0.1 1e10 1E-5 2.5e+3 1e 1e+ 1.e5 .5 0.0001 3.14159265358979323846264338327950288 "
+                "1e400 1e-400 123456789012345678901234567890.5 9.999999999999999999e-1 4.9406564584124654e-324 "
+                "1.7976931348623157e308 0e0 00.5 1.2.3" },
+    { "strings", "\"\" \"abc\" \"a\\\"b\" \"\\n\\t\\\\\\x41\\x4\\0\" \"\\q\\'\" \"two\nlines\" \"#no comment\" \"x\"\"y\"" },
+    { "long string", "\"0123456789012345678901234567890123456789012345678901234567890123456789\\n01234567890123456789\"" },
+    { "unterminated string", "a \"open\nb \"crlf\r\nc \"\\\"" },
+    { "chars", "'a' '\\n' '\\x41' '\\xff' '\\'' '\\\\' '\"' ' ' '\\0' '#'" },
+    { "bad chars", "'' 'ab' 'a ''" },
+    { "line comments", "# line\nx #\ny # trailing\r\nz #" },
+    { "block comments", "## block ## x ## multi\nline ## y ## # inner # ## ### triple ### #### z" },
+    { "unterminated block", "a ## runs # to the end" },
+    { "line breaks", "a\nb\r\nc\rd\r\r\n\n\n" },
+    { "invalid", "$ ` \\ \x01\x7f a$b $$ \r x\\y" },
+    { "keywords", "namespace type struct enum use var return for while if else switch case default break "
+                  "continue nil i8 i16 i32 i64 u8 u16 u32 u64 bln usize str MAIN ARGS main args i128 u7 Type _" },
+    { "mixed", "use cli::io;\nMAIN(ARGS) -> i32 {\n    var x: u8 = 0x1F << 2; # shift\n    x %= 3; x ^= 1;\n"
+               "    io::print(\"x = \", x...);\n    return x >= 2 ? 'y' : 'n';\n}\n" },
+};
+
+// Deterministic texts glued from fragments, with or without blanks between them
+static void _check_generated(void) {
+    static const char* const fragments[] = {
+        "a", "_b1", "var", "i64", "0", "07", "0x1f", "0b10", "3.5", "1e-3", "99999999999999999999", "\"s\"",
+        "\"e\\x4\\n\"", "'c'", "'\\t'", "#c\n", "## b ##", "##\n##", "\n", "\r\n", "::", "->", "...", "<<=",
+        ">>", "%=", "^=", "@", "(", "}", "$", "\r", "'", ".", "e", "x",
+    };
+    uint64_t state = 1;
+    char text[TEST_MAX_TEXT];
+    for (int round = 0; round < 300; round++) {
+        size_t len = 0;
+        for (int k = 0; k < 40; k++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            const char* fragment = fragments[(state >> 33) % TEST_COUNT(fragments)];
+            const char* separator = (state >> 20) % 3 == 0 ? "" : " ";
+            len += (size_t)snprintf(text + len, sizeof(text) - len, "%s%s", fragment, separator);
+        }
+        _check_text("generated", text);
+    }
+}
+
+int main(void) {
+    _check_example(SLN_TEST_EXAMPLE("basic/syntax.sl"));
+    _check_example(SLN_TEST_EXAMPLE("ext/optimizise_project1.sl"));
+    _check_operators();
+    for (size_t i = 0; i < TEST_COUNT(_cases); i++) _check_text(_cases[i][0], _cases[i][1]);
+    _check_generated();
+    return SLN_TEST_RESULT();
+}
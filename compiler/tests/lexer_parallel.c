@@ -0,0 +1,309 @@
+/**
+ * @file lexer_parallel.c
+ * @brief sln_lex_generate_parallel() and the driver against serial lexing.
+ *
+ * Texts of a few megabytes are made mostly of multi-line `##` comments
+ * holding quotes and multi-line strings holding `##`, so the line
+ * starts the text is split at fall inside them. Each is lexed serially
+ * and in parallel, on threads and on a pool, with fresh interners:
+ * tokens, symbol ids, status and diagnostics must all match. The driver
+ * must then give a large unit the same tokens with four jobs, which lex
+ * it in parts, as with one.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <driver/driver.h>
+#include <lexer/lexer.h>
+#include <lexer/lexer_tokens.h>
+#include <common/source.h>
+#include <utils/intern.h>
+#include <utils/thread_pool.h>
+
+#include "test_util.h"
+
+#define TEST_TEXT_SIZE (2u * 1024u * 1024u)
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} _text_t;
+
+static uint64_t _next(uint64_t* state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+static void _append(_text_t* text, const char* piece) {
+    size_t len = strlen(piece);
+    if (!text->data) return;
+    if (text->len + len + SLN_COMMON_SOURCE_PADDING > text->cap) {
+        size_t cap = (text->cap ? text->cap * 2 : 4096) + len;
+        char* data = realloc(text->data, cap);
+        if (!data) {
+            free(text->data);
+            text->data = NULL;
+            return;
+        }
+        text->data = data;
+        text->cap = cap;
+    }
+    memcpy(text->data + text->len, piece, len);
+    text->len += len;
+    memset(text->data + text->len, 0, SLN_COMMON_SOURCE_PADDING);
+}
+
+static const char* const _code[] = {
+    "let value = call(1, 2.5, 'c') + 0x1F;\n",
+    "while (i < 10) { i += 1; } # line comment with \" and ##\n",
+    "fn name::space -> int { ret \"short\"; }\n",
+    "x = y << 2 >> 1 ... z;\r\n",
+};
+static const char* const _comment_lines[] = {
+    "  a \"quote that never closes here\n",
+    "  # a hash, and 'a char\n",
+    "  fn looks(like) -> code { \"and a string\" }\n",
+    "\n",
+};
+static const char* const _string_lines[] = {
+    "  ## not a comment inside a string\n",
+    "  # nor this, \\\" escaped quote\n",
+    "  fn looks(like) -> code ## { }\n",
+    "\n",
+};
+
+static void _lines(_text_t* text, const char* const lines[4], size_t count, uint64_t* state) {
+    for (size_t i = 0; i < count; i++) _append(text, lines[_next(state) % 4]);
+}
+
+typedef enum {
+    _SHAPE_COMMENT,     /**< One comment over nearly all of the text */
+    _SHAPE_STRING,      /**< One string over nearly all of the text */
+    _SHAPE_MIXED,       /**< Comments, strings and code of random sizes */
+    _SHAPE_OPEN_COMMENT,
+    _SHAPE_OPEN_STRING,
+    _SHAPE_ERRORS,      /**< Mixed, with some invalid characters */
+    _SHAPE_CAPPED,      /**< More invalid characters than are reported */
+} _shape_t;
+
+static const char* const _shape_names[] = {
+    "comment", "string", "mixed", "unterminated comment", "unterminated string", "errors", "capped",
+};
+
+static _text_t _generate(_shape_t shape, uint64_t seed) {
+    _text_t text = { malloc(4096), 0, 4096 };
+    uint64_t state = seed;
+    _append(&text, _code[0]);
+    switch (shape) {
+        case _SHAPE_COMMENT:
+        case _SHAPE_OPEN_COMMENT:
+            _append(&text, "##\n");
+            while (text.data && text.len < TEST_TEXT_SIZE) _lines(&text, _comment_lines, 64, &state);
+            if (shape == _SHAPE_COMMENT) _append(&text, "##\n");
+            break;
+        case _SHAPE_STRING:
+        case _SHAPE_OPEN_STRING:
+            _append(&text, "s = \"\n");
+            while (text.data && text.len < TEST_TEXT_SIZE) _lines(&text, _string_lines, 64, &state);
+            if (shape == _SHAPE_STRING) _append(&text, "\";\n");
+            break;
+        default:
+            while (text.data && text.len < TEST_TEXT_SIZE) {
+                size_t lines = 1 + (size_t)(_next(&state) % 4096);
+                switch (_next(&state) % 3) {
+                    case 0:
+                        _append(&text, "##\n");
+                        _lines(&text, _comment_lines, lines, &state);
+                        _append(&text, "##\n");
+                        break;
+                    case 1:
+                        _append(&text, "s = \"\n");
+                        _lines(&text, _string_lines, lines, &state);
+                        _append(&text, "\";\n");
+                        break;
+                    default:
+                        _lines(&text, _code, lines, &state);
+                        break;
+                }
+                if (shape == _SHAPE_ERRORS && _next(&state) % 8 == 0) _append(&text, "a $ b ` c\n");
+                if (shape == _SHAPE_CAPPED) _append(&text, "$ $ $ $ $ $ $ $ $ $ $ $ $ $ $ $ $ $ $ $\n");
+            }
+            break;
+    }
+    _append(&text, _code[2]);
+    return text;
+}
+
+// Everything written to a diagnostics stream so far
+static char* _contents(FILE* file) {
+    long size = ftell(file);
+    char* data = calloc((size_t)(size > 0 ? size : 0) + 1, 1);
+    if (!data) return NULL;
+    rewind(file);
+    size_t read = fread(data, 1, (size_t)(size > 0 ? size : 0), file);
+    data[read] = '\0';
+    return data;
+}
+
+static void _check_parallel(const char* name, const char* text, const sln_lex_token_buffer_t* expected,
+                            sln_lex_error_t expected_status, const char* expected_diags,
+                            size_t threads, sln_utils_pool_t* pool) {
+    sln_utils_intern_t* symbols = sln_utils_intern_create();
+    FILE* sink = tmpfile();
+    if (!symbols || !sink) {
+        SLN_TEST_CHECK(false, "%s: setup failed", name);
+        if (symbols) sln_utils_intern_destroy(symbols);
+        if (sink) fclose(sink);
+        return;
+    }
+
+    const char* mode = pool ? "pool" : "threads";
+    sln_lex_token_buffer_t actual = {0};
+    sln_lex_error_t status = sln_lex_generate_parallel(text, &actual, symbols, sink, threads, pool);
+    SLN_TEST_CHECK(status == expected_status, "%s (%zu %s): status %d, expected %d",
+                   name, threads, mode, (int)status, (int)expected_status);
+
+    bool same = true;
+    for (size_t i = 0; same && i < actual.len && i < expected->len; i++) {
+        same = sln_test_same_token(&actual.tokens[i], &expected->tokens[i]);
+        SLN_TEST_CHECK(same, "%s (%zu %s): token %zu is type %d [%u,+%u), expected type %d [%u,+%u)",
+                       name, threads, mode, i, (int)actual.tokens[i].type, actual.tokens[i].span.offset,
+                       actual.tokens[i].span.length, (int)expected->tokens[i].type,
+                       expected->tokens[i].span.offset, expected->tokens[i].span.length);
+    }
+    SLN_TEST_CHECK(actual.len == expected->len, "%s (%zu %s): %zu tokens, expected %zu",
+                   name, threads, mode, actual.len, expected->len);
+
+    char* diags = _contents(sink);
+    SLN_TEST_CHECK(diags && strcmp(diags, expected_diags) == 0, "%s (%zu %s): diagnostics differ",
+                   name, threads, mode);
+    free(diags);
+    sln_lex_free_tokens(&actual);
+    fclose(sink);
+    sln_utils_intern_destroy(symbols);
+}
+
+static void _check_text(const char* name, const char* text, sln_utils_pool_t* pool) {
+    sln_utils_intern_t* symbols = sln_utils_intern_create();
+    FILE* sink = tmpfile();
+    if (!symbols || !sink) {
+        SLN_TEST_CHECK(false, "%s: setup failed", name);
+        if (symbols) sln_utils_intern_destroy(symbols);
+        if (sink) fclose(sink);
+        return;
+    }
+    sln_lex_token_buffer_t expected = {0};
+    sln_lex_error_t expected_status = sln_lex_generate(text, &expected, symbols, sink);
+    char* expected_diags = _contents(sink);
+    SLN_TEST_CHECK(expected_diags != NULL, "%s: cannot read diagnostics", name);
+
+    static const size_t threads[] = { 2, 3, 4, 8 };
+    for (size_t i = 0; expected_diags && i < sizeof(threads) / sizeof(threads[0]); i++) {
+        _check_parallel(name, text, &expected, expected_status, expected_diags, threads[i], NULL);
+        if (pool) _check_parallel(name, text, &expected, expected_status, expected_diags, threads[i], pool);
+    }
+
+    free(expected_diags);
+    sln_lex_free_tokens(&expected);
+    fclose(sink);
+    sln_utils_intern_destroy(symbols);
+}
+
+// Tokens and trivia of the one unit a driver run emits. Both runs
+// intern in token order into a fresh interner, so symbol ids match too
+typedef struct {
+    sln_lex_token_t* tokens;
+    size_t len;
+    sln_lex_trivia_item_t* trivia;
+    size_t trivia_len;
+    sln_lex_error_t status;
+    bool failed;
+} _emitted_t;
+
+static void _capture(const sln_driver_unit_t* unit, FILE* out, void* user) {
+    (void)out;
+    _emitted_t* emitted = user;
+    emitted->status = unit->status;
+    size_t len = unit->tokens ? unit->tokens->len : 0;
+    size_t trivia_len = unit->tokens ? unit->tokens->trivia.len : 0;
+    emitted->tokens = calloc(len + 1, sizeof(sln_lex_token_t));
+    emitted->trivia = calloc(trivia_len + 1, sizeof(sln_lex_trivia_item_t));
+    emitted->failed = !emitted->tokens || !emitted->trivia;
+    for (size_t i = 0; !emitted->failed && i < len; i++) {
+        emitted->tokens[i] = sln_lex_tokens_get(unit->tokens, i);
+    }
+    if (!emitted->failed && trivia_len) {
+        memcpy(emitted->trivia, unit->tokens->trivia.items, trivia_len * sizeof(sln_lex_trivia_item_t));
+    }
+    emitted->len = emitted->failed ? 0 : len;
+    emitted->trivia_len = emitted->failed ? 0 : trivia_len;
+}
+
+static _emitted_t _run_driver(const char* path, size_t jobs) {
+    _emitted_t emitted = {0};
+    sln_utils_intern_t* symbols = sln_utils_intern_create();
+    if (!symbols) {
+        emitted.failed = true;
+        return emitted;
+    }
+    sln_input_arg_t arg = { .type = SLN_IN_ARG_TYPE_FILE, .cstr = path };
+    sln_driver_options_t options = { .jobs = jobs, .emit = _capture, .user = &emitted };
+    sln_exit_code_t code = sln_driver_run(&arg, 1, symbols, &options);
+    emitted.failed = emitted.failed || code == SLN_EXIT_FAILURE_INTERNAL;
+
+    sln_utils_intern_destroy(symbols);
+    return emitted;
+}
+
+static void _check_driver(const char* name, const _text_t* text) {
+    char path[] = "/tmp/selena_lexer_parallel_XXXXXX";
+    int fd = mkstemp(path);
+    SLN_TEST_CHECK(fd >= 0, "%s: cannot create a temporary file", name);
+    if (fd < 0) return;
+    bool written = write(fd, text->data, text->len) == (ssize_t)text->len;
+    close(fd);
+    SLN_TEST_CHECK(written, "%s: cannot write the temporary file", name);
+
+    _emitted_t serial = _run_driver(path, 1);
+    _emitted_t parallel = _run_driver(path, 4);
+    unlink(path);
+    SLN_TEST_CHECK(!serial.failed && !parallel.failed, "%s: driver run failed", name);
+    SLN_TEST_CHECK(serial.status == parallel.status, "%s: driver status %d with 4 jobs, %d with 1",
+                   name, (int)parallel.status, (int)serial.status);
+    SLN_TEST_CHECK(serial.len == parallel.len, "%s: driver gave %zu tokens with 4 jobs, %zu with 1",
+                   name, parallel.len, serial.len);
+    for (size_t i = 0; i < serial.len && i < parallel.len; i++) {
+        bool same = sln_test_same_token(&parallel.tokens[i], &serial.tokens[i]);
+        SLN_TEST_CHECK(same, "%s: driver token %zu differs with 4 jobs", name, i);
+        if (!same) break;
+    }
+    bool same_trivia = serial.trivia_len == parallel.trivia_len &&
+        (serial.trivia_len == 0 ||
+         memcmp(serial.trivia, parallel.trivia, serial.trivia_len * sizeof(sln_lex_trivia_item_t)) == 0);
+    SLN_TEST_CHECK(same_trivia, "%s: driver trivia differ with 4 jobs", name);
+    free(serial.tokens);
+    free(parallel.tokens);
+    free(serial.trivia);
+    free(parallel.trivia);
+}
+
+int main(void) {
+    sln_utils_pool_t* pool = sln_utils_pool_create(4);
+    SLN_TEST_CHECK(pool != NULL, "cannot create the pool");
+
+    for (size_t shape = 0; shape < sizeof(_shape_names) / sizeof(_shape_names[0]); shape++) {
+        _text_t text = _generate((_shape_t)shape, 11 + shape);
+        SLN_TEST_CHECK(text.data != NULL, "%s: cannot allocate the text", _shape_names[shape]);
+        if (!text.data) continue;
+        _check_text(_shape_names[shape], text.data, pool);
+        if (shape == _SHAPE_MIXED || shape == _SHAPE_COMMENT) _check_driver(_shape_names[shape], &text);
+        free(text.data);
+    }
+
+    if (pool) sln_utils_pool_destroy(pool);
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,136 @@
+/**
+ * @file lexer_relex.c
+ * @brief sln_lex_relex() after random edits against lexing the whole text.
+ *
+ * Each run applies a chain of random edits to one buffer: inserted
+ * pieces open and close `##` comments, strings and characters, add
+ * escapes and line breaks, and deletions cut through all of them. After
+ * every edit the buffer must hold exactly the tokens (kind, span,
+ * payload) sln_lex_generate() gives for the new text, and the first
+ * unterminated string must not lie before the buffer's bound for it.
+ * Diagnostics are printed for relexed tokens only, so they are not
+ * compared.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lexer/lexer.h>
+#include <common/source.h>
+#include <utils/intern.h>
+
+#include "test_util.h"
+
+#define TEST_TEXT_MAX (16u * 1024u)
+#define TEST_EDITS 400
+
+static uint64_t _next(uint64_t* state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+static const char* const _pieces[] = {
+    "\"", "\"", "##", "##", "#", "\n", "\r\n", "\\", "'", "\\\"",
+    "\"text\"", "## block ##", "'c'", "name", " ", "0x1F", "2.5", "<<=", "...", "$",
+    "\"open\n", "##\nclosed later", "call(a, b);\n",
+};
+
+static void _check_buffer(const char* name, size_t step, const char* text,
+                          const sln_lex_token_buffer_t* actual, sln_utils_intern_t* symbols, FILE* sink) {
+    sln_lex_token_buffer_t expected = {0};
+    sln_lex_error_t status = sln_lex_generate(text, &expected, symbols, sink);
+    SLN_TEST_CHECK(status != SLN_LEX_ALLOCATION_FAILED, "%s: lexing failed", name);
+
+    bool same = actual->len == expected.len;
+    SLN_TEST_CHECK(same, "%s, edit %zu: %zu tokens, expected %zu", name, step, actual->len, expected.len);
+    for (size_t i = 0; same && i < expected.len; i++) {
+        same = sln_test_same_token(&actual->tokens[i], &expected.tokens[i]);
+        SLN_TEST_CHECK(same, "%s, edit %zu: token %zu is type %d [%u,+%u), expected type %d [%u,+%u)",
+                       name, step, i, (int)actual->tokens[i].type, actual->tokens[i].span.offset,
+                       actual->tokens[i].span.length, (int)expected.tokens[i].type,
+                       expected.tokens[i].span.offset, expected.tokens[i].span.length);
+    }
+    SLN_TEST_CHECK(actual->unterminated <= expected.unterminated,
+                   "%s, edit %zu: unterminated string bound %zu is past the first one at %zu",
+                   name, step, actual->unterminated, expected.unterminated);
+    sln_lex_free_tokens(&expected);
+}
+
+static void _check_edits(const char* name, const char* initial, uint64_t seed) {
+    char* text = calloc(TEST_TEXT_MAX + SLN_COMMON_SOURCE_PADDING, 1);
+    char* next = calloc(TEST_TEXT_MAX + SLN_COMMON_SOURCE_PADDING, 1);
+    sln_utils_intern_t* symbols = sln_utils_intern_create();
+    FILE* sink = tmpfile();
+    if (!text || !next || !symbols || !sink) {
+        SLN_TEST_CHECK(false, "%s: setup failed", name);
+        free(text);
+        free(next);
+        if (symbols) sln_utils_intern_destroy(symbols);
+        if (sink) fclose(sink);
+        return;
+    }
+    size_t len = strlen(initial);
+    if (len > TEST_TEXT_MAX / 2) len = TEST_TEXT_MAX / 2;
+    memcpy(text, initial, len);
+
+    sln_lex_token_buffer_t buffer = {0};
+    sln_lex_error_t status = sln_lex_generate(text, &buffer, symbols, sink);
+    SLN_TEST_CHECK(status != SLN_LEX_ALLOCATION_FAILED, "%s: lexing failed", name);
+
+    uint64_t state = seed;
+    for (size_t step = 0; step < TEST_EDITS && buffer.tokens; step++) {
+        const char* piece = _pieces[_next(&state) % (sizeof(_pieces) / sizeof(_pieces[0]))];
+        size_t offset = len ? (size_t)(_next(&state) % (len + 1)) : 0;
+        size_t removed = (size_t)(_next(&state) % 4 == 0 ? _next(&state) % 24 : 0);
+        if (removed > len - offset) removed = len - offset;
+        size_t inserted = _next(&state) % 5 == 0 ? 0 : strlen(piece);
+        if (len - removed + inserted > TEST_TEXT_MAX) {
+            inserted = 0;
+            removed = len - offset;
+        }
+
+        memcpy(next, text, offset);
+        memcpy(next + offset, piece, inserted);
+        memcpy(next + offset + inserted, text + offset + removed, len - offset - removed);
+        len = len - removed + inserted;
+        memset(next + len, 0, SLN_COMMON_SOURCE_PADDING);
+        char* swap = text;
+        text = next;
+        next = swap;
+
+        sln_lex_edit_t edit = { offset, removed, inserted };
+        sln_lex_relexed_t relexed;
+        status = sln_lex_relex(text, &buffer, &edit, symbols, sink, &relexed);
+        SLN_TEST_CHECK(status != SLN_LEX_ALLOCATION_FAILED, "%s, edit %zu: relexing failed", name, step);
+        if (!buffer.tokens) break;
+        SLN_TEST_CHECK(relexed.first + relexed.inserted <= buffer.len, "%s, edit %zu: relexed range [%zu,+%zu) past %zu tokens",
+                       name, step, relexed.first, relexed.inserted, buffer.len);
+        _check_buffer(name, step, text, &buffer, symbols, sink);
+    }
+
+    sln_lex_free_tokens(&buffer);
+    fclose(sink);
+    sln_utils_intern_destroy(symbols);
+    free(next);
+    free(text);
+}
+
+static void _check_example(const char* path) {
+    sln_common_source_t source = {0};
+    SLN_TEST_CHECK(sln_common_source_load(&source, path), "cannot load %s", path);
+    if (!source.text) return;
+    for (uint64_t seed = 1; seed <= 8; seed++) _check_edits(path, source.text, seed);
+    sln_common_source_free(&source);
+}
+
+int main(void) {
+    _check_example(SLN_TEST_EXAMPLE("basic/syntax.sl"));
+    _check_example(SLN_TEST_EXAMPLE("ext/optimizise_project1.sl"));
+    for (uint64_t seed = 1; seed <= 32; seed++) {
+        _check_edits("empty", "", seed);
+        _check_edits("open string", "a = \"no end\nb = 1; # \\\"\nc = 'x';\n", seed);
+        _check_edits("open comment", "a = 1;\n## no end \" quote\nb = \"s\";\n", seed);
+    }
+    return SLN_TEST_RESULT();
+}
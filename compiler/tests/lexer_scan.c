@@ -0,0 +1,233 @@
+/**
+ * @file lexer_scan.c
+ * @brief Every scanning kernel set the CPU supports, called directly.
+ *
+ * skip_blanks, find_eol, find_hash and find_quote of each set must
+ * return the byte the scalar loops stop at. The scan starts at each of
+ * the 64 offsets past a 64-byte boundary, and the stopping byte, each
+ * one the kernel stops at and NUL, is placed 0 to 63 bytes further.
+ * The bytes before the start all stop the scan and another stop
+ * follows the first, so a kernel that reads its first aligned block
+ * without masking the bytes before `p`, or returns a later match,
+ * fails.
+ *
+ * find_invalid_utf8 of each set must stop where decoding the range
+ * with sln_lex_utf8_decode() first fails. Well-formed and ill-formed
+ * sequences are placed across the 16- and 32-byte block edges the SSE2
+ * and AVX2 kernels work in, with the range ending after, exactly at
+ * the end of, and inside the sequence; random texts of mixed sequences
+ * with some bytes corrupted cover the rest.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <lexer/lexer_scan.h>
+#include <lexer/lexer_utf8.h>
+
+#include "test_util.h"
+
+#define TEST_BUFFER 256
+#define TEST_SCAN_SPAN 64
+#define TEST_UTF8_SPAN 80
+#define TEST_UTF8_RANDOM 4000
+
+typedef struct {
+    const char* bytes;
+    bool valid;
+} _sequence_t;
+
+typedef const char* (*_scan_fn_t)(const char* p);
+
+typedef struct {
+    const char* name;
+    _scan_fn_t (*kernel)(const sln_lex_scan_kernels_t* set);
+    const char* filler;                 /**< Bytes the scan goes past, in a cycle */
+    const char* stops;                  /**< Bytes it stops at besides NUL */
+} _scan_t;
+
+static _scan_fn_t _skip_blanks(const sln_lex_scan_kernels_t* set) { return set->skip_blanks; }
+static _scan_fn_t _find_eol(const sln_lex_scan_kernels_t* set) { return set->find_eol; }
+static _scan_fn_t _find_hash(const sln_lex_scan_kernels_t* set) { return set->find_hash; }
+static _scan_fn_t _find_quote(const sln_lex_scan_kernels_t* set) { return set->find_quote; }
+
+// Fillers hold the stops of the other kernels and bytes above 0x7F
+static const _scan_t _scans[] = {
+    { "skip_blanks", _skip_blanks, " \t  \t", "x\n#\"\r\x80\xA0\xFF" },
+    { "find_eol", _find_eol, "ab #\"\\\t\r\x80\xFF", "\n" },
+    { "find_hash", _find_hash, "ab \n\"\\\t\x80\xFF", "#" },
+    { "find_quote", _find_quote, "ab \n#\t\r\x80\xFF", "\"\\" },
+};
+
+// Stop `stop` at `at` bytes past `align`, in every kernel set
+static void _check_stop(const sln_lex_scan_kernels_t* sets, size_t count, const _scan_t* scan,
+                        size_t align, size_t at, char stop) {
+    static _Alignas(64) char buffer[TEST_BUFFER];
+    size_t filler_len = strlen(scan->filler);
+    char* p = buffer + align;
+    memset(buffer, scan->stops[0], align);
+    for (size_t i = 0; i < TEST_BUFFER - align - 1; i++) p[i] = scan->filler[(i + at) % filler_len];
+    buffer[TEST_BUFFER - 1] = '\0';
+    p[at] = stop;
+    p[at + 1 + at % 3] = scan->stops[0];
+
+    const char* expected = p + at;
+    for (size_t k = 0; k < count; k++) {
+        const char* actual = scan->kernel(&sets[k])(p);
+        SLN_TEST_CHECK(actual == expected, "%s %s: stopped at %td for byte 0x%02X at %zu past alignment %zu",
+                       sets[k].name, scan->name, actual - p, (unsigned)(unsigned char)stop, at, align);
+    }
+}
+
+static void _check_scans(const sln_lex_scan_kernels_t* sets, size_t count) {
+    for (size_t s = 0; s < sizeof(_scans) / sizeof(_scans[0]); s++) {
+        const _scan_t* scan = &_scans[s];
+        size_t stop_count = strlen(scan->stops);
+        for (size_t align = 0; align < TEST_SCAN_SPAN; align++) {
+            for (size_t at = 0; at < TEST_SCAN_SPAN; at++) {
+                for (size_t i = 0; i <= stop_count; i++) _check_stop(sets, count, scan, align, at, scan->stops[i]);
+            }
+        }
+    }
+}
+
+// Well-formed sequences first, as _check_random() picks among them by index
+static const _sequence_t _sequences[] = {
+    { "\xC2\x80", true },                   // smallest 2-byte
+    { "\xC3\xA9", true },
+    { "\xDF\xBF", true },
+    { "\xE0\xA0\x80", true },               // smallest 3-byte
+    { "\xE2\x82\xAC", true },
+    { "\xED\x9F\xBF", true },               // below the surrogates
+    { "\xEE\x80\x80", true },
+    { "\xEF\xBF\xBF", true },
+    { "\xF0\x90\x80\x80", true },           // smallest 4-byte
+    { "\xF0\x9F\x98\x80", true },
+    { "\xF4\x8F\xBF\xBF", true },           // U+10FFFF
+    { "\x80", false },                      // continuation without a lead
+    { "\xBF\xBF", false },
+    { "\xC0\x80", false },                  // overlong
+    { "\xC1\xBF", false },
+    { "\xE0\x80\x80", false },
+    { "\xE0\x9F\xBF", false },
+    { "\xF0\x80\x80\x80", false },
+    { "\xF0\x8F\xBF\xBF", false },
+    { "\xED\xA0\x80", false },              // surrogates
+    { "\xED\xBF\xBF", false },
+    { "\xF4\x90\x80\x80", false },          // above U+10FFFF
+    { "\xF5\x80\x80\x80", false },
+    { "\xFF", false },
+    { "\xC3" "A", false },                  // cut short by ASCII
+    { "\xE2\x82" "A", false },
+    { "\xF0\x9F\x98" "A", false },
+    { "\xC3\xC3\xA9", false },              // cut short by a lead
+    { "\xE2\xE2\x82\xAC", false },
+};
+
+// First byte of [p, end) where sln_lex_utf8_decode() fails or runs past end
+static const char* _reference_utf8(const char* p, const char* end) {
+    while (p < end) {
+        uint32_t code_point;
+        size_t len = sln_lex_utf8_decode(p, &code_point);
+        if (!len || len > (size_t)(end - p)) return p;
+        p += len;
+    }
+    return end;
+}
+
+static void _check_range(const sln_lex_scan_kernels_t* set, const char* p, const char* end, const char* what) {
+    const char* expected = _reference_utf8(p, end);
+    const char* actual = set->find_invalid_utf8(p, end);
+    SLN_TEST_CHECK(actual == expected, "%s find_invalid_utf8, %s: stopped at %td, expected %td",
+                   set->name, what, actual - p, expected - p);
+}
+
+// One sequence at each offset of a text of `filler`, starting `align` bytes past a 64-byte boundary
+static void _check_placed(const sln_lex_scan_kernels_t* set, const _sequence_t* sequence, const char* filler) {
+    static _Alignas(64) char buffer[TEST_BUFFER];
+    static const size_t aligns[] = { 0, 1, 7, 15, 16, 31 };
+    size_t len = strlen(sequence->bytes);
+    size_t filler_len = strlen(filler);
+    for (size_t a = 0; a < sizeof(aligns) / sizeof(aligns[0]); a++) {
+        char* p = buffer + aligns[a];
+        for (size_t at = 0; at + filler_len <= TEST_UTF8_SPAN; at += filler_len) {
+            memset(buffer, 0, sizeof(buffer));
+            for (size_t i = 0; i + filler_len <= TEST_UTF8_SPAN + 8; i += filler_len) memcpy(p + i, filler, filler_len);
+            memcpy(p + at, sequence->bytes, len);
+
+            char what[96];
+            snprintf(what, sizeof(what), "%s%s at %zu, align %zu", sequence->valid ? "" : "bad ",
+                     filler_len > 1 ? "after 2-byte text" : "after ASCII", at, aligns[a]);
+            _check_range(set, p, p + TEST_UTF8_SPAN + 8, what);
+            // The range ends exactly after the sequence, then inside it
+            _check_range(set, p, p + at + len, what);
+            if (len > 1) _check_range(set, p, p + at + len - 1, what);
+        }
+    }
+}
+
+static uint64_t _next(uint64_t* state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+// Texts of random sequences, valid and not, in which a few bytes may then be overwritten
+static void _check_random(const sln_lex_scan_kernels_t* set) {
+    static _Alignas(64) char buffer[TEST_BUFFER];
+    uint64_t state = 0x0fu;
+    size_t valid_count = 0;
+    for (size_t k = 0; k < sizeof(_sequences) / sizeof(_sequences[0]); k++) valid_count += _sequences[k].valid;
+
+    for (size_t round = 0; round < TEST_UTF8_RANDOM; round++) {
+        memset(buffer, 0, sizeof(buffer));
+        size_t align = _next(&state) % 32;
+        size_t target = 1 + _next(&state) % (TEST_BUFFER - 64);
+        char* p = buffer + align;
+        size_t len = 0;
+        while (len < target) {
+            const char* piece = "a";
+            if (_next(&state) % 3 == 0) {
+                // Mostly valid sequences
+                size_t k = _next(&state) % (sizeof(_sequences) / sizeof(_sequences[0]));
+                if (!_sequences[k].valid && _next(&state) % 8 != 0) k %= valid_count;
+                piece = _sequences[k].bytes;
+            }
+            size_t piece_len = strlen(piece);
+            if (len + piece_len > TEST_BUFFER - 40) break;
+            memcpy(p + len, piece, piece_len);
+            len += piece_len;
+        }
+        if (len > 0 && _next(&state) % 4 == 0) p[_next(&state) % len] = (char)(0x80 + _next(&state) % 0x80);
+
+        char what[64];
+        snprintf(what, sizeof(what), "random text %zu", round);
+        _check_range(set, p, p + len, what);
+        if (len > 0) _check_range(set, p, p + _next(&state) % len, what);
+    }
+}
+
+static void _check_utf8(const sln_lex_scan_kernels_t* set) {
+    for (size_t k = 0; k < sizeof(_sequences) / sizeof(_sequences[0]); k++) {
+        _check_placed(set, &_sequences[k], "a");
+        _check_placed(set, &_sequences[k], "\xC3\xA9");
+    }
+    _check_random(set);
+
+    // Empty ranges
+    static const char empty[] = "";
+    SLN_TEST_CHECK(set->find_invalid_utf8(empty, empty) == empty, "%s find_invalid_utf8: empty range", set->name);
+}
+
+int main(void) {
+    size_t count = 0;
+    const sln_lex_scan_kernels_t* sets = sln_lex_scan_sets(&count);
+    SLN_TEST_CHECK(count >= 1 && strcmp(sets[0].name, "scalar") == 0, "the scalar kernels are not listed first");
+    SLN_TEST_CHECK(strcmp(sln_lex_scan.name, sets[count - 1].name) == 0, "the lexer uses %s rather than %s",
+                   sln_lex_scan.name, sets[count - 1].name);
+    for (size_t i = 0; i < count; i++) {
+        printf("kernels: %s\n", sets[i].name);
+        _check_utf8(&sets[i]);
+    }
+    _check_scans(sets, count);
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,179 @@
+/**
+ * @file lexer_stream.c
+ * @brief Pull lexer over a pipe against sln_lex_generate().
+ *
+ * A writer thread feeds each text into a pipe in chunks of 1 to 16
+ * bytes while the pull lexer reads it through a window of the same
+ * order, so tokens, strings and comments straddle chunk and window
+ * edges everywhere. Every token (kind, input offset, length, payload)
+ * and the final status must match the whole-text lexer.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include <lexer/lexer.h>
+#include <lexer/lexer_stream.h>
+#include <common/source.h>
+#include <common/stream.h>
+#include <utils/intern.h>
+
+#include "test_util.h"
+
+#define TEST_GENERATED_SIZE (32u * 1024u)
+
+typedef struct {
+    int fd;
+    const char* text;
+    size_t len;
+    uint64_t seed;
+} _writer_t;
+
+static uint64_t _next(uint64_t* state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+static int _write_chunks(void* arg) {
+    _writer_t* writer = arg;
+    uint64_t state = writer->seed;
+    for (size_t pos = 0; pos < writer->len;) {
+        size_t chunk = 1 + (size_t)(_next(&state) % 16);
+        if (chunk > writer->len - pos) chunk = writer->len - pos;
+        ssize_t written = write(writer->fd, writer->text + pos, chunk);
+        if (written <= 0) break;
+        pos += (size_t)written;
+    }
+    close(writer->fd);
+    return 0;
+}
+
+static void _check_text(const char* name, const char* text, uint64_t seed) {
+    size_t len = strlen(text);
+    char* padded = calloc(len + SLN_COMMON_SOURCE_PADDING, 1);
+    sln_utils_intern_t* symbols = sln_utils_intern_create();
+    FILE* sink = tmpfile();
+    if (!padded || !symbols || !sink) {
+        SLN_TEST_CHECK(false, "%s: setup failed", name);
+        free(padded);
+        if (symbols) sln_utils_intern_destroy(symbols);
+        if (sink) fclose(sink);
+        return;
+    }
+    memcpy(padded, text, len);
+
+    sln_lex_token_buffer_t expected = {0};
+    sln_lex_error_t expected_status = sln_lex_generate(padded, &expected, symbols, sink);
+
+    int fds[2];
+    SLN_TEST_CHECK(pipe(fds) == 0, "%s: pipe failed", name);
+    _writer_t writer = { fds[1], padded, len, seed };
+    thrd_t thread;
+    bool started = thrd_create(&thread, _write_chunks, &writer) == thrd_success;
+    SLN_TEST_CHECK(started, "%s: writer thread failed", name);
+
+    sln_common_stream_t input;
+    sln_lex_stream_t lexer;
+    size_t chunk_size = 1 + (size_t)(seed % 16);
+    bool opened = started && sln_common_stream_open_fd(&input, fds[0], chunk_size);
+    sln_lex_error_t error = opened ? sln_lex_stream_init(&lexer, &input, symbols, sink) : SLN_LEX_NO_FILE;
+    SLN_TEST_CHECK(error == SLN_LEX_OK, "%s: stream setup failed (%d)", name, (int)error);
+
+    size_t i = 0;
+    bool same = true;
+    sln_lex_token_t token = { .type = SLN_LEX_TOKEN_UNKNOWN };
+    while (error == SLN_LEX_OK && same && token.type != SLN_LEX_TOKEN_EOF) {
+        uint64_t offset;
+        error = sln_lex_stream_next(&lexer, &token, &offset);
+        SLN_TEST_CHECK(error == SLN_LEX_OK, "%s: stream error %d", name, (int)error);
+        if (error != SLN_LEX_OK) break;
+
+        // Compare with input offsets, as the window has moved on
+        token.span.offset = (uint32_t)offset;
+        same = i < expected.len && sln_test_same_token(&token, &expected.tokens[i]);
+        SLN_TEST_CHECK(same, "%s (chunk size %zu): token %zu is type %d [%u,+%u), expected type %d [%u,+%u)",
+                       name, chunk_size, i, (int)token.type, token.span.offset, token.span.length,
+                       i < expected.len ? (int)expected.tokens[i].type : -1,
+                       i < expected.len ? expected.tokens[i].span.offset : 0,
+                       i < expected.len ? expected.tokens[i].span.length : 0);
+        i++;
+    }
+    if (same && error == SLN_LEX_OK) {
+        SLN_TEST_CHECK(i == expected.len, "%s: %zu tokens, expected %zu", name, i, expected.len);
+        SLN_TEST_CHECK(lexer.status == expected_status, "%s: status %d, expected %d",
+                       name, (int)lexer.status, (int)expected_status);
+    }
+
+    if (started) {
+        // Drain what the writer still has, so it can finish
+        char drain[256];
+        while (read(fds[0], drain, sizeof(drain)) > 0) continue;
+        thrd_join(thread, NULL);
+    } else {
+        close(fds[1]);
+    }
+    close(fds[0]);
+    if (opened) sln_common_stream_close(&input);
+    sln_lex_free_tokens(&expected);
+    fclose(sink);
+    sln_utils_intern_destroy(symbols);
+    free(padded);
+}
+
+static void _check_example(const char* path) {
+    sln_common_source_t source = {0};
+    SLN_TEST_CHECK(sln_common_source_load(&source, path), "cannot load %s", path);
+    if (!source.text) return;
+    for (uint64_t seed = 1; seed <= 16; seed++) _check_text(path, source.text, seed);
+    sln_common_source_free(&source);
+}
+
+static const char* const _cases[][2] = {
+    { "operators", "<<= >>= ... :: -> ++ -- && || == != <= >= += -= *= /= %= &= |= ^= << >> @ ? ~ !" },
+    { "numbers", "0 07 0x1F 0b101 123456789 18446744073709551616 1.5 2.5e+10 1e 3.14159265358979323846" },
+    { "strings", "\"\" \"abc\" \"a\\\"b\" \"\\n\\t\\\\\\x41\" \"two\nlines\" \"a long string that spans many chunks\"" },
+    { "unterminated string", "a \"open to the end of the line\nb \"crlf\r\nc \"at the very end" },
+    { "chars", "'a' '\\n' '\\x41' '\\'' '' 'ab'" },
+    { "comments", "# line comment\nx ## block\ncomment ## y ## # not closed # ## z\r\n## to the end" },
+    { "line breaks", "a\nb\r\nc\rd\r\r\n\n" },
+    { "invalid", "$ ` \\ a$b \xff\xfe \xe2\x82" },
+    { "utf-8", "\xd0\xb8\xd0\xbc\xd1\x8f = \"\xe2\x82\xac\"; # \xd0\xba\xd0\xbe\xd0\xbc\xd0\xbc\xd0\xb5\xd0\xbd\xd1\x82\n'\xc3\xa9'" },
+    { "empty", "" },
+};
+
+// The cases above glued with comment markers and quotes that open and
+// close across them, long enough to move the window many times
+static char* _generated(void) {
+    char* text = calloc(TEST_GENERATED_SIZE + 1, 1);
+    if (!text) return NULL;
+    size_t len = 0;
+    uint64_t state = 7;
+    for (;;) {
+        const char* piece = _cases[_next(&state) % (sizeof(_cases) / sizeof(_cases[0]))][1];
+        size_t piece_len = strlen(piece);
+        if (len + piece_len + 8 > TEST_GENERATED_SIZE) break;
+        memcpy(text + len, piece, piece_len);
+        len += piece_len;
+        memcpy(text + len, " ## \"\n", 6);
+        len += 6;
+    }
+    return text;
+}
+
+int main(void) {
+    _check_example(SLN_TEST_EXAMPLE("basic/syntax.sl"));
+    _check_example(SLN_TEST_EXAMPLE("ext/optimizise_project1.sl"));
+    for (size_t i = 0; i < sizeof(_cases) / sizeof(_cases[0]); i++) {
+        for (uint64_t seed = 1; seed <= 16; seed++) _check_text(_cases[i][0], _cases[i][1], seed);
+    }
+    char* generated = _generated();
+    SLN_TEST_CHECK(generated != NULL, "cannot allocate the generated text");
+    if (generated) {
+        for (uint64_t seed = 1; seed <= 4; seed++) _check_text("generated", generated, seed);
+    }
+    free(generated);
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,132 @@
+/**
+ * @file lexer_trivia.c
+ * @brief Dense token streams against the full sln_lex_generate() stream.
+ *
+ * sln_lex_generate_trivia(), sln_lex_generate_tokens() and the lexer
+ * pipe must all give the significant tokens of sln_lex_generate() and
+ * nothing else; merging the trivia back in front of the token each item
+ * is keyed to must give the full stream again.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lexer/lexer.h>
+#include <lexer/lexer_pipe.h>
+#include <lexer/lexer_tokens.h>
+#include <common/source.h>
+#include <utils/intern.h>
+
+#include "test_util.h"
+
+static bool _is_trivia(sln_lex_token_type_t type) {
+    return type == SLN_LEX_TOKEN_EOL || type == SLN_LEX_TOKEN_COMMENT;
+}
+
+// Checks `tokens`, `count` of them, and their trivia against the full stream
+static void _check_dense(const char* name, const char* what, const sln_lex_token_buffer_t* full,
+                         const sln_lex_token_t* tokens, size_t count, const sln_lex_trivia_t* trivia) {
+    size_t index = 0;
+    size_t items = 0;
+    bool same = true;
+    for (size_t i = 0; same && i < full->len; i++) {
+        const sln_lex_token_t* expected = &full->tokens[i];
+        if (_is_trivia(expected->type)) {
+            if (!trivia) continue;
+            same = items < trivia->len && trivia->items[items].token == index &&
+                   trivia->items[items].type == expected->type &&
+                   trivia->items[items].span.offset == expected->span.offset &&
+                   trivia->items[items].span.length == expected->span.length;
+            SLN_TEST_CHECK(same, "%s (%s): trivia item %zu differs from token %zu", name, what, items, i);
+            items++;
+            continue;
+        }
+        same = index < count && sln_test_same_token(&tokens[index], expected);
+        SLN_TEST_CHECK(same, "%s (%s): token %zu differs from token %zu of the full stream", name, what, index, i);
+        index++;
+    }
+    if (!same) return;
+    SLN_TEST_CHECK(index == count, "%s (%s): %zu tokens, expected %zu", name, what, count, index);
+    if (trivia) SLN_TEST_CHECK(items == trivia->len, "%s (%s): %zu trivia items, expected %zu", name, what, trivia->len, items);
+}
+
+static void _check_text(const char* name, const char* text) {
+    sln_utils_intern_t* symbols = sln_utils_intern_create();
+    FILE* sink = tmpfile();
+    if (!symbols || !sink) {
+        SLN_TEST_CHECK(false, "%s: setup failed", name);
+        if (symbols) sln_utils_intern_destroy(symbols);
+        if (sink) fclose(sink);
+        return;
+    }
+
+    sln_lex_token_buffer_t full = {0};
+    sln_lex_error_t status = sln_lex_generate(text, &full, symbols, sink);
+
+    sln_lex_token_buffer_t dense = {0};
+    sln_lex_trivia_t trivia = {0};
+    SLN_TEST_CHECK(sln_lex_generate_trivia(text, &dense, &trivia, symbols, sink) == status,
+                   "%s: sln_lex_generate_trivia() status differs", name);
+    _check_dense(name, "trivia", &full, dense.tokens, dense.len, &trivia);
+
+    sln_lex_tokens_t stream = {0};
+    SLN_TEST_CHECK(sln_lex_generate_tokens(text, &stream, symbols, sink) == status,
+                   "%s: sln_lex_generate_tokens() status differs", name);
+    sln_lex_token_t* expanded = calloc(stream.len + 1, sizeof(sln_lex_token_t));
+    for (size_t i = 0; expanded && i < stream.len; i++) expanded[i] = sln_lex_tokens_get(&stream, i);
+    if (expanded) _check_dense(name, "tokens", &full, expanded, stream.len, &stream.trivia);
+
+    sln_lex_pipe_t* pipe = NULL;
+    SLN_TEST_CHECK(sln_lex_pipe_open(text, symbols, sink, &pipe) == SLN_LEX_OK, "%s: pipe failed", name);
+    sln_lex_token_t* piped = calloc(full.len + 1, sizeof(sln_lex_token_t));
+    size_t piped_len = 0;
+    const sln_lex_batch_t* batch;
+    while (pipe && piped && (batch = sln_lex_pipe_next(pipe))) {
+        SLN_TEST_CHECK(piped_len + batch->len <= full.len, "%s: the pipe gave too many tokens", name);
+        if (piped_len + batch->len > full.len) break;
+        memcpy(piped + piped_len, batch->tokens, batch->len * sizeof(sln_lex_token_t));
+        piped_len += batch->len;
+    }
+    if (pipe) SLN_TEST_CHECK(sln_lex_pipe_close(pipe) == status, "%s: pipe status differs", name);
+    if (piped) _check_dense(name, "pipe", &full, piped, piped_len, NULL);
+
+    free(piped);
+    free(expanded);
+    sln_lex_tokens_free(&stream);
+    sln_lex_free_trivia(&trivia);
+    sln_lex_free_tokens(&dense);
+    sln_lex_free_tokens(&full);
+    fclose(sink);
+    sln_utils_intern_destroy(symbols);
+}
+
+static void _check_example(const char* path) {
+    sln_common_source_t source = {0};
+    SLN_TEST_CHECK(sln_common_source_load(&source, path), "cannot load %s", path);
+    if (!source.text) return;
+    _check_text(path, source.text);
+    sln_common_source_free(&source);
+}
+
+static const char* const _cases[][2] = {
+    { "empty", "" },
+    { "only trivia", "# a\n\n## b ##\r\n" },
+    { "leading and trailing", "\n# c\nx\n## d ##\n" },
+    { "runs", "a\n\n\n# c\n# d\nb ## e\nf ## c\n" },
+    { "unterminated", "a \"open\nb ## open" },
+};
+
+int main(void) {
+    _check_example(SLN_TEST_EXAMPLE("basic/syntax.sl"));
+    _check_example(SLN_TEST_EXAMPLE("ext/optimizise_project1.sl"));
+    for (size_t i = 0; i < sizeof(_cases) / sizeof(_cases[0]); i++) {
+        size_t len = strlen(_cases[i][1]);
+        char* text = calloc(len + SLN_COMMON_SOURCE_PADDING, 1);
+        SLN_TEST_CHECK(text != NULL, "%s: cannot allocate", _cases[i][0]);
+        if (!text) continue;
+        memcpy(text, _cases[i][1], len);
+        _check_text(_cases[i][0], text);
+        free(text);
+    }
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,189 @@
+/**
+ * @file parser_parallel.c
+ * @brief sln_parse_parallel() against sln_parse().
+ *
+ * A generated module with every node kind is parsed serially, then in
+ * parallel with the default chunk size and with chunks of a few tokens,
+ * so even short texts are cut at many items: status, tree node for node
+ * and `extra` word for word, and diagnostics must match. Variants cut
+ * inside an item (`struct { .. }[3]` ends at a '}' the splitter takes
+ * for the end of the item), unbalance the brackets, and put syntax
+ * errors in a late chunk, all of which fall back to sln_parse().
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/thread_pool.h>
+
+#include "parser_util.h"
+
+// Copies of the module items, enough for two default chunks
+#define TEST_COPIES 300
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} _text_t;
+
+static uint64_t _next(uint64_t* state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+static void _append(_text_t* text, const char* piece) {
+    size_t len = strlen(piece);
+    if (!text->data) return;
+    if (text->len + len + 1 > text->cap) {
+        size_t cap = (text->cap ? text->cap * 2 : 4096) + len;
+        char* data = realloc(text->data, cap);
+        if (!data) {
+            free(text->data);
+            text->data = NULL;
+            return;
+        }
+        text->data = data;
+        text->cap = cap;
+    }
+    memcpy(text->data + text->len, piece, len + 1);
+    text->len += len;
+}
+
+// Items that, with the generated functions, hold every node kind but ERROR
+static const char* const _items[] = {
+    "use cli::io;\nuse m::e as ee;\nuse m::e*;\n",
+    "namespace m {\n"
+    "    type s = struct { a: i32, b: u8[4], c: (i32; f64) };\n"
+    "    type e = enum { E1, E2 = 3, @e_ext };\n"
+    "    k: f64 = 1.5;\n"
+    "};\n",
+    "m::e@e_ext = { E3, E4 };\n",
+    "MAIN(ARGS:(m::s)):i32 {\n"
+    "    for (i = 0; i < ARGS.a; i++) { cli::io.println(\"arg\", ARGS.b[i]); }\n"
+    "    return 0;\n"
+    "}\n",
+};
+
+// Body statements of the generated functions
+static const char* const _statements[] = {
+    "    v += a * 2 - 1;\n",
+    "    if (a > 2) { v += 1; } else { v -= 1; }\n",
+    "    while (v < 10) { v++; if (v == 5) { break; } continue; }\n",
+    "    for (i: i32 = 0; i < 3; i++) { v = v << i | 1; }\n",
+    "    switch (v) { case 1 { v = -v; } default { v = !v; } }\n",
+    "    w: str = \"text\";\n    c: char = 'c';\n",
+    "    t = (v, w);\n    l = { 1, 2, { 3, 4 } };\n    n = nil;\n",
+    "    q = b.a[2] -> u8;\n    r = v ? w : v > 1 ? nil : w;\n",
+    "    g(v, w, h(1));\n",
+    "    { { v = (v + 1) * (v - 1); } }\n",
+};
+
+// The module; `flaw`, if not NULL, is inserted after `flaw_at` copies
+static char* _module(const char* flaw, size_t flaw_at) {
+    _text_t text = { malloc(4096), 0, 4096 };
+    if (text.data) text.data[0] = '\0';
+    uint64_t state = 0x5e1e4a;
+    char line[128];
+    for (size_t copy = 0; copy < TEST_COPIES && text.data; copy++) {
+        if (flaw && copy == flaw_at) _append(&text, flaw);
+        _append(&text, _items[copy % (sizeof(_items) / sizeof(_items[0]))]);
+        snprintf(line, sizeof(line), "f%zu(a: i32, b: m::s): (i32; str) = {\n    v: i32 = a + %zu;\n", copy, copy);
+        _append(&text, line);
+        size_t count = 1 + _next(&state) % 6;
+        for (size_t i = 0; i < count; i++) {
+            _append(&text, _statements[_next(&state) % (sizeof(_statements) / sizeof(_statements[0]))]);
+        }
+        _append(&text, "    return (v, w);\n};\n");
+    }
+    return text.data;
+}
+
+typedef struct {
+    const char* name;
+    char* text;
+    sln_parse_error_t status;       /**< Expected of sln_parse() */
+} _case_t;
+
+// The serial tree of the clean module must hold every kind, so every rule of the join is used
+static void _check_kinds(const sln_ast_t* ast) {
+    bool seen[_SLN_AST_KIND_COUNT] = { false };
+    for (size_t i = 0; i < ast->len; i++) seen[ast->nodes[i].kind] = true;
+    for (size_t kind = 0; kind < _SLN_AST_KIND_COUNT; kind++) {
+        SLN_TEST_CHECK(seen[kind] || kind == SLN_AST_ERROR, "the module has no %s node",
+                       sln_ast_kind_name((sln_ast_kind_t)kind));
+    }
+}
+
+static void _check_case(const char* name, const char* text, sln_parse_error_t status,
+                        sln_utils_pool_t* pool, bool check_kinds) {
+    static const size_t chunk_tokens[] = { 0, 1, 3, 64, 4096 };
+    sln_test_parse_t serial;
+    SLN_TEST_CHECK(sln_test_parse_init(&serial, text), "%s: setup failed", name);
+    if (!serial.text || !sln_test_parse_lex(&serial, name)) {
+        sln_test_parse_free(&serial);
+        return;
+    }
+    sln_test_parse_serial(&serial);
+    SLN_TEST_CHECK(serial.status == status, "%s: sln_parse() gave %d, expected %d",
+                   name, (int)serial.status, (int)status);
+    if (check_kinds) _check_kinds(&serial.ast);
+    const char* expected = sln_test_parse_diagnostics(&serial);
+
+    for (size_t i = 0; i < sizeof(chunk_tokens) / sizeof(chunk_tokens[0]); i++) {
+        char what[128];
+        snprintf(what, sizeof(what), "%s, chunks of %zu", name, chunk_tokens[i]);
+        sln_test_parse_t parallel;
+        SLN_TEST_CHECK(sln_test_parse_init(&parallel, text), "%s: setup failed", what);
+        if (parallel.text) {
+            parallel.status = sln_parse_parallel(parallel.text, &serial.tokens, &parallel.arena, parallel.diags,
+                                                 &parallel.ast, pool, chunk_tokens[i]);
+            SLN_TEST_CHECK(parallel.status == serial.status, "%s: status %d, sln_parse() gave %d",
+                           what, (int)parallel.status, (int)serial.status);
+            sln_test_same_tree(what, &serial.ast, &parallel.ast);
+            const char* actual = sln_test_parse_diagnostics(&parallel);
+            SLN_TEST_CHECK(strcmp(actual, expected) == 0, "%s: diagnostics differ:\n%s\nsln_parse() printed:\n%s",
+                           what, actual, expected);
+        }
+        sln_test_parse_free(&parallel);
+    }
+    sln_test_parse_free(&serial);
+}
+
+int main(void) {
+    sln_utils_pool_t* pool = sln_utils_pool_create(4);
+    SLN_TEST_CHECK(pool != NULL, "cannot create the pool");
+    if (!pool) return SLN_TEST_RESULT();
+
+    _case_t cases[] = {
+        { "module", _module(NULL, 0), SLN_PARSE_OK },
+        // The splitter ends the item at `}` and the chunk after it starts with `[3]`
+        { "bad cut", _module("type arr = struct { x: i32 }[3];\n", TEST_COPIES / 2), SLN_PARSE_OK },
+        { "stray bracket", _module("x: i32 = (1 + 2));\n", TEST_COPIES / 2), SLN_PARSE_UNEXPECTED_TOKEN },
+        { "unclosed bracket", _module("g(): nil = { x = [1;\n", TEST_COPIES - 1), SLN_PARSE_UNEXPECTED_TOKEN },
+        { "late errors", _module("x: i32 = ;\ntype t = struct { n: };\nuse ;\n", TEST_COPIES - 2),
+          SLN_PARSE_UNEXPECTED_TOKEN },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        SLN_TEST_CHECK(cases[i].text != NULL, "%s: out of memory", cases[i].name);
+        if (cases[i].text) _check_case(cases[i].name, cases[i].text, cases[i].status, pool, i == 0);
+        free(cases[i].text);
+    }
+
+    // Short texts are cut too when the chunks are small
+    static const char* const examples[] = {
+        SLN_TEST_EXAMPLE("basic/syntax.sl"),
+        SLN_TEST_EXAMPLE("ext/optimizise_project1.sl"),
+    };
+    for (size_t i = 0; i < sizeof(examples) / sizeof(examples[0]); i++) {
+        sln_common_source_t source = {0};
+        SLN_TEST_CHECK(sln_common_source_load(&source, examples[i]), "cannot load %s", examples[i]);
+        if (!source.text) continue;
+        _check_case(examples[i], source.text, SLN_PARSE_OK, pool, false);
+        sln_common_source_free(&source);
+    }
+
+    sln_utils_pool_destroy(pool);
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,125 @@
+/**
+ * @file parser_pipe.c
+ * @brief sln_parse_pipe() against sln_parse().
+ *
+ * Each text is lexed in full and parsed with sln_parse(), then lexed
+ * through a pipe and parsed with sln_parse_pipe(): status, tree and
+ * diagnostics must match. Besides both examples, the texts repeat them
+ * over many batches, repeat a text with several syntax errors past
+ * SLN_PARSE_MAX_ERRORS, put the errors after a long clean prefix, and
+ * nest too deep at the start, so parsing stops with most of the text
+ * still in the pipe.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lexer/lexer_pipe.h>
+
+#include "parser_util.h"
+
+// Syntax errors on several lines, recovered from one by one
+static const char _errors[] =
+    "namespace a { x:i32 = ; };\n"
+    "type t = struct { n: };\n"
+    "MAIN():i32 = {\n"
+    "    y = (1 + ;\n"
+    "    z = 2;\n"
+    "    w = a[;\n"
+    "    v = 3 4;\n"
+    "    return 0;\n"
+    "};\n"
+    "use ;\n";
+
+// @p prefix_count copies of @p prefix, then @p count copies of @p piece, then @p suffix; to free()
+static char* _repeat(const char* prefix, size_t prefix_count, const char* piece, size_t count, const char* suffix) {
+    size_t prefix_len = strlen(prefix);
+    size_t piece_len = strlen(piece);
+    size_t suffix_len = strlen(suffix);
+    char* text = malloc(prefix_len * prefix_count + piece_len * count + suffix_len + 1);
+    if (!text) return NULL;
+    char* at = text;
+    for (size_t i = 0; i < prefix_count; i++, at += prefix_len) memcpy(at, prefix, prefix_len);
+    for (size_t i = 0; i < count; i++, at += piece_len) memcpy(at, piece, piece_len);
+    memcpy(at, suffix, suffix_len + 1);
+    return text;
+}
+
+// An expression nested past SLN_PARSE_MAX_DEPTH, then @p count copies of @p piece; to free()
+static char* _deep_then(const char* piece, size_t count) {
+    char* deep = _repeat("x:i32 = ", 1, "(", 2 * SLN_PARSE_MAX_DEPTH, "1;\n");
+    char* text = deep ? _repeat(deep, 1, piece, count, "") : NULL;
+    free(deep);
+    return text;
+}
+
+static sln_parse_error_t _parse_piped(sln_test_parse_t* parse) {
+    FILE* sink = tmpfile();
+    sln_lex_pipe_t* pipe = NULL;
+    sln_lex_error_t opened = sink ? sln_lex_pipe_open(parse->text, parse->symbols, sink, &pipe)
+                                  : SLN_LEX_ALLOCATION_FAILED;
+    parse->status = SLN_PARSE_ALLOCATION_FAILED;
+    if (opened == SLN_LEX_OK) {
+        parse->status = sln_parse_pipe(parse->text, pipe, &parse->tokens, &parse->arena, parse->diags, &parse->ast);
+        sln_lex_pipe_close(pipe);
+    }
+    if (sink) fclose(sink);
+    return parse->status;
+}
+
+static void _check_text(const char* name, const char* text) {
+    sln_test_parse_t serial;
+    sln_test_parse_t piped;
+    bool ready = sln_test_parse_init(&serial, text) & sln_test_parse_init(&piped, text);
+    SLN_TEST_CHECK(ready, "%s: setup failed", name);
+    if (ready && sln_test_parse_lex(&serial, name)) {
+        sln_test_parse_serial(&serial);
+        _parse_piped(&piped);
+        SLN_TEST_CHECK(piped.status == serial.status, "%s: status %d, sln_parse() gave %d",
+                       name, (int)piped.status, (int)serial.status);
+        if (piped.status != SLN_PARSE_ALLOCATION_FAILED) sln_test_same_tree(name, &serial.ast, &piped.ast);
+        const char* expected = sln_test_parse_diagnostics(&serial);
+        const char* actual = sln_test_parse_diagnostics(&piped);
+        SLN_TEST_CHECK(strcmp(actual, expected) == 0, "%s: diagnostics differ:\n%s\nsln_parse() printed:\n%s",
+                       name, actual, expected);
+    }
+    sln_test_parse_free(&piped);
+    sln_test_parse_free(&serial);
+}
+
+static void _check_example(const char* path, size_t copies) {
+    sln_common_source_t source = {0};
+    SLN_TEST_CHECK(sln_common_source_load(&source, path), "cannot load %s", path);
+    if (!source.text) return;
+    char* text = _repeat("", 0, source.text, copies, "");
+    SLN_TEST_CHECK(text != NULL, "%s: out of memory", path);
+    if (text) _check_text(path, text);
+    free(text);
+    sln_common_source_free(&source);
+}
+
+int main(void) {
+    static const char* const examples[] = {
+        SLN_TEST_EXAMPLE("basic/syntax.sl"),
+        SLN_TEST_EXAMPLE("ext/optimizise_project1.sl"),
+    };
+    for (size_t i = 0; i < sizeof(examples) / sizeof(examples[0]); i++) {
+        _check_example(examples[i], 1);
+        // Many more batches than SLN_LEX_PIPE_DEPTH
+        _check_example(examples[i], 200);
+    }
+
+    struct { const char* name; char* text; } cases[] = {
+        { "errors", _repeat("", 0, _errors, 1, "") },
+        { "errors past the limit", _repeat("", 0, _errors, 40, "") },
+        { "errors after clean items", _repeat("f():nil;\nx:i32 = 1 + 2 * 3;\n", 2000, _errors, 3, "") },
+        { "too deep", _repeat("x:i32 = ", 1, "(", 4 * SLN_PARSE_MAX_DEPTH, "1;\n") },
+        { "too deep then more", _deep_then("g():nil;\n", 20000) },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        SLN_TEST_CHECK(cases[i].text != NULL, "%s: out of memory", cases[i].name);
+        if (cases[i].text) _check_text(cases[i].name, cases[i].text);
+        free(cases[i].text);
+    }
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,174 @@
+/**
+ * @file parser_tree.c
+ * @brief Syntax trees of sln_parse() against expected dumps.
+ *
+ * Both examples must parse cleanly and dump exactly as the files under
+ * tests/expected/ do; run with SELENA_UPDATE_EXPECTED=1 to rewrite them
+ * after a deliberate change to the tree. Short expressions pin
+ * precedence and associativity, and a text with seeded syntax errors
+ * must give one diagnostic per error, at its line, and a complete tree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parser_util.h"
+
+// Statements of MAIN in the expression cases, and the dump of everything above them
+#define TEST_WRAP_BEFORE "MAIN():i32 = { "
+#define TEST_WRAP_AFTER "; };\n"
+#define TEST_WRAP_DUMP "ROOT\n  FUNC\n    NAME MAIN\n    TYPE_BUILTIN i32\n    BLOCK\n      EXPR_STMT\n"
+#define TEST_WRAP_INDENT "        "
+#define TEST_TEXT_MAX 1024
+
+static bool _write_file(const char* path, const char* data) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool written = fwrite(data, 1, strlen(data), file) == strlen(data);
+    return fclose(file) == 0 && written;
+}
+
+static void _check_example(const char* path, const char* expected_path) {
+    sln_common_source_t source = {0};
+    SLN_TEST_CHECK(sln_common_source_load(&source, path), "cannot load %s", path);
+    if (!source.text) return;
+    sln_test_parse_t parse;
+    SLN_TEST_CHECK(sln_test_parse_init(&parse, source.text), "%s: setup failed", path);
+    sln_common_source_free(&source);
+    if (!parse.text || !sln_test_parse_lex(&parse, path)) {
+        sln_test_parse_free(&parse);
+        return;
+    }
+
+    SLN_TEST_CHECK(sln_test_parse_serial(&parse) == SLN_PARSE_OK, "%s: parser error %d", path, (int)parse.status);
+    const char* diagnostics = sln_test_parse_diagnostics(&parse);
+    SLN_TEST_CHECK(diagnostics[0] == '\0', "%s: unexpected diagnostics:\n%s", path, diagnostics);
+    char* dump = sln_test_parse_dump(&parse);
+    SLN_TEST_CHECK(dump != NULL, "%s: cannot dump the tree", path);
+
+    const char* update = getenv("SELENA_UPDATE_EXPECTED");
+    if (dump && update && strcmp(update, "1") == 0) {
+        SLN_TEST_CHECK(_write_file(expected_path, dump), "cannot write %s", expected_path);
+    } else if (dump) {
+        sln_common_source_t expected = {0};
+        SLN_TEST_CHECK(sln_common_source_load(&expected, expected_path), "cannot load %s", expected_path);
+        if (expected.text) {
+            size_t line = 1;
+            size_t i = 0;
+            for (; dump[i] && dump[i] == expected.text[i]; i++) line += dump[i] == '\n';
+            SLN_TEST_CHECK(dump[i] == expected.text[i], "%s: the tree differs from %s at line %zu",
+                           path, expected_path, line);
+        }
+        sln_common_source_free(&expected);
+    }
+    free(dump);
+    sln_test_parse_free(&parse);
+}
+
+// Expression cases: the text of one statement and the dump of its expression
+static const char* const _expressions[][2] = {
+    { "a = b = c",
+      "BINARY =\n  NAME a\n  BINARY =\n    NAME b\n    NAME c\n" },
+    { "a - b - c",
+      "BINARY -\n  BINARY -\n    NAME a\n    NAME b\n  NAME c\n" },
+    { "a ? b : c ? d : e",
+      "TERNARY\n  NAME a\n  NAME b\n  TERNARY\n    NAME c\n    NAME d\n    NAME e\n" },
+    { "a << b + c",
+      "BINARY <<\n  NAME a\n  BINARY +\n    NAME b\n    NAME c\n" },
+    { "a + b * c - d",
+      "BINARY -\n  BINARY +\n    NAME a\n    BINARY *\n      NAME b\n      NAME c\n  NAME d\n" },
+    { "a | b ^ c & d == e",
+      "BINARY |\n  NAME a\n  BINARY ^\n    NAME b\n    BINARY &\n      NAME c\n      BINARY ==\n"
+      "        NAME d\n        NAME e\n" },
+    { "a < b << c",
+      "BINARY <\n  NAME a\n  BINARY <<\n    NAME b\n    NAME c\n" },
+    { "a || b && c",
+      "BINARY ||\n  NAME a\n  BINARY &&\n    NAME b\n    NAME c\n" },
+    { "a += b ? c : d",
+      "BINARY +=\n  NAME a\n  TERNARY\n    NAME b\n    NAME c\n    NAME d\n" },
+};
+
+static void _check_expression(const char* statement, const char* expected) {
+    char text[TEST_TEXT_MAX];
+    char wanted[TEST_TEXT_MAX];
+    snprintf(text, sizeof(text), TEST_WRAP_BEFORE "%s" TEST_WRAP_AFTER, statement);
+    size_t len = (size_t)snprintf(wanted, sizeof(wanted), TEST_WRAP_DUMP);
+    for (const char* line = expected; *line && len < sizeof(wanted);) {
+        const char* end = strchr(line, '\n');
+        int n = end ? (int)(end - line) : (int)strlen(line);
+        len += (size_t)snprintf(wanted + len, sizeof(wanted) - len, TEST_WRAP_INDENT "%.*s\n", n, line);
+        line += n + (end != NULL);
+    }
+
+    sln_test_parse_t parse;
+    SLN_TEST_CHECK(sln_test_parse_init(&parse, text), "%s: setup failed", statement);
+    if (parse.text && sln_test_parse_lex(&parse, statement)) {
+        SLN_TEST_CHECK(sln_test_parse_serial(&parse) == SLN_PARSE_OK, "%s: parser error %d", statement, (int)parse.status);
+        char* dump = sln_test_parse_dump(&parse);
+        SLN_TEST_CHECK(dump && strcmp(dump, wanted) == 0, "%s: parsed as\n%s\nexpected\n%s", statement,
+                       dump ? dump : "(nothing)", wanted);
+        free(dump);
+    }
+    sln_test_parse_free(&parse);
+}
+
+// One syntax error on each line listed in _error_lines
+static const char _errors[] =
+    "namespace a { x:i32 = ; };\n"
+    "type t = struct { n: };\n"
+    "MAIN():i32 = {\n"
+    "    y = (1 + ;\n"
+    "    z = 2;\n"
+    "    w = a[;\n"
+    "    v = 3 4;\n"
+    "    return 0;\n"
+    "};\n"
+    "use ;\n"
+    "f():nil;\n";
+
+static const size_t _error_lines[] = { 1, 2, 4, 6, 7, 10 };
+
+static size_t _count(const char* text, const char* needle) {
+    size_t count = 0;
+    for (const char* at = strstr(text, needle); at; at = strstr(at + 1, needle)) count++;
+    return count;
+}
+
+static void _check_recovery(void) {
+    sln_test_parse_t parse;
+    SLN_TEST_CHECK(sln_test_parse_init(&parse, _errors), "recovery: setup failed");
+    if (parse.text && sln_test_parse_lex(&parse, "recovery")) {
+        sln_parse_error_t status = sln_test_parse_serial(&parse);
+        SLN_TEST_CHECK(status == SLN_PARSE_UNEXPECTED_TOKEN, "recovery: parser gave %d", (int)status);
+        const char* diagnostics = sln_test_parse_diagnostics(&parse);
+        size_t seeded = sizeof(_error_lines) / sizeof(_error_lines[0]);
+        size_t reported = _count(diagnostics, "(at line ");
+        SLN_TEST_CHECK(reported == seeded, "recovery: %zu diagnostics for %zu errors:\n%s", reported, seeded, diagnostics);
+        for (size_t i = 0; i < seeded; i++) {
+            char at[32];
+            snprintf(at, sizeof(at), "(at line %zu,", _error_lines[i]);
+            SLN_TEST_CHECK(_count(diagnostics, at) == 1, "recovery: no single diagnostic on line %zu", _error_lines[i]);
+        }
+
+        // What follows each error is still in the tree
+        static const char* const survivors[] = { "TYPE_DEF t", "FUNC", "NAME z", "NAME v", "RETURN", "NAME f" };
+        char* dump = sln_test_parse_dump(&parse);
+        SLN_TEST_CHECK(dump != NULL, "recovery: cannot dump the tree");
+        for (size_t i = 0; dump && i < sizeof(survivors) / sizeof(survivors[0]); i++) {
+            SLN_TEST_CHECK(strstr(dump, survivors[i]), "recovery: %s is missing after an error:\n%s", survivors[i], dump);
+        }
+        free(dump);
+    }
+    sln_test_parse_free(&parse);
+}
+
+int main(void) {
+    _check_example(SLN_TEST_EXAMPLE("basic/syntax.sl"), SLN_TEST_EXPECTED("syntax.ast"));
+    _check_example(SLN_TEST_EXAMPLE("ext/optimizise_project1.sl"), SLN_TEST_EXPECTED("optimizise_project1.ast"));
+    for (size_t i = 0; i < sizeof(_expressions) / sizeof(_expressions[0]); i++) {
+        _check_expression(_expressions[i][0], _expressions[i][1]);
+    }
+    _check_recovery();
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,119 @@
+/**
+ * @file parser_util.h
+ * @brief Source texts parsed for the parser tests.
+ *
+ * A fixture holds a padded copy of one text, its significant tokens, the
+ * arena its tree is parsed into and a stream catching the diagnostics,
+ * so parses of the same text by different parsers can be compared tree
+ * for tree and diagnostic for diagnostic.
+ */
+
+#ifndef SELENA_TESTS_PARSER_UTIL_H_
+#define SELENA_TESTS_PARSER_UTIL_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lexer/lexer.h>
+#include <parser/ast.h>
+#include <parser/parser.h>
+#include <common/source.h>
+#include <utils/allocation.h>
+#include <utils/intern.h>
+
+#include "test_util.h"
+
+typedef struct {
+    char* text;                     /**< Copy followed by SLN_COMMON_SOURCE_PADDING zero bytes */
+    size_t len;
+    sln_utils_intern_t* symbols;
+    sln_lex_token_buffer_t tokens;
+    sln_utils_arena_t arena;
+    sln_ast_t ast;
+    sln_parse_error_t status;
+    FILE* diags;
+    char* diag_text;
+    size_t diag_len;
+} sln_test_parse_t;
+
+/// @brief Copies @p text; the fixture has no tokens yet.
+static inline bool sln_test_parse_init(sln_test_parse_t* parse, const char* text) {
+    memset(parse, 0, sizeof(*parse));
+    parse->len = strlen(text);
+    parse->text = calloc(parse->len + SLN_COMMON_SOURCE_PADDING, 1);
+    if (parse->text) memcpy(parse->text, text, parse->len);
+    parse->symbols = sln_utils_intern_create();
+    parse->diags = open_memstream(&parse->diag_text, &parse->diag_len);
+    sln_utils_arena_init(&parse->arena, "test", 0);
+    return parse->text && parse->symbols && parse->diags;
+}
+
+static inline void sln_test_parse_free(sln_test_parse_t* parse) {
+    sln_lex_free_tokens(&parse->tokens);
+    sln_utils_arena_free(&parse->arena);
+    if (parse->diags) fclose(parse->diags);
+    free(parse->diag_text);
+    if (parse->symbols) sln_utils_intern_destroy(parse->symbols);
+    free(parse->text);
+}
+
+/// @brief Lexes the text into its significant tokens; lexer diagnostics are dropped.
+static inline bool sln_test_parse_lex(sln_test_parse_t* parse, const char* name) {
+    FILE* sink = tmpfile();
+    sln_lex_trivia_t trivia = {0};
+    sln_lex_error_t lexed = sink ? sln_lex_generate_trivia(parse->text, &parse->tokens, &trivia, parse->symbols, sink)
+                                 : SLN_LEX_ALLOCATION_FAILED;
+    sln_lex_free_trivia(&trivia);
+    if (sink) fclose(sink);
+    SLN_TEST_CHECK(lexed != SLN_LEX_ALLOCATION_FAILED && parse->tokens.tokens, "%s: lexing failed", name);
+    return lexed != SLN_LEX_ALLOCATION_FAILED && parse->tokens.tokens;
+}
+
+/// @brief Parses the lexed tokens with sln_parse().
+static inline sln_parse_error_t sln_test_parse_serial(sln_test_parse_t* parse) {
+    parse->status = sln_parse(parse->text, &parse->tokens, &parse->arena, parse->diags, &parse->ast);
+    return parse->status;
+}
+
+/// @brief Diagnostics printed so far.
+static inline const char* sln_test_parse_diagnostics(sln_test_parse_t* parse) {
+    fflush(parse->diags);
+    return parse->diag_text ? parse->diag_text : "";
+}
+
+/// @brief sln_ast_dump() of the tree, to free(); NULL if it cannot be printed.
+static inline char* sln_test_parse_dump(const sln_test_parse_t* parse) {
+    char* dump = NULL;
+    size_t len = 0;
+    FILE* stream = open_memstream(&dump, &len);
+    if (!stream) return NULL;
+    sln_ast_dump(&parse->ast, parse->text, stream);
+    fclose(stream);
+    return dump;
+}
+
+/// @brief Whether two trees have the same nodes and `extra` words; reports the first difference.
+static inline bool sln_test_same_tree(const char* what, const sln_ast_t* expected, const sln_ast_t* actual) {
+    SLN_TEST_CHECK(actual->len == expected->len, "%s: %zu nodes, expected %zu", what, actual->len, expected->len);
+    SLN_TEST_CHECK(actual->extra_len == expected->extra_len, "%s: %zu extra words, expected %zu",
+                   what, actual->extra_len, expected->extra_len);
+    if (actual->len != expected->len || actual->extra_len != expected->extra_len) return false;
+    for (size_t i = 0; i < expected->len; i++) {
+        const sln_ast_node_t* a = &actual->nodes[i];
+        const sln_ast_node_t* e = &expected->nodes[i];
+        bool same = a->kind == e->kind && a->flags == e->flags && a->token == e->token &&
+                    a->lhs == e->lhs && a->rhs == e->rhs;
+        SLN_TEST_CHECK(same, "%s: node %zu is %s token %u [%u, %u], expected %s token %u [%u, %u]", what, i,
+                       sln_ast_kind_name((sln_ast_kind_t)a->kind), a->token, a->lhs, a->rhs,
+                       sln_ast_kind_name((sln_ast_kind_t)e->kind), e->token, e->lhs, e->rhs);
+        if (!same) return false;
+    }
+    for (size_t i = 0; i < expected->extra_len; i++) {
+        SLN_TEST_CHECK(actual->extra[i] == expected->extra[i], "%s: extra[%zu] is %u, expected %u",
+                       what, i, actual->extra[i], expected->extra[i]);
+        if (actual->extra[i] != expected->extra[i]) return false;
+    }
+    return true;
+}
+
+#endif // SELENA_TESTS_PARSER_UTIL_H_
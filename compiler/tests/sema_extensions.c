@@ -0,0 +1,230 @@
+/**
+ * @file sema_extensions.c
+ * @brief Extension points filled from several units.
+ *
+ * Units contribute names to `main::exit_status@exit_status_ext` and to
+ * the points of `main::codes`, an enum with explicit values. After
+ * sln_sema_bind() each point must list its names by unit and then in
+ * source order, whatever order the units were collected in; the names
+ * must be numbered in that order from the enumerator before the point,
+ * a name taken twice must be reported once and kept once, and a value
+ * an explicit enumerator already holds must be reported as a conflict.
+ * An extension may name its enum through aliases declared after it, in
+ * its own unit or a later one.
+ */
+
+#include <stdio.h>
+
+#include "sema_util.h"
+
+#define TEST_LAYOUT_MAX 256
+
+static const char _library[] =
+    "namespace main {\n"
+    "    type exit_status = enum { EXIT_SUCCESS, EXIT_FAILURE, @exit_status_ext, EXIT_LAST };\n"
+    "    type codes = enum { C0 = 10, @more, C1 = 13, @tail };\n"
+    "};\n";
+
+static const char _by_alias[] =
+    "use main as m;\n"
+    "m::exit_status@exit_status_ext = { EXIT_B1, EXIT_B2 };\n";
+
+static const char _in_namespace[] =
+    "namespace n { use main::exit_status as es; es@exit_status_ext = { EXIT_C1 }; };\n";
+
+static const char _two_blocks[] =
+    "main::exit_status@exit_status_ext = { EXIT_D1 };\n"
+    "main::codes@tail = { T1 };\n"
+    "main::exit_status@exit_status_ext = { EXIT_D2, EXIT_D3 };\n";
+
+#define EXIT_POINT "main::exit_status::exit_status_ext"
+
+// Writes `NAME=value` for every name of the point at @p path, in registry order
+static void _layout(sln_test_sema_t* sema, const char* path, char* out, size_t size) {
+    size_t len = 0;
+    out[0] = '\0';
+    sln_sema_id_t point = sln_test_sema_resolve(sema, 0, path);
+    SLN_TEST_CHECK(point != SLN_SEMA_NONE, "%s does not resolve", path);
+    if (point == SLN_SEMA_NONE) return;
+    size_t count = 0;
+    const sln_sema_id_t* ids = sln_sema_extensions(sema->table, point, &count);
+    for (size_t i = 0; ids && i < count && len < size; i++) {
+        const sln_sema_entry_t* entry = sln_sema_entry(sema->table, ids[i]);
+        SLN_TEST_CHECK((entry->flags & SLN_SEMA_FLAG_EXTENSION) && entry->target == point,
+                       "%s: name %zu is not an extension of the point", path, i);
+        const char* name = sln_utils_intern_get(sema->symbols, entry->name, NULL);
+        int written = snprintf(out + len, size - len, "%s%s=%lld", i ? " " : "", name ? name : "?",
+                               (entry->flags & SLN_SEMA_FLAG_VALUED) ? (long long)entry->value : -1LL);
+        if (written < 0) break;
+        len += (size_t)written;
+    }
+}
+
+static void _expect_layout(sln_test_sema_t* sema, const char* what, const char* path, const char* expected) {
+    char actual[TEST_LAYOUT_MAX];
+    _layout(sema, path, actual, sizeof(actual));
+    SLN_TEST_CHECK(strcmp(actual, expected) == 0, "%s: %s holds \"%s\", expected \"%s\"", what, path, actual, expected);
+}
+
+static void _expect_value(sln_test_sema_t* sema, const char* what, const char* path, int64_t value) {
+    sln_sema_id_t id = sln_test_sema_resolve(sema, 0, path);
+    SLN_TEST_CHECK(id != SLN_SEMA_NONE, "%s: %s does not resolve", what, path);
+    if (id == SLN_SEMA_NONE) return;
+    const sln_sema_entry_t* entry = sln_sema_entry(sema->table, id);
+    SLN_TEST_CHECK((entry->flags & SLN_SEMA_FLAG_VALUED) && entry->value == value,
+                   "%s: %s has value %lld, expected %lld", what, path, (long long)entry->value, (long long)value);
+}
+
+// Collects @p texts as units 0, 1, ..., in the order @p collect gives if set, and binds them
+static sln_sema_error_t _build_in(sln_test_sema_t* sema, const char* what, const char* const* texts, size_t count,
+                                  const size_t* collect) {
+    SLN_TEST_CHECK(sln_test_sema_init(sema), "%s: setup failed", what);
+    for (size_t i = 0; i < count; i++) {
+        size_t unit = collect ? collect[i] : i;
+        sln_sema_error_t error = sln_test_sema_add_as(sema, unit, what, texts[unit]);
+        SLN_TEST_CHECK(error == SLN_SEMA_OK, "%s: unit %zu: collect error %d", what, unit, (int)error);
+    }
+    return sln_sema_bind(sema->table, sema->diags);
+}
+
+static sln_sema_error_t _build(sln_test_sema_t* sema, const char* what, const char* const* texts, size_t count) {
+    return _build_in(sema, what, texts, count, NULL);
+}
+
+// Two units extend the same point, one through an alias, one from a namespace
+static void _check_units(void) {
+    const char* const texts[] = { _library, _by_alias, _in_namespace };
+    sln_test_sema_t sema;
+    sln_sema_error_t error = _build(&sema, "units", texts, 3);
+    SLN_TEST_CHECK(error == SLN_SEMA_OK, "units: bind error %d", (int)error);
+
+    _expect_layout(&sema, "units", EXIT_POINT, "EXIT_B1=2 EXIT_B2=3 EXIT_C1=4");
+    _expect_value(&sema, "units", "main::exit_status::EXIT_FAILURE", 1);
+    _expect_value(&sema, "units", "main::exit_status::EXIT_LAST", 5);
+    sln_sema_id_t b2 = sln_test_sema_resolve(&sema, 0, "main::exit_status::EXIT_B2");
+    sln_sema_id_t c1 = sln_test_sema_resolve(&sema, 0, "main::exit_status::EXIT_C1");
+    SLN_TEST_CHECK(b2 != SLN_SEMA_NONE && sln_sema_entry(sema.table, b2)->unit == 1, "units: EXIT_B2 is not from unit 1");
+    SLN_TEST_CHECK(c1 != SLN_SEMA_NONE && sln_sema_entry(sema.table, c1)->unit == 2, "units: EXIT_C1 is not from unit 2");
+    _expect_layout(&sema, "units", "main::codes::more", "");
+    sln_test_sema_free(&sema);
+}
+
+// A name given twice, or already an enumerator of the enum, is reported and kept once
+static void _check_duplicates(void) {
+    const char* const texts[] = {
+        _library,
+        "main::exit_status@exit_status_ext = { EXIT_B1, EXIT_B2 };\n",
+        "main::exit_status@exit_status_ext = { EXIT_B1 };\n",
+        "main::exit_status@exit_status_ext = { EXIT_LAST, EXIT_B3 };\n",
+    };
+    sln_test_sema_t sema;
+    sln_sema_error_t error = _build(&sema, "duplicates", texts, 4);
+    SLN_TEST_CHECK(error == SLN_SEMA_DUPLICATE, "duplicates: bind gave %d, expected a duplicate", (int)error);
+    SLN_TEST_CHECK(sln_test_sema_reported(&sema, "duplicate declaration"), "duplicates: nothing was reported");
+    SLN_TEST_CHECK(sln_test_sema_reported(&sema, "EXIT_B1"), "duplicates: EXIT_B1 was not reported");
+    SLN_TEST_CHECK(sln_test_sema_reported(&sema, "EXIT_LAST"), "duplicates: EXIT_LAST was not reported");
+
+    _expect_layout(&sema, "duplicates", EXIT_POINT, "EXIT_B1=2 EXIT_B2=3 EXIT_B3=4");
+    sln_sema_id_t b1 = sln_test_sema_resolve(&sema, 0, "main::exit_status::EXIT_B1");
+    SLN_TEST_CHECK(b1 != SLN_SEMA_NONE && sln_sema_entry(sema.table, b1)->unit == 1,
+                   "duplicates: EXIT_B1 is not the first one given");
+    sln_sema_id_t last = sln_test_sema_resolve(&sema, 0, "main::exit_status::EXIT_LAST");
+    SLN_TEST_CHECK(last != SLN_SEMA_NONE && !(sln_sema_entry(sema.table, last)->flags & SLN_SEMA_FLAG_EXTENSION),
+                   "duplicates: EXIT_LAST is no longer the enum's own");
+    _expect_value(&sema, "duplicates", "main::exit_status::EXIT_LAST", 5);
+    sln_test_sema_free(&sema);
+}
+
+// Names count up from the explicit value before the point; taking a later explicit value is a conflict
+static void _check_explicit(void) {
+    const char* const texts[] = {
+        _library,
+        "main::codes@more = { K1, K2 };\nmain::codes@tail = { T1 };\n",
+    };
+    sln_test_sema_t sema;
+    sln_sema_error_t error = _build(&sema, "explicit", texts, 2);
+    SLN_TEST_CHECK(error == SLN_SEMA_OK, "explicit: bind error %d", (int)error);
+    _expect_layout(&sema, "explicit", "main::codes::more", "K1=11 K2=12");
+    _expect_layout(&sema, "explicit", "main::codes::tail", "T1=14");
+    _expect_value(&sema, "explicit", "main::codes::C0", 10);
+    _expect_value(&sema, "explicit", "main::codes::C1", 13);
+    sln_test_sema_free(&sema);
+
+    const char* const conflict[] = {
+        _library,
+        "main::codes@more = { K1, K2, K3 };\n",
+    };
+    error = _build(&sema, "conflict", conflict, 2);
+    SLN_TEST_CHECK(error == SLN_SEMA_VALUE_CONFLICT, "conflict: bind gave %d, expected a value conflict", (int)error);
+    SLN_TEST_CHECK(sln_test_sema_reported(&sema, "enumerator value already taken") &&
+                   sln_test_sema_reported(&sema, "K3"), "conflict: K3 was not reported");
+    SLN_TEST_CHECK(!sln_test_sema_reported(&sema, "C1"), "conflict: the explicit C1 was reported");
+    _expect_layout(&sema, "conflict", "main::codes::more", "K1=11 K2=12 K3=13");
+    _expect_value(&sema, "conflict", "main::codes::C1", 13);
+    sln_test_sema_free(&sema);
+}
+
+// The enum is reached through aliases bound only after the extensions naming them
+static void _check_late_alias(void) {
+    const char* const texts[] = {
+        _library,
+        "e@exit_status_ext = { EXIT_E1 };\nuse f as e;\nuse g as f;\nuse main::exit_status as g;\n",
+        "namespace n { ms::exit_status@exit_status_ext = { EXIT_F1 }; };\n",
+        "namespace n { use main as ms; };\n",
+    };
+    sln_test_sema_t sema;
+    sln_sema_error_t error = _build(&sema, "late alias", texts, 4);
+    SLN_TEST_CHECK(error == SLN_SEMA_OK, "late alias: bind error %d", (int)error);
+    SLN_TEST_CHECK(!sln_test_sema_reported(&sema, "exit_status"), "late alias: an extension was reported");
+    _expect_layout(&sema, "late alias", EXIT_POINT, "EXIT_E1=2 EXIT_F1=3");
+    _expect_value(&sema, "late alias", "main::exit_status::EXIT_LAST", 4);
+    sln_test_sema_free(&sema);
+}
+
+// The registry follows the unit index and then the source, whatever order the
+// units are collected in and however often they are built
+static void _check_order(void) {
+    static const char* const units[][4] = {
+        { _library, _by_alias, _in_namespace, _two_blocks },
+        { _two_blocks, _in_namespace, _library, _by_alias },
+        { _in_namespace, _two_blocks, _by_alias, _library },
+    };
+    static const char* const expected[] = {
+        "EXIT_B1=2 EXIT_B2=3 EXIT_C1=4 EXIT_D1=5 EXIT_D2=6 EXIT_D3=7",
+        "EXIT_D1=2 EXIT_D2=3 EXIT_D3=4 EXIT_C1=5 EXIT_B1=6 EXIT_B2=7",
+        "EXIT_C1=2 EXIT_D1=3 EXIT_D2=4 EXIT_D3=5 EXIT_B1=6 EXIT_B2=7",
+    };
+    static const size_t collect[][4] = {
+        { 0, 1, 2, 3 },
+        { 0, 1, 2, 3 },
+        { 3, 2, 1, 0 },
+        { 2, 0, 3, 1 },
+    };
+    for (size_t i = 0; i < sizeof(collect) / sizeof(collect[0]) * 3; i++) {
+        size_t u = i % 3;
+        size_t c = i / 3;
+        char what[48];
+        snprintf(what, sizeof(what), "units %zu, collected %zu", u, c);
+        sln_test_sema_t sema;
+        sln_sema_error_t error = _build_in(&sema, what, units[u], 4, collect[c]);
+        SLN_TEST_CHECK(error == SLN_SEMA_OK, "%s: bind error %d", what, (int)error);
+        _expect_layout(&sema, what, EXIT_POINT, expected[u]);
+        _expect_layout(&sema, what, "main::codes::tail", "T1=14");
+        _expect_value(&sema, what, "main::exit_status::EXIT_LAST", 8);
+
+        // Binding again must not move anything
+        error = sln_sema_bind(sema.table, sema.diags);
+        SLN_TEST_CHECK(error == SLN_SEMA_OK, "%s: second bind error %d", what, (int)error);
+        _expect_layout(&sema, what, EXIT_POINT, expected[u]);
+        sln_test_sema_free(&sema);
+    }
+}
+
+int main(void) {
+    _check_units();
+    _check_duplicates();
+    _check_explicit();
+    _check_late_alias();
+    _check_order();
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,181 @@
+/**
+ * @file sema_symbols.c
+ * @brief Names of the examples, resolved through the symbol table.
+ *
+ * examples/basic/syntax.sl and examples/ext/optimizise_project1.sl are
+ * collected with a library unit declaring the namespaces they use but
+ * do not define. Their imports must bind, and each resolved path must
+ * land on the entry declaring it: `use cli:io;`, the enumerators of
+ * main::exit_status and its extension, the glob `use main::exit_status*;`
+ * and the `as ext` and `as pr1` aliases, each seen only from the unit
+ * that imports it.
+ *
+ * A second table binds imports written in any order: a long chain of
+ * aliases written backwards across two units, names a later glob import
+ * or a later qualified function brings in, and paths that never resolve,
+ * which must be reported.
+ */
+
+#include "sema_util.h"
+
+static const char _library[] =
+    "namespace cli { namespace io { println(s:str):nil; }; flush():nil; };\n"
+    "namespace selena { namespace extensor {\n"
+    "    type ir = struct { n:i32 };\n"
+    "    type exit_status = enum { OK, FAIL };\n"
+    "}; };\n"
+    "namespace project1_optimizers {\n"
+    "    type opt_type = enum { TYPE1, TYPE2, TYPE3 };\n"
+    "    choose_opt(x:i32):opt_type;\n"
+    "    optimize1(x:i32):i32;\n"
+    "};\n"
+    "namespace main { namespace exit { type codes = enum { EXIT_SUCCESS }; }; };\n";
+
+enum { UNIT_SYNTAX, UNIT_PROJECT, UNIT_LIBRARY };
+
+// Links of the backwards chain `use x{i-1} as x{i};`, half in each unit
+#define TEST_CHAIN 4000
+
+static const char _late_names[] =
+    "use g as h;\n"
+    "use late2 as l2;\n"
+    "use lib*;\n"
+    "use late as l;\n"
+    "use lib::missing as m;\n"
+    "use nowhere as z;\n";
+
+static const char _late_library[] =
+    "namespace x0 { f():nil; };\n"
+    "namespace lib { g():nil; };\n"
+    "lib::late():nil;\n"
+    "lib::late2():nil;\n";
+
+// Checks that @p path resolves from @p unit to an entry of @p kind declared in @p declared_in
+static sln_sema_id_t _expect(sln_test_sema_t* sema, uint32_t unit, const char* path,
+                             sln_sema_kind_t kind, uint32_t declared_in) {
+    sln_sema_id_t id = sln_test_sema_resolve(sema, unit, path);
+    SLN_TEST_CHECK(id != SLN_SEMA_NONE, "unit %u: %s does not resolve", unit, path);
+    if (id == SLN_SEMA_NONE) return id;
+    const sln_sema_entry_t* entry = sln_sema_entry(sema->table, id);
+    SLN_TEST_CHECK(entry->kind == kind, "unit %u: %s is a %s, expected a %s", unit, path,
+                   sln_sema_kind_name((sln_sema_kind_t)entry->kind), sln_sema_kind_name(kind));
+    SLN_TEST_CHECK(entry->unit == declared_in, "unit %u: %s is declared in unit %u, expected %u",
+                   unit, path, entry->unit, declared_in);
+    return id;
+}
+
+static void _expect_same(sln_test_sema_t* sema, uint32_t unit, const char* path, sln_sema_id_t id) {
+    sln_sema_id_t found = sln_test_sema_resolve(sema, unit, path);
+    SLN_TEST_CHECK(found == id, "unit %u: %s resolves to #%u, expected #%u", unit, path, found, id);
+}
+
+static void _expect_none(sln_test_sema_t* sema, uint32_t unit, const char* path) {
+    sln_sema_id_t found = sln_test_sema_resolve(sema, unit, path);
+    SLN_TEST_CHECK(found == SLN_SEMA_NONE, "unit %u: %s resolves to #%u, expected nothing", unit, path, found);
+}
+
+static void _expect_value(sln_test_sema_t* sema, sln_sema_id_t id, const char* path, int64_t value) {
+    if (id == SLN_SEMA_NONE) return;
+    const sln_sema_entry_t* entry = sln_sema_entry(sema->table, id);
+    SLN_TEST_CHECK((entry->flags & SLN_SEMA_FLAG_VALUED) && entry->value == value,
+                   "%s has value %lld, expected %lld", path, (long long)entry->value, (long long)value);
+}
+
+// Writes `namespace c { use x{i-1} as x{i}; ... };` for i from @p last down to @p first, then @p tail
+static char* _chain_text(size_t first, size_t last, const char* tail) {
+    size_t cap = (last - first + 1) * 32 + strlen(tail) + 32;
+    char* text = malloc(cap);
+    if (!text) return NULL;
+    size_t len = (size_t)snprintf(text, cap, "namespace c {\n");
+    for (size_t i = last; i >= first; i--) len += (size_t)snprintf(text + len, cap - len, "use x%zu as x%zu;\n", i - 1, i);
+    snprintf(text + len, cap - len, "};\n%s", tail);
+    return text;
+}
+
+static void _check_binding(void) {
+    sln_test_sema_t sema;
+    SLN_TEST_CHECK(sln_test_sema_init(&sema), "binding: setup failed");
+    char* names = _chain_text(TEST_CHAIN / 2 + 1, TEST_CHAIN, _late_names);
+    char* library = _chain_text(1, TEST_CHAIN / 2, _late_library);
+    SLN_TEST_CHECK(names && library, "binding: cannot allocate");
+    if (names && library) {
+        sln_sema_error_t error = sln_test_sema_add(&sema, "names", names);
+        SLN_TEST_CHECK(error == SLN_SEMA_OK, "names: collect error %d", (int)error);
+        error = sln_test_sema_add(&sema, "late library", library);
+        SLN_TEST_CHECK(error == SLN_SEMA_OK, "late library: collect error %d", (int)error);
+        error = sln_sema_bind(sema.table, sema.diags);
+        SLN_TEST_CHECK(error == SLN_SEMA_UNRESOLVED, "binding: bind gave %d, expected unresolved paths", (int)error);
+
+        char path[64];
+        snprintf(path, sizeof(path), "c::x%d::f", TEST_CHAIN);
+        sln_sema_id_t f = _expect(&sema, 1, "x0::f", SLN_SEMA_FUNC, 1);
+        _expect_same(&sema, 0, path, f);
+        _expect_same(&sema, 0, "h", sln_test_sema_resolve(&sema, 1, "lib::g"));
+        _expect(&sema, 0, "l", SLN_SEMA_FUNC, 1);
+        _expect_same(&sema, 0, "l2", sln_test_sema_resolve(&sema, 1, "lib::late2"));
+        _expect_none(&sema, 0, "m");
+        _expect_none(&sema, 0, "z");
+        SLN_TEST_CHECK(sln_test_sema_reported(&sema, "lib::missing"), "binding: lib::missing was not reported");
+        SLN_TEST_CHECK(sln_test_sema_reported(&sema, "nowhere"), "binding: nowhere was not reported");
+        SLN_TEST_CHECK(!sln_test_sema_reported(&sema, "late"), "binding: a late name was reported");
+    }
+    free(names);
+    free(library);
+    sln_test_sema_free(&sema);
+}
+
+int main(void) {
+    sln_test_sema_t sema;
+    SLN_TEST_CHECK(sln_test_sema_init(&sema), "setup failed");
+
+    sln_sema_error_t error = sln_test_sema_add_file(&sema, SLN_TEST_EXAMPLE("basic/syntax.sl"));
+    SLN_TEST_CHECK(error == SLN_SEMA_OK, "syntax.sl: collect error %d", (int)error);
+    error = sln_test_sema_add_file(&sema, SLN_TEST_EXAMPLE("ext/optimizise_project1.sl"));
+    SLN_TEST_CHECK(error == SLN_SEMA_OK, "optimizise_project1.sl: collect error %d", (int)error);
+    error = sln_test_sema_add(&sema, "library", _library);
+    SLN_TEST_CHECK(error == SLN_SEMA_OK, "library: collect error %d", (int)error);
+    error = sln_sema_bind(sema.table, sema.diags);
+    SLN_TEST_CHECK(error == SLN_SEMA_OK, "bind error %d", (int)error);
+
+    // use cli:io;
+    sln_sema_id_t io = _expect(&sema, UNIT_LIBRARY, "cli::io", SLN_SEMA_NAMESPACE, UNIT_LIBRARY);
+    _expect_same(&sema, UNIT_SYNTAX, "io", io);
+    _expect(&sema, UNIT_SYNTAX, "io::println", SLN_SEMA_FUNC, UNIT_LIBRARY);
+    _expect_none(&sema, UNIT_PROJECT, "io");
+
+    // The enum and its extension, from every unit
+    sln_sema_id_t success = _expect(&sema, UNIT_SYNTAX, "main::exit_status::EXIT_SUCCESS",
+                                    SLN_SEMA_ENUMERATOR, UNIT_SYNTAX);
+    _expect_same(&sema, UNIT_PROJECT, "main::exit_status::EXIT_SUCCESS", success);
+    _expect_value(&sema, success, "EXIT_SUCCESS", 0);
+    sln_sema_id_t err2 = _expect(&sema, UNIT_SYNTAX, "main::exit_status::EXIT_ERR2",
+                                 SLN_SEMA_ENUMERATOR, UNIT_SYNTAX);
+    _expect_value(&sema, err2, "EXIT_ERR2", 3);
+    _expect(&sema, UNIT_SYNTAX, "main::exit_status::exit_status_ext", SLN_SEMA_EXT_POINT, UNIT_SYNTAX);
+    sln_sema_id_t exit_success = _expect(&sema, UNIT_PROJECT, "main::exit::codes::EXIT_SUCCESS",
+                                         SLN_SEMA_ENUMERATOR, UNIT_LIBRARY);
+    SLN_TEST_CHECK(exit_success != success, "main::exit and main::exit_status share EXIT_SUCCESS");
+
+    // use main::exit_status*; reaches the extension's names too, in its own unit only
+    _expect_same(&sema, UNIT_SYNTAX, "EXIT_SUCCESS", success);
+    _expect_same(&sema, UNIT_SYNTAX, "EXIT_ERR2", err2);
+    _expect_none(&sema, UNIT_PROJECT, "EXIT_SUCCESS");
+    _expect_none(&sema, UNIT_LIBRARY, "EXIT_ERR2");
+
+    // use selena::extensor as ext; use project1_optimizers as pr1;
+    sln_sema_id_t extensor = _expect(&sema, UNIT_LIBRARY, "selena::extensor", SLN_SEMA_NAMESPACE, UNIT_LIBRARY);
+    _expect_same(&sema, UNIT_PROJECT, "ext", extensor);
+    _expect(&sema, UNIT_PROJECT, "ext::ir", SLN_SEMA_TYPE, UNIT_LIBRARY);
+    _expect(&sema, UNIT_PROJECT, "ext::MAIN_IR", SLN_SEMA_FUNC, UNIT_PROJECT);
+    _expect_same(&sema, UNIT_LIBRARY, "selena::extensor::MAIN_IR",
+                 sln_test_sema_resolve(&sema, UNIT_PROJECT, "ext::MAIN_IR"));
+    sln_sema_id_t type2 = _expect(&sema, UNIT_PROJECT, "pr1::opt_type::TYPE2", SLN_SEMA_ENUMERATOR, UNIT_LIBRARY);
+    _expect_value(&sema, type2, "TYPE2", 1);
+    _expect_none(&sema, UNIT_SYNTAX, "ext");
+    _expect_none(&sema, UNIT_SYNTAX, "pr1::opt_type");
+
+    sln_test_sema_free(&sema);
+
+    _check_binding();
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,124 @@
+/**
+ * @file sema_util.h
+ * @brief Symbol tables built from source texts, for the sema tests.
+ *
+ * Each added text is one unit: it is lexed, parsed and collected into
+ * the shared table, and kept with its tokens until the fixture is
+ * freed. Diagnostics go to a temporary file that checks can read back.
+ */
+
+#ifndef SELENA_TESTS_SEMA_UTIL_H_
+#define SELENA_TESTS_SEMA_UTIL_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lexer/lexer.h>
+#include <parser/parser.h>
+#include <sema/symbols.h>
+#include <common/source.h>
+#include <utils/allocation.h>
+#include <utils/intern.h>
+
+#include "test_util.h"
+
+#define SLN_TEST_SEMA_MAX_UNITS 8
+#define SLN_TEST_SEMA_MAX_PATH 16
+
+typedef struct {
+    sln_utils_intern_t* symbols;
+    sln_sema_symbols_t* table;
+    sln_utils_arena_t arena;
+    FILE* diags;
+    char* texts[SLN_TEST_SEMA_MAX_UNITS];
+    sln_lex_token_buffer_t tokens[SLN_TEST_SEMA_MAX_UNITS];
+    size_t units;
+} sln_test_sema_t;
+
+static inline bool sln_test_sema_init(sln_test_sema_t* sema) {
+    memset(sema, 0, sizeof(*sema));
+    sema->symbols = sln_utils_intern_create();
+    sema->table = sema->symbols ? sln_sema_symbols_create(sema->symbols) : NULL;
+    sema->diags = tmpfile();
+    sln_utils_arena_init(&sema->arena, "test", 0);
+    return sema->table && sema->diags;
+}
+
+static inline void sln_test_sema_free(sln_test_sema_t* sema) {
+    for (size_t u = 0; u < sema->units; u++) {
+        sln_lex_free_tokens(&sema->tokens[u]);
+        free(sema->texts[u]);
+    }
+    if (sema->table) sln_sema_symbols_destroy(sema->table);
+    if (sema->symbols) sln_utils_intern_destroy(sema->symbols);
+    if (sema->diags) fclose(sema->diags);
+    sln_utils_arena_free(&sema->arena);
+}
+
+/// @brief Adds @p text as unit @p unit, which must not be taken yet; it must lex and parse cleanly.
+static inline sln_sema_error_t sln_test_sema_add_as(sln_test_sema_t* sema, size_t unit, const char* name,
+                                                    const char* text) {
+    if (unit >= SLN_TEST_SEMA_MAX_UNITS || sema->texts[unit]) return SLN_SEMA_ALLOCATION_FAILED;
+    if (sema->units <= unit) sema->units = unit + 1;
+    size_t len = strlen(text);
+    sema->texts[unit] = calloc(len + SLN_COMMON_SOURCE_PADDING, 1);
+    if (!sema->texts[unit]) return SLN_SEMA_ALLOCATION_FAILED;
+    memcpy(sema->texts[unit], text, len);
+
+    sln_lex_trivia_t trivia = {0};
+    sln_lex_error_t lexed = sln_lex_generate_trivia(sema->texts[unit], &sema->tokens[unit], &trivia,
+                                                    sema->symbols, sema->diags);
+    sln_lex_free_trivia(&trivia);
+    SLN_TEST_CHECK(lexed == SLN_LEX_OK, "%s: lexer error %d", name, (int)lexed);
+    if (lexed != SLN_LEX_OK) return SLN_SEMA_NO_TREE;
+
+    sln_ast_t ast;
+    sln_parse_error_t parsed = sln_parse(sema->texts[unit], &sema->tokens[unit], &sema->arena, sema->diags, &ast);
+    SLN_TEST_CHECK(parsed == SLN_PARSE_OK, "%s: parser error %d", name, (int)parsed);
+    if (parsed != SLN_PARSE_OK) return SLN_SEMA_NO_TREE;
+    return sln_sema_collect(sema->table, (uint32_t)unit, &ast, sema->texts[unit], sema->diags);
+}
+
+/// @brief Adds @p text as the next unit.
+static inline sln_sema_error_t sln_test_sema_add(sln_test_sema_t* sema, const char* name, const char* text) {
+    return sln_test_sema_add_as(sema, sema->units, name, text);
+}
+
+/// @brief Adds the file at @p path as the next unit.
+static inline sln_sema_error_t sln_test_sema_add_file(sln_test_sema_t* sema, const char* path) {
+    sln_common_source_t source = {0};
+    SLN_TEST_CHECK(sln_common_source_load(&source, path), "cannot load %s", path);
+    if (!source.text) return SLN_SEMA_NO_TREE;
+    sln_sema_error_t error = sln_test_sema_add(sema, path, source.text);
+    sln_common_source_free(&source);
+    return error;
+}
+
+/// @brief Resolves `a::b::c` from the root scope of @p unit.
+static inline sln_sema_id_t sln_test_sema_resolve(sln_test_sema_t* sema, uint32_t unit, const char* path) {
+    sln_utils_sym_t segments[SLN_TEST_SEMA_MAX_PATH];
+    size_t len = 0;
+    for (const char* p = path; len < SLN_TEST_SEMA_MAX_PATH;) {
+        const char* end = strstr(p, "::");
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        segments[len++] = sln_utils_intern(sema->symbols, p, n);
+        if (!end) break;
+        p = end + 2;
+    }
+    return sln_sema_resolve(sema->table, SLN_SEMA_ROOT, sln_sema_unit_scope(sema->table, unit), segments, len);
+}
+
+/// @brief Whether the diagnostics so far contain @p text.
+static inline bool sln_test_sema_reported(sln_test_sema_t* sema, const char* text) {
+    long size = ftell(sema->diags);
+    char* data = calloc((size_t)(size > 0 ? size : 0) + 1, 1);
+    if (!data) return false;
+    rewind(sema->diags);
+    size_t read = fread(data, 1, (size_t)(size > 0 ? size : 0), sema->diags);
+    data[read] = '\0';
+    bool found = strstr(data, text) != NULL;
+    free(data);
+    return found;
+}
+
+#endif // SELENA_TESTS_SEMA_UTIL_H_
@@ -0,0 +1,58 @@
+/**
+ * @file test_util.h
+ * @brief Checks shared by the in-tree tests.
+ *
+ * Each test is one executable run by ctest. A failed check prints its
+ * location and message and the test goes on, so one run reports every
+ * mismatch; main() returns SLN_TEST_RESULT().
+ */
+
+#ifndef SELENA_TESTS_TEST_UTIL_H_
+#define SELENA_TESTS_TEST_UTIL_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <lexer/lexer.h>
+
+static int sln_test_failures = 0;
+
+/// @brief Records a failure with a printf-style message unless `cond` holds.
+#define SLN_TEST_CHECK(cond, ...)                                   \
+    do {                                                            \
+        if (!(cond)) {                                              \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);         \
+            fprintf(stderr, __VA_ARGS__);                           \
+            fputc('\n', stderr);                                    \
+            sln_test_failures++;                                    \
+        }                                                           \
+    } while (0)
+
+/// @brief Exit status of the test.
+#define SLN_TEST_RESULT() (sln_test_failures == 0 ? 0 : 1)
+
+/// @brief Whether two tokens of the same text have the same kind, span and payload.
+static inline bool sln_test_same_token(const sln_lex_token_t* a, const sln_lex_token_t* b) {
+    if (a->type != b->type || a->span.offset != b->span.offset || a->span.length != b->span.length) return false;
+    switch (a->type) {
+        case SLN_LEX_TOKEN_IDENTIFIER:
+        case SLN_LEX_TOKEN_STRING_LITERAL:
+            return a->data.sym == b->data.sym;
+        case SLN_LEX_TOKEN_INT_LITERAL:
+            return a->data.u64 == b->data.u64;
+        case SLN_LEX_TOKEN_CHAR_LITERAL:
+            return a->data.i64 == b->data.i64;
+        case SLN_LEX_TOKEN_FLOAT_LITERAL:
+            return !(a->data.lfloat < b->data.lfloat) && !(a->data.lfloat > b->data.lfloat);
+        default:
+            return true;
+    }
+}
+
+/// @brief Path of a file under the repository's examples directory.
+#define SLN_TEST_EXAMPLE(path) SELENA_EXAMPLES_DIR "/" path
+
+/// @brief Path of a file under tests/expected/.
+#define SLN_TEST_EXPECTED(path) SELENA_TESTS_DIR "/expected/" path
+
+#endif // SELENA_TESTS_TEST_UTIL_H_
@@ -0,0 +1,170 @@
+/**
+ * @file utils_ring.c
+ * @brief Stress of the single-producer/single-consumer ring.
+ *
+ * A producer thread pushes numbered slots through rings of 1, 4 and 16
+ * slots while the consumer checks that each arrives once, whole and in
+ * order. Either side is slowed down now and then so the other has to
+ * sleep on a full or an empty ring. Consumers that cancel early, before
+ * or after the producer filled the ring and went to sleep, must let
+ * the producer finish without publishing more than fits.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <threads.h>
+
+#include <utils/spsc_ring.h>
+
+#include "test_util.h"
+
+#define TEST_SLOTS 100000u
+#define TEST_SLOT_SIZE 64u
+#define TEST_PAUSE_EVERY 4096u
+
+typedef struct {
+    uint64_t seq;
+    uint64_t inverse;                   /**< ~seq */
+    unsigned char fill[TEST_SLOT_SIZE - 2 * sizeof(uint64_t)];
+} _slot_t;
+
+typedef struct {
+    sln_utils_ring_t ring;
+    size_t count;                       /**< Slots to publish */
+    bool slow;                          /**< Pauses every TEST_PAUSE_EVERY slots */
+    atomic_size_t published;
+    bool refused;                       /**< An acquire returned NULL */
+    bool stable;                        /**< Repeated acquires returned the same slot */
+} _producer_t;
+
+static void _pause(void) {
+    thrd_sleep(&(struct timespec){ .tv_nsec = 200000 }, NULL);
+}
+
+static int _produce(void* arg) {
+    _producer_t* producer = arg;
+    producer->stable = true;
+    for (size_t i = 0; i < producer->count; i++) {
+        if (producer->slow && i % TEST_PAUSE_EVERY == 0) _pause();
+        _slot_t* slot = sln_utils_ring_acquire(&producer->ring);
+        if (!slot) {
+            producer->refused = true;
+            break;
+        }
+        if (i % 7 == 0 && sln_utils_ring_acquire(&producer->ring) != slot) producer->stable = false;
+        slot->seq = i;
+        slot->inverse = ~(uint64_t)i;
+        memset(slot->fill, (int)(i & 0xffu), sizeof(slot->fill));
+        sln_utils_ring_publish(&producer->ring);
+        atomic_fetch_add(&producer->published, 1);
+    }
+    sln_utils_ring_close(&producer->ring);
+    return 0;
+}
+
+static bool _intact(const _slot_t* slot, size_t seq) {
+    if (slot->seq != seq || slot->inverse != ~(uint64_t)seq) return false;
+    for (size_t i = 0; i < sizeof(slot->fill); i++) {
+        if (slot->fill[i] != (unsigned char)(seq & 0xffu)) return false;
+    }
+    return true;
+}
+
+static bool _start(_producer_t* producer, thrd_t* thread, size_t depth, size_t count, bool slow) {
+    memset(producer, 0, sizeof(*producer));
+    atomic_init(&producer->published, 0);
+    producer->count = count;
+    producer->slow = slow;
+    SLN_TEST_CHECK(sln_utils_ring_init(&producer->ring, depth, sizeof(_slot_t)), "depth %zu: init failed", depth);
+    if (!producer->ring.slots) return false;
+    if (thrd_create(thread, _produce, producer) != thrd_success) {
+        SLN_TEST_CHECK(false, "depth %zu: cannot start the producer", depth);
+        sln_utils_ring_free(&producer->ring);
+        return false;
+    }
+    return true;
+}
+
+// Every slot arrives once and in order; `slow_producer` makes the consumer wait on an empty ring
+static void _check_stream(size_t depth, bool slow_producer, bool slow_consumer) {
+    _producer_t producer;
+    thrd_t thread;
+    if (!_start(&producer, &thread, depth, TEST_SLOTS, slow_producer)) return;
+
+    size_t received = 0;
+    bool ordered = true;
+    for (const _slot_t* slot; (slot = sln_utils_ring_peek(&producer.ring));) {
+        if (slow_consumer && received % TEST_PAUSE_EVERY == 0) _pause();
+        if (ordered && !_intact(slot, received)) {
+            SLN_TEST_CHECK(false, "depth %zu: slot %zu holds %llu", depth, received, (unsigned long long)slot->seq);
+            ordered = false;
+        }
+        if (sln_utils_ring_peek(&producer.ring) != slot) ordered = false;
+        sln_utils_ring_release(&producer.ring);
+        received++;
+    }
+    thrd_join(thread, NULL);
+
+    SLN_TEST_CHECK(ordered, "depth %zu: slots out of order or changed under the consumer", depth);
+    SLN_TEST_CHECK(received == TEST_SLOTS, "depth %zu: %zu of %u slots received", depth, received, TEST_SLOTS);
+    SLN_TEST_CHECK(!producer.refused, "depth %zu: acquire failed without a cancel", depth);
+    SLN_TEST_CHECK(producer.stable, "depth %zu: repeated acquires moved to another slot", depth);
+    SLN_TEST_CHECK(sln_utils_ring_peek(&producer.ring) == NULL, "depth %zu: peek after the end returned a slot", depth);
+    sln_utils_ring_free(&producer.ring);
+}
+
+// The consumer reads `keep` slots then cancels; with `wait_full`, only once the
+// producer has filled the ring and had time to go to sleep on it
+static void _check_cancel(size_t depth, size_t keep, bool wait_full) {
+    _producer_t producer;
+    thrd_t thread;
+    if (!_start(&producer, &thread, depth, TEST_SLOTS, false)) return;
+
+    size_t received = 0;
+    for (const _slot_t* slot; received < keep && (slot = sln_utils_ring_peek(&producer.ring)); received++) {
+        SLN_TEST_CHECK(_intact(slot, received), "depth %zu: slot %zu damaged before the cancel", depth, received);
+        sln_utils_ring_release(&producer.ring);
+    }
+    if (wait_full) {
+        while (atomic_load(&producer.published) < keep + depth) thrd_yield();
+        _pause();
+    }
+    sln_utils_ring_cancel(&producer.ring);
+    thrd_join(thread, NULL);
+
+    SLN_TEST_CHECK(producer.refused, "depth %zu, cancel after %zu: the producer was never refused", depth, keep);
+    size_t published = atomic_load(&producer.published);
+    SLN_TEST_CHECK(published <= keep + depth, "depth %zu, cancel after %zu: %zu slots published into %zu free",
+                   depth, keep, published, keep + depth);
+    sln_utils_ring_free(&producer.ring);
+}
+
+static void _check_init(void) {
+    sln_utils_ring_t ring;
+    SLN_TEST_CHECK(!sln_utils_ring_init(&ring, 0, TEST_SLOT_SIZE), "a ring of 0 slots was accepted");
+    SLN_TEST_CHECK(!sln_utils_ring_init(&ring, 12, TEST_SLOT_SIZE), "a ring of 12 slots was accepted");
+    SLN_TEST_CHECK(!sln_utils_ring_init(&ring, 4, 0), "a ring of empty slots was accepted");
+
+    // Closed before anything is published: the consumer sees the end at once
+    if (sln_utils_ring_init(&ring, 4, TEST_SLOT_SIZE)) {
+        sln_utils_ring_close(&ring);
+        SLN_TEST_CHECK(sln_utils_ring_peek(&ring) == NULL, "an empty closed ring returned a slot");
+        sln_utils_ring_free(&ring);
+    }
+}
+
+int main(void) {
+    static const size_t depths[] = { 1, 4, 16 };
+    _check_init();
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+        _check_stream(depths[i], false, false);
+        _check_stream(depths[i], true, false);
+        _check_stream(depths[i], false, true);
+        _check_cancel(depths[i], 0, false);
+        _check_cancel(depths[i], 0, true);
+        _check_cancel(depths[i], 37, true);
+        _check_cancel(depths[i], 1000, false);
+    }
+    return SLN_TEST_RESULT();
+}
@@ -0,0 +1,632 @@
+/**
+ * @file bench_lex.c
+ * @brief Lexer throughput benchmark.
+ *
+ * Usage: selena_bench_lex [options]
+ *
+ *   --size N[K|M|G]   corpus size, 1K to 1G (default 16M)
+ *   --seed N          corpus seed (default 1)
+ *   --mix k=w,...     token weights; kinds: ident, keyword, number,
+ *                     string, comment, operator
+ *   --runs N          timed runs, the fastest is reported (default 5)
+ *   --input PATH      lex a file instead of a generated corpus
+ *   --write PATH      save the generated corpus
+ *   --mode M          lex (default) or keywords
+ *
+ * The corpus is a deterministic function of size, seed and mix, so
+ * runs of different commits lex the same bytes. Prints one JSON object
+ * with throughput, allocations per token (from an extra profiled run)
+ * and, where perf_event_open is allowed, hardware counters averaged
+ * over the timed runs.
+ *
+ * The keywords mode times keyword recognition alone. It draws a list
+ * of words from the ident and keyword weights of the mix, a quarter
+ * of the identifiers being near misses such as "uses" or "i6", and
+ * looks every word up size / 4 times in total, both through
+ * sln_lex_keyword_type() and through a linear scan of the keyword
+ * list. The two must agree on every word.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__linux__)
+#   include <unistd.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <linux/perf_event.h>
+#   define BENCH_PERF 1
+#endif
+
+#include <lexer/lexer.h>
+#include <lexer/lexer_keywords.h>
+#include <lexer/lexer_operators.h>
+#include <common/source.h>
+#include <utils/alloc_stats.h>
+#include <utils/allocation.h>
+
+#define BENCH_MIN_SIZE 1024UL
+#define BENCH_MAX_SIZE (1024UL * 1024UL * 1024UL)
+#define BENCH_DEFAULT_SIZE (16UL * 1024UL * 1024UL)
+#define BENCH_MAX_RUNS 1000
+#define BENCH_TOKEN_MAX 160
+#define BENCH_KEYWORD_WORDS 4096UL
+
+typedef enum {
+    BENCH_MIX_IDENT,
+    BENCH_MIX_KEYWORD,
+    BENCH_MIX_NUMBER,
+    BENCH_MIX_STRING,
+    BENCH_MIX_COMMENT,
+    BENCH_MIX_OPERATOR,
+    _BENCH_MIX_COUNT
+} _bench_mix_t;
+
+static const char* const _mix_names[_BENCH_MIX_COUNT] = {
+    "ident", "keyword", "number", "string", "comment", "operator"
+};
+
+#define _BENCH_SPELLING(name, spelling) spelling,
+static const char* const _keywords[] = { SLN_LEX_KEYWORDS(_BENCH_SPELLING) };
+static const char* const _operators[] = { SLN_LEX_OPERATORS(_BENCH_SPELLING) };
+#undef _BENCH_SPELLING
+
+#define BENCH_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+static const char _ident_start[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+static const char _ident_rest[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+static const char _words[] = "abcdefghijklmnopqrstuvwxyz ";
+
+// splitmix64: small, fast and the same on every platform
+static uint64_t _next(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static size_t _below(uint64_t* state, size_t bound) {
+    return (size_t)(_next(state) % bound);
+}
+
+static char _pick(uint64_t* state, const char* set, size_t set_len) {
+    return set[_below(state, set_len)];
+}
+
+static size_t _emit_words(uint64_t* state, char* out, size_t max) {
+    size_t len = 1 + _below(state, max);
+    for (size_t i = 0; i < len; i++) out[i] = _pick(state, _words, sizeof(_words) - 1);
+    return len;
+}
+
+// Writes one token of the given kind, at most BENCH_TOKEN_MAX bytes
+static size_t _emit_token(uint64_t* state, _bench_mix_t kind, char* out) {
+    size_t len = 0;
+    switch (kind) {
+        case BENCH_MIX_IDENT: {
+            size_t ident_len = 1 + _below(state, 12);
+            out[len++] = _pick(state, _ident_start, sizeof(_ident_start) - 1);
+            while (len < ident_len) out[len++] = _pick(state, _ident_rest, sizeof(_ident_rest) - 1);
+            return len;
+        }
+        case BENCH_MIX_KEYWORD: {
+            const char* keyword = _keywords[_below(state, BENCH_COUNT(_keywords))];
+            len = strlen(keyword);
+            memcpy(out, keyword, len);
+            return len;
+        }
+        case BENCH_MIX_NUMBER: {
+            uint64_t value = _next(state);
+            int written;
+            switch (_below(state, 5)) {
+                case 0:  written = snprintf(out, BENCH_TOKEN_MAX, "%llu", (unsigned long long)(value % 1000000u)); break;
+                case 1:  written = snprintf(out, BENCH_TOKEN_MAX, "0x%llX", (unsigned long long)(value >> 32)); break;
+                case 2:  written = snprintf(out, BENCH_TOKEN_MAX, "0b%llu%llu%llu%llu", (unsigned long long)(value & 1), (unsigned long long)((value >> 1) & 1),
+                                            (unsigned long long)((value >> 2) & 1), (unsigned long long)((value >> 3) & 1)); break;
+                case 3:  written = snprintf(out, BENCH_TOKEN_MAX, "%llu.%llu", (unsigned long long)(value % 1000u), (unsigned long long)((value >> 20) % 100000u)); break;
+                default: written = snprintf(out, BENCH_TOKEN_MAX, "%llu.%llue-%llu", (unsigned long long)(value % 10u), (unsigned long long)((value >> 8) % 1000u),
+                                            (unsigned long long)((value >> 40) % 30u)); break;
+            }
+            return written > 0 ? (size_t)written : 0;
+        }
+        case BENCH_MIX_STRING: {
+            static const char* const escapes[] = { "\\n", "\\t", "\\\\", "\\\"", "\\x41" };
+            size_t chars = _below(state, 24);
+            out[len++] = '"';
+            for (size_t i = 0; i < chars; i++) {
+                if (_below(state, 10) == 0) {
+                    const char* escape = escapes[_below(state, BENCH_COUNT(escapes))];
+                    size_t escape_len = strlen(escape);
+                    memcpy(out + len, escape, escape_len);
+                    len += escape_len;
+                } else {
+                    out[len++] = _pick(state, _words, sizeof(_words) - 1);
+                }
+            }
+            out[len++] = '"';
+            return len;
+        }
+        case BENCH_MIX_COMMENT:
+            out[len++] = '#';
+            if (_below(state, 2) == 0) {
+                out[len++] = ' ';
+                len += _emit_words(state, out + len, 60);
+                out[len++] = '\n';
+            } else {
+                out[len++] = '#';
+                len += _emit_words(state, out + len, 30);
+                out[len++] = '\n';
+                len += _emit_words(state, out + len, 30);
+                out[len++] = '#';
+                out[len++] = '#';
+            }
+            return len;
+        case BENCH_MIX_OPERATOR:
+        default: {
+            const char* op = _operators[_below(state, BENCH_COUNT(_operators))];
+            len = strlen(op);
+            memcpy(out, op, len);
+            return len;
+        }
+    }
+}
+
+// Fills exactly `size` bytes; the buffer has room for the zero padding
+static char* _generate(size_t size, uint64_t seed, const unsigned weights[_BENCH_MIX_COUNT]) {
+    char* text = SLN_ALLOC(size + SLN_COMMON_SOURCE_PADDING, char);
+    if (!text) return NULL;
+
+    unsigned total = 0;
+    for (size_t k = 0; k < _BENCH_MIX_COUNT; k++) total += weights[k];
+
+    uint64_t state = seed;
+    char token[BENCH_TOKEN_MAX];
+    size_t len = 0;
+    for (;;) {
+        size_t roll = _below(&state, total);
+        size_t kind = 0;
+        while (roll >= weights[kind]) roll -= weights[kind++];
+
+        size_t token_len = _emit_token(&state, (_bench_mix_t)kind, token);
+        if (len + token_len + 1 > size) break;
+        memcpy(text + len, token, token_len);
+        len += token_len;
+        text[len++] = _below(&state, 10) == 0 ? '\n' : ' ';
+    }
+    memset(text + len, '\n', size - len);
+    return text;
+}
+
+static bool _parse_size(const char* value, size_t* out) {
+    char* end = NULL;
+    errno = 0;
+    unsigned long long n = strtoull(value, &end, 10);
+    if (errno || end == value) return false;
+    unsigned long long scale = 1;
+    if (*end == 'K' || *end == 'k') scale = 1024ULL;
+    else if (*end == 'M' || *end == 'm') scale = 1024ULL * 1024ULL;
+    else if (*end == 'G' || *end == 'g') scale = 1024ULL * 1024ULL * 1024ULL;
+    else if (*end != '\0') return false;
+    if (scale != 1 && end[1] != '\0') return false;
+    if (n > BENCH_MAX_SIZE / scale) return false;
+    n *= scale;
+    if (n < BENCH_MIN_SIZE) return false;
+    *out = (size_t)n;
+    return true;
+}
+
+static bool _parse_mix(const char* value, unsigned weights[_BENCH_MIX_COUNT]) {
+    unsigned parsed[_BENCH_MIX_COUNT] = {0};
+    memcpy(parsed, weights, sizeof(parsed));
+    while (*value) {
+        const char* eq = strchr(value, '=');
+        if (!eq) return false;
+        size_t kind = 0;
+        while (kind < _BENCH_MIX_COUNT &&
+               !(strlen(_mix_names[kind]) == (size_t)(eq - value) && strncmp(_mix_names[kind], value, (size_t)(eq - value)) == 0)) {
+            kind++;
+        }
+        if (kind == _BENCH_MIX_COUNT) return false;
+        char* end = NULL;
+        unsigned long weight = strtoul(eq + 1, &end, 10);
+        if (end == eq + 1 || weight > 1000000UL || (*end != ',' && *end != '\0')) return false;
+        parsed[kind] = (unsigned)weight;
+        value = *end == ',' ? end + 1 : end;
+    }
+    unsigned total = 0;
+    for (size_t k = 0; k < _BENCH_MIX_COUNT; k++) total += parsed[k];
+    if (total == 0) return false;
+    memcpy(weights, parsed, sizeof(parsed));
+    return true;
+}
+
+static double _now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef enum {
+    BENCH_COUNTER_CYCLES,
+    BENCH_COUNTER_INSTRUCTIONS,
+    BENCH_COUNTER_BRANCH_MISSES,
+    BENCH_COUNTER_CACHE_MISSES,
+    _BENCH_COUNTER_COUNT
+} _bench_counter_t;
+
+static const char* const _counter_names[_BENCH_COUNTER_COUNT] = {
+    "cycles", "instructions", "branch_misses", "cache_misses"
+};
+
+typedef struct {
+    int fds[_BENCH_COUNTER_COUNT];
+    bool ok;
+    int error;
+} _bench_perf_t;
+
+static void _perf_open(_bench_perf_t* perf) {
+    perf->ok = false;
+    perf->error = ENOSYS;
+    for (size_t i = 0; i < _BENCH_COUNTER_COUNT; i++) perf->fds[i] = -1;
+#if defined(BENCH_PERF)
+    static const uint64_t configs[_BENCH_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+    };
+    for (size_t i = 0; i < _BENCH_COUNTER_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.disabled = i == 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : perf->fds[0], 0UL);
+        if (fd < 0) {
+            perf->error = errno;
+            for (size_t j = 0; j < i; j++) close(perf->fds[j]);
+            return;
+        }
+        perf->fds[i] = (int)fd;
+    }
+    perf->ok = true;
+    perf->error = 0;
+#endif
+}
+
+static void _perf_switch(const _bench_perf_t* perf, bool on) {
+#if defined(BENCH_PERF)
+    if (!perf->ok) return;
+    if (on) ioctl(perf->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(perf->fds[0], on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#else
+    (void)perf;
+    (void)on;
+#endif
+}
+
+static bool _perf_read(const _bench_perf_t* perf, uint64_t values[_BENCH_COUNTER_COUNT]) {
+#if defined(BENCH_PERF)
+    if (!perf->ok) return false;
+    uint64_t group[1 + _BENCH_COUNTER_COUNT];
+    if (read(perf->fds[0], group, sizeof(group)) != (ssize_t)sizeof(group)) return false;
+    for (size_t i = 0; i < _BENCH_COUNTER_COUNT; i++) values[i] += group[1 + i];
+    return true;
+#else
+    (void)perf;
+    (void)values;
+    return false;
+#endif
+}
+
+static void _perf_close(_bench_perf_t* perf) {
+#if defined(BENCH_PERF)
+    for (size_t i = 0; perf->ok && i < _BENCH_COUNTER_COUNT; i++) close(perf->fds[i]);
+#endif
+    perf->ok = false;
+}
+
+// One lexer pass with a fresh interner; returns the token count, 0 on failure
+static size_t _lex_once(const char* text) {
+    sln_utils_intern_t* symbols = sln_utils_intern_create();
+    if (!symbols) return 0;
+    sln_lex_token_buffer_t buffer = {0};
+    sln_lex_error_t error = sln_lex_generate(text, &buffer, symbols, stderr);
+    size_t tokens = error == SLN_LEX_ALLOCATION_FAILED ? 0 : buffer.len;
+    sln_lex_free_tokens(&buffer);
+    sln_utils_intern_destroy(symbols);
+    return tokens;
+}
+
+// Spelling of a keyword with one byte changed or one byte appended
+static size_t _emit_near_miss(uint64_t* state, char* out) {
+    const char* keyword = _keywords[_below(state, BENCH_COUNT(_keywords))];
+    size_t len = strlen(keyword);
+    memcpy(out, keyword, len);
+    char extra = _pick(state, _ident_rest, sizeof(_ident_rest) - 1);
+    if (_below(state, 2) == 0) {
+        out[len++] = extra;
+    } else {
+        out[len - 1] = extra;
+    }
+    return len;
+}
+
+// The scan the perfect hash replaced, kept as the baseline
+static sln_lex_token_type_t _keyword_linear(const char* str, size_t len) {
+    for (size_t i = 0; i < BENCH_COUNT(_keywords); i++) {
+        if (strlen(_keywords[i]) == len && memcmp(_keywords[i], str, len) == 0) {
+            return (sln_lex_token_type_t)(SLN_LEX_TOKEN_KW_NAMESPACE + i);
+        }
+    }
+    return SLN_LEX_TOKEN_UNKNOWN;
+}
+
+typedef sln_lex_token_type_t (*_bench_lookup_t)(const char* str, size_t len);
+
+// Read through a volatile so neither lookup is inlined into the loop
+static _bench_lookup_t volatile _lookup;
+
+typedef struct {
+    char* text;
+    uint32_t* offsets;
+    uint8_t* lengths;
+    size_t count;
+} _bench_words_t;
+
+static bool _keyword_words(_bench_words_t* words, uint64_t seed, const unsigned weights[_BENCH_MIX_COUNT]) {
+    words->text = SLN_ALLOC(BENCH_KEYWORD_WORDS * BENCH_TOKEN_MAX, char);
+    words->offsets = SLN_ALLOC(BENCH_KEYWORD_WORDS, uint32_t);
+    words->lengths = SLN_ALLOC(BENCH_KEYWORD_WORDS, uint8_t);
+    if (!words->text || !words->offsets || !words->lengths) return false;
+
+    unsigned idents = weights[BENCH_MIX_IDENT];
+    unsigned total = idents + weights[BENCH_MIX_KEYWORD];
+    if (total == 0) return false;
+
+    uint64_t state = seed;
+    size_t len = 0;
+    for (size_t i = 0; i < BENCH_KEYWORD_WORDS; i++) {
+        size_t roll = _below(&state, total);
+        size_t word_len;
+        if (roll >= idents) {
+            word_len = _emit_token(&state, BENCH_MIX_KEYWORD, words->text + len);
+        } else if (roll % 4 == 0) {
+            word_len = _emit_near_miss(&state, words->text + len);
+        } else {
+            word_len = _emit_token(&state, BENCH_MIX_IDENT, words->text + len);
+        }
+        words->offsets[i] = (uint32_t)len;
+        words->lengths[i] = (uint8_t)word_len;
+        len += word_len;
+    }
+    words->count = BENCH_KEYWORD_WORDS;
+    return true;
+}
+
+static void _keyword_words_free(_bench_words_t* words) {
+    sln_utils_free(words->text);
+    sln_utils_free(words->offsets);
+    sln_utils_free(words->lengths);
+}
+
+// Best time of `runs` passes over the words; returns the sum of the types found
+static size_t _time_lookups(const _bench_words_t* words, size_t rounds, int runs, double* best) {
+    size_t sum = 0;
+    *best = 0.0;
+    for (int r = 0; r < runs; r++) {
+        double start = _now();
+        for (size_t k = 0; k < rounds; k++) {
+            for (size_t i = 0; i < words->count; i++) {
+                sum += (size_t)_lookup(words->text + words->offsets[i], words->lengths[i]);
+            }
+        }
+        double elapsed = _now() - start;
+        if (r == 0 || elapsed < *best) *best = elapsed;
+    }
+    return sum;
+}
+
+static int _bench_keywords(size_t size, uint64_t seed, int runs, const unsigned weights[_BENCH_MIX_COUNT]) {
+    _bench_words_t words = {0};
+    if (!_keyword_words(&words, seed, weights)) {
+        fprintf(stderr, "error: cannot build the word list (need ident or keyword weight)\n");
+        _keyword_words_free(&words);
+        return 1;
+    }
+
+    size_t keywords = 0;
+    for (size_t i = 0; i < words.count; i++) {
+        const char* word = words.text + words.offsets[i];
+        sln_lex_token_type_t hashed = sln_lex_keyword_type(word, words.lengths[i]);
+        if (hashed != _keyword_linear(word, words.lengths[i])) {
+            fprintf(stderr, "error: lookups disagree on '%.*s'\n", (int)words.lengths[i], word);
+            _keyword_words_free(&words);
+            return 1;
+        }
+        keywords += hashed != SLN_LEX_TOKEN_UNKNOWN;
+    }
+
+    size_t rounds = size / 4 / words.count;
+    if (rounds == 0) rounds = 1;
+    double lookups = (double)rounds * (double)words.count;
+
+    double hash_best;
+    double linear_best;
+    _lookup = sln_lex_keyword_type;
+    size_t hash_sum = _time_lookups(&words, rounds, runs, &hash_best);
+    _lookup = _keyword_linear;
+    size_t linear_sum = _time_lookups(&words, rounds, runs, &linear_best);
+
+    printf("{\"mode\":\"keywords\",\"words\":%zu,\"keywords\":%zu,\"seed\":%llu,\"runs\":%d,\"lookups\":%.0f",
+           words.count, keywords, (unsigned long long)seed, runs, lookups);
+    printf(",\"ns_per_lookup\":{\"hash\":%.3f,\"linear\":%.3f},\"speedup\":%.2f,\"checksum\":%s}\n",
+           hash_best * 1e9 / lookups, linear_best * 1e9 / lookups,
+           hash_best > 0.0 ? linear_best / hash_best : 0.0,
+           hash_sum == linear_sum ? "true" : "false");
+    _keyword_words_free(&words);
+    return hash_sum == linear_sum ? 0 : 1;
+}
+
+static int _compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void _usage(const char* program) {
+    fprintf(stderr, "usage: %s [--size N[K|M|G]] [--seed N] [--mix kind=weight,...] "
+                    "[--runs N] [--input PATH] [--write PATH] [--mode lex|keywords]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    size_t size = BENCH_DEFAULT_SIZE;
+    uint64_t seed = 1;
+    unsigned weights[_BENCH_MIX_COUNT] = { 40, 12, 10, 6, 4, 28 };
+    int runs = 5;
+    const char* input = NULL;
+    const char* write_path = NULL;
+    bool keyword_mode = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool ok = value != NULL;
+        if (!ok) {
+            // every option takes a value
+        } else if (strcmp(arg, "--size") == 0) {
+            ok = _parse_size(value, &size);
+        } else if (strcmp(arg, "--seed") == 0) {
+            seed = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--mix") == 0) {
+            ok = _parse_mix(value, weights);
+        } else if (strcmp(arg, "--runs") == 0) {
+            runs = atoi(value);
+            ok = runs > 0 && runs <= BENCH_MAX_RUNS;
+        } else if (strcmp(arg, "--input") == 0) {
+            input = value;
+        } else if (strcmp(arg, "--write") == 0) {
+            write_path = value;
+        } else if (strcmp(arg, "--mode") == 0) {
+            keyword_mode = strcmp(value, "keywords") == 0;
+            ok = keyword_mode || strcmp(value, "lex") == 0;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "error: bad option '%s'\n", arg);
+            _usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if (keyword_mode) return _bench_keywords(size, seed, runs, weights);
+
+    sln_common_source_t source = {0};
+    char* generated = NULL;
+    const char* text;
+    if (input) {
+        if (!sln_common_source_load(&source, input)) {
+            fprintf(stderr, "error: cannot read '%s': %s\n", input, strerror(source.error));
+            return 1;
+        }
+        text = source.text;
+        size = source.len;
+    } else {
+        generated = _generate(size, seed, weights);
+        if (!generated) {
+            fprintf(stderr, "error: cannot allocate a %zu byte corpus\n", size);
+            return 1;
+        }
+        text = generated;
+    }
+
+    if (write_path && generated) {
+        FILE* out = fopen(write_path, "wb");
+        if (!out || fwrite(generated, 1, size, out) != size || fclose(out) != 0) {
+            perror(write_path);
+            return 1;
+        }
+    }
+
+    // Warm-up pass, which also gives the token count
+    size_t tokens = _lex_once(text);
+    if (tokens == 0) {
+        fprintf(stderr, "error: lexing failed\n");
+        return 1;
+    }
+
+    _bench_perf_t perf;
+    _perf_open(&perf);
+    uint64_t counters[_BENCH_COUNTER_COUNT] = {0};
+    double* times = SLN_ALLOC((size_t)runs, double);
+    if (!times) return 1;
+    for (int r = 0; r < runs; r++) {
+        _perf_switch(&perf, true);
+        double start = _now();
+        _lex_once(text);
+        double elapsed = _now() - start;
+        _perf_switch(&perf, false);
+        _perf_read(&perf, counters);
+        times[r] = elapsed;
+    }
+    _perf_close(&perf);
+    qsort(times, (size_t)runs, sizeof(*times), _compare_doubles);
+    double best = times[0];
+    double median = times[runs / 2];
+
+    // Profiled pass, kept out of the timings
+    size_t alloc_count = 0;
+    size_t alloc_bytes = 0;
+    size_t peak_live = 0;
+    if (sln_utils_alloc_stats_enable()) {
+        _lex_once(text);
+        sln_utils_alloc_stats_totals(&alloc_count, &alloc_bytes, &peak_live);
+        sln_utils_alloc_stats_disable();
+    }
+
+    printf("{\"corpus\":{\"source\":");
+    if (input) {
+        printf("\"file\",\"bytes\":%zu", size);
+    } else {
+        printf("\"generated\",\"bytes\":%zu,\"seed\":%llu,\"mix\":{", size, (unsigned long long)seed);
+        for (size_t k = 0; k < _BENCH_MIX_COUNT; k++) printf("%s\"%s\":%u", k ? "," : "", _mix_names[k], weights[k]);
+        printf("}");
+    }
+    printf("},\"runs\":%d,\"tokens\":%zu", runs, tokens);
+    printf(",\"seconds\":{\"best\":%.6f,\"median\":%.6f}", best, median);
+    printf(",\"mb_per_s\":%.2f,\"tokens_per_s\":%.0f",
+           (double)size / best / 1e6, (double)tokens / best);
+    printf(",\"allocs_per_token\":%.6f,\"alloc_bytes_per_token\":%.3f,\"peak_live_bytes\":%zu",
+           (double)alloc_count / (double)tokens, (double)alloc_bytes / (double)tokens, peak_live);
+    printf(",\"counters\":");
+    if (perf.error == 0) {
+        printf("{");
+        for (size_t i = 0; i < _BENCH_COUNTER_COUNT; i++) {
+            printf("%s\"%s\":%llu", i ? "," : "", _counter_names[i],
+                   (unsigned long long)(counters[i] / (uint64_t)runs));
+        }
+        printf(",\"per_token\":{");
+        for (size_t i = 0; i < _BENCH_COUNTER_COUNT; i++) {
+            printf("%s\"%s\":%.4f", i ? "," : "", _counter_names[i],
+                   (double)counters[i] / (double)runs / (double)tokens);
+        }
+        printf("}}");
+    } else {
+        printf("null,\"counters_error\":\"%s\"", strerror(perf.error));
+    }
+    printf("}\n");
+
+    sln_utils_free(times);
+    sln_utils_free(generated);
+    sln_common_source_free(&source);
+    return 0;
+}
@@ -0,0 +1,353 @@
+
+/**
+ * @file lexgen.c
+ * @brief Build-time generator of the lexer lookup tables.
+ *
+ * Usage: selena_lexgen <output header>
+ *
+ * Emits:
+ *  - a multiply-shift perfect hash over the keyword list from
+ *    lexer/lexer_keywords.h, so the lexer recognizes a keyword with
+ *    one hash and at most one compare;
+ *  - the 256-entry character class and flag tables that drive the
+ *    lexer dispatch;
+ *  - the operator state-transition table built from the list in
+ *    lexer/lexer_operators.h.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <lexer/lexer.h>
+#include <lexer/lexer_keywords.h>
+#include <lexer/lexer_operators.h>
+
+#define LEXGEN_MIN_HASH_BITS 5
+#define LEXGEN_MAX_HASH_BITS 10
+#define LEXGEN_SEED_ATTEMPTS 1000000u
+#define LEXGEN_MAX_OP_STATES 255
+#define LEXGEN_MAX_OP_CLASSES 64
+
+typedef struct {
+    const char* name;
+    const char* text;
+    size_t length;
+    uint32_t key;
+} _lexgen_keyword_t;
+
+#define _LEXGEN_KEYWORD(name, spelling) { #name, spelling, sizeof(spelling) - 1, 0 },
+static _lexgen_keyword_t _keywords[] = {
+    SLN_LEX_KEYWORDS(_LEXGEN_KEYWORD)
+};
+#undef _LEXGEN_KEYWORD
+
+static const size_t _keyword_count = sizeof(_keywords) / sizeof(_keywords[0]);
+
+static inline uint32_t _slot(uint32_t key, uint32_t seed, unsigned bits) {
+    return (key * seed) >> (32 - bits);
+}
+
+static bool _try_seed(uint32_t seed, unsigned bits) {
+    uint8_t used[1u << LEXGEN_MAX_HASH_BITS] = {0};
+    for (size_t i = 0; i < _keyword_count; i++) {
+        uint32_t slot = _slot(_keywords[i].key, seed, bits);
+        if (used[slot]) return false;
+        used[slot] = 1;
+    }
+    return true;
+}
+
+static bool _find_perfect_hash(uint32_t* out_seed, unsigned* out_bits) {
+    for (unsigned bits = LEXGEN_MIN_HASH_BITS; bits <= LEXGEN_MAX_HASH_BITS; bits++) {
+        if ((1u << bits) < _keyword_count) continue;
+
+        // Odd multipliers from a fixed xorshift sequence keep the output reproducible
+        uint32_t state = 0x9E3779B9u;
+        for (uint32_t attempt = 0; attempt < LEXGEN_SEED_ATTEMPTS; attempt++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            if (_try_seed(state | 1u, bits)) {
+                *out_seed = state | 1u;
+                *out_bits = bits;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// ------- Character classes -------
+
+static const char* const _char_class_names[] = {
+    "SLN_LEX_CC_OTHER",     /* bytes that start no token */
+    "SLN_LEX_CC_NUL",       /* end of text */
+    "SLN_LEX_CC_BLANK",     /* ' ' '\t' */
+    "SLN_LEX_CC_NEWLINE",   /* '\n' */
+    "SLN_LEX_CC_CR",        /* '\r' */
+    "SLN_LEX_CC_HASH",      /* '#' */
+    "SLN_LEX_CC_IDENT",     /* [A-Za-z_] */
+    "SLN_LEX_CC_DIGIT",     /* [0-9] */
+    "SLN_LEX_CC_QUOTE",     /* '"' */
+    "SLN_LEX_CC_APOS",      /* '\'' */
+    "SLN_LEX_CC_OPERATOR",  /* first byte of an operator */
+    "SLN_LEX_CC_UTF8",      /* 0x80-0xFF, part of a multi-byte sequence */
+};
+
+enum {
+    _CC_OTHER, _CC_NUL, _CC_BLANK, _CC_NEWLINE, _CC_CR, _CC_HASH,
+    _CC_IDENT, _CC_DIGIT, _CC_QUOTE, _CC_APOS, _CC_OPERATOR, _CC_UTF8,
+};
+
+#define _CF_IDENT  0x01u
+#define _CF_DIGIT  0x02u
+#define _CF_XDIGIT 0x04u
+#define _CF_OCTAL  0x08u
+#define _CF_BINARY 0x10u
+
+#define _LEXGEN_OPERATOR(name, spelling) { "SLN_LEX_TOKEN_" #name, spelling, SLN_LEX_TOKEN_##name },
+static const struct {
+    const char* token;
+    const char* text;
+    int value;
+} _operators[] = {
+    SLN_LEX_OPERATORS(_LEXGEN_OPERATOR)
+};
+#undef _LEXGEN_OPERATOR
+
+static const size_t _operator_count = sizeof(_operators) / sizeof(_operators[0]);
+
+static bool _is_alpha(int c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+static bool _is_digit(int c) { return c >= '0' && c <= '9'; }
+
+static void _emit_table(FILE* out, const char* decl, const uint8_t* table) {
+    fprintf(out, "%s[256] = {", decl);
+    for (int c = 0; c < 256; c++) {
+        fprintf(out, "%s%u,", c % 16 ? " " : "\n    ", table[c]);
+    }
+    fprintf(out, "\n};\n\n");
+}
+
+static bool _emit_char_classes(FILE* out) {
+    uint8_t classes[256] = {0};
+    uint8_t flags[256] = {0};
+
+    for (int c = 0; c < 256; c++) {
+        if (_is_alpha(c) || c == '_') flags[c] |= _CF_IDENT;
+        if (_is_digit(c)) flags[c] |= _CF_IDENT | _CF_DIGIT | _CF_XDIGIT;
+        if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')) flags[c] |= _CF_XDIGIT;
+        if (c >= '0' && c <= '7') flags[c] |= _CF_OCTAL;
+        if (c == '0' || c == '1') flags[c] |= _CF_BINARY;
+
+        if (_is_alpha(c) || c == '_') classes[c] = _CC_IDENT;
+        else if (_is_digit(c)) classes[c] = _CC_DIGIT;
+        else if (c >= 0x80) classes[c] = _CC_UTF8;
+    }
+    for (size_t i = 0; i < _operator_count; i++) {
+        classes[(uint8_t)_operators[i].text[0]] = _CC_OPERATOR;
+    }
+    classes['\0'] = _CC_NUL;
+    classes[' '] = _CC_BLANK;
+    classes['\t'] = _CC_BLANK;
+    classes['\n'] = _CC_NEWLINE;
+    classes['\r'] = _CC_CR;
+    classes['#'] = _CC_HASH;
+    classes['"'] = _CC_QUOTE;
+    classes['\''] = _CC_APOS;
+
+    fprintf(out, "enum {\n");
+    for (size_t i = 0; i < sizeof(_char_class_names) / sizeof(_char_class_names[0]); i++) {
+        fprintf(out, "    %s,\n", _char_class_names[i]);
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "#define SLN_LEX_CF_IDENT  0x%02Xu /* [A-Za-z0-9_] */\n", _CF_IDENT);
+    fprintf(out, "#define SLN_LEX_CF_DIGIT  0x%02Xu /* [0-9] */\n", _CF_DIGIT);
+    fprintf(out, "#define SLN_LEX_CF_XDIGIT 0x%02Xu /* [0-9A-Fa-f] */\n", _CF_XDIGIT);
+    fprintf(out, "#define SLN_LEX_CF_OCTAL  0x%02Xu /* [0-7] */\n", _CF_OCTAL);
+    fprintf(out, "#define SLN_LEX_CF_BINARY 0x%02Xu /* [01] */\n\n", _CF_BINARY);
+
+    _emit_table(out, "static const uint8_t _sln_lex_char_class", classes);
+    _emit_table(out, "static const uint8_t _sln_lex_char_flags", flags);
+    return true;
+}
+
+// ------- Operator DFA -------
+
+// State 0 is dead, state 1 is the start; every state is a trie node,
+// so it stands for exactly one prefix of some operator.
+static struct {
+    uint8_t next[LEXGEN_MAX_OP_CLASSES];
+    uint8_t parent;
+    int token;          /* longest operator that is a prefix of this state */
+    unsigned length;    /* its length */
+} _states[LEXGEN_MAX_OP_STATES + 1];
+
+static bool _emit_operators(FILE* out) {
+    if (_operator_count != (size_t)(SLN_LEX_TOKEN_SEMICOLON - SLN_LEX_TOKEN_PLUS + 1)) {
+        fprintf(stderr, "lexgen: lexer_operators.h lists %zu operators, sln_lex_token_type_t has %d\n",
+                _operator_count, SLN_LEX_TOKEN_SEMICOLON - SLN_LEX_TOKEN_PLUS + 1);
+        return false;
+    }
+    for (size_t i = 0; i < _operator_count; i++) {
+        if (_operators[i].value != SLN_LEX_TOKEN_PLUS + (int)i) {
+            fprintf(stderr, "lexgen: operator '%s' is out of token order\n", _operators[i].text);
+            return false;
+        }
+    }
+
+    // Operator byte classes: 0 for bytes outside every operator
+    uint8_t op_class[256] = {0};
+    unsigned class_count = 1;
+    for (size_t i = 0; i < _operator_count; i++) {
+        for (const char* p = _operators[i].text; *p; p++) {
+            if (op_class[(uint8_t)*p]) continue;
+            if (class_count == LEXGEN_MAX_OP_CLASSES) {
+                fprintf(stderr, "lexgen: too many operator bytes\n");
+                return false;
+            }
+            op_class[(uint8_t)*p] = (uint8_t)class_count++;
+        }
+    }
+
+    unsigned state_count = 2;
+    _states[0].token = -1;
+    _states[1].token = -1;
+    for (size_t i = 0; i < _operator_count; i++) {
+        unsigned state = 1;
+        for (const char* p = _operators[i].text; *p; p++) {
+            uint8_t cls = op_class[(uint8_t)*p];
+            if (!_states[state].next[cls]) {
+                if (state_count > LEXGEN_MAX_OP_STATES) {
+                    fprintf(stderr, "lexgen: too many operator states\n");
+                    return false;
+                }
+                _states[state_count].parent = (uint8_t)state;
+                _states[state_count].token = -1;
+                _states[state].next[cls] = (uint8_t)state_count++;
+            }
+            state = _states[state].next[cls];
+        }
+        if (_states[state].token >= 0) {
+            fprintf(stderr, "lexgen: operator '%s' listed twice\n", _operators[i].text);
+            return false;
+        }
+        _states[state].token = (int)i;
+        _states[state].length = (unsigned)strlen(_operators[i].text);
+    }
+
+    // States are created after their parents, so one forward pass fills in
+    // the fallback of non-accepting states (e.g. ".." falls back to ".").
+    for (unsigned s = 2; s < state_count; s++) {
+        if (_states[s].token < 0) {
+            _states[s].token = _states[_states[s].parent].token;
+            _states[s].length = _states[_states[s].parent].length;
+        }
+    }
+
+    fprintf(out, "#define SLN_LEX_OP_START 1\n");
+    fprintf(out, "#define SLN_LEX_OP_STATES %u\n", state_count);
+    fprintf(out, "#define SLN_LEX_OP_CLASSES %u\n\n", class_count);
+    _emit_table(out, "static const uint8_t _sln_lex_op_class", op_class);
+
+    fprintf(out, "static const uint8_t _sln_lex_op_next[SLN_LEX_OP_STATES][SLN_LEX_OP_CLASSES] = {\n");
+    for (unsigned s = 0; s < state_count; s++) {
+        fprintf(out, "    {");
+        for (unsigned c = 0; c < class_count; c++) fprintf(out, "%s%u", c ? ", " : "", _states[s].next[c]);
+        fprintf(out, "},\n");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "/* Token and length of the longest operator accepted on the way to a state */\n");
+    fprintf(out, "static const uint8_t _sln_lex_op_token[SLN_LEX_OP_STATES] = {\n");
+    for (unsigned s = 0; s < state_count; s++) {
+        fprintf(out, "    %s,\n", _states[s].token < 0 ? "SLN_LEX_TOKEN_UNKNOWN" : _operators[_states[s].token].token);
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "static const uint8_t _sln_lex_op_length[SLN_LEX_OP_STATES] = {");
+    for (unsigned s = 0; s < state_count; s++) fprintf(out, "%s%u", s ? ", " : "", _states[s].length);
+    fprintf(out, "};\n\n");
+    return true;
+}
+
+// ------- Keywords -------
+
+static bool _emit_keywords(FILE* out) {
+    size_t min_len = SIZE_MAX, max_len = 0;
+    for (size_t i = 0; i < _keyword_count; i++) {
+        _keywords[i].key = sln_lex_keyword_key(_keywords[i].text, _keywords[i].length);
+        if (_keywords[i].length < min_len) min_len = _keywords[i].length;
+        if (_keywords[i].length > max_len) max_len = _keywords[i].length;
+
+        for (size_t j = 0; j < i; j++) {
+            if (_keywords[j].key == _keywords[i].key) {
+                fprintf(stderr, "lexgen: keywords '%s' and '%s' share a hash key; "
+                                "extend sln_lex_keyword_key()\n",
+                        _keywords[j].text, _keywords[i].text);
+                return false;
+            }
+        }
+    }
+
+    uint32_t seed;
+    unsigned bits;
+    if (!_find_perfect_hash(&seed, &bits)) {
+        fprintf(stderr, "lexgen: no perfect hash found for %zu keywords\n", _keyword_count);
+        return false;
+    }
+
+    fprintf(out, "#define SLN_LEX_KEYWORD_MIN_LEN %zu\n", min_len);
+    fprintf(out, "#define SLN_LEX_KEYWORD_MAX_LEN %zu\n", max_len);
+    fprintf(out, "#define SLN_LEX_KEYWORD_HASH_BITS %u\n", bits);
+    fprintf(out, "#define SLN_LEX_KEYWORD_HASH_SEED 0x%08Xu\n\n", seed);
+
+    fprintf(out, "static const struct {\n");
+    fprintf(out, "    char text[%zu];\n", max_len + 1);
+    fprintf(out, "    uint8_t length;\n");
+    fprintf(out, "    uint8_t type;\n");
+    fprintf(out, "} _sln_lex_keyword_hash[1u << SLN_LEX_KEYWORD_HASH_BITS] = {\n");
+    for (size_t i = 0; i < _keyword_count; i++) {
+        fprintf(out, "    [%u] = {\"%s\", %zu, SLN_LEX_TOKEN_KW_%s},\n",
+                _slot(_keywords[i].key, seed, bits),
+                _keywords[i].text, _keywords[i].length, _keywords[i].name);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static inline uint32_t _sln_lex_keyword_slot(const char* str, size_t len) {\n");
+    fprintf(out, "    return (sln_lex_keyword_key(str, len) * SLN_LEX_KEYWORD_HASH_SEED)\n");
+    fprintf(out, "        >> (32 - SLN_LEX_KEYWORD_HASH_BITS);\n");
+    fprintf(out, "}\n\n");
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <output header>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* out = fopen(argv[1], "w");
+    if (!out) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fprintf(out, "/* Generated by tools/lexgen.c. Do not edit. */\n\n");
+    fprintf(out, "#ifndef SELENA_LEXER_TABLES_H_\n");
+    fprintf(out, "#define SELENA_LEXER_TABLES_H_\n\n");
+    fprintf(out, "#include <stdint.h>\n");
+    fprintf(out, "#include <stddef.h>\n\n");
+    fprintf(out, "#include <lexer/lexer.h>\n\n");
+
+    bool ok = _emit_keywords(out) && _emit_char_classes(out) && _emit_operators(out);
+
+    fprintf(out, "#endif // SELENA_LEXER_TABLES_H_\n");
+    if (fclose(out) != 0) ok = false;
+
+    if (!ok) {
+        remove(argv[1]);
+        return 1;
+    }
+    return 0;
+}